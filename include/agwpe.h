@@ -0,0 +1,44 @@
+#ifndef AGWPE_H
+#define AGWPE_H
+
+#include <Arduino.h>
+
+#define AGW_TCP_PORT 8000           // default AGWPE port
+#define AGW_TCP_MAX_CLIENTS 3       // connections over this are refused
+#define AGW_TCP_CLIENT_QUEUE 8      // messages waiting for socket space per client, a client that falls further behind is dropped
+#define AGW_TCP_TX_QUEUE 4          // frames from clients waiting for the APRS task to send them on RF
+
+typedef struct
+{
+    uint8_t clients;    // connected now
+    uint32_t accepted;  // connections accepted
+    uint32_t refused;   // connections refused, all client slots in use
+    uint32_t frames;    // RF frames offered to monitoring clients
+    uint32_t slow;      // clients dropped for not keeping up
+    uint32_t txFrames;  // frames from clients queued for RF
+    uint32_t txDropped; // frames from clients dropped, TX queue full or RX only port
+} agwTcpStats;
+
+/**
+ * @brief Start listening for AGWPE clients
+ * @return False if the server could not be created
+ */
+bool agwTcpBegin(uint16_t port);
+
+/**
+ * @brief Send a received AX.25 frame to the clients that asked for monitor ('m') or raw ('k') frames
+ * Each message kind is built once into a shared buffer, client queues only hold a reference to it.
+ * Never waits for a client: a client whose queue is full is disconnected.
+ * @param port RX port the frame was received on
+ * @param ax25 AX.25 frame without the FCS
+ */
+void agwTcpBroadcast(uint8_t port, const uint8_t *ax25, size_t len);
+
+/**
+ * @brief Hand the frames sent by clients to the AX.25 TX buffer, called by the APRS task
+ */
+void agwTcpPoll();
+
+void agwTcpGetStats(agwTcpStats *stats);
+
+#endif // AGWPE_H
@@ -0,0 +1,80 @@
+#ifndef APRSFILTER_H
+#define APRSFILTER_H
+
+#include <Arduino.h>
+#include "pbuf.h"
+
+#define APRS_FILTER_TEXT 100         // longest filter string in the configuration
+#define APRS_FILTER_PARTS 16         // "r/.. b/.. -t/.." are 3 parts
+#define APRS_FILTER_ARGS 32          // callsigns, prefixes, names and symbol sets over all parts
+#define APRS_FILTER_ARG_LEN 10       // longest argument kept, callsign with SSID or object name
+#define APRS_FILTER_LOOKUP_MS 60000  // how long a station position found for f/ and t/ is reused
+
+typedef struct
+{
+    char type;         // filter letter, 'r', 'a', 'b', 'p', 'o', 't', 's', 'f', 'd', 'q', 'e', 'u', 'm'
+    bool negate;       // '-' part, drops what it matches
+    uint8_t argFirst;  // arguments of this part, arg[argFirst] to arg[argFirst + argCount - 1]
+    uint8_t argCount;
+    uint16_t types;    // t/: T_xxx packet types
+    float lat;         // r/, m/, f/, t/: centre in degrees, a/: north west corner
+    float lon;
+    float lat2;        // a/: south east corner
+    float lon2;
+    float cosLat;      // cos(lat), for the range test
+    float range;       // haversine of the range angle, sin^2(km / 2R), compared without any asin or sqrt
+    uint32_t found;    // f/, t/ with a call: millis() the centre was looked up, 0 never
+} aprsFilterPart;
+
+/**
+ * @brief Compiled APRS-IS filter
+ * @details Same syntax as the aprsc server side filter, parts separated by spaces. A packet passes
+ * if it matches any part without '-' and none with '-'. Callsigns and names may end in '*'.
+ * Nothing is allocated. A match writes the f/ and t/ centres it looks up into the part, so a
+ * filter belongs to one task, which compiles and matches it; tasks keep their own copies.
+ */
+typedef struct
+{
+    uint8_t parts;
+    uint8_t args;
+    uint8_t errors;  // parts that could not be compiled, they are left out
+    aprsFilterPart part[APRS_FILTER_PARTS];
+    char arg[APRS_FILTER_ARGS][APRS_FILTER_ARG_LEN + 1];
+} aprsFilter;
+
+/**
+ * @brief Station position lookup for f/ and t/ with a callsign
+ * @return False if the station or its position is not known
+ */
+typedef bool (*aprsFilterLookup)(const char *call, float *lat, float *lon);
+
+/**
+ * @brief Compile a filter string
+ * @param text Filter like "r/13.75/100.5/50 b/HS1* -t/w", empty for none
+ * @return False if a part was not understood, the other parts are still used
+ */
+bool aprsFilterCompile(aprsFilter *f, const char *text);
+
+/**
+ * @brief True if no filter is set, everything passes then
+ */
+static inline bool aprsFilterEmpty(const aprsFilter *f) { return f->parts == 0; }
+
+/**
+ * @brief Check a packet parsed by ParseAPRS::parse_aprs()
+ * @details srccall_end, dstcall_end and info_start have to point into data, the path is
+ * the text between dstcall_end and info_start.
+ */
+bool aprsFilterMatch(aprsFilter *f, const struct pbuf_t *pb);
+
+/**
+ * @brief Own position for m/
+ */
+void aprsFilterSetHome(float lat, float lon);
+
+/**
+ * @brief Set how f/ and t/ find the position of another station
+ */
+void aprsFilterSetLookup(aprsFilterLookup lookup);
+
+#endif // APRSFILTER_H
@@ -0,0 +1,51 @@
+#ifndef APRSIS_H
+#define APRSIS_H
+
+#include <Arduino.h>
+#include <tnc2.h>
+
+#define APRSIS_TX_BUFFER 1024 // outgoing lines collected for one write
+#define APRSIS_RX_BURST 32    // received lines handled per taskNetwork loop, the rest wait for the next one
+
+typedef struct
+{
+    uint32_t rxLines;     // lines received
+    uint32_t rxBytes;
+    uint32_t rxOverflows; // lines dropped for being longer than TNC2_LINE_MAX
+    uint32_t txLines;     // lines sent
+    uint32_t txBytes;
+    uint32_t txWrites;    // socket writes, several lines share one
+    uint32_t txDropped;   // lines dropped, not connected or write failed
+    uint16_t rxLinesPerSec; // over the last second
+    uint32_t rxBytesPerSec;
+    uint16_t txLinesPerSec;
+    uint32_t txBytesPerSec;
+} aprsIsStats;
+
+/**
+ * @brief Forget a partial line and unsent lines, called for a new connection
+ */
+void aprsIsReset();
+
+/**
+ * @brief Take the next line received from APRS-IS, reading what the socket has without waiting
+ * @param[out] *len Line length without CR LF
+ * @return The line, NUL terminated, valid until the next call. NULL if no complete line is there.
+ */
+char *aprsIsRead(size_t *len);
+
+/**
+ * @brief Queue a line for APRS-IS, CR LF is added
+ * Lines are sent together by the next aprsIsFlush(), the buffer is flushed first if it is full.
+ * @return False if the line was dropped
+ */
+bool aprsIsSend(const char *line, size_t len);
+
+/**
+ * @brief Write all queued lines with one socket write
+ */
+void aprsIsFlush();
+
+void aprsIsGetStats(aprsIsStats *stats);
+
+#endif // APRSIS_H
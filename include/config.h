@@ -13,6 +13,9 @@
 
 #include <Arduino.h>
 #include "sensor.h"
+#include "kisstcp.h"
+#include "agwpe.h"
+#include "aprsfilter.h"
 
 #define COMMENT_SIZE 25
 #define STATUS_SIZE 50
@@ -29,6 +32,10 @@
 #define ACTIVATE_STATUS (1 << 6)		// packet is status
 #define ACTIVATE_WIFI (1 << 7)		// packet is wifi
 
+#define RF_PORT_1 (1 << 0)			// RX port of the TX radio, bit of digi_ports and rf2inet_ports
+#define RF_PORT_2 (1 << 1)			// receive only second radio
+#define RF_PORTS_ALL (RF_PORT_1 | RF_PORT_2)
+
 
 // #include <FS.h>
 // #include <SD.h>
@@ -129,10 +136,12 @@ typedef struct Config_Struct
 	bool igate_en;
 	bool rf2inet;
 	bool inet2rf;
+	uint8_t rf2inet_ports; // RX ports gated to APRS-IS, bit 0 - RF port 1, bit 1 - RF port 2
 	bool igate_loc2rf;
 	bool igate_loc2inet;
 	uint16_t rf2inetFilter;
 	uint16_t inet2rfFilter;
+	char inet2rf_filter[APRS_FILTER_TEXT]; // APRS-IS filter syntax, applied on top of inet2rfFilter, empty for none
 	//--APRS-IS
 	uint8_t aprs_ssid;
 	uint16_t aprs_port;
@@ -160,6 +169,7 @@ typedef struct Config_Struct
 
 	// DIGI REPEATER
 	bool digi_en;
+	uint8_t digi_ports; // RX ports digipeated on the TX radio, bit 0 - RF port 1, bit 1 - RF port 2
 	bool digi_auto;
 	bool digi_loc2rf;
 	bool digi_loc2inet;
@@ -285,6 +295,7 @@ typedef struct Config_Struct
 	bool tx_display = true;
 	bool rx_display = true;
 	uint16_t dispFilter;
+	char disp_filter[APRS_FILTER_TEXT]; // APRS-IS filter syntax for last heard and display, empty for none
 	bool dispRF;
 	bool dispINET;
 
@@ -294,7 +305,15 @@ typedef struct Config_Struct
 	uint8_t preamble;
 	uint8_t modem_type;
 	uint8_t fx25_mode;
+	uint8_t fx25_tag_distance; // bit errors allowed in a received FX.25 correlation tag, 0 - exact match
+	uint8_t modem_demods; // parallel 1200 Bd demodulators, 0 - board default
+	uint16_t modem_fixbits; // CRC recovery attempts per bad frame, 0 - disabled
+	bool rf2_en; // RF port 2: a second, receive only radio on its own ADC input
+	int8_t rf2_adc_gpio = -1;
+	uint8_t rf2_modem_type;
+	bool rf2_audio_lpf;
 	uint16_t tx_timeslot;
+	uint16_t tx_burst_time; // max airtime of one transmission in ms, frames queued beyond it wait for the next one
 	char ntp_host[20];
 
 	// VPN wiregurad
@@ -389,6 +408,11 @@ typedef struct Config_Struct
 	bool ext_tnc_enable = false;
 	int8_t ext_tnc_channel = 0;
 	int8_t ext_tnc_mode = 0;
+	bool kiss_tcp_en = false; // KISS over TCP for network clients, applied after restart
+	uint16_t kiss_tcp_port = KISS_TCP_PORT;
+	char kiss_tcp_filter[APRS_FILTER_TEXT] = ""; // APRS-IS filter syntax for frames sent to KISS clients, empty for all
+	bool agw_en = false; // AGWPE server for network clients, applied after restart
+	uint16_t agw_port = AGW_TCP_PORT;
 
 	// Sleep mode
 	bool pwr_en;
@@ -465,6 +489,7 @@ typedef struct Config_Struct
 	uint16_t mqtt_port;
 	uint16_t mqtt_topic_flag;
 	uint16_t mqtt_subscribe_flag;
+	char mqtt_filter[APRS_FILTER_TEXT]; // APRS-IS filter syntax for packets published, empty for all
 #endif
 
 	uint8_t trk_mice_type;
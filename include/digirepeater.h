@@ -2,6 +2,15 @@
 #define DIGIREPEATER_H
 
 #include <AX25.h>
+#include <dupecheck.h>
+
+// A packet is repeated once per window, copies heard back from other digipeaters are dropped
+#define DIGI_DUPE_WINDOW_MS 30000
+#ifdef BOARD_HAS_PSRAM
+#define DIGI_DUPE_ENTRIES 1024
+#else
+#define DIGI_DUPE_ENTRIES 256
+#endif
 
 int digiProcess(AX25Msg &Packet);
 
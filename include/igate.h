@@ -4,19 +4,18 @@
 #include <LibAPRSesp.h>
 #include <WiFiClient.h>
 #include <AX25.h>
+#include <dupecheck.h>
 #include "main.h"
 
-// Duplicate packet detection
-#define DUP_PACKET_CACHE_SIZE 10
-#define DUP_PACKET_TIMEOUT_MS 30000  // 30 seconds
-
-struct DupPacketCache {
-    char hash[16];
-    unsigned long timestamp;
-};
+// Duplicate packet detection, a packet is gated once per window whatever path it was heard on
+#define IGATE_DUPE_WINDOW_MS 30000  // 30 seconds, as aprsc
+#ifdef BOARD_HAS_PSRAM
+#define IGATE_DUPE_ENTRIES 4096     // 100 packets/s for the whole window
+#else
+#define IGATE_DUPE_ENTRIES 512
+#endif
 
 int igateProcess(AX25Msg &Packet);
 bool isDuplicatePacket(AX25Msg &Packet);
-void clearExpiredDuplicates(void);
 
 #endif
\ No newline at end of file
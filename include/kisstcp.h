@@ -0,0 +1,44 @@
+#ifndef KISSTCP_H
+#define KISSTCP_H
+
+#include <Arduino.h>
+
+#define KISS_TCP_PORT 8001          // default port, the one used by Dire Wolf and most KISS TNC software
+#define KISS_TCP_MAX_CLIENTS 4      // connections over this are refused
+#define KISS_TCP_CLIENT_QUEUE 8     // frames waiting for socket space per client, a client that falls further behind is dropped
+#define KISS_TCP_RX_QUEUE 4         // frames from clients waiting for the APRS task to send them on RF
+
+typedef struct
+{
+    uint8_t clients;    // connected now
+    uint32_t accepted;  // connections accepted
+    uint32_t refused;   // connections refused, all client slots in use
+    uint32_t frames;    // RF frames offered to the clients
+    uint32_t poolFails; // RF frames not sent to any client, no free frame buffer
+    uint32_t slow;      // clients dropped for not keeping up
+    uint32_t rxFrames;  // frames received from clients
+    uint32_t rxDropped; // frames from clients dropped, RX queue full
+} kissTcpStats;
+
+/**
+ * @brief Start listening for KISS clients
+ * @return False if the server could not be created
+ */
+bool kissTcpBegin(uint16_t port);
+
+/**
+ * @brief Send a received AX.25 frame to every client
+ * The frame is KISS encoded once into a shared buffer, each client queue only holds a reference to it.
+ * Never waits for a client: a client whose queue is full is disconnected.
+ * @param ax25 AX.25 frame without the FCS
+ */
+void kissTcpBroadcast(const uint8_t *ax25, size_t len);
+
+/**
+ * @brief Hand the frames received from clients to the AX.25 TX buffer, called by the APRS task
+ */
+void kissTcpPoll();
+
+void kissTcpGetStats(kissTcpStats *stats);
+
+#endif // KISSTCP_H
@@ -16,9 +16,17 @@
 
 #include <Arduino.h>
 #include <AX25.h>
+#include <fx25.h>
 #include "weather.h"
 
 #include "config.h"
+#include "txqueue.h"
+#include "kisstcp.h"
+#include "agwpe.h"
+#include <dupecheck.h>
+#include <stationdb.h>
+#include "aprsis.h"
+#include "pktbuf.h"
 // #if defined(TTGO_T_Beam_S3_SUPREME_V3)  || defined(HELTEC_V3_GPS) || defined(HELTEC_HTIT_TRACKER) || defined(APRS_LORA_HT) || defined(APRS_LORA_DONGLE)
 // #else
 // #include "soc/rtc_wdt.h"
@@ -82,13 +90,27 @@
 #ifdef BOARD_HAS_PSRAM
 #define TLMLISTSIZE 100
 #define PKGLISTSIZE 30
+#define STATIONLISTSIZE 2048 // stations kept in pkgList, the most recent PKGLISTSIZE are listed
+#define PKTBUF_SMALL_COUNT 1600 // packet buffers of each size class, about 3 of 4 packets fit a small one
+#define PKTBUF_MEDIUM_COUNT 800
+#define PKTBUF_LARGE_COUNT 64
 #define PKGTXSIZE 10
+#define INET2RF_DUPE_ENTRIES 1024
 #else
 #define TLMLISTSIZE 5
 #define PKGLISTSIZE 20
+#define STATIONLISTSIZE PKGLISTSIZE
+#define PKTBUF_SMALL_COUNT 24
+#define PKTBUF_MEDIUM_COUNT 16
+#define PKTBUF_LARGE_COUNT 4
 #define PKGTXSIZE 5
+#define INET2RF_DUPE_ENTRIES 256
 #endif
 
+#define APRS_TASK_IDLE_MS 100 // longest taskAPRS sleep when nothing is pending, frames and TX packets wake it earlier
+#define TX_BURST_WINDOW_MS 1000 // RF packets due this soon are sent in the same transmission as a packet due now
+#define INET2RF_DUPE_WINDOW_MS 30000 // an APRS-IS packet goes to RF once in this time
+
 #define LOG_NONE 0
 #define LOG_TRACKER (1 << 0)
 #define LOG_IGATE (1 << 1)
@@ -131,6 +153,11 @@
 #define INET_CHANNEL	(1<<1)
 #define TNC_CHANNEL	(1<<2)
 
+// Where a pkgList entry was last heard
+#define PKG_CHANNEL_RF	0
+#define PKG_CHANNEL_INET	1
+#define PKG_CHANNEL_RF2	2
+
 #ifdef TTGO_TWR
 #define MIC_CTRL_PIN (17)
 
@@ -258,7 +285,7 @@ typedef struct
 	char calsign[11];
 	char object[10];
 	char ssid[5];
-	bool channel;
+	uint8_t channel;
 	unsigned int pkg;
 	uint16_t type;
 	uint8_t symbol;
@@ -327,16 +354,6 @@ typedef struct Telemetry_struct
 	bool EQNS_FLAG;
 } TelemetryType;
 
-typedef struct txQueue_struct
-{
-	bool Active;
-	uint8_t Channel;
-	long timeStamp;
-	int Delay;
-	size_t length;
-	char Info[350];
-} txQueueType;
-
 typedef struct txDispStruct
 {
 	uint8_t tx_ch;
@@ -423,21 +440,20 @@ void taskAPRS(void *pvParameters);
 void taskAPRSPoll(void *pvParameters);
 void taskNetwork(void *pvParameters);
 //void taskTNC(void *pvParameters);
-void sort(pkgListType a[], int size);
-void sortPkgDesc(pkgListType a[], int size);
 //int processPacket(String &tnc2);
 int digiProcess(AX25Msg &Packet);
 void printTime();
 int popTNC2Raw(int &ret);
 int pushTNC2Raw(int raw);
-//int pkgListUpdate(char *call, char *raw, uint16_t type, bool channel, uint16_t audioLvl);
+//int pkgListUpdate(char *call, char *raw, uint16_t type, uint8_t channel, uint16_t audioLvl);
 int pkgList_Find(char *call,char *object, uint16_t type);
 int pkgList_Find(char *call, uint16_t type);
-int pkgList_Find(char *call);
 pkgListType getPkgList(int idx);
+int pkgListView(int *idx, int max, enum StationDbOrder order);
+int pkgListStep(int idx, bool older);
 //String myBeacon(String Path);
 int tlmList_Find(char *call);
-int tlmListOld();
+int tlmListUpdate(const char *call);
 TelemetryType getTlmList(int idx);
 //void powerSave();
 //void powerWakeup();
@@ -445,7 +461,11 @@ TelemetryType getTlmList(int idx);
 int packet2Raw(String &tnc2, AX25Msg &Packet);
 //bool waitResponse(String &data, String rsp = "\r\n", uint32_t timeout = 1000);
 //String sendIsAckMsg(String toCallSign, char *msgId);
-bool pkgTxPush(const char *info, size_t len, int dly,uint8_t Ch);
+bool pkgTxPush(const char *info, size_t len, int dly,uint8_t Ch, uint8_t prio = TX_PRIO_BEACON);
+void aprsTaskNotify();
+bool inet2rfDuplicate(const char *line, size_t len);
+void aprsFiltersUpdate();
+bool pbufParseTnc2(struct pbuf_t *pb, const char *line, size_t len);
 //bool pkgTxUpdate(const char *info, int delay);
 void dispWindow(String line, uint8_t mode, bool filter);
 void dispTxWindow(txDisp txs);
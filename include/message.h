@@ -30,7 +30,7 @@ String aesDecryptBase64WithIV(const String &b64, const uint8_t key[16], const ch
 void sendAPRSMessage(const String &toCall, const String &message, bool encrypt);
 void handleIncomingAPRS(const String& line);
 void sendAPRSMessageRetry();
-void pkgMsgSort(msgType a[]);
+int pkgMsgView(int *idx, int max);
 // void processMessage(const char* message);
 // void sendMessage(const char* message);
 
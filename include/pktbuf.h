@@ -0,0 +1,62 @@
+#ifndef PKTBUF_H
+#define PKTBUF_H
+
+#include <Arduino.h>
+#include "pbuf.h"
+
+#define PKTBUF_CLASSES 3 // PACKETLEN_MAX_SMALL, PACKETLEN_MAX_MEDIUM and PACKETLEN_MAX_LARGE bytes, the NUL included
+
+typedef struct
+{
+    uint16_t size;   // bytes per buffer
+    uint16_t count;  // buffers in the class
+    uint16_t used;   // in use now
+    uint16_t peak;   // most ever in use at the same time
+    uint32_t allocs; // buffers handed out
+    uint32_t spills; // handed out for a shorter packet because the smaller classes were full
+    uint32_t fails;  // packets of this class that found no free buffer here or in a larger class
+} pktPoolStats;
+
+/**
+ * @brief Allocate the buffers of every class, PSRAM is used when available
+ * @details Called once before any task uses the pool. Buffers are never given back to the
+ * heap, so a long running IGate does not fragment it.
+ * @param counts Buffers of each class, smallest first
+ */
+bool pktPoolInit(const uint16_t counts[PKTBUF_CLASSES]);
+
+/**
+ * @brief Take a buffer for a packet of len bytes plus the NUL, with one reference
+ * @return NULL if no class that fits has a free buffer
+ */
+char *pktBufAlloc(size_t len);
+
+/**
+ * @brief Copy a packet into a new buffer, NUL terminated
+ */
+char *pktBufDup(const char *data, size_t len);
+
+/**
+ * @brief Add a reference, for another holder of the same packet
+ * @return The buffer, NULL stays NULL
+ */
+char *pktBufRef(char *buf);
+
+/**
+ * @brief Drop a reference, the buffer is free again after the last one. NULL is ignored.
+ */
+void pktBufRelease(char *buf);
+
+/**
+ * @brief True if the text lies in a pool buffer, so it can be shared with pktBufRef()
+ */
+bool pktBufOwns(const char *buf);
+
+/**
+ * @brief Bytes a buffer can hold, the NUL included
+ */
+size_t pktBufSize(const char *buf);
+
+void pktPoolGetStats(pktPoolStats stats[PKTBUF_CLASSES]);
+
+#endif // PKTBUF_H
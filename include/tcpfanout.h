@@ -0,0 +1,102 @@
+#ifndef TCPFANOUT_H
+#define TCPFANOUT_H
+
+#include <Arduino.h>
+
+class AsyncServer;
+class AsyncClient;
+
+#define TCP_FANOUT_QUEUE_MAX 16 // longest client queue
+
+/**
+ * @brief Message in the pool of a server, shared by every client queue it is in
+ */
+typedef struct
+{
+    uint16_t length;
+    uint8_t refs;  // holders, free when 0
+    uint8_t *data; // messageSize bytes
+} tcpFanoutMessage;
+
+struct tcpFanout;
+
+typedef struct
+{
+    struct tcpFanout *server;
+    AsyncClient *client; // NULL when the slot is free
+    uint8_t slot;
+    uint8_t queue[TCP_FANOUT_QUEUE_MAX];
+    uint8_t head;
+    uint8_t count;
+    uint16_t offset; // bytes of the head message already written to the socket
+    bool drop;       // being disconnected, takes no more messages
+} tcpFanoutClient;
+
+/**
+ * @brief What a server built on the fan-out supplies, the callbacks run in the TCP task
+ */
+typedef struct
+{
+    const char *name;     // for the log
+    uint8_t maxClients;   // connections over this are refused
+    uint8_t queueLen;     // messages waiting for socket space per client, up to TCP_FANOUT_QUEUE_MAX
+    uint8_t messages;     // pool size, the client queues plus the messages being built
+    uint16_t messageSize; // longest message
+    void (*onConnect)(void *arg, uint8_t slot);                                   // a client took a slot, reset its state
+    void (*onData)(void *arg, uint8_t slot, const uint8_t *data, size_t len);    // bytes from a client
+    void *arg;
+} tcpFanoutConfig;
+
+/**
+ * @brief TCP server sending the same messages to many clients without waiting for any of them
+ * @details A message is built once into a pool buffer and every client queue only holds its
+ * index. The buffer is free again when the last client has copied it into its socket. A client
+ * whose queue is full has stopped reading: its messages are given back and it is disconnected,
+ * it never holds the sender back. Queuing writes what the socket takes in the caller's task.
+ * Zero initialized until tcpFanoutBegin().
+ */
+typedef struct tcpFanout
+{
+    tcpFanoutConfig cfg;
+    AsyncServer *server;
+    tcpFanoutMessage *messages;
+    tcpFanoutClient *clients;
+    SemaphoreHandle_t mutex; // guards the pool and the queues, servers use it for their own state too
+    uint8_t clientCount;     // connected now
+    uint32_t accepted;
+    uint32_t refused;        // all client slots in use
+    uint32_t slow;           // dropped for not keeping up
+} tcpFanout;
+
+/**
+ * @brief Allocate the pool and the client slots and start listening
+ * @return False if the server could not be created
+ */
+bool tcpFanoutBegin(tcpFanout *f, const tcpFanoutConfig *cfg, uint16_t port);
+
+/**
+ * @brief Take the server lock, the functions below expect it held. Nothing happens before tcpFanoutBegin().
+ */
+void tcpFanoutLock(tcpFanout *f);
+void tcpFanoutUnlock(tcpFanout *f);
+
+/**
+ * @brief Take a free pool buffer, held once by the caller until tcpFanoutRelease()
+ * @return NULL if the pool is empty
+ */
+tcpFanoutMessage *tcpFanoutAlloc(tcpFanout *f);
+
+void tcpFanoutRelease(tcpFanout *f, tcpFanoutMessage *m);
+
+/**
+ * @brief True if a client is connected on the slot and not being dropped
+ */
+bool tcpFanoutActive(const tcpFanout *f, uint8_t slot);
+
+/**
+ * @brief Queue a message for a client and write what the socket takes
+ * @return False if the slot has no active client, or the client was dropped because its queue is full
+ */
+bool tcpFanoutQueue(tcpFanout *f, uint8_t slot, tcpFanoutMessage *m);
+
+#endif // TCPFANOUT_H
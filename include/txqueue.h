@@ -0,0 +1,80 @@
+#ifndef TXQUEUE_H
+#define TXQUEUE_H
+
+#include <Arduino.h>
+
+// Priority classes, a lower value is sent first when several packets are due
+#define TX_PRIO_DIGI 0   // digipeated frames
+#define TX_PRIO_MSG 1    // messages, acks and traffic gated to RF
+#define TX_PRIO_BEACON 2 // own position, status and object beacons
+#define TX_PRIO_TLM 3    // telemetry and weather reports
+#define TX_PRIO_COUNT 4
+
+#define TX_QUEUE_CHANNELS 3          // one queue for each of RF_CHANNEL, INET_CHANNEL and TNC_CHANNEL
+#define TX_QUEUE_INFO_SIZE 350       // longest TNC2 packet that can be queued
+#define TX_QUEUE_EXPIRE_MS 60000     // packets still waiting this long after they were due are dropped
+
+typedef struct
+{
+    uint32_t queued;   // packets accepted
+    uint32_t sent;     // packets handed to a channel, once per channel
+    uint32_t dropped;  // rejected or evicted by a higher class while the queue was full
+    uint32_t expired;  // not sent within TX_QUEUE_EXPIRE_MS of the due time
+    uint32_t replaced; // removed by txQueueCancel(), e.g. a digipeat renewed by a newer copy
+    uint32_t delaySum; // total ms from due time to send, for the average queue delay
+    uint32_t delayMax; // longest ms from due time to send
+} txQueueClassStats;
+
+typedef struct
+{
+    txQueueClassStats cls[TX_PRIO_COUNT];
+    uint16_t used; // slots holding a packet
+    uint16_t peak; // most slots ever used
+    uint16_t size; // slot count
+} txQueueStats;
+
+/**
+ * @brief Allocate the packet slots, PSRAM is used when available
+ * @param size Number of packets that can wait at the same time
+ */
+bool txQueueInit(uint16_t size);
+
+/**
+ * @brief Queue a TNC2 packet for one or more channels
+ * When all slots are in use, the newest packet of the lowest class below prio is evicted,
+ * otherwise the new packet is rejected. Either way the drop is counted and logged.
+ * @param info TNC2 packet, it is copied
+ * @param dly Delay in ms before the packet is due on RF, INET and TNC take it immediately
+ * @param ch Channel mask, RF_CHANNEL | INET_CHANNEL | TNC_CHANNEL
+ * @param prio TX_PRIO_xxx class
+ * @return False if the packet was dropped
+ */
+bool txQueuePush(const char *info, size_t len, int dly, uint8_t ch, uint8_t prio);
+
+/**
+ * @brief Take the next due packet of a channel, highest class first, earliest due time within a class
+ * @param ch One of RF_CHANNEL, INET_CHANNEL, TNC_CHANNEL
+ * @param[out] info Packet copy, NUL terminated
+ * @param size Size of the info buffer
+ * @param ahead Also take packets due within this many ms, to join a transmission that is starting anyway
+ * @return Packet length, 0 if nothing is due
+ */
+size_t txQueuePop(uint8_t ch, char *info, size_t size, uint32_t ahead = 0);
+
+/**
+ * @brief Drop the packets of a channel that have been due for longer than TX_QUEUE_EXPIRE_MS
+ * Called for channels that cannot send right now, so their packets do not hold slots forever.
+ * @param all Drop every packet of the channel, not just the expired ones (channel disabled)
+ */
+void txQueueExpire(uint8_t ch, bool all);
+
+/**
+ * @brief Remove the first packet of a channel accepted by match()
+ * @return True if a packet was removed
+ */
+bool txQueueCancel(uint8_t ch, bool (*match)(const char *info, size_t len, uint8_t channels, void *arg), void *arg);
+
+int txQueueCount();
+void txQueueGetStats(txQueueStats *stats);
+
+#endif // TXQUEUE_H
@@ -1,5 +1,6 @@
 
 #include <Arduino.h>
+#include <atomic>
 #include "AFSK.h"
 #include "esp_log.h"
 #include "esp_adc/adc_oneshot.h"
@@ -27,6 +28,13 @@
 #include "driver/sigmadelta.h"
 
 #include "esp_dsp.h"
+
+// TX audio is rendered ahead and streamed by I2S PDM DMA where the chip supports it,
+// define AFSK_TX_ISR to go back to the per-sample DAC timer interrupt
+#if SOC_I2S_SUPPORTS_PDM_TX && !defined(I2S_INTERNAL) && !defined(AFSK_TX_ISR)
+#define AFSK_TX_DMA
+#include "driver/i2s_pdm.h"
+#endif
 #include <dsps_fir.h>
 #ifdef CONFIG_IDF_TARGET_ESP32C3
 #include <esp32c3/rom/crc.h>
@@ -37,6 +45,7 @@
 #endif
 
 #include "modem.h"
+#include "decimator.h"
 
 #include "fx25.h"
 
@@ -92,14 +101,13 @@ hw_timer_t *timer_adc = NULL;
 
 static int Vref = 950;
 
-#define FILTER_TAPS 8 // Number of taps in the FIR filter
 uint16_t SAMPLERATE = 38400;
 // Resampling configuration
 #define INPUT_RATE 38400
 #define OUTPUT_RATE 9600
 uint16_t RESAMPLE_RATIO = (SAMPLERATE / OUTPUT_RATE); // 38400/9600 = 3
 uint16_t BLOCK_SIZE = (SAMPLERATE / 50);              // Must be multiple of resample ratio
-float *audio_buffer = NULL;
+int16_t *audio_buffer = NULL; // DC-free, AGC-scaled 12-bit samples, decimated in place
 
 // AGC configuration
 #define AGC_TARGET_RMS 0.2f // Target RMS level (-10dBFS)
@@ -125,111 +133,123 @@ extern float markFreq;  // mark frequency
 extern float spaceFreq; // space freque
 extern float baudRate;  // baudrate
 
-/****************** Ring Buffer gen from DeepSeek *********************/
-//#if defined(CONFIG_IDF_TARGET_ESP32S3)
-#define BUFFER_SIZE 1500
-// #else
-// #define BUFFER_SIZE 770
-// #endif
-
-// Guards fifo.head/tail/count between the ADC ISR (producer) and AFSK_Poll (consumer).
-// count-- in RingBuffer_Pop() is a non-atomic read-modify-write; without a spinlock shared
-// with the ISR's count++, the ISR can preempt mid-update and the decrement is lost. Over
-// long uptime (ISR runs up to ~38.4kHz) this drifts fifo.count away from the real buffer
-// occupancy until RingBuffer_Size() never reaches BLOCK_SIZE again and RX permanently stalls.
-static portMUX_TYPE fifoMux = portMUX_INITIALIZER_UNLOCKED;
+/****************** ADC sample ring *********************/
+// Single-producer/single-consumer ring between the ADC callback (producer) and AFSK_Poll (consumer).
+// head is only written by the producer and tail only by the consumer; both are free-running
+// counters, so the fill level is always head - tail and cannot drift, and no lock is needed.
+#define BUFFER_SIZE 2048 // must be a power of two
+#define BUFFER_MASK (BUFFER_SIZE - 1)
 
 typedef struct
 {
-  int16_t buffer[BUFFER_SIZE]; // Buffer to store int16_t data
-  int head;                    // Index for the next write
-  int tail;                    // Index for the next read
-  int count;                   // Number of elements in the buffer
-  bool lock;
+  int16_t buffer[BUFFER_SIZE];
+  std::atomic<uint32_t> head; // total samples written
+  std::atomic<uint32_t> tail; // total samples consumed
+  volatile uint32_t overruns;  // samples dropped because the ring was full
+  volatile uint32_t underruns; // pop requests that found less than asked for
 } RingBuffer;
 
-// Initialize the ring buffer
-void IRAM_ATTR RingBuffer_Init(RingBuffer *rb)
+// Initialize the ring buffer, only while the producer is stopped
+void RingBuffer_Init(RingBuffer *rb)
 {
-  rb->head = 0;
-  rb->tail = 0;
-  rb->count = 0;
-  rb->lock = false;
+  rb->head.store(0, std::memory_order_relaxed);
+  rb->tail.store(0, std::memory_order_relaxed);
+  rb->overruns = 0;
+  rb->underruns = 0;
 }
 
-// Check if the buffer is full
-bool IRAM_ATTR RingBuffer_IsFull(const RingBuffer *rb)
-{
-  return rb->count == BUFFER_SIZE;
-}
-
-// Check if the buffer is empty
-bool IRAM_ATTR RingBuffer_IsEmpty(const RingBuffer *rb)
+// Get the number of elements in the buffer
+static inline uint32_t IRAM_ATTR RingBuffer_Size(const RingBuffer *rb)
 {
-  return rb->count == 0;
+  return rb->head.load(std::memory_order_acquire) - rb->tail.load(std::memory_order_acquire);
 }
 
-// Add an element to the buffer (push)
-bool IRAM_ATTR RingBuffer_Push(RingBuffer *rb, int16_t data)
+// Add an element to the buffer (producer side)
+static inline bool IRAM_ATTR RingBuffer_Push(RingBuffer *rb, int16_t data)
 {
-  if (RingBuffer_IsFull(rb))
+  uint32_t head = rb->head.load(std::memory_order_relaxed);
+  if ((head - rb->tail.load(std::memory_order_acquire)) >= BUFFER_SIZE)
   {
+    rb->overruns++;
     return false; // Buffer is full
   }
-  rb->lock = true;
-  if (rb->head >= BUFFER_SIZE || rb->head < 0)
-    rb->head = 0; // Check if head exceeds buffer size
-  rb->buffer[rb->head] = data;
-  rb->head = (rb->head + 1) % BUFFER_SIZE; // Wrap around using modulo
-  rb->count++;
-  rb->lock = false;
+  rb->buffer[head & BUFFER_MASK] = data;
+  rb->head.store(head + 1, std::memory_order_release);
   return true;
 }
 
-// Remove an element from the buffer (pop)
-bool IRAM_ATTR RingBuffer_Pop(RingBuffer *rb, int16_t *data)
+// Get a contiguous span of up to max samples (consumer side), the span stays valid until RingBuffer_Release()
+static inline size_t RingBuffer_PopN(RingBuffer *rb, const int16_t **span, size_t max)
 {
-  if (RingBuffer_IsEmpty(rb))
-  {
-    return false; // Buffer is empty
-  }
-  int to = 0;
-  while (rb->lock) // Wait until the buffer is not locked
+  uint32_t tail = rb->tail.load(std::memory_order_relaxed);
+  uint32_t available = rb->head.load(std::memory_order_acquire) - tail;
+  if (available < max)
   {
-    delay(1); // Avoid busy-waiting, adjust as needed
-    if (to++ > 100)
-      return false; // Timeout after 1 second
+    rb->underruns++;
+    max = available;
   }
-  // Actual read + count-- must be mutually exclusive with the ISR's count++
-  // (same spinlock the producer side uses), otherwise this non-atomic
-  // read-modify-write can lose an update if the ISR fires mid-decrement.
-  portENTER_CRITICAL(&fifoMux);
-  if (rb->count == 0) // defensive re-check now that we hold the lock
-  {
-    portEXIT_CRITICAL(&fifoMux);
-    return false;
-  }
-  if (rb->tail >= BUFFER_SIZE || rb->tail < 0)
-    rb->tail = 0; // Check if tail exceeds buffer size
-  *data = rb->buffer[rb->tail];
-  rb->tail = (rb->tail + 1) % BUFFER_SIZE; // Wrap around using modulo
-  rb->count--;
-  portEXIT_CRITICAL(&fifoMux);
-  return true;
+  uint32_t toEnd = BUFFER_SIZE - (tail & BUFFER_MASK);
+  if (max > toEnd)
+    max = toEnd;
+  *span = &rb->buffer[tail & BUFFER_MASK];
+  return max;
 }
 
-// Get the number of elements in the buffer
-int IRAM_ATTR RingBuffer_Size(const RingBuffer *rb)
+// Return n samples obtained with RingBuffer_PopN() to the producer
+static inline void RingBuffer_Release(RingBuffer *rb, size_t n)
+{
+  rb->tail.store(rb->tail.load(std::memory_order_relaxed) + n, std::memory_order_release);
+}
+
+// Drop everything the producer has written so far (consumer side)
+static inline void RingBuffer_Flush(RingBuffer *rb)
 {
-  return rb->count;
+  rb->tail.store(rb->head.load(std::memory_order_acquire), std::memory_order_release);
 }
 
 RingBuffer fifo; // Declare a ring buffer statically (this will be in DRAM, but functions are in IRAM)
+RingBuffer fifo2; // samples of the second RX port, demultiplexed from the same ADC pattern
+
+static std::atomic<bool> fifoFlushRequest(false);
 
-// Flush the ADC FIFO — called from ModemTransmitStop() to discard stale samples
+// Flush the ADC FIFO — called from ModemTransmitStop() to discard stale samples.
+// Only the consumer may move tail, so this just asks AFSK_Poll() to drop the samples on its next call.
 void IRAM_ATTR AFSK_FlushFifo(void)
 {
-  RingBuffer_Init(&fifo);
+  fifoFlushRequest.store(true, std::memory_order_release);
+}
+
+void AFSK_GetFifoStats(uint32_t *overruns, uint32_t *underruns)
+{
+  *overruns = fifo.overruns + fifo2.overruns;
+  *underruns = fifo.underruns + fifo2.underruns;
+}
+
+static TaskHandle_t pollTask = NULL; // task blocked in AFSK_WaitForSamples(), woken by the ADC callbacks
+
+// Wake the poll task from the ADC callback (ISR context)
+static inline void IRAM_ATTR AFSK_NotifyPoll(BaseType_t *mustYield)
+{
+  if (pollTask != NULL)
+    vTaskNotifyGiveFromISR(pollTask, mustYield);
+}
+
+// Block the calling task until the ADC ring holds a full block, replaces a fixed polling delay before AFSK_Poll()
+void AFSK_WaitForSamples(void)
+{
+#ifndef I2S_INTERNAL
+  if (pollTask == NULL)
+    pollTask = xTaskGetCurrentTaskHandle();
+  // during TX the ring is neither filled nor drained, so only sleep then
+  if (!hw_afsk_dac_isr && (RingBuffer_Size(&fifo) >= BLOCK_SIZE))
+    return;
+  TickType_t timeout = portMAX_DELAY;
+#ifdef ADC_SAMPLE
+  if (_sql_pin > -1)
+    timeout = 10 / portTICK_PERIOD_MS; // the ADC is stopped while the squelch is closed, keep polling the SQL pin
+#endif
+  ulTaskNotifyTake(pdTRUE, timeout);
+#endif
 }
 /******************************************************************** */
 
@@ -330,60 +350,52 @@ void LED_Status2(uint8_t r, uint8_t g, uint8_t b)
   // portEXIT_CRITICAL_ISR(&ledMux);
 }
 
-// const float resample_coeffs[FILTER_TAPS] = {
-//   -0.001296,  -0.005406,  -0.012387,  -0.010745,  0.020421,  0.090370,  0.178421,  0.240624,  0.240624,  0.178421,  0.090370,  0.020421,  -0.010745,  -0.012387,  -0.005406,  -0.001296
-// };
-// Filter coefficients (designed for 38400→9600 resampling)
-// cutoff = 4800  # Nyquist for 9600Hz
-const float resample_coeffs[FILTER_TAPS] = {
-    0.003560, 0.038084, 0.161032, 0.297324, 0.297324, 0.161032, 0.038084, 0.003560};
-// Filter instance and buffers
-fir_f32_t resample_fir;
-// float input_buffer[BLOCK_SIZE] = {0};
-// float output_buffer[BLOCK_SIZE / RESAMPLE_RATIO] = {0};
-// float filter_state[FILTER_TAPS + BLOCK_SIZE - 1] = {0};
-void resample_audio(float *input_buffer)
-{
-  // Apply anti-aliasing filter and decimate
-  for (int i = 0; i < BLOCK_SIZE / RESAMPLE_RATIO; i++)
-  {
-    float sum = 0;
-    for (int j = 0; j < FILTER_TAPS; j++)
-    {
-      int index = i * RESAMPLE_RATIO + j;
-      if (index < BLOCK_SIZE)
-      {
-        sum += input_buffer[index] * resample_coeffs[j];
-      }
-    }
-    input_buffer[i] = sum;
-  }
-}
-
-// AGC state
-float agc_gain = 1.0f;
-
 tcb_t tcb;
+tcb_t tcb2; // DC average and carrier level of the second RX port
+
+// Receive chain of one audio input. Port 0 is the radio that also transmits,
+// port 1 an optional second receiver sampled in the same ADC pattern.
+typedef struct
+{
+  RingBuffer *fifo;
+  tcb_t *tp;
+  struct Decimator decimator; // anti-aliasing filter and decimation to the modem rate, state is kept across blocks
+  uint16_t ratio;             // ADC rate / modem rate
+  enum ModemType modem;
+  float agcGain;
+  int32_t agcGainQ12; // agcGain in Q12, applied per sample
+  int offset;         // DC offset in mV
+  int mVrms;
+  uint8_t dcdCount;
+} AfskRxPort;
+
+static AfskRxPort rxPorts[MODEM_MAX_PORTS] = {
+    {&fifo, &tcb, {}, 1, MODEM_1200, 1.0f, 4096, 0, 0, 0},
+    {&fifo2, &tcb2, {}, 1, MODEM_1200, 1.0f, 4096, 0, 0, 0},
+};
+static uint8_t rxPortCount = 1;
+
+// Second RX port setup, see afskSetPort2()
+static int8_t rx2Pin = -1;
+static uint8_t rx2Modem = 1;
+static bool rx2Bpf = false;
 
 // Audio processing
 volatile bool new_samples = false;
 
-float update_agc(float *input_buffer, size_t len)
+// Update AGC gain of a port once per block from the sum of squares of the scaled 12-bit samples
+float update_agc(AfskRxPort *rp, int64_t sum_sq, size_t len)
 {
   // Calculate RMS of current block
-  float sum_sq = 0;
-  for (int i = 0; i < len; i++)
-  {
-    sum_sq += input_buffer[i] * input_buffer[i];
-  }
-  float rms = sqrtf(sum_sq / len);
+  float rms = sqrtf((float)sum_sq / (float)len) / 2048.0f;
 
   // Adjust gain based on RMS level
   float error = AGC_TARGET_RMS / (rms + 1e-6f);
   float rate = (error < 1.0f) ? AGC_RELEASE : AGC_ATTACK;
-  agc_gain = agc_gain * (1.0f - rate) + (agc_gain * error) * rate;
-  agc_gain = fmaxf(fminf(agc_gain, AGC_MAX_GAIN), AGC_MIN_GAIN);
-  return agc_gain;
+  rp->agcGain = rp->agcGain * (1.0f - rate) + (rp->agcGain * error) * rate;
+  rp->agcGain = fmaxf(fminf(rp->agcGain, AGC_MAX_GAIN), AGC_MIN_GAIN);
+  rp->agcGainQ12 = (int32_t)(rp->agcGain * 4096.0f);
+  return rp->agcGain;
 }
 
 #define AX25_FLAG 0x7e
@@ -716,19 +728,17 @@ void IRAM_ATTR sample_adc_isr()
   adcIsrCount++;
   if (!hw_afsk_dac_isr)
   {
-    fifo.lock = true;
     // digitalWrite(15,HIGH);
-    portENTER_CRITICAL_ISR(&fifoMux); // ISR start - same lock RingBuffer_Pop() uses
     int16_t adc = analogReadMilliVolts(adc_pins[0]);
-
-    // RingBuffer_Push(&fifo, adc);
-    // if(fifo.head >= BUFFER_SIZE || fifo.head < 0) fifo.head = 0; // Check if head exceeds buffer size
-    fifo.buffer[fifo.head] = adc;
-    fifo.head = (fifo.head + 1) % BUFFER_SIZE; // Wrap around using modulo
-    fifo.count++;
-    portEXIT_CRITICAL_ISR(&fifoMux); // ISR end
+    RingBuffer_Push(&fifo, adc);
+    if ((fifo.head.load(std::memory_order_relaxed) % BLOCK_SIZE) == 0) // a block is complete
+    {
+      BaseType_t mustYield = pdFALSE;
+      AFSK_NotifyPoll(&mustYield);
+      if (mustYield == pdTRUE)
+        portYIELD_FROM_ISR();
+    }
     // digitalWrite(15,LOW);
-    fifo.lock = false;
   }
 }
 #else
@@ -753,7 +763,6 @@ void AFSK_TimerEnable(bool sts)
   {
 
 #ifdef ADC_SAMPLE
-    RingBuffer_IsEmpty(&fifo);
     timerStart(timer_adc);
 #else
     //   timerAlarmEnable(timer);
@@ -795,8 +804,24 @@ SemaphoreHandle_t xI2CSemaphore;
 
 #define DEFAULT_SEMAPHORE_TIMEOUT 10
 
+#ifdef AFSK_TX_DMA
+static TaskHandle_t txTask = NULL; // AFSK_TxTask(), renders and streams the TX audio
+#endif
+static volatile uint32_t txDmaFallbacks = 0; // transmissions sent by the DAC timer because the I2S channel could not be opened
+
 void DAC_TimerEnable(bool sts)
 {
+#ifdef AFSK_TX_DMA
+  // TX audio is streamed by AFSK_TxTask() which also ends the transmission,
+  // the DAC timer only runs when the task could not open its I2S channel
+  if (sts)
+  {
+    if (txTask != NULL)
+      xTaskNotifyGive(txTask);
+    dacEn = 0;
+    return;
+  }
+#endif
   if (timer_dac == NULL)
     return;
   portENTER_CRITICAL_ISR(&timerMux);
@@ -812,6 +837,11 @@ void DAC_TimerEnable(bool sts)
   dacEn = 0;
 }
 
+void AFSK_GetTxStats(uint32_t *dmaFallbacks)
+{
+  *dmaFallbacks = txDmaFallbacks;
+}
+
 bool getTransmit()
 {
   bool ret = false;
@@ -893,7 +923,33 @@ void setPtt(bool state)
 }
 
 uint8_t modem_config = 0;
-void afskSetModem(uint8_t val, bool bpf, uint16_t timeSlot, uint16_t preamble, uint8_t fx25Mode)
+
+// Modem types in afskSetModem() numbering
+static const enum ModemType afskModemTypes[] = {MODEM_300, MODEM_1200, MODEM_1200_V23, MODEM_9600};
+
+// ADC sample rate afskSetModem() picks for a modem type on this target
+static uint16_t afskAdcRate(uint8_t val)
+{
+  if (val == 3)
+    return 38400;
+#if defined(ADC_SAMPLE)
+  return 9600;
+#elif defined(CONFIG_IDF_TARGET_ESP32C3) || defined(CONFIG_IDF_TARGET_ESP32C6)
+  return (val == 0) ? 9600 : 19200;
+#else
+  return (val == 0) ? 19200 : 28800;
+#endif
+}
+
+// Set up the second RX port, applied by the next afskSetModem() and started with the ADC
+void afskSetPort2(int8_t pin, uint8_t val, bool bpf)
+{
+  rx2Pin = pin;
+  rx2Modem = (val < 4) ? val : 1;
+  rx2Bpf = bpf;
+}
+
+void afskSetModem(uint8_t val, bool bpf, uint16_t timeSlot, uint16_t preamble, uint8_t fx25Mode, uint8_t demodCount)
 {
   if (bpf)
     ModemConfig.flatAudioIn = 1;
@@ -953,19 +1009,46 @@ void afskSetModem(uint8_t val, bool bpf, uint16_t timeSlot, uint16_t preamble, u
     BLOCK_SIZE = (SAMPLERATE / 100); // Must be multiple of resample ratio
     RESAMPLE_RATIO = (SAMPLERATE / 38400);
   }
+
+  rxPortCount = 1;
+#if !defined(ADC_SAMPLE) && !defined(I2S_INTERNAL)
+  if (rx2Pin > -1)
+  {
+    // both inputs are converted in one ADC pattern, so they share the faster of the two rates
+    if (afskAdcRate(rx2Modem) > SAMPLERATE)
+      SAMPLERATE = afskAdcRate(rx2Modem);
+    BLOCK_SIZE = (SAMPLERATE / 50); // Must be multiple of both resample ratios
+    RESAMPLE_RATIO = SAMPLERATE / ((ModemConfig.modem == MODEM_9600) ? 38400 : 9600);
+    rxPorts[1].modem = afskModemTypes[rx2Modem];
+    rxPorts[1].ratio = SAMPLERATE / ((rxPorts[1].modem == MODEM_9600) ? 38400 : 9600);
+    rxPortCount = 2;
+  }
+#else
+  if (rx2Pin > -1)
+    log_w("Second RX port needs the continuous ADC driver, disabled");
+#endif
+  rxPorts[0].modem = ModemConfig.modem;
+  rxPorts[0].ratio = RESAMPLE_RATIO;
+  ModemConfig.ports = rxPortCount;
+  ModemConfig.port1Modem = rxPorts[1].modem;
+  ModemConfig.port1FlatAudioIn = rx2Bpf ? 1 : 0;
+
   if (audio_buffer != NULL)
   {
     free(audio_buffer);
     audio_buffer = NULL;
   }
-  audio_buffer = (float *)calloc(BLOCK_SIZE, sizeof(float));
+  audio_buffer = (int16_t *)calloc(BLOCK_SIZE, sizeof(int16_t));
   if (audio_buffer == NULL)
   {
     log_d("Error allocating memory for audio buffer");
     return;
   }
-  log_d("Modem: %d, SampleRate: %d, BlockSize: %d", ModemConfig.modem, SAMPLERATE, BLOCK_SIZE);
+  for (uint8_t i = 0; i < rxPortCount; i++)
+    DecimatorInit(&rxPorts[i].decimator, rxPorts[i].ratio);
+  log_d("Modem: %d, SampleRate: %d, BlockSize: %d, Ports: %d", ModemConfig.modem, SAMPLERATE, BLOCK_SIZE, rxPortCount);
   ModemConfig.usePWM = 1;
+  ModemConfig.demodCount = demodCount;
   ModemInit();
   Ax25Init(fx25Mode);
   if (fx25Mode > 0)
@@ -1012,6 +1095,7 @@ typedef struct
 
 #ifndef I2S_INTERNAL
 int16_t adcPush;
+static adc_channel_t adcChannel[MODEM_MAX_PORTS]; // ADC1 channel of each RX port
 // static TaskHandle_t s_task_handle;
 //  adc_oneshot_unit_handle_t adc1_handle;
 static bool IRAM_ATTR s_conv_done_cb(adc_continuous_handle_t stAdcHandle, const adc_continuous_evt_data_t *edata, void *user_data)
@@ -1021,35 +1105,30 @@ static bool IRAM_ATTR s_conv_done_cb(adc_continuous_handle_t stAdcHandle, const
   // the demodulator state when drained, causing permanent RX freeze.
   if(hw_afsk_dac_isr)
     return true;
-  portENTER_CRITICAL_ISR(&fifoMux); // same lock RingBuffer_Pop() uses
-  fifo.lock = true;
   for (uint32_t k = 0; k < edata->size; k += SOC_ADC_DIGI_RESULT_BYTES)
   {
     adc_digi_output_data_t *p = (adc_digi_output_data_t *)&edata->conv_frame_buffer[k];
 
 #if defined(CONFIG_IDF_TARGET_ESP32)
-    if (p->type1.channel > 0)
-      continue;
+    uint32_t channel = p->type1.channel;
     adcPush = (int16_t)p->type1.data;
 #else
-    if ((p->type2.channel > 0) || (p->type2.unit > 0))
+    if (p->type2.unit > 0)
       continue;
+    uint32_t channel = p->type2.channel;
     adcPush = (int)p->type2.data;
 #endif
 
-    if (fifo.head >= BUFFER_SIZE || fifo.head < 0)
-      RingBuffer_Init(&fifo); // Check if head exceeds buffer size
-      //fifo.head = 0; // Check if head exceeds buffer size
-    fifo.buffer[fifo.head] = adcPush;
-    fifo.head = (fifo.head + 1) % BUFFER_SIZE; // Wrap around using modulo
-    fifo.count++;
-    // RingBuffer_Push(&fifo, adcPush);
+    // the pattern alternates between the ports, demultiplex by channel
+    if (channel == adcChannel[0])
+      RingBuffer_Push(&fifo, adcPush);
+    else if ((rxPortCount > 1) && (channel == adcChannel[1]))
+      RingBuffer_Push(&fifo2, adcPush);
   }
-  fifo.lock = false;
-  portEXIT_CRITICAL_ISR(&fifoMux);
-  // vTaskDelay(TMP102_UPDATE_CICLE_MS / portTICK_PERIOD_MS);
-  // return (mustYield == pdTRUE);
-  return true;
+  // one conversion frame is one block
+  BaseType_t mustYield = pdFALSE;
+  AFSK_NotifyPoll(&mustYield);
+  return (mustYield == pdTRUE);
 }
 // static TaskHandle_t s_task_handle;
 // static bool IRAM_ATTR s_conv_done_cb(adc_continuous_handle_t handle, const adc_continuous_evt_data_t *edata, void *user_data)
@@ -1076,8 +1155,20 @@ void adc_continue_init(void)
   {
     log_e("Only ADC1 pins are supported in continuous mode!");
   }
+  adcChannel[0] = channel;
 
-  uint32_t conv_frame_size = (uint32_t)(BLOCK_SIZE * SOC_ADC_DIGI_RESULT_BYTES);
+  if (rxPortCount > 1)
+  {
+    adc_unit_t unit2 = ADC_UNIT_1;
+    if ((adc_continuous_io_to_channel(rx2Pin, &unit2, &adcChannel[1]) != ESP_OK) || (unit2 != ADC_UNIT_1) || (adcChannel[1] == channel))
+    {
+      log_e("Pin %d is not a free ADC1 pin, second RX port disabled", rx2Pin);
+      rxPortCount = 1;
+    }
+  }
+
+  // one conversion frame holds one block of every port
+  uint32_t conv_frame_size = (uint32_t)(BLOCK_SIZE * rxPortCount * SOC_ADC_DIGI_RESULT_BYTES);
   // uint32_t conv_frame_size = ADC_SAMPLES_COUNT;
   /* On initialise l'ADC : */
   adc_continuous_handle_cfg_t AdcHandleConfig = {
@@ -1095,9 +1186,9 @@ void adc_continue_init(void)
     /* On configure l'ADC : */
     adc_continuous_config_t AdcConfig = {
 #if defined(CONFIG_IDF_TARGET_ESP32)
-        .sample_freq_hz = (uint32_t)(SAMPLERATE * 11 / 9),
+        .sample_freq_hz = (uint32_t)(SAMPLERATE * rxPortCount * 11 / 9),
 #else
-        .sample_freq_hz = (uint32_t)(SAMPLERATE),
+        .sample_freq_hz = (uint32_t)(SAMPLERATE * rxPortCount),
 #endif
         .conv_mode = ADC_CONV_SINGLE_UNIT_1, // On utilise uniquement l'ADC1.
         .format = ADC_OUTPUT_TYPE,           // On utilise le type 2. Pris dans l'exemple.
@@ -1105,16 +1196,14 @@ void adc_continue_init(void)
     log_d("ADC Continuous Configuration Done. SAMPLERATE: %d Hz", AdcConfig.sample_freq_hz);
 
     adc_digi_pattern_config_t adc_pattern[SOC_ADC_PATT_LEN_MAX] = {0};
-    AdcConfig.pattern_num = 1;
-    // for (int ii = 0; ii < NBR_CHANNELS; ii++)
-    //{
-    // uint8_t unit = ADC_UNIT_1;
-    // uint8_t ch = channel & 0x7;
-    adc_pattern[0].atten = cfg_adc_atten;
-    adc_pattern[0].channel = channel;
-    adc_pattern[0].unit = ADC_UNIT_1;
-    adc_pattern[0].bit_width = SOC_ADC_DIGI_MAX_BITWIDTH;
-    //}
+    AdcConfig.pattern_num = rxPortCount;
+    for (int ii = 0; ii < rxPortCount; ii++)
+    {
+      adc_pattern[ii].atten = cfg_adc_atten;
+      adc_pattern[ii].channel = adcChannel[ii];
+      adc_pattern[ii].unit = ADC_UNIT_1;
+      adc_pattern[ii].bit_width = SOC_ADC_DIGI_MAX_BITWIDTH;
+    }
     AdcConfig.adc_pattern = adc_pattern;
     Err = adc_continuous_config(AdcHandle, &AdcConfig);
     if (Err != ESP_OK)
@@ -1228,24 +1317,135 @@ void adc_continue_init(void)
  * Configure and initialize the sigma delta modulation
  * on channel 0 to output signal on GPIO4
  */
+#if defined(TTGO_TWR)
+#define AFSK_TX_GPIO GPIO_NUM_18 // GPIO18 is used for TTGO TWR
+#elif defined(CONFIG_IDF_TARGET_ESP32C3)
+#define AFSK_TX_GPIO GPIO_NUM_1 // GPIO1 is used for ESP32C3
+#elif defined(CONFIG_IDF_TARGET_ESP32S3)
+#define AFSK_TX_GPIO GPIO_NUM_2 // GPIO2 is used for ESP32S3
+#else
+#define AFSK_TX_GPIO GPIO_NUM_26
+#endif
+
 static void sigmadelta_init(void)
 {
   sigmadelta_config_t sigmadelta_cfg = {
       .channel = SIGMADELTA_CHANNEL_0,
       .sigmadelta_duty = 127,
       .sigmadelta_prescale = 96,
-#if defined(TTGO_TWR)
-      .sigmadelta_gpio = GPIO_NUM_18, // GPIO4 is used for TTGO TWR
-#elif defined(CONFIG_IDF_TARGET_ESP32C3)
-      .sigmadelta_gpio = GPIO_NUM_1, // GPIO1 is used for ESP32C3
-#elif defined(CONFIG_IDF_TARGET_ESP32S3)
-      .sigmadelta_gpio = GPIO_NUM_2, // GPIO2 is used for ESP32S3
+      .sigmadelta_gpio = AFSK_TX_GPIO,
+  };
+  sigmadelta_config(&sigmadelta_cfg);
+}
+
+#ifdef AFSK_TX_DMA
+/****************** DMA TX engine *********************/
+// The whole HDLC bitstream is rendered block by block with ModemTxRender() and written to an I2S PDM TX
+// channel on the sigma-delta pin. The I2S driver copies each block into its DMA ring, so the next block is
+// rendered while the previous ones play, and there is one interrupt per block instead of one per sample.
+#define TX_BLOCK_SIZE 256 // samples per DMA buffer, 6.7 ms at CONFIG_AFSK_DAC_SAMPLERATE
+#define TX_DMA_BLOCKS 4   // DMA buffers queued ahead
+
+static i2s_chan_handle_t txChan = NULL;
+static int16_t txBlock[TX_BLOCK_SIZE];
+
+// Create the PDM TX channel, this also routes the TX pin from the sigma-delta to I2S
+static esp_err_t txChannelOpen(void)
+{
+  i2s_chan_config_t chanCfg = I2S_CHANNEL_DEFAULT_CONFIG(I2S_NUM_0, I2S_ROLE_MASTER);
+  chanCfg.dma_desc_num = TX_DMA_BLOCKS;
+  chanCfg.dma_frame_num = TX_BLOCK_SIZE;
+  chanCfg.auto_clear = true; // send silence if rendering falls behind
+  esp_err_t err = i2s_new_channel(&chanCfg, &txChan, NULL);
+  if (err != ESP_OK)
+    return err;
+
+  i2s_pdm_tx_config_t pdmCfg = {
+#if SOC_I2S_HW_VERSION_2
+      // one line DAC mode, meant for an RC filter on the data pin
+      .clk_cfg = I2S_PDM_TX_CLK_DAC_DEFAULT_CONFIG(CONFIG_AFSK_DAC_SAMPLERATE),
+      .slot_cfg = I2S_PDM_TX_SLOT_DAC_DEFAULT_CONFIG(I2S_DATA_BIT_WIDTH_16BIT, I2S_SLOT_MODE_MONO),
 #else
-      .sigmadelta_gpio = GPIO_NUM_26,
+      .clk_cfg = I2S_PDM_TX_CLK_DEFAULT_CONFIG(CONFIG_AFSK_DAC_SAMPLERATE),
+      .slot_cfg = I2S_PDM_TX_SLOT_DEFAULT_CONFIG(I2S_DATA_BIT_WIDTH_16BIT, I2S_SLOT_MODE_MONO),
 #endif
+      .gpio_cfg = {
+          .clk = I2S_GPIO_UNUSED,
+          .dout = AFSK_TX_GPIO,
+          .invert_flags = {
+              .clk_inv = false,
+          },
+      },
   };
-  sigmadelta_config(&sigmadelta_cfg);
+  err = i2s_channel_init_pdm_tx_mode(txChan, &pdmCfg);
+  if (err == ESP_OK)
+    err = i2s_channel_enable(txChan);
+  if (err != ESP_OK)
+  {
+    i2s_del_channel(txChan);
+    txChan = NULL;
+  }
+  return err;
+}
+
+// Delete the PDM TX channel and give the TX pin back to the sigma-delta
+static void txChannelClose(void)
+{
+  if (txChan == NULL)
+    return;
+  i2s_channel_disable(txChan);
+  i2s_del_channel(txChan);
+  txChan = NULL;
+  sigmadelta_init();
+}
+
+// TX task, woken by DAC_TimerEnable(true) from ModemTransmitStart()
+static void AFSK_TxTask(void *pvParameters)
+{
+  size_t written;
+  for (;;)
+  {
+    ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+    if (!hw_afsk_dac_isr) // TX already stopped
+      continue;
+
+    esp_err_t err = txChannelOpen();
+    if (err != ESP_OK)
+    {
+      // send this transmission the old way: the DAC timer ISR drives the sigma-delta pin
+      // and ends TX with ModemTransmitStop(), which also stops the timer
+      txDmaFallbacks++;
+      log_e("TX I2S channel failed: %s, using the DAC timer", esp_err_to_name(err));
+      sigmadelta_init();
+      if (timer_dac == NULL)
+      {
+        ModemTransmitStop(); // nothing can send the audio, unkey
+        continue;
+      }
+      portENTER_CRITICAL(&timerMux);
+      timerStart(timer_dac);
+      portEXIT_CRITICAL(&timerMux);
+      continue;
+    }
+
+    size_t n;
+    do
+    {
+      n = ModemTxRender(txBlock, TX_BLOCK_SIZE);
+      memset(&txBlock[n], 0, (TX_BLOCK_SIZE - n) * sizeof(*txBlock));
+      i2s_channel_write(txChan, txBlock, sizeof(txBlock), &written, portMAX_DELAY);
+    } while (n == TX_BLOCK_SIZE);
+
+    // a write returns once a DMA buffer is free, so after a full ring of silence the last block has been played
+    memset(txBlock, 0, sizeof(txBlock));
+    for (uint8_t i = 0; i < TX_DMA_BLOCKS; i++)
+      i2s_channel_write(txChan, txBlock, sizeof(txBlock), &written, portMAX_DELAY);
+    txChannelClose();
+    ModemTransmitStop();
+  }
 }
+/******************************************************************** */
+#endif
 
 void AFSK_hw_init(void)
 {
@@ -1282,6 +1482,7 @@ void AFSK_hw_init(void)
     digitalWrite(_pwr_pin, !_pwr_active);
 
   RingBuffer_Init(&fifo); // Initialize the ring buffer
+  RingBuffer_Init(&fifo2);
 
 #ifdef I2S_INTERNAL
   //  Initialize the I2S peripheral
@@ -1334,6 +1535,11 @@ void AFSK_hw_init(void)
   // Repeat the alarm (third parameter) with unlimited count = 0 (fourth parameter).
   timerAlarm(timer_dac, (uint64_t)20000000 / CONFIG_AFSK_DAC_SAMPLERATE, true, 0);
   timerStop(timer_dac);
+#ifdef AFSK_TX_DMA
+  if (txTask == NULL)
+    xTaskCreatePinnedToCore(AFSK_TxTask, "afskTx", 3072, NULL, 5, &txTask, tskNO_AFFINITY); // above the application tasks, it only renders and blocks on DMA
+  log_d("TX DMA engine started");
+#endif
 
   //   ESP_LOGI(TAG, "Create timer handle");
   //   gptimer_handle_t gptimer = NULL;
@@ -1420,6 +1626,14 @@ void AFSK_init(int8_t adc_pin, int8_t dac_pin, int8_t ptt_pin, int8_t sql_pin, i
   tp->SlotTime = 10;      // 100ms
   tp->TXDELAY = 50;       // 500ms
   tp->persistence_P = 63; // P = 0.25
+
+  // the second RX port only needs the DC average and carrier level
+  tp = &tcb2;
+  tp->port = 1;
+  tp->kiss_type = 1 << 4;
+  tp->avg = 2048;
+  tp->cdt = false;
+  tp->cdt_lvl = 0;
   AFSK_hw_init();
 }
 
@@ -1515,7 +1729,6 @@ extern float dBV;
 
 long mVsum = 0;
 int mVsumCount = 0;
-uint8_t dcd_cnt = 0;
 bool sqlActiveOld = false;
 #define READ_LEN 256
 // uint32_t ret_num = 0;
@@ -1523,7 +1736,12 @@ bool sqlActiveOld = false;
 
 void AFSK_Poll(bool SA818, bool RFPower)
 {
-  fifoSampleCount = fifo.count;  // Diagnostic snapshot
+  if (fifoFlushRequest.exchange(false, std::memory_order_acq_rel))
+  {
+    RingBuffer_Flush(&fifo);
+    RingBuffer_Flush(&fifo2);
+  }
+  fifoSampleCount = RingBuffer_Size(&fifo);  // Diagnostic snapshot
   int mV;
   int x = 0;
   int16_t adc = 0;
@@ -1667,7 +1885,9 @@ void AFSK_Poll(bool SA818, bool RFPower)
 
     if (audio_buffer != NULL)
     {
-      tcb_t *tp = &tcb;
+      uint8_t port = 0;
+      AfskRxPort *rp = &rxPorts[port];
+      tcb_t *tp = rp->tp;
 #ifdef I2S_INTERNAL
       // log_d("RX Signal");
       sqlActive = false;
@@ -1710,108 +1930,121 @@ void AFSK_Poll(bool SA818, bool RFPower)
       //               free(resultADC);
       //       }
       // while (adcq.getCount() >= BLOCK_SIZE)
-      while (RingBuffer_Size(&fifo) >= BLOCK_SIZE)
+      for (port = 0; port < rxPortCount; port++)
       {
-        //digitalWrite(15, HIGH);
-
-        mVsum = 0;
-        mVsumCount = 0;
-        // portENTER_CRITICAL_ISR(&timerMux);
-        for (x = 0; x < BLOCK_SIZE; x++)
+        rp = &rxPorts[port];
+        tp = rp->tp;
+        while (RingBuffer_Size(rp->fifo) >= BLOCK_SIZE)
         {
-          // while(adcq_lock) delay(1);
-          // if (!adcq.pop(&adc)) // Pull queue buffer
+          //digitalWrite(15, HIGH);
 
-          bool ret = RingBuffer_Pop(&fifo, &adc);
-          if (!ret)
-            break;
-          // if (!RingBuffer_Pop(&fifo, &adc))
-          //   break;
-
-#endif
-          tp->avg_sum += adc - tp->avg_buf[tp->avg_idx];
-          tp->avg_buf[tp->avg_idx++] = adc;
-          if (tp->avg_idx >= TCB_AVG_N)
-            tp->avg_idx -= TCB_AVG_N;
-          tp->avg = tp->avg_sum / TCB_AVG_N;
-
-          // carrier detect
-          adcVal = (int)adc - (int)tp->avg;
-          int m = 1;
-          if ((RESAMPLE_RATIO > 1) || (ModemConfig.modem == MODEM_9600))
+          mVsum = 0;
+          mVsumCount = 0;
+          int64_t agcSum = 0;
+          const int16_t *span = NULL;
+          size_t spanLen = 0, spanPos = 0;
+          for (x = 0; x < BLOCK_SIZE; x++)
           {
-            m = 4;
-          }
+            if (spanPos == spanLen) // take the next contiguous span out of the ring, at most two per block
+            {
+              RingBuffer_Release(rp->fifo, spanLen);
+              spanLen = RingBuffer_PopN(rp->fifo, &span, BLOCK_SIZE - x);
+              spanPos = 0;
+              if (spanLen == 0)
+                break;
+            }
+            adc = span[spanPos++];
 
-          if (x % m == 0)
-          {
+#endif
+            tp->avg_sum += adc - tp->avg_buf[tp->avg_idx];
+            tp->avg_buf[tp->avg_idx++] = adc;
+            if (tp->avg_idx >= TCB_AVG_N)
+              tp->avg_idx -= TCB_AVG_N;
+            tp->avg = tp->avg_sum / TCB_AVG_N;
+
+            // carrier detect
+            adcVal = (int)adc - (int)tp->avg;
+            int m = 1;
+            if ((rp->ratio > 1) || (rp->modem == MODEM_9600))
+            {
+              m = 4;
+            }
+
+            if (x % m == 0)
+            {
 #ifdef ADC_SAMPLE
-            mV = adc;
+              mV = adc;
 #else
-            adc_cali_raw_to_voltage(AdcCaliHandle, adc, &mV);
+              adc_cali_raw_to_voltage(AdcCaliHandle, adc, &mV);
 #endif
-            mV -= offset;
-            // mVsum += powl(mV, 2); // VRMS = √(1/n)(V1^2 +V2^2 + … + Vn^2)
-            // mV = (adcVal * Vref) >> 12;
-            mVsum += mV * mV; // Accumulate squared voltage values
-            mVsumCount++;
+              mV -= rp->offset;
+              // mVsum += powl(mV, 2); // VRMS = √(1/n)(V1^2 +V2^2 + … + Vn^2)
+              // mV = (adcVal * Vref) >> 12;
+              mVsum += mV * mV; // Accumulate squared voltage values
+              mVsumCount++;
+            }
+
+            int32_t sample = (adcVal * rp->agcGainQ12) >> 12;
+            if (sample > INT16_MAX)
+              sample = INT16_MAX;
+            else if (sample < INT16_MIN)
+              sample = INT16_MIN;
+            agcSum += sample * sample;
+            audio_buffer[x] = (int16_t)sample;
           }
-
-          float sample = (float)adcVal / 2048.0f * agc_gain;
-          audio_buffer[x] = sample;
-        }
-        // portEXIT_CRITICAL_ISR(&timerMux);
-        //  Update AGC gain
-        update_agc(audio_buffer, BLOCK_SIZE);
+#ifndef I2S_INTERNAL
+          RingBuffer_Release(rp->fifo, spanLen);
+#endif
+          //  Update AGC gain
+          update_agc(rp, agcSum, BLOCK_SIZE);
+          // Low-pass and decimate every block, also when idle, so the filter history stays continuous
+          size_t decimated = DecimatorProcess(&rp->decimator, audio_buffer, x - (x % rp->ratio), audio_buffer);
 #ifdef ADC_SAMPLE
-        offset = tp->avg;
+          rp->offset = tp->avg;
 #else
-        adc_cali_raw_to_voltage(AdcCaliHandle, tp->avg, &offset);
+          adc_cali_raw_to_voltage(AdcCaliHandle, tp->avg, &rp->offset);
 #endif
 
-        if (mVsumCount > 0)
-        {
-          tp->cdt_lvl = mVrms = sqrtl(mVsum / mVsumCount); // RMS voltage  VRMS = √(1/mVsumCount)(mVsum)
-          mVsum = 0;
-          mVsumCount = 0;
-          if (mVrms > 10) // >-40dBm
+          if (mVsumCount > 0)
           {
-            if (dcd_cnt < 100)
-              dcd_cnt++;
+            tp->cdt_lvl = rp->mVrms = sqrtl(mVsum / mVsumCount); // RMS voltage  VRMS = √(1/mVsumCount)(mVsum)
+            mVsum = 0;
+            mVsumCount = 0;
+            if (rp->mVrms > 10) // >-40dBm
+            {
+              if (rp->dcdCount < 100)
+                rp->dcdCount++;
+            }
+            else if (rp->mVrms < 5) // <-46dBm
+            {
+              if (rp->dcdCount > 0)
+                rp->dcdCount--;
+            }
+            // Tool conversion dBv <--> Vrms at http://sengpielaudio.com/calculator-db-volt.htm
+            // dBV = 20.0F * log10(Vrms);
+            // log_d("Audio dc_offset=%d mVrms=%d", offset, mVrms);
           }
-          else if (mVrms < 5) // <-46dBm
+          if (port == 0) // port 0 levels are the ones shown as the radio input
           {
-            if (dcd_cnt > 0)
-              dcd_cnt--;
+            offset = rp->offset;
+            mVrms = rp->mVrms;
           }
-          // Tool conversion dBv <--> Vrms at http://sengpielaudio.com/calculator-db-volt.htm
-          // dBV = 20.0F * log10(Vrms);
-          // log_d("Audio dc_offset=%d mVrms=%d", offset, mVrms);
-        }
 
-        if ((dcd_cnt > 3) || (ModemConfig.modem == MODEM_9600))
-        {
-          tp->cdt = true;
-          //  Process audio block
-          if (RESAMPLE_RATIO > 1)
-            resample_audio(audio_buffer);
-
-          // Process audio block
-          int16_t sample;
-
-          for (int i = 0; i < BLOCK_SIZE / RESAMPLE_RATIO; i++)
+          if ((rp->dcdCount > 3) || (rp->modem == MODEM_9600))
           {
-            // Convert back to 12-bit audio (0-4095)
-            sample = (int16_t)(audio_buffer[i] * 2048.0F);
-            MODEM_DECODE(sample, mVrms);
+            tp->cdt = true;
+            // Process audio block
+            ModemDecodeBlock(port, audio_buffer, decimated, rp->mVrms);
           }
+          else
+          {
+            tp->cdt = false;
+          }
+          //digitalWrite(15, LOW);
         }
-        else
-        {
-          tp->cdt = false;
-        }
-        //digitalWrite(15, LOW);
+#ifndef I2S_INTERNAL
       }
+#endif
     }
     // #ifdef SQL
     //     }
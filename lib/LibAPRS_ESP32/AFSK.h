@@ -421,6 +421,7 @@ extern int offset;
 void AFSK_init(int8_t adc_pin, int8_t dac_pin, int8_t ptt_pin, int8_t sql_pin, int8_t pwr_pin, int8_t led_tx_pin, int8_t led_rx_pin, int8_t led_strip_pin,bool ptt_act,bool sql_act,bool pwr_act);
 void AFSK_deinit();
 void AFSK_Poll(bool SA818,bool RFPower);
+void AFSK_WaitForSamples(void);
 void AFSK_TimerEnable(bool sts);
 void DAC_TimerEnable(bool sts);
 void afskSetHPF(bool val);
@@ -432,9 +433,12 @@ void afskSetSQL(int8_t val, bool act);
 bool getTransmit();
 void setTransmit(bool val);
 bool getReceive();
-void afskSetModem(uint8_t val, bool bpf,uint16_t timeSlot,uint16_t preamble,uint8_t fx25Mode);
+void afskSetModem(uint8_t val, bool bpf,uint16_t timeSlot,uint16_t preamble,uint8_t fx25Mode,uint8_t demodCount = 0);
+void afskSetPort2(int8_t pin, uint8_t val, bool bpf);
 void setPtt(bool state);
 void IRAM_ATTR LED_Status2(uint8_t red, uint8_t green, uint8_t blue);
+void AFSK_GetFifoStats(uint32_t *overruns, uint32_t *underruns);
+void AFSK_GetTxStats(uint32_t *dmaFallbacks);
 
 
 #endif
\ No newline at end of file
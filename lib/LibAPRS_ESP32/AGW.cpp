@@ -0,0 +1,364 @@
+#include <Arduino.h>
+#include <string.h>
+#include <stdlib.h>
+#include <ctype.h>
+#include <stdio.h>
+#include <time.h>
+#include "AGW.h"
+#include "AX25.h"
+#include "modem.h"
+
+#ifndef BV
+#define BV(n) _BV(n) //used by AX25_REPEATED()
+#endif
+
+#define AGW_VERSION_MAJOR 2005 //version reported to 'R', the AGWPE release clients expect
+#define AGW_VERSION_MINOR 127
+
+static void putLe32(uint8_t *p, uint32_t v)
+{
+	p[0] = v;
+	p[1] = v >> 8;
+	p[2] = v >> 16;
+	p[3] = v >> 24;
+}
+
+/**
+ * @brief Copy a callsign into a NUL padded AGW_CALL_SIZE field, longer callsigns are cut
+ */
+static void copyCall(char *field, const char *call)
+{
+	size_t len = strnlen(call, AGW_CALL_SIZE);
+	memcpy(field, call, len);
+	memset(&field[len], 0, AGW_CALL_SIZE - len);
+}
+
+void AgwBuildHeader(uint8_t *header, uint8_t port, uint8_t kind, uint8_t pid, const char *callFrom, const char *callTo, uint32_t dataLen)
+{
+	memset(header, 0, AGW_HEADER_SIZE);
+	header[0] = port;
+	header[4] = kind;
+	header[6] = pid;
+	if (callFrom != NULL)
+		copyCall((char *)&header[8], callFrom);
+	if (callTo != NULL)
+		copyCall((char *)&header[18], callTo);
+	putLe32(&header[28], dataLen);
+}
+
+uint32_t AgwParseHeader(const uint8_t *header, uint8_t *port, uint8_t *kind, uint8_t *pid, char *callFrom, char *callTo)
+{
+	if (port != NULL)
+		*port = header[0];
+	if (kind != NULL)
+		*kind = header[4];
+	if (pid != NULL)
+		*pid = header[6];
+	if (callFrom != NULL)
+	{
+		memcpy(callFrom, &header[8], AGW_CALL_SIZE);
+		callFrom[AGW_CALL_SIZE] = 0;
+	}
+	if (callTo != NULL)
+	{
+		memcpy(callTo, &header[18], AGW_CALL_SIZE);
+		callTo[AGW_CALL_SIZE] = 0;
+	}
+	return header[28] | (header[29] << 8) | (header[30] << 16) | ((uint32_t)header[31] << 24);
+}
+
+/**
+ * @brief Send a reply message to the client
+ */
+static void reply(struct AgwSession *s, uint8_t port, uint8_t kind, const char *callFrom, const void *data, uint32_t len)
+{
+	uint8_t msg[AGW_HEADER_SIZE + 256];
+	if (len > sizeof(msg) - AGW_HEADER_SIZE)
+		return;
+	AgwBuildHeader(msg, port, kind, 0, callFrom, NULL, len);
+	memcpy(&msg[AGW_HEADER_SIZE], data, len);
+	s->write(s->arg, msg, AGW_HEADER_SIZE + len);
+}
+
+/**
+ * @brief Store a "CALL-SSID" callsign in AX.25 address format
+ * @return False if it is not a valid callsign
+ */
+static bool putCall(uint8_t *out, const char *call, bool last)
+{
+	uint8_t i = 0;
+	uint8_t ssid = 0;
+	while ((i < AGW_CALL_SIZE) && (call[i] != 0) && (call[i] != '-') && (call[i] != ' '))
+	{
+		char c = toupper(call[i]);
+		if ((i >= 6) || !isalnum(c))
+			return false;
+		out[i++] = c << 1;
+	}
+	if (i == 0)
+		return false;
+	if ((i < AGW_CALL_SIZE) && (call[i] == '-'))
+	{
+		int n = atoi(&call[i + 1]);
+		if ((n < 0) || (n > 15))
+			return false;
+		ssid = n;
+	}
+	for (; i < 6; i++)
+		out[i] = ' ' << 1;
+	out[6] = 0x60 | (ssid << 1) | (last ? 1 : 0);
+	return true;
+}
+
+/**
+ * @brief Build a UI frame from an 'M' or 'V' message and hand it to the sender
+ * @param *digis Digipeater callsigns, AGW_CALL_SIZE bytes each
+ */
+static void sendUi(struct AgwSession *s, uint8_t port, uint8_t pid, const char *from, const char *to, const uint8_t *digis, uint8_t digiCount, const uint8_t *info, size_t infoLen)
+{
+	uint8_t frame[AX25_FRAME_MAX_SIZE];
+	char call[AGW_CALL_SIZE + 1];
+	size_t size = 0;
+
+	if (!putCall(&frame[0], to, false) || !putCall(&frame[7], from, digiCount == 0))
+		return;
+	size = 14;
+	for (uint8_t i = 0; i < digiCount; i++)
+	{
+		memcpy(call, &digis[i * AGW_CALL_SIZE], AGW_CALL_SIZE);
+		call[AGW_CALL_SIZE] = 0;
+		if (!putCall(&frame[size], call, i == (digiCount - 1)))
+			return;
+		size += 7;
+	}
+	frame[size++] = AX25_CTRL_UI;
+	frame[size++] = pid ? pid : AX25_PID_NOLAYER3;
+	if (size + infoLen > sizeof(frame))
+		return;
+	memcpy(&frame[size], info, infoLen);
+	size += infoLen;
+	s->send(s->arg, port, frame, size);
+}
+
+static void registerCall(struct AgwSession *s, const char *call)
+{
+	uint8_t ok = (call[0] != 0) && (s->callCount < AGW_MAX_CALLS);
+	for (uint8_t i = 0; i < s->callCount; i++)
+	{
+		if (strncmp(s->calls[i], call, AGW_CALL_SIZE) == 0)
+			ok = 0; //already registered, fails as in AGWPE
+	}
+	if (ok)
+		copyCall(s->calls[s->callCount++], call);
+	reply(s, 0, 'X', call, &ok, 1);
+}
+
+static void unregisterCall(struct AgwSession *s, const char *call)
+{
+	for (uint8_t i = 0; i < s->callCount; i++)
+	{
+		if (strncmp(s->calls[i], call, AGW_CALL_SIZE) == 0)
+		{
+			s->callCount--;
+			memmove(s->calls[i], s->calls[i + 1], (s->callCount - i) * AGW_CALL_SIZE);
+			break;
+		}
+	}
+}
+
+static const char *portDescription(uint8_t port)
+{
+	switch (ModemGetPortType(port))
+	{
+	case MODEM_300:
+		return "300 Bd AFSK";
+	case MODEM_1200_V23:
+		return "1200 Bd AFSK V.23";
+	case MODEM_9600:
+		return "9600 Bd G3RUH";
+	default:
+		return "1200 Bd AFSK";
+	}
+}
+
+/**
+ * @brief Handle one complete message from the client
+ */
+static void handleMessage(struct AgwSession *s)
+{
+	uint8_t port, kind, pid;
+	char from[AGW_CALL_SIZE + 1], to[AGW_CALL_SIZE + 1];
+	uint32_t len = AgwParseHeader(s->header, &port, &kind, &pid, from, to);
+
+	switch (kind)
+	{
+	case 'R': //version
+	{
+		uint8_t v[8] = {AGW_VERSION_MAJOR & 0xFF, AGW_VERSION_MAJOR >> 8, 0, 0, AGW_VERSION_MINOR, 0, 0, 0};
+		reply(s, 0, 'R', NULL, v, sizeof(v));
+		break;
+	}
+	case 'G': //port information, "count;Port1 description;..."
+	{
+		char info[128];
+		uint8_t ports = ModemGetPortCount();
+		int n = snprintf(info, sizeof(info), "%u;", ports);
+		for (uint8_t i = 0; i < ports; i++)
+			n += snprintf(&info[n], sizeof(info) - n, "Port%u %s%s;", i + 1, portDescription(i), i ? " RX only" : "");
+		reply(s, 0, 'G', NULL, info, n + 1);
+		break;
+	}
+	case 'g': //port capabilities
+	{
+		static const uint8_t baudCode[] = {0, 0, 0, 3}; //AGW codes 0 - 1200, 3 - 9600, 300 Bd has none
+		uint8_t cap[12] = {0};
+		cap[0] = baudCode[ModemGetPortType(port < ModemGetPortCount() ? port : 0)];
+		cap[1] = 0xFF; //traffic level not tracked
+		cap[2] = Ax25Config.txDelayLength / 10;
+		cap[3] = Ax25Config.txTailLength / 10;
+		cap[4] = Ax25Config.persist;
+		cap[5] = Ax25Config.slotTime / 10;
+		cap[6] = 1; //max frames, UI only
+		reply(s, port, 'g', NULL, cap, sizeof(cap));
+		break;
+	}
+	case 'X':
+		registerCall(s, from);
+		break;
+	case 'x':
+		unregisterCall(s, from);
+		break;
+	case 'm':
+		s->monitor ^= 1;
+		break;
+	case 'k':
+		s->raw ^= 1;
+		break;
+	case 'M': //UI frame, no digipeaters
+		sendUi(s, port, pid, from, to, NULL, 0, s->data, len);
+		break;
+	case 'V': //UI frame via digipeaters: count, count * callsign, info
+	{
+		uint8_t count = (len > 0) ? s->data[0] : 0;
+		if ((count > AX25_MAX_RPT) || (len < 1 + (uint32_t)count * AGW_CALL_SIZE))
+			break;
+		size_t offset = 1 + count * AGW_CALL_SIZE;
+		sendUi(s, port, pid, from, to, &s->data[1], count, &s->data[offset], len - offset);
+		break;
+	}
+	case 'K': //raw frame, KISS command byte first
+		if ((len > 15) && (len - 1 <= AX25_FRAME_MAX_SIZE))
+			s->send(s->arg, port, &s->data[1], len - 1);
+		break;
+	default:
+		break;
+	}
+}
+
+void AgwInit(struct AgwSession *s, agw_write_t write, agw_send_t send, void *arg)
+{
+	memset(s, 0, sizeof(*s));
+	s->write = write;
+	s->send = send;
+	s->arg = arg;
+}
+
+void AgwReceive(struct AgwSession *s, const uint8_t *data, size_t len)
+{
+	while (len > 0)
+	{
+		size_t n;
+		if (s->received < AGW_HEADER_SIZE)
+		{
+			n = AGW_HEADER_SIZE - s->received;
+			if (n > len)
+				n = len;
+			memcpy(&s->header[s->received], data, n);
+			s->received += n;
+			if (s->received == AGW_HEADER_SIZE)
+				s->dataLen = AgwParseHeader(s->header, NULL, NULL, NULL, NULL, NULL);
+		}
+		else
+		{
+			uint32_t pos = s->received - AGW_HEADER_SIZE;
+			n = s->dataLen - pos;
+			if (n > len)
+				n = len;
+			if (pos < AGW_MAX_DATA)
+				memcpy(&s->data[pos], data, (pos + n > AGW_MAX_DATA) ? AGW_MAX_DATA - pos : n);
+			s->received += n;
+		}
+		data += n;
+		len -= n;
+		if ((s->received >= AGW_HEADER_SIZE) && (s->received - AGW_HEADER_SIZE == s->dataLen))
+		{
+			if (s->dataLen <= AGW_MAX_DATA) //longer ones were only skipped
+				handleMessage(s);
+			s->received = 0;
+		}
+	}
+}
+
+/**
+ * @brief Format a decoded callsign as "CALL-SSID"
+ */
+static void callText(char *out, const AX25Call *call)
+{
+	if (call->ssid)
+		snprintf(out, AGW_CALL_SIZE + 1, "%s-%u", call->call, call->ssid);
+	else
+		snprintf(out, AGW_CALL_SIZE + 1, "%s", call->call);
+}
+
+size_t AgwMonitorMessage(uint8_t *out, size_t size, uint8_t port, const uint8_t *frame, size_t len)
+{
+	AX25Msg msg;
+	char from[AGW_CALL_SIZE + 1], to[AGW_CALL_SIZE + 1], call[AGW_CALL_SIZE + 1];
+
+	if ((len < 16) || (size < AGW_HEADER_SIZE + 1))
+		return 0;
+	memset(&msg, 0, sizeof(msg));
+	ax25_decode((uint8_t *)frame, len, 0, &msg);
+	if (msg.ctrl != AX25_CTRL_UI)
+		return 0;
+	//ax25_decode() only copies the information field of APRS frames, take it from the frame
+	size_t head = 16 + 7 * msg.rpt_count;
+	if (len < head)
+		return 0;
+	const char *info = (const char *)&frame[head];
+	size_t infoLen = len - head;
+	callText(from, &msg.src);
+	callText(to, &msg.dst);
+
+	// " 1:Fm N0CALL-1 To APRS Via WIDE1-1* <UI pid=F0 Len=28 >[12:34:56]\r" info "\r", as AGWPE shows it
+	char *text = (char *)&out[AGW_HEADER_SIZE];
+	size_t room = size - AGW_HEADER_SIZE - 1; //keep the NUL, it is part of the data
+	int n = snprintf(text, room, " %u:Fm %s To %s", port + 1, from, to);
+	for (uint8_t i = 0; (i < msg.rpt_count) && (n < (int)room); i++)
+	{
+		callText(call, &msg.rpt_list[i]);
+		n += snprintf(&text[n], room - n, "%s%s%s", i ? "," : " Via ", call, AX25_REPEATED(&msg, i) ? "*" : "");
+	}
+	time_t now = time(NULL);
+	struct tm t;
+	localtime_r(&now, &t);
+	if (n < (int)room)
+		n += snprintf(&text[n], room - n, " <UI pid=%02X Len=%u >[%02d:%02d:%02d]\r", msg.pid, (unsigned)infoLen, t.tm_hour, t.tm_min, t.tm_sec);
+	if (n < (int)room)
+		n += snprintf(&text[n], room - n, "%.*s\r", (int)infoLen, info);
+	if (n >= (int)room)
+		n = room - 1;
+	text[n++] = 0;
+	AgwBuildHeader(out, port, 'U', msg.pid, from, to, n);
+	return AGW_HEADER_SIZE + n;
+}
+
+size_t AgwRawMessage(uint8_t *out, size_t size, uint8_t port, const uint8_t *frame, size_t len)
+{
+	if (AGW_HEADER_SIZE + 1 + len > size)
+		return 0;
+	AgwBuildHeader(out, port, 'K', 0, NULL, NULL, len + 1);
+	out[AGW_HEADER_SIZE] = port << 4; //KISS data command of the port
+	memcpy(&out[AGW_HEADER_SIZE + 1], frame, len);
+	return AGW_HEADER_SIZE + 1 + len;
+}
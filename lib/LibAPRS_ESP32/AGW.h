@@ -0,0 +1,88 @@
+#ifndef AGW_H_
+#define AGW_H_
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+
+#define AGW_HEADER_SIZE 36
+#define AGW_CALL_SIZE 10 //callsign field of the header, NUL padded
+#define AGW_MAX_DATA 512 //longest data part accepted or sent, the data of longer messages is skipped
+#define AGW_MAX_MESSAGE (AGW_HEADER_SIZE + AGW_MAX_DATA)
+#define AGW_MAX_CALLS 4 //callsigns one client can register
+
+/**
+ * @brief Output of a session, called with one whole AGW message at a time
+ */
+typedef void (*agw_write_t)(void *arg, const uint8_t *msg, size_t len);
+
+/**
+ * @brief Called with an AX.25 frame (without FCS) a client wants transmitted
+ */
+typedef void (*agw_send_t)(void *arg, uint8_t port, const uint8_t *frame, size_t len);
+
+/**
+ * @brief State of one AGWPE client connection
+ */
+struct AgwSession
+{
+	uint8_t header[AGW_HEADER_SIZE];
+	uint8_t data[AGW_MAX_DATA];
+	uint32_t received; //bytes of the current message received so far, header included
+	uint32_t dataLen; //data length of the current message
+	uint8_t monitor : 1; //'m' toggled on, gets 'U' monitor messages
+	uint8_t raw : 1; //'k' toggled on, gets 'K' raw frames
+	char calls[AGW_MAX_CALLS][AGW_CALL_SIZE]; //registered with 'X'
+	uint8_t callCount;
+	agw_write_t write;
+	agw_send_t send;
+	void *arg;
+};
+
+/**
+ * @brief Start a session for a new client
+ * @param write Where replies go
+ * @param send Where frames to transmit go
+ * @param arg Passed to write and send
+ */
+void AgwInit(struct AgwSession *s, agw_write_t write, agw_send_t send, void *arg);
+
+/**
+ * @brief Feed bytes received from the client, complete messages are handled as they arrive
+ * @details Supported: 'R' version, 'G' port info, 'g' port capabilities, 'X'/'x' (un)register callsign,
+ * 'm' monitor toggle, 'k' raw frames toggle, 'M' and 'V' send UI frame, 'K' send raw frame.
+ * Other kinds are ignored.
+ */
+void AgwReceive(struct AgwSession *s, const uint8_t *data, size_t len);
+
+/**
+ * @brief Build the 'U' monitor message of a received frame, for clients with monitoring on
+ * @param[out] *out Message buffer, AGW_MAX_MESSAGE bytes are always enough
+ * @param port RX port the frame was received on
+ * @param *frame AX.25 frame without FCS
+ * @return Message length, 0 if the frame is not a UI frame
+ */
+size_t AgwMonitorMessage(uint8_t *out, size_t size, uint8_t port, const uint8_t *frame, size_t len);
+
+/**
+ * @brief Build the 'K' raw message of a received frame, for clients with raw frames on
+ * @return Message length, 0 if it does not fit
+ */
+size_t AgwRawMessage(uint8_t *out, size_t size, uint8_t port, const uint8_t *frame, size_t len);
+
+/**
+ * @brief Parse an AGW header
+ * @param *header AGW_HEADER_SIZE bytes
+ * @param[out] *kind Data kind, e.g. 'U'
+ * @param[out] *callFrom, *callTo NUL terminated callsigns, AGW_CALL_SIZE + 1 bytes, may be NULL
+ * @return Data length
+ */
+uint32_t AgwParseHeader(const uint8_t *header, uint8_t *port, uint8_t *kind, uint8_t *pid, char *callFrom, char *callTo);
+
+/**
+ * @brief Build an AGW header
+ * @param *callFrom, *callTo Callsigns, may be NULL
+ */
+void AgwBuildHeader(uint8_t *header, uint8_t port, uint8_t kind, uint8_t pid, const char *callFrom, const char *callTo, uint32_t dataLen);
+
+#endif /* AGW_H_ */
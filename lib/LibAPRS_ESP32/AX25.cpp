@@ -24,6 +24,7 @@ along with VP-Digi.  If not, see <http://www.gnu.org/licenses/>.
 #include "common.h"
 #include <stdbool.h>
 #include <string.h>
+#include <atomic>
 
 #include "AFSK.h"
 #include "CRC-CCIT.h"
@@ -39,12 +40,13 @@ struct Ax25ProtoConfig Ax25Config;
 #else
 #define FRAME_MAX_COUNT (3) //max count of frames in buffer
 #endif
+#define RX_FRAME_MAX_COUNT_PSRAM (64) //max count of received frames waiting for the consumer when the pool is in PSRAM
 #define FRAME_BUFFER_SIZE (FRAME_MAX_COUNT * AX25_FRAME_MAX_SIZE) //circular frame buffer length
 
 #define STATIC_HEADER_FLAG_COUNT 4 //number of flags sent before each frame
 #define STATIC_FOOTER_FLAG_COUNT 1 //number of flags sent after each frame
 
-#define MAX_TRANSMIT_RETRY_COUNT 8 //max number of retries if channel is busy
+#define CSMA_MAX_DEFER_TIME 10000 //ms, transmit anyway if the channel stays busy this long (stuck DCD)
 
 #define SYNC_BYTE 0x7E //preamble/postamble octet
 
@@ -62,12 +64,26 @@ struct FrameHandle
 #endif
 };
 
-static uint8_t rxBuffer[FRAME_BUFFER_SIZE]; //circular buffer for received frames
-static uint16_t rxBufferHead = 0; //circular RX buffer write index
-static struct FrameHandle rxFrame[FRAME_MAX_COUNT];
-static uint8_t rxFrameHead = 0;
-static uint8_t rxFrameTail = 0;
-static bool rxFrameBufferFull = false;
+//RX frame pool
+//Each decoder receives directly into a pool slot it owns. A good frame is published by passing that slot
+//to the ready ring and taking a new one from the free ring, so the frame is never copied. The consumer
+//borrows the oldest ready frame and gives the slot back to the free ring when done.
+//The RX task publishes and takes free slots, the consumer task borrows and releases them,
+//so both rings are single-producer/single-consumer and need no lock.
+#define RX_SLOT_RING_SIZE 128 //must be a power of two greater than the slot count
+#define RX_SLOT_RING_MASK (RX_SLOT_RING_SIZE - 1)
+
+struct RxSlotRing
+{
+	uint8_t slot[RX_SLOT_RING_SIZE];
+	std::atomic<uint32_t> head; //total slots pushed
+	std::atomic<uint32_t> tail; //total slots popped
+};
+
+static struct Ax25RxFrame *rxSlots = NULL; //slot storage, allocated once
+static uint16_t rxSlotCount = 0;
+static struct RxSlotRing rxReady; //received frames, oldest first
+static struct RxSlotRing rxFree; //slots owned by nobody
 
 static uint8_t txBuffer[FRAME_BUFFER_SIZE];  //circular TX frame buffer
 static uint16_t txBufferHead = 0; //circular TX buffer write index
@@ -85,6 +101,7 @@ static uint8_t txTagByteIdx = 0;
 static uint8_t frameReceived; //a bitmap of receivers that received the frame
 
 ax25_callback_t _hook;
+static ax25_notify_t rxNotify = NULL; //called when a received frame is committed to the RX frame pool
 
 enum TxStage
 {
@@ -119,53 +136,365 @@ static uint8_t txBitstuff = 0; //bit-stuffing counter
 static uint16_t txTailElapsed; //counter of TXTail bytes already sent
 static uint16_t txCrc = 0xFFFF; //current CRC
 static unsigned long txQuiet = 0; //quit time + current tick value
-static uint8_t txRetries = 0; //number of TX retries
+static unsigned long txDeferStart = 0; //when the first channel access attempt for the pending transmission was made
+static bool txDeferring = false; //channel access attempts are ongoing
+static uint32_t txBits = 0; //bits sent, for airtime statistics
+static uint32_t txBurstStart = 0; //txBits value at the start of the current transmission
+static uint32_t txBurstBits; //burst airtime limit in bits
+static struct Ax25TxStats txStats; //transmitter statistics
 static enum TxInitStage txInitStage; //current TX initialization stage
 static enum TxStage txStage; //current TX stage
 
+#define RX_WEAK_BITS 12 //number of least confident bits remembered per frame for CRC recovery
+
 struct RxState
 {
 	uint16_t crc; //current CRC
-	uint8_t frame[AX25_FRAME_MAX_SIZE]; //raw frame buffer
+	uint8_t *frame; //raw frame buffer, data of the pool slot owned by this decoder
+	uint8_t slot; //index of that slot
 	uint16_t frameIdx; //index for raw frame buffer
 	uint8_t receivedByte; //byte being currently received
 	uint8_t receivedBitIdx; //bit index for recByte
 	uint8_t rawData; //raw data being currently received
 	enum Ax25RxStage rx; //current RX stage
-	uint8_t frameReceived; //frame received flag
 #ifdef ENABLE_FX25
 	struct Fx25Mode *fx25Mode;
 	uint64_t tag; //received correlation tag
+	uint8_t tagErrors; //bits the received tag differed from the mode tag
 #endif
+	uint16_t weakBit[RX_WEAK_BITS]; //positions (byte * 8 + bit) of the least confident bits of the frame
+	uint8_t weakLevel[RX_WEAK_BITS]; //how weak each of them is
+	uint8_t weakCount;
 };
 
 static struct RxState rxState[MODEM_MAX_DEMODULATOR_COUNT];
 
-static uint16_t lastCrc = 0; //CRC of the last received frame. If not 0, a frame was successfully received
-static uint16_t rxMultiplexDelay = 0; //simple delay for decoder multiplexer to avoid receiving the same frame twice
+#define RX_CRC_SET_SIZE 8 //number of recently received frames remembered for decoder multiplexing
+#define RX_CRC_HOLD_BITS 32 //how long (in bit periods) a received frame is remembered
+
+//all decoders of the bank receive the same frame a few samples apart
+//a frame is stored only by the first decoder, the others are counted and dropped
+//decoders of different ports listen to different radios, so they never drop each other's frames
+struct RxCrcEntry
+{
+	uint16_t crc; //frame CRC
+	uint8_t port; //port the frame was received on
+	uint8_t decoders; //bitmap of decoders that received the frame, 0 - entry unused
+	uint32_t tick; //rxTick value when the frame was first received
+};
+
+static struct RxCrcEntry rxCrcSet[RX_CRC_SET_SIZE];
+static uint8_t rxCrcCount = 0; //number of used entries in rxCrcSet
+static uint32_t rxTick = 0; //incremented on each Ax25BitParse() call
+
+static struct Ax25RxStats rxStats; //receiver statistics
 
 static uint16_t txDelay; //number of TXDelay bytes to send
 static uint16_t txTail; //number of TXTail bytes to send
 
-static uint8_t outputFrameBuffer[AX25_FRAME_MAX_SIZE];
+/**
+ * @brief Add a slot index to a ring
+ * @return False if the ring is full
+ */
+static inline bool slotRingPush(struct RxSlotRing *r, uint8_t slot)
+{
+	uint32_t head = r->head.load(std::memory_order_relaxed);
+	if((head - r->tail.load(std::memory_order_acquire)) >= RX_SLOT_RING_SIZE)
+		return false;
+	r->slot[head & RX_SLOT_RING_MASK] = slot;
+	r->head.store(head + 1, std::memory_order_release);
+	return true;
+}
+
+/**
+ * @brief Get the oldest slot index of a ring without removing it
+ * @return False if the ring is empty
+ */
+static inline bool slotRingPeek(struct RxSlotRing *r, uint8_t *slot)
+{
+	uint32_t tail = r->tail.load(std::memory_order_relaxed);
+	if(r->head.load(std::memory_order_acquire) == tail)
+		return false;
+	*slot = r->slot[tail & RX_SLOT_RING_MASK];
+	return true;
+}
+
+/**
+ * @brief Remove the oldest slot index from a ring
+ * @return False if the ring is empty
+ */
+static inline bool slotRingPop(struct RxSlotRing *r, uint8_t *slot)
+{
+	if(!slotRingPeek(r, slot))
+		return false;
+	r->tail.store(r->tail.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+	return true;
+}
+
+static inline uint32_t slotRingSize(struct RxSlotRing *r)
+{
+	return r->head.load(std::memory_order_acquire) - r->tail.load(std::memory_order_acquire);
+}
+
+/**
+ * @brief Allocate the RX frame pool and give every decoder its slot
+ * @details Done only once, so frames that are waiting or borrowed survive a modem reconfiguration
+ */
+static void initRxPool(void)
+{
+	if(rxSlots != NULL)
+		return;
+
+#ifdef BOARD_HAS_PSRAM
+	rxSlotCount = RX_FRAME_MAX_COUNT_PSRAM + MODEM_MAX_DEMODULATOR_COUNT;
+	rxSlots = (struct Ax25RxFrame*)ps_calloc(rxSlotCount, sizeof(*rxSlots));
+	if(rxSlots == NULL) //no PSRAM found, fall back to internal RAM
+#endif
+	{
+		rxSlotCount = FRAME_MAX_COUNT + MODEM_MAX_DEMODULATOR_COUNT;
+		rxSlots = (struct Ax25RxFrame*)calloc(rxSlotCount, sizeof(*rxSlots));
+		if(rxSlots == NULL)
+		{
+			rxSlotCount = 0;
+			log_e("RX frame pool allocation failed");
+			return;
+		}
+	}
+
+	rxReady.head.store(0, std::memory_order_relaxed);
+	rxReady.tail.store(0, std::memory_order_relaxed);
+	rxFree.head.store(0, std::memory_order_relaxed);
+	rxFree.tail.store(0, std::memory_order_relaxed);
+	for(uint16_t i = MODEM_MAX_DEMODULATOR_COUNT; i < rxSlotCount; i++)
+		slotRingPush(&rxFree, i);
+	log_i("RX frame pool: %u frames", rxSlotCount - MODEM_MAX_DEMODULATOR_COUNT);
+}
+
+/**
+ * @brief Publish the frame received by a decoder and give the decoder a new slot
+ * @param *rx Receiver state, rx->frameIdx holds the frame size without FCS
+ * @param modem Decoder number
+ * @param mV Signal level in mV RMS
+ * @param corrected Number of bytes corrected by FX.25, AX25_NOT_FX25 if not a FX.25 frame
+ * @return False if the pool is full and the frame was dropped
+ */
+static bool publishRxFrame(struct RxState *rx, uint8_t modem, uint16_t mV, uint8_t corrected)
+{
+	uint8_t next;
+	if(!slotRingPop(&rxFree, &next))
+		return false;
+
+	struct Ax25RxFrame *f = &rxSlots[rx->slot];
+	f->size = rx->frameIdx;
+	f->mVrms = mV;
+	f->corrected = corrected;
+	f->port = ModemGetDemodulatorPort(modem);
+	rxStats.portFrames[f->port]++;
+	ModemGetSignalLevel(modem, &f->peak, &f->valley, &f->level);
+	log_d("Pkt=%d SND: peak=%d valley=%d level=%d", f->size, f->peak, f->valley, f->level);
+	slotRingPush(&rxReady, rx->slot); //cannot fail, the ring is longer than the pool
+
+	rx->slot = next;
+	rx->frame = rxSlots[next].data;
+
+	uint32_t used = slotRingSize(&rxReady);
+	if(used > rxStats.poolPeak)
+		rxStats.poolPeak = used;
+	if(rxNotify != NULL)
+		rxNotify();
+	return true;
+}
+
+/**
+ * @brief Remove expired frames from the multiplexer set
+ */
+static void expireRxCrc(void)
+{
+	uint32_t hold = RX_CRC_HOLD_BITS * ModemGetDemodulatorCount();
+	for(uint8_t i = 0; i < RX_CRC_SET_SIZE; i++)
+	{
+		if(rxCrcSet[i].decoders && ((rxTick - rxCrcSet[i].tick) > hold))
+		{
+			frameReceived |= rxCrcSet[i].decoders;
+			rxCrcSet[i].decoders = 0;
+			rxCrcCount--;
+		}
+	}
+}
+
+/**
+ * @brief Register a correctly received frame in the multiplexer set
+ * @param crc Frame CRC
+ * @param modem Decoder number
+ * @return True if this is a new frame that should be stored, false if another decoder already received it
+ */
+static bool registerRxCrc(uint16_t crc, uint8_t modem)
+{
+	struct RxCrcEntry *slot = NULL;
+	uint8_t port = ModemGetDemodulatorPort(modem);
+
+	rxStats.slotDecoded[modem]++;
+	for(uint8_t i = 0; i < RX_CRC_SET_SIZE; i++)
+	{
+		if(rxCrcSet[i].decoders == 0)
+		{
+			if(slot == NULL)
+				slot = &rxCrcSet[i];
+		}
+		else if((rxCrcSet[i].crc == crc) && (rxCrcSet[i].port == port))
+		{
+			rxCrcSet[i].decoders |= (1 << modem);
+			rxStats.duplicates++;
+			return false;
+		}
+	}
+
+	if(slot == NULL) //set full, reuse the oldest entry
+	{
+		slot = &rxCrcSet[0];
+		for(uint8_t i = 1; i < RX_CRC_SET_SIZE; i++)
+		{
+			if((rxTick - rxCrcSet[i].tick) > (rxTick - slot->tick))
+				slot = &rxCrcSet[i];
+		}
+		frameReceived |= slot->decoders;
+	}
+	else
+		rxCrcCount++;
+
+	slot->crc = crc;
+	slot->port = port;
+	slot->tick = rxTick;
+	slot->decoders = (1 << modem);
+	rxStats.slotFirst[modem]++;
+	return true;
+}
 
 #define GET_FREE_SIZE(max, head, tail) (((head) < (tail)) ? ((tail) - (head)) : ((max) - (head) + (tail)))
 #define GET_USED_SIZE(max, head, tail) (max - GET_FREE_SIZE(max, head, tail))
 
 /**
- * @brief Recalculate CRC for one bit
- * @param bit Input bit
- * @param *crc CRC pointer
+ * @brief Remember a low-confidence bit of the frame being received, keeping the weakest ones
+ * @param *rx Receiver state
+ * @param pos Bit position in the frame
+ * @param weak Weakness level, greater than 0
  */
-static void calculateCRC(uint8_t bit, uint16_t *crc)
+static void storeWeakBit(struct RxState *rx, uint16_t pos, uint8_t weak)
 {
-    uint16_t xor_result;
-    xor_result = *crc ^ bit;
-    *crc >>= 1;
-    if (xor_result & 0x0001)
-    {
-    	*crc ^= 0x8408;
-    }
+	uint8_t i = rx->weakCount;
+	if(i == RX_WEAK_BITS) //full, replace the strongest entry if it is stronger than this bit
+	{
+		uint8_t strongest = 0;
+		for(uint8_t k = 1; k < RX_WEAK_BITS; k++)
+		{
+			if(rx->weakLevel[k] < rx->weakLevel[strongest])
+				strongest = k;
+		}
+		if(rx->weakLevel[strongest] >= weak)
+			return;
+		i = strongest;
+	}
+	else
+		rx->weakCount++;
+
+	rx->weakBit[i] = pos;
+	rx->weakLevel[i] = weak;
+}
+
+/**
+ * @brief Try to recover a frame with bad FCS by flipping 1 or 2 of its least confident bits
+ * @details CRC16 is linear, so flipping a data bit changes the computed CRC by a value that only depends
+ * on the distance to the end of the frame, and flipping an FCS bit changes the received CRC by that bit.
+ * These syndromes are computed once (a single pass of zero-bit CRC steps), then every candidate is just
+ * an XOR and compare, up to Ax25Config.fixBits candidates.
+ * @param *rx Receiver state, rx->crc holds the final computed CRC. On success the frame and rx->crc are fixed
+ * @return True if the frame was recovered
+ */
+static bool fixRxBits(struct RxState *rx)
+{
+	uint16_t dataBits = (rx->frameIdx - 2) * 8;
+	uint16_t received = rx->frame[rx->frameIdx - 2] | ((uint16_t)rx->frame[rx->frameIdx - 1] << 8);
+	uint16_t syndrome = rx->crc ^ received;
+
+	uint8_t order[RX_WEAK_BITS]; //candidates, weakest first
+	uint16_t effect[RX_WEAK_BITS];
+	uint8_t count = 0;
+	for(uint8_t i = 0; i < rx->weakCount; i++)
+	{
+		if(rx->weakBit[i] >= (dataBits + 16)) //part of the closing flag
+			continue;
+		uint8_t k = count++;
+		while((k > 0) && (rx->weakLevel[order[k - 1]] < rx->weakLevel[i]))
+		{
+			order[k] = order[k - 1];
+			k--;
+		}
+		order[k] = i;
+	}
+	if(count == 0)
+		return false;
+
+	//syndromes of the data bits, in one walk from the end of the data towards its start
+	uint8_t byPos[RX_WEAK_BITS]; //candidates, highest position first
+	for(uint8_t i = 0; i < count; i++)
+	{
+		uint8_t k = i;
+		while((k > 0) && (rx->weakBit[order[byPos[k - 1]]] < rx->weakBit[order[i]]))
+		{
+			byPos[k] = byPos[k - 1];
+			k--;
+		}
+		byPos[k] = i;
+	}
+	uint16_t delta = 0x8408; //CRC change caused by flipping the last data bit
+	uint16_t distance = 0; //number of bits between the flipped bit and the end of the data
+	for(uint8_t i = 0; i < count; i++)
+	{
+		uint16_t pos = rx->weakBit[order[byPos[i]]];
+		if(pos >= dataBits) //FCS bit, flips the received CRC directly
+		{
+			effect[byPos[i]] = 1 << (pos - dataBits);
+			continue;
+		}
+		for(; distance < (dataBits - 1 - pos); distance++)
+			delta = (delta >> 1) ^ ((delta & 1) ? 0x8408 : 0);
+		effect[byPos[i]] = delta;
+	}
+
+	uint16_t attempts = 0;
+	int8_t flipA = -1, flipB = -1;
+	for(uint8_t i = 0; (i < count) && (flipA < 0); i++)
+	{
+		if(attempts++ >= Ax25Config.fixBits)
+			return false;
+		if(effect[i] == syndrome)
+			flipA = i;
+	}
+	for(uint8_t i = 0; (i < count) && (flipA < 0); i++)
+	{
+		for(uint8_t j = i + 1; (j < count) && (flipA < 0); j++)
+		{
+			if(attempts++ >= Ax25Config.fixBits)
+				return false;
+			if((effect[i] ^ effect[j]) == syndrome)
+			{
+				flipA = i;
+				flipB = j;
+			}
+		}
+	}
+	if(flipA < 0)
+		return false;
+
+	uint16_t pos = rx->weakBit[order[flipA]];
+	rx->frame[pos >> 3] ^= (1 << (pos & 7));
+	if(flipB >= 0)
+	{
+		pos = rx->weakBit[order[flipB]];
+		rx->frame[pos >> 3] ^= (1 << (pos & 7));
+	}
+	rx->crc = rx->frame[rx->frameIdx - 2] | ((uint16_t)rx->frame[rx->frameIdx - 1] << 8);
+	return true;
 }
 
 uint8_t Ax25GetReceivedFrameBitmap(void)
@@ -297,17 +626,6 @@ void ax25_decode(uint8_t *buf,size_t len,uint16_t mVrms, AX25Msg *msg)
 }
 
 #ifdef ENABLE_FX25
-static void removeLastFrameFromRxBuffer(void)
-{
-	// rxFrameHead is only advanced on successful validation (see parseFx25Frame()),
-	// so at this point it still points at the current (failed) frame's slot -
-	// reset buffer head back to that frame's own start position.
-	rxBufferHead = rxFrame[rxFrameHead].start;
-	rxFrameBufferFull = false;
-}
-
-
-
 static void *writeFx25Frame(uint8_t *data, uint16_t size)
 {
 	//first calculate how big the frame can be
@@ -338,7 +656,7 @@ static void *writeFx25Frame(uint8_t *data, uint16_t size)
 	//header flag
 	txFx25Buffer[index++] = 0x7E;
 
-	uint16_t crc = 0xFFFF;
+	uint16_t crc = crc_ccit_block(CRC_CCIT_INIT_VAL, data, size);
 
 	uint8_t bits = 0; //bit counter within a byte
 	uint8_t bitstuff = 0;
@@ -352,13 +670,11 @@ static void *writeFx25Frame(uint8_t *data, uint16_t size)
 			{
 				if((data[i] >> k) & 1)
 				{
-					calculateCRC(1, &crc);
 					bitstuff++;
 					txFx25Buffer[index] |= 0x80;
 				}
 				else
 				{
-					calculateCRC(0, &crc);
 					bitstuff = 0;
 				}
 			}
@@ -437,34 +753,33 @@ static void *writeFx25Frame(uint8_t *data, uint16_t size)
 	return ret;
 }
 
-static struct FrameHandle* parseFx25Frame(uint8_t *frame, uint16_t size, uint16_t *crc)
+/**
+ * @brief Remove bit stuffing from a corrected FX.25 data block and check the AX.25 frame in it
+ * @details Works in place, the output never gets ahead of the input
+ * @param *frame FX.25 data block, overwritten with the AX.25 frame
+ * @param size Block data size
+ * @param *crc Frame CRC
+ * @return Frame size without FCS, 0 if there is no valid frame
+ */
+static uint16_t parseFx25Frame(uint8_t *frame, uint16_t size, uint16_t *crc)
 {
-	struct FrameHandle *h = &rxFrame[rxFrameHead];
-	uint16_t initialRxBufferHead = rxBufferHead;
-	uint8_t tempRxFrameHead = rxFrameHead;
-
-	if(!rxFrameBufferFull)
-	{
-		rxFrame[tempRxFrameHead].start = rxBufferHead;
-	}
-	else
-		return NULL;
-
 	uint16_t i = 0; //input data index
 	uint16_t k = 0; //output data size
-	while(frame[i] == 0x7E)
+	while((i < size) && (frame[i] == 0x7E))
 		i++;
 
 	uint8_t bitstuff = 0;
 	uint8_t outBit = 0;
+	uint8_t outByte = 0;
 	for(; i < size; i++)
 	{
+		uint8_t inByte = frame[i];
 		for(uint8_t b = 0; b < 8; b++)
 		{
-			if(frame[i] & (1 << b))
+			if(inByte & (1 << b))
 			{
-				rxBuffer[rxBufferHead] >>= 1;
-				rxBuffer[rxBufferHead] |= 0x80;
+				outByte >>= 1;
+				outByte |= 0x80;
 				bitstuff++;
 			}
 			else
@@ -480,64 +795,39 @@ static struct FrameHandle* parseFx25Frame(uint8_t *frame, uint16_t size, uint16_
 				}
 				else if(bitstuff >= 7) //zero after 7 ones, illegal byte
 				{
-					removeLastFrameFromRxBuffer();
-					return NULL;
+					return 0;
 				}
 				bitstuff = 0;
-				rxBuffer[rxBufferHead] >>= 1;
+				outByte >>= 1;
 			}
 			outBit++;
 			if(outBit == 8)
 			{
-				k++;
-				rxBufferHead++;
-				rxBufferHead %= FRAME_BUFFER_SIZE;
+				frame[k++] = outByte;
 				outBit = 0;
 			}
 		}
 	}
 
 endParseFx25Frame:
-	*crc = 0xFFFF;
-	i = initialRxBufferHead;
+	if(k < 17) //same minimum as for plain AX.25 frames
+		return 0;
 
-	for(uint16_t j = 0; j < (k - 2); j++)
-	{
-		for(uint8_t b = 0; b < 8; b++)
-			calculateCRC((rxBuffer[i] >> b) & 1, crc);
-
-		i++;
-		i %= FRAME_BUFFER_SIZE;
-	}
+	k -= 2; //without FCS
+	*crc = crc_ccit_block(CRC_CCIT_INIT_VAL, frame, k) ^ 0xFFFF;
+	if((frame[k] != (*crc & 0xFF)) || (frame[k + 1] != ((*crc >> 8) & 0xFF))) //check CRC
+		return 0;
 
-
-	*crc ^= 0xFFFF;
-	if((rxBuffer[i] == (*crc & 0xFF) )
-		&& (rxBuffer[(i + 1) % FRAME_BUFFER_SIZE] == ((*crc >> 8) & 0xFF))) //check CRC
+	uint16_t pathEnd = 0;
+	for(; pathEnd < k; pathEnd++)
 	{
-		uint16_t pathEnd = initialRxBufferHead;
-		for(uint16_t j = 0; j < (k - 2); j++)
-		{
-			if(rxBuffer[pathEnd] & 1)
-				break;
-			pathEnd++;
-			pathEnd %= FRAME_BUFFER_SIZE;
-		}
-
-		if(Ax25Config.allowNonAprs || (((rxBuffer[(pathEnd + 1) % FRAME_BUFFER_SIZE] == 0x03) && (rxBuffer[(pathEnd + 2) % FRAME_BUFFER_SIZE] == 0xF0))))
-		{
-			h->size = k - 2;
-			// Only increment rxFrameHead after successful validation
-			rxFrameHead = tempRxFrameHead + 1;
-			rxFrameHead %= FRAME_MAX_COUNT;
-			if(rxFrameHead == txFrameHead)
-				rxFrameBufferFull = true;
-			return h;
-		}
+		if(frame[pathEnd] & 1)
+			break;
 	}
 
-	removeLastFrameFromRxBuffer();
-	return NULL;
+	if(Ax25Config.allowNonAprs || (((frame[pathEnd + 1] == 0x03) && (frame[pathEnd + 2] == 0xF0))))
+		return k;
+	return 0;
 }
 #endif
 
@@ -586,31 +876,21 @@ void *Ax25WriteTxFrame(uint8_t *data, uint16_t size)
 }
 
 
-bool Ax25ReadNextRxFrame(uint8_t **dst, uint16_t *size, int8_t *peak, int8_t *valley, uint8_t *level, uint8_t *corrected, uint16_t *mV)
+struct Ax25RxFrame *Ax25BorrowRxFrame(void)
 {
-	if((rxFrameHead == rxFrameTail) && !rxFrameBufferFull)
-		return false;
-
-	*dst = outputFrameBuffer;
-
-	for(uint16_t i = 0; i < rxFrame[rxFrameTail].size; i++)
-	{
-		(*dst)[i] = rxBuffer[(rxFrame[rxFrameTail].start + i) % FRAME_BUFFER_SIZE];
-	}
-
-	*peak = rxFrame[rxFrameTail].peak;
-	*valley = rxFrame[rxFrameTail].valley;
-	*level = rxFrame[rxFrameTail].level;
-	*size = rxFrame[rxFrameTail].size;
-	*corrected = rxFrame[rxFrameTail].corrected;
-	*mV = rxFrame[rxFrameTail].mVrms;
+	uint8_t slot;
+	if(!slotRingPeek(&rxReady, &slot))
+		return NULL;
+	return &rxSlots[slot];
+}
 
-	//__disable_irq();
-	rxFrameBufferFull = false;
-	rxFrameTail++;
-	rxFrameTail %= FRAME_MAX_COUNT;
-	//__enable_irq();
-	return true;
+void Ax25ReleaseRxFrame(struct Ax25RxFrame *frame)
+{
+	uint8_t slot;
+	if(!slotRingPeek(&rxReady, &slot) || (frame != &rxSlots[slot]))
+		return;
+	slotRingPop(&rxReady, &slot);
+	slotRingPush(&rxFree, slot);
 }
 
 enum Ax25RxStage Ax25GetRxStage(uint8_t modem)
@@ -619,25 +899,15 @@ enum Ax25RxStage Ax25GetRxStage(uint8_t modem)
 }
 
 extern AX25Ctx AX25;
-void Ax25BitParse(uint8_t bit, uint8_t modem,uint16_t mV)
+void Ax25BitParse(uint8_t bit, uint8_t modem,uint16_t mV, uint8_t weak)
 {
-	if(lastCrc != 0) //there was a frame received
-	{
-		rxMultiplexDelay++;
-		if(rxMultiplexDelay > (4 * MODEM_MAX_DEMODULATOR_COUNT)) //hold it for a while and wait for other decoders to receive the frame
-		{
-			lastCrc = 0;
-			rxMultiplexDelay = 0;
-			for(uint8_t i = 0; i < MODEM_MAX_DEMODULATOR_COUNT; i++)
-			{
-				frameReceived |= ((rxState[i].frameReceived > 0) << i);
-				rxState[i].frameReceived = 0;
-			}
-		}
-
-	}
+	rxTick++;
+	if(rxCrcCount != 0) //there were frames received, forget them after a while
+		expireRxCrc();
 
 	struct RxState *rx = (struct RxState*)&(rxState[modem]);
+	if(rx->frame == NULL) //no RX frame pool
+		return;
 
 	rx->rawData <<= 1; //store incoming bit
 	rx->rawData |= (bit > 0);
@@ -649,7 +919,7 @@ void Ax25BitParse(uint8_t bit, uint8_t modem,uint16_t mV)
 
 	if(Ax25Config.fx25
 			&& (rx->rx != RX_STAGE_FX25_FRAME)
-			&& (NULL != (rx->fx25Mode = (struct Fx25Mode*)Fx25GetModeForTag(rx->tag))))
+			&& (NULL != (rx->fx25Mode = (struct Fx25Mode*)Fx25GetModeForTag(rx->tag, &rx->tagErrors))))
 	{
 		rx->rx = RX_STAGE_FX25_FRAME;
 		rx->receivedByte = 0;
@@ -669,6 +939,12 @@ void Ax25BitParse(uint8_t bit, uint8_t modem,uint16_t mV)
 				if(rx->frameIdx >= 17) //correct frame must be at least 17 bytes long (source+destination+control+CRC)
 				{
 					rx->crc ^= 0xFFFF;
+					bool fixed = false;
+					if((rx->frame[rx->frameIdx - 2] != (rx->crc & 0xFF)) || (rx->frame[rx->frameIdx - 1] != ((rx->crc >> 8) & 0xFF))) //check CRC
+					{
+						if(Ax25Config.fixBits && fixRxBits(rx)) //bad CRC, try flipping the least confident bits
+							fixed = true;
+					}
 					if((rx->frame[rx->frameIdx - 2] == (rx->crc & 0xFF)) && (rx->frame[rx->frameIdx - 1] == ((rx->crc >> 8) & 0xFF))) //check CRC
 					{
 						uint16_t i = 13;
@@ -684,45 +960,29 @@ void Ax25BitParse(uint8_t bit, uint8_t modem,uint16_t mV)
 						if(Ax25Config.allowNonAprs || (((rx->frame[i + 1] == 0x03) && (rx->frame[i + 2] == 0xF0))))
 						{                                                       
 
-							rx->frameReceived = 1;
 							rx->frameIdx -= 2; //remove CRC
-							if(rx->crc != lastCrc) //the other decoder has not received this frame yet, so store it in main frame buffer
+							if(registerRxCrc(rx->crc, modem)) //no other decoder has received this frame yet, so store it in main frame buffer
 							{
-								lastCrc = rx->crc; //store CRC of this frame
                                 //  ax25_decode(rx->frame,rx->frameIdx,mV);
                                 //  int8_t peak,valley;
                                 //  uint8_t level;
                                 //  ModemGetSignalLevel(modem, &peak,&valley,&level);
                                 //log_d("Pkt=%d SND: peak=%d valley=%d level=%d",rx->frameIdx,peak,valley,level);
 
-								if(!rxFrameBufferFull) //if enough space, store the frame
+								if(publishRxFrame(rx, modem, mV, AX25_NOT_FX25)) //if enough space, hand the frame over to the consumer
 								{
-									rxFrame[rxFrameHead].start = rxBufferHead;
-									rxFrame[rxFrameHead].mVrms=mV;
-									ModemGetSignalLevel(modem, &rxFrame[rxFrameHead].peak, &rxFrame[rxFrameHead].valley, &rxFrame[rxFrameHead].level);
-									log_d("Pkt=%d SND: peak=%d valley=%d level=%d",rx->frameIdx,rxFrame[rxFrameHead].peak,rxFrame[rxFrameHead].valley,rxFrame[rxFrameHead].level);
-#ifdef ENABLE_FX25
-									rxFrame[rxFrameHead].fx25Mode = NULL;
-#endif
-									rxFrame[rxFrameHead].corrected = AX25_NOT_FX25;
-									//__disable_irq();
-									rxFrame[rxFrameHead++].size = rx->frameIdx;
-									rxFrameHead %= FRAME_MAX_COUNT;
-									if(rxFrameHead == rxFrameTail)
-										rxFrameBufferFull = true;
-									//__enable_irq();
-
-									for(uint16_t i = 0; i < rx->frameIdx; i++)
-									{
-										rxBuffer[rxBufferHead++] = rx->frame[i];
-										rxBufferHead %= FRAME_BUFFER_SIZE;
-									}
+									rxStats.frames++;
+									if(fixed)
+										rxStats.bitFixes++;
 								}else{
+									rxStats.overruns++;
 									log_w("RX frame buffer full");
 								}
 							}
 						}
 					}
+					else
+						rxStats.crcErrors++;
 				}
 			}
 			rx->rx = RX_STAGE_FLAG;
@@ -755,16 +1015,16 @@ void Ax25BitParse(uint8_t bit, uint8_t modem,uint16_t mV)
 	if(rx->rawData & 0x01) //received bit 1
 		rx->receivedByte |= 0x80; //store it
 
+	if((rx->frameIdx == 0) && (rx->receivedBitIdx == 0)) //first bit of a new frame
+		rx->weakCount = 0;
+	if(weak)
+		storeWeakBit(rx, rx->frameIdx * 8 + rx->receivedBitIdx, weak);
+
 
 	if(++rx->receivedBitIdx >= 8) //received full byte
 	{
-		if(rx->frameIdx >= 2)
-		{
-			for(uint8_t k = 0; k < 8; k++)
-			{
-				calculateCRC((rx->frame[rx->frameIdx - 2] >> k) & 1, &(rx->crc));
-			}
-		}
+		if(rx->frameIdx >= 2) //CRC lags two bytes behind, so that the FCS itself is not included
+			rx->crc = update_crc_ccit(rx->frame[rx->frameIdx - 2], rx->crc);
 
 #ifdef ENABLE_FX25
 		//end of FX.25 reception, that is received full block
@@ -773,23 +1033,27 @@ void Ax25BitParse(uint8_t bit, uint8_t modem,uint16_t mV)
 			uint8_t fixed = 0;
 			bool fecSuccess = Fx25Decode(rx->frame, rx->fx25Mode, &fixed);
 			uint16_t crc;
-			struct FrameHandle *h = parseFx25Frame(rx->frame, rx->frameIdx, &crc);
-			if(h != NULL)
+			uint16_t size = parseFx25Frame(rx->frame, rx->frameIdx, &crc);
+			if(size == 0)
+				rxStats.fx25Failures++;
+			else if(registerRxCrc(crc, modem)) //no other decoder has received this frame yet
 			{
-				rx->frameReceived = 1;
-				ModemGetSignalLevel(modem, &h->peak, &h->valley, &h->level);
-				if(fecSuccess)
+				rx->frameIdx = size;
+				if(publishRxFrame(rx, modem, mV, fecSuccess ? fixed : AX25_NOT_FX25))
 				{
-					h->corrected = fixed;
-					h->fx25Mode = rx->fx25Mode;
+					if(fecSuccess)
+						rxStats.fx25Corrected += fixed;
+					if(rx->tagErrors)
+						rxStats.fx25TagFixed++;
+					rxStats.frames++;
+					rxStats.fx25Frames++;
 				}
 				else
-					h->corrected = AX25_NOT_FX25;
-				lastCrc = crc;
+				{
+					rxStats.overruns++;
+					log_w("RX frame buffer full");
+				}
 			}
-			// on failure, parseFx25Frame() already cleaned up the buffer state itself
-			// (calling removeLastFrameFromRxBuffer() again here would rewind rxBufferHead
-			// past the previous, still-unread frame and corrupt it)
 			rx->rx = RX_STAGE_FLAG;
 			rx->receivedByte = 0;
 			rx->receivedBitIdx = 0;
@@ -817,6 +1081,17 @@ void Ax25BitParse(uint8_t bit, uint8_t modem,uint16_t mV)
 }
 
 
+/**
+ * @brief Check if the next queued frame would exceed the burst airtime limit
+ * @return True if there is a next frame and it must wait for another transmission
+ */
+static inline bool burstFull(void)
+{
+	if((txFrameHead == txFrameTail) && !txFrameBufferFull)
+		return false;
+	return ((txBits - txBurstStart) + (uint32_t)txFrame[txFrameTail].size * 8) > txBurstBits;
+}
+
 uint8_t Ax25GetTxBit(void)
 {
 	if(txBitIdx == 8)
@@ -879,6 +1154,10 @@ transmitNormalData:
 				{
 					txByte = txBuffer[(txFrame[txFrameTail].start + txByteIdx) % FRAME_BUFFER_SIZE];
 					txByteIdx++;
+#ifdef ENABLE_FX25
+					if(NULL == txFrame[txFrameTail].fx25Mode) //FX.25 blocks already carry the FCS
+#endif
+						txCrc = update_crc_ccit(txByte, txCrc);
 				}
 #ifdef ENABLE_FX25
 				else if(txFrame[txFrameTail].fx25Mode != NULL)
@@ -888,7 +1167,13 @@ transmitNormalData:
 					txFrameTail++;
 					txFrameTail %= FRAME_MAX_COUNT;
 					txByteIdx = 0;
+					txStats.frames++;
 					//__enable_irq();
+					if(burstFull())
+					{
+						txStats.burstCuts++;
+						goto transmitTail;
+					}
 					if((txFrameHead != txFrameTail) || txFrameBufferFull)
 					{
 						if(txFrame[txFrameTail].fx25Mode != NULL)
@@ -945,23 +1230,33 @@ transmitTail:
 			else
 			{
 				txFlagsElapsed = 0;
+				txBitstuff = 0; //flags are not stuffed, ones at the end of the CRC must not count in the next frame
 				//__disable_irq();
 				txFrameBufferFull = false;
 				txFrameTail++;
 				txFrameTail %= FRAME_MAX_COUNT;
 				txByteIdx = 0;
-#ifdef ENABLE_FX25
-				if(((txFrameHead != txFrameTail) || txFrameBufferFull) && (txFrame[txFrameTail].fx25Mode != NULL))
+				txStats.frames++;
+				if(burstFull()) //next frame waits for another transmission, send the tail now
 				{
-					//__enable_irq();
-					txStage = TX_STAGE_CORRELATION_TAG;
-					txTagByteIdx = 0;
-					goto transmitTag;
+					txStats.burstCuts++;
+					txStage = TX_STAGE_TAIL;
 				}
+				else
+				{
+#ifdef ENABLE_FX25
+					if(((txFrameHead != txFrameTail) || txFrameBufferFull) && (txFrame[txFrameTail].fx25Mode != NULL))
+					{
+						//__enable_irq();
+						txStage = TX_STAGE_CORRELATION_TAG;
+						txTagByteIdx = 0;
+						goto transmitTag;
+					}
 #endif
-				//__enable_irq();
-				txStage = TX_STAGE_DATA; //return to normal data transmission stage. There might be a next frame to transmit
-				goto transmitNormalData;
+					//__enable_irq();
+					txStage = TX_STAGE_DATA; //return to normal data transmission stage. There might be a next frame to transmit
+					goto transmitNormalData;
+				}
 			}
 		}
 		if(txStage == TX_STAGE_TAIL) //transmitting tail
@@ -979,7 +1274,10 @@ transmitTail:
 				txBitstuff = 0;
 				txByte = 0;
 				txInitStage = TX_INIT_OFF;
-				txBufferTail = txBufferHead;
+				if((txFrameHead != txFrameTail) || txFrameBufferFull) //frames left by the burst limit stay in the buffer
+					txBufferTail = txFrame[txFrameTail].start;
+				else
+					txBufferTail = txBufferHead;
 				ModemTransmitStop();
 				return 0;
 			}
@@ -987,6 +1285,7 @@ transmitTail:
 
 	}
 
+	txBits++;
 	uint8_t txBit = 0;
 	//transmitting normal data or CRC in AX.25 mode
 	if(
@@ -1012,9 +1311,6 @@ transmitTail:
 				txBit = 0;
 				txBitstuff = 0; //0 being transmitted, reset bit stuffing counter
 			}
-			if(txStage == TX_STAGE_DATA) //calculate CRC only for normal data
-				calculateCRC(txByte & 1, &txCrc);
-
 			txByte >>= 1;
 			txBitIdx++;
 		}
@@ -1060,13 +1356,33 @@ static void transmitStart(void)
 	txBitIdx = 0;
 	txFlagsElapsed = 0;
 	txDelayElapsed = 0;
+	txBurstStart = txBits;
+	txStats.transmissions++;
 	ModemTransmitStart();
 	log_d("transmitStart");
 }
 
 
+/**
+ * @brief Check if the channel is busy
+ * @return True if any demodulator of the TX port has DCD or any of its decoders is inside a frame
+ */
+static bool channelBusy(void)
+{
+	if(ModemDcdState())
+		return true;
+	for(uint8_t i = 0; i < ModemGetDemodulatorCount(); i++)
+	{
+		if((ModemGetDemodulatorPort(i) == 0) && (rxState[i].rx > RX_STAGE_FLAG))
+			return true;
+	}
+	return false;
+}
+
 /**
  * @brief Start transmitting when possible
+ * @details p-persistent CSMA: after the quiet time the channel is sampled once per slot time.
+ * A busy slot is skipped. A free slot is used with probability (persist + 1) / 256.
  * @attention Must be continuously polled in main loop
  */
 void Ax25TransmitCheck(void)
@@ -1079,29 +1395,36 @@ void Ax25TransmitCheck(void)
 	 //if(ModemIsTxTestOngoing()) //TX test is enabled, wait for now
 	 //	return;
 
-	 if(txQuiet < millis()) //quit time has elapsed
+	 unsigned long now = millis();
+	 if((long)(now - txQuiet) < 0) //quiet time or current slot has not elapsed yet
+	 	return;
+
+	 if(!txDeferring)
 	 {
-	 	if(!ModemDcdState()) //channel is free
-	 	{
-	 		txInitStage = TX_INIT_TRANSMITTING; //transmit right now
-	 		txRetries = 0;
-	 		transmitStart();
-	 	}
-	 	else //channel is busy
+	 	txDeferring = true;
+	 	txDeferStart = now;
+	 }
+
+	 if(channelBusy())
+	 {
+	 	if((now - txDeferStart) < CSMA_MAX_DEFER_TIME)
 	 	{
-	 		if(txRetries >= MAX_TRANSMIT_RETRY_COUNT) //timeout
-	 		{
-	 			txInitStage = TX_INIT_TRANSMITTING; //transmit right now
-	 			txRetries = 0;
-	 			transmitStart();
-	 		}
-	 		else //still trying
-	 		{
-	 			txQuiet = millis() + random(100, 1000); //try again after some random time
-	 			txRetries++;
-	 		}
+	 		txStats.busyDefers++;
+	 		txQuiet = now + Ax25Config.slotTime; //sample the channel again in the next slot
+	 		return;
 	 	}
+	 	txStats.forced++; //busy for too long, most likely a stuck DCD
+	 }
+	 else if((uint8_t)random(0, 256) > Ax25Config.persist) //channel is free, but not our turn
+	 {
+	 	txStats.persistDefers++;
+	 	txQuiet = now + Ax25Config.slotTime;
+	 	return;
 	 }
+
+	 txDeferring = false;
+	 txInitStage = TX_INIT_TRANSMITTING; //transmit right now
+	 transmitStart();
 }
 
 void Ax25Init(uint8_t fx25Mode)
@@ -1109,6 +1432,9 @@ void Ax25Init(uint8_t fx25Mode)
 	txCrc = 0xFFFF;
     memset(&Ax25Config, 0, sizeof(Ax25Config));
     Ax25Config.quietTime = 2000;
+	Ax25Config.slotTime = AX25_SLOT_TIME_DEFAULT;
+	Ax25Config.persist = AX25_PERSIST_DEFAULT;
+	Ax25Config.burstTime = AX25_BURST_TIME_DEFAULT;
 	Ax25Config.txDelayLength = 300;
 	Ax25Config.txTailLength = 1;
 	if(fx25Mode==0){
@@ -1122,12 +1448,25 @@ void Ax25Init(uint8_t fx25Mode)
 		Ax25Config.fx25Tx = 1;
 	}
 
-	memset((void*)rxState, 0, sizeof(rxState));
+	Ax25Config.fixBits = AX25_FIX_BITS_DEFAULT;
+
+	initRxPool();
 	for(uint8_t i = 0; i < (sizeof(rxState) / sizeof(rxState[0])); i++)
+	{
+		uint8_t slot = rxSlots ? rxState[i].slot : 0;
+		if(rxState[i].frame == NULL) //first init, decoder i owns slot i
+			slot = i;
+		memset((void*)&rxState[i], 0, sizeof(rxState[i]));
+		rxState[i].slot = slot;
+		rxState[i].frame = rxSlots ? rxSlots[slot].data : NULL;
 		rxState[i].crc = 0xFFFF;
+	}
+	memset(rxCrcSet, 0, sizeof(rxCrcSet));
+	rxCrcCount = 0;
 
 	txDelay = ((float)Ax25Config.txDelayLength / (8.f * 1000.f / ModemGetBaudrate())); //change milliseconds to byte count
 	txTail = ((float)Ax25Config.txTailLength / (8.f * 1000.f / ModemGetBaudrate()));
+	txBurstBits = ((float)Ax25Config.burstTime * ModemGetBaudrate() / 1000.f); //change milliseconds to bit count
 	txInitStage == TX_INIT_OFF;
 	txQuiet = (millis() + (Ax25Config.quietTime) + random(10, 200)); //calculate required delay
 }
@@ -1138,6 +1477,36 @@ void Ax25TxDelay(uint16_t delay_ms)
 	txDelay = ((float)Ax25Config.txDelayLength / (8.f * 1000.f / ModemGetBaudrate())); //change milliseconds to byte count
 }
 
+void Ax25TxTail(uint16_t tail_ms)
+{
+	Ax25Config.txTailLength = tail_ms;
+	txTail = ((float)Ax25Config.txTailLength / (8.f * 1000.f / ModemGetBaudrate())); //change milliseconds to byte count
+}
+
+void Ax25Csma(uint16_t slot_ms, uint8_t persist)
+{
+	Ax25Config.slotTime = slot_ms;
+	Ax25Config.persist = persist;
+}
+
+void Ax25BurstTime(uint16_t burst_ms)
+{
+	Ax25Config.burstTime = burst_ms;
+	txBurstBits = ((float)Ax25Config.burstTime * ModemGetBaudrate() / 1000.f); //change milliseconds to bit count
+}
+
+uint8_t Ax25TxFreeFrames(void)
+{
+	if(txFrameBufferFull)
+		return 0;
+	return FRAME_MAX_COUNT - ((txFrameHead + FRAME_MAX_COUNT - txFrameTail) % FRAME_MAX_COUNT);
+}
+
+void Ax25FixBits(uint16_t attempts)
+{
+	Ax25Config.fixBits = attempts;
+}
+
 void Ax25TimeSlot(uint16_t ts)
 {
 	if(ts>0){
@@ -1282,7 +1651,6 @@ char ax25_encode(ax25frame &frame, char *txt, int size)
     return 0;
 }
 
-#define CRC_CCIT_INIT_VAL ((uint16_t)0xFFFF)
 #define HDLC_FLAG  0x7E
 #define HDLC_RESET 0x7F
 #define AX25_ESC   0x1B
@@ -1361,7 +1729,35 @@ int hdlcFrame(uint8_t *outbuf, size_t outbuf_len, AX25Ctx *ctx, ax25frame *pkg)
     return idx;
 }
 
+void Ax25SetRxNotify(ax25_notify_t notify)
+{
+	rxNotify = notify;
+}
+
+bool Ax25TxBusy(void)
+{
+	return (txInitStage != TX_INIT_OFF) || (txFrameHead != txFrameTail) || txFrameBufferFull;
+}
+
 bool Ax25NewRxFrames(void)
 {
-	return (rxFrameHead != rxFrameTail) || rxFrameBufferFull;
-}
\ No newline at end of file
+	return slotRingSize(&rxReady) != 0;
+}
+
+void Ax25GetRxStats(struct Ax25RxStats *stats)
+{
+	*stats = rxStats;
+	stats->poolSize = (rxSlotCount > MODEM_MAX_DEMODULATOR_COUNT) ? (rxSlotCount - MODEM_MAX_DEMODULATOR_COUNT) : 0;
+	stats->poolUsed = slotRingSize(&rxReady);
+}
+
+void Ax25ClearRxStats(void)
+{
+	memset(&rxStats, 0, sizeof(rxStats));
+}
+
+void Ax25GetTxStats(struct Ax25TxStats *stats)
+{
+	*stats = txStats;
+	stats->airtimeMs = (uint32_t)((double)txBits * 1000.0 / ModemGetBaudrate());
+}
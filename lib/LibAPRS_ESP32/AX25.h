@@ -23,6 +23,7 @@ along with VP-Digi.  If not, see <http://www.gnu.org/licenses/>.
 #include <Arduino.h>
 #include <stdint.h>
 #include <stdbool.h>
+#include "modem.h"
 
 #define AX25_NOT_FX25 255
 
@@ -44,9 +45,63 @@ struct Ax25ProtoConfig
 	uint16_t txDelayLength; //TXDelay length in ms
 	uint16_t txTailLength; //TXTail length in ms
 	uint16_t quietTime; //Quiet time in ms
+	uint16_t slotTime; //CSMA slot time in ms (KISS SLOTTIME * 10)
+	uint8_t persist; //CSMA persistence, transmit in a free slot with probability (persist + 1) / 256 (KISS P)
+	uint16_t burstTime; //max airtime of one transmission in ms, queued frames beyond it wait for the next one
 	uint8_t allowNonAprs : 1; //allow non-APRS packets
 	bool fx25 : 1; //enable FX.25 (AX.25 + FEC)
 	bool fx25Tx : 1; //enable TX in FX.25
+	uint16_t fixBits; //max CRC recovery attempts (bit flip candidates) per failed frame, 0 - disabled
+};
+
+#define AX25_FIX_BITS_DEFAULT 32 //default CRC recovery attempt budget
+#define AX25_SLOT_TIME_DEFAULT 100 //default CSMA slot time in ms, KISS default SLOTTIME 10
+#define AX25_PERSIST_DEFAULT 63 //default CSMA persistence, KISS default P 63 (25 %)
+#define AX25_BURST_TIME_DEFAULT 3000 //default max airtime of one transmission in ms
+
+struct Ax25TxStats
+{
+	uint32_t transmissions; //PTT cycles
+	uint32_t frames; //frames sent
+	uint32_t airtimeMs; //time spent transmitting
+	uint32_t busyDefers; //slots skipped because the channel was busy
+	uint32_t persistDefers; //free slots skipped by the persistence draw
+	uint32_t forced; //transmissions started on a channel that stayed busy too long (stuck DCD)
+	uint32_t burstCuts; //transmissions ended early by the burst airtime limit with frames still queued
+};
+
+struct Ax25RxStats
+{
+	uint32_t frames; //frames stored in RX buffer
+	uint32_t portFrames[MODEM_MAX_PORTS]; //frames stored in RX buffer per port
+	uint32_t crcErrors; //complete frames dropped due to CRC mismatch (counted per decoder)
+	uint32_t overruns; //good frames dropped because RX frame pool was full
+	uint32_t fx25Frames; //frames recovered from FX.25 blocks
+	uint32_t fx25Corrected; //total number of bytes fixed by FX.25 decoder
+	uint32_t fx25Failures; //FX.25 blocks that could not be recovered
+	uint32_t fx25TagFixed; //FX.25 frames received despite bit errors in the correlation tag
+	uint32_t duplicates; //frames dropped because another decoder already received them
+	uint32_t bitFixes; //frames recovered by flipping 1 or 2 low-confidence bits
+	uint32_t slotFirst[MODEM_MAX_DEMODULATOR_COUNT]; //frames where this decoder was the first to hit
+	uint32_t slotDecoded[MODEM_MAX_DEMODULATOR_COUNT]; //all frames decoded by this decoder
+	uint16_t poolSize; //number of received frames the RX frame pool can hold
+	uint16_t poolUsed; //frames currently waiting for the consumer or borrowed
+	uint16_t poolPeak; //highest poolUsed seen
+};
+
+/**
+ * @brief Received frame, stored in a slot of the RX frame pool
+ */
+struct Ax25RxFrame
+{
+	uint16_t size; //frame size without FCS
+	int8_t peak; //signal positive peak value in %
+	int8_t valley; //signal negative peak value in %
+	uint8_t level; //signal level in %
+	uint8_t corrected; //number of bytes corrected in FX.25 mode, AX25_NOT_FX25 if not a FX.25 frame
+	uint16_t mVrms; //signal level in mV RMS
+	uint8_t port; //port (audio input) the frame was received on
+	uint8_t data[AX25_FRAME_MAX_SIZE];
 };
 
 #define AX25_CTRL_UI      0x03
@@ -59,6 +114,7 @@ extern bool ax25_stateTx;
 extern int transmissionState;
 
 typedef void (*ax25_callback_t)(struct AX25Msg *msg);
+typedef void (*ax25_notify_t)(void);
 typedef struct Hdlc
 {
     uint8_t demodulatedBits;
@@ -136,16 +192,18 @@ uint8_t Ax25GetReceivedFrameBitmap(void);
 void Ax25ClearReceivedFrameBitmap(void);
 
 /**
- * @brief Get next received frame (if available)
- * @param **dst Pointer to internal buffer
- * @param *size Actual frame size
- * @param *peak Signal positive peak value in %
- * @param *valley Signal negative peak value in %
- * @param *level Signal level in %
- * @param *corrected Number of bytes corrected in FX.25 mode. 255 is returned if not a FX.25 packet.
- * @return True if frame was read, false if no more frames to read
+ * @brief Borrow the oldest received frame (if available)
+ * @details The frame is not copied, it stays in its pool slot until released with Ax25ReleaseRxFrame().
+ * Calling this again before the release returns the same frame.
+ * @return Pointer to the frame or NULL if there are no frames
  */
-bool Ax25ReadNextRxFrame(uint8_t **dst, uint16_t *size, int8_t *peak, int8_t *valley, uint8_t *level, uint8_t *corrected, uint16_t *mV);
+struct Ax25RxFrame *Ax25BorrowRxFrame(void);
+
+/**
+ * @brief Return a frame obtained with Ax25BorrowRxFrame() to the RX frame pool
+ * @param *frame Borrowed frame, must not be used afterwards
+ */
+void Ax25ReleaseRxFrame(struct Ax25RxFrame *frame);
 
 /**
  * @brief Get current RX stage
@@ -160,9 +218,10 @@ enum Ax25RxStage Ax25GetRxStage(uint8_t modemNo);
  * @details Handles bit-stuffing, header and CRC checking, stores received frame and sets "frame received flag", multiplexes both decoders
  * @param[in] bit Incoming bit
  * @param[in] *dem Modem state pointer
+ * @param[in] weak Bit confidence from the symbol slicer, 0 - certain, higher - less confident
  * @warning Only for internal use
  */
-void Ax25BitParse(uint8_t bit, uint8_t modem,uint16_t mV);
+void Ax25BitParse(uint8_t bit, uint8_t modem,uint16_t mV, uint8_t weak = 0);
 
 /**
  * @brief Get next bit to be transmitted
@@ -194,6 +253,73 @@ char ax25_encode(ax25frame &frame, char *txt,int size);
 int hdlcFrame(uint8_t *outbuf, size_t outbuf_len, AX25Ctx *ctx, ax25frame *pkg);
 void Ax25TxDelay(uint16_t delay_ms);
 void Ax25TimeSlot(uint16_t ts);
+
+/**
+ * @brief Set TXTail length
+ * @param tail_ms Tail length in ms
+ */
+void Ax25TxTail(uint16_t tail_ms);
+
+/**
+ * @brief Set CSMA channel access parameters (KISS SLOTTIME and P)
+ * @details Once the quiet time has passed, the channel is sampled every slot time. In a free slot the
+ * frame is sent with probability (persist + 1) / 256, otherwise the next slot is waited for.
+ * @param slot_ms Slot time in ms
+ * @param persist Persistence, 255 - transmit in the first free slot
+ */
+void Ax25Csma(uint16_t slot_ms, uint8_t persist);
+
+/**
+ * @brief Set the burst airtime limit
+ * @details Frames queued while transmitting are sent in the same transmission, separated only by a flag,
+ * as long as the next frame still ends within this time from the start of the transmission
+ * @param burst_ms Max airtime in ms
+ */
+void Ax25BurstTime(uint16_t burst_ms);
+
+/**
+ * @brief Get number of frames that can still be written to the transmit buffer
+ * @return Free frame handles
+ */
+uint8_t Ax25TxFreeFrames(void);
+
+/**
+ * @brief Get transmitter and channel access statistics
+ * @param[out] *stats Statistics
+ */
+void Ax25GetTxStats(struct Ax25TxStats *stats);
+
+/**
+ * @brief Set the CRC recovery budget
+ * @details When a frame fails the FCS check, up to this many single and double flips of its
+ * least confident bits are tried before the frame is dropped
+ * @param attempts Max attempts per frame, 0 - disabled
+ */
+void Ax25FixBits(uint16_t attempts);
 bool Ax25NewRxFrames(void);
 
+/**
+ * @brief Set the function called when a received frame is committed to the RX frame pool
+ * @details Called from the RX (modem polling) task, typically used to wake the task consuming frames
+ * @param notify Function to call, NULL to disable
+ */
+void Ax25SetRxNotify(ax25_notify_t notify);
+
+/**
+ * @brief Check if frames are waiting for transmission or being transmitted
+ * @return True if TX is pending or ongoing
+ */
+bool Ax25TxBusy(void);
+
+/**
+ * @brief Get receiver statistics
+ * @param *stats Output structure
+ */
+void Ax25GetRxStats(struct Ax25RxStats *stats);
+
+/**
+ * @brief Clear receiver statistics
+ */
+void Ax25ClearRxStats(void);
+
 #endif /* AX25_H_ */
\ No newline at end of file
@@ -1,6 +1,8 @@
 #include "CRC-CCIT.h"
+#include "esp_attr.h"
 
-const uint16_t crc_ccit_table[256] = {
+// kept in internal RAM: it is read for every received byte of every demodulator, a flash cache miss costs more than the lookup
+DRAM_ATTR const uint16_t crc_ccit_table[256] = {
     0x0000, 0x1189, 0x2312, 0x329b, 0x4624, 0x57ad, 0x6536, 0x74bf,
     0x8c48, 0x9dc1, 0xaf5a, 0xbed3, 0xca6c, 0xdbe5, 0xe97e, 0xf8f7,
     0x1081, 0x0108, 0x3393, 0x221a, 0x56a5, 0x472c, 0x75b7, 0x643e,
@@ -33,4 +35,25 @@ const uint16_t crc_ccit_table[256] = {
     0x6b46, 0x7acf, 0x4854, 0x59dd, 0x2d62, 0x3ceb, 0x0e70, 0x1ff9,
     0xf78f, 0xe606, 0xd49d, 0xc514, 0xb1ab, 0xa022, 0x92b9, 0x8330,
     0x7bc7, 0x6a4e, 0x58d5, 0x495c, 0x3de3, 0x2c6a, 0x1ef1, 0x0f78,
-};
\ No newline at end of file
+};
+
+uint16_t crc_ccit_block(uint16_t crc, const uint8_t *data, size_t len)
+{
+    while (len--)
+        crc = (crc >> 8) ^ crc_ccit_table[(crc ^ *data++) & 0xff];
+    return crc;
+}
+
+uint16_t crc_ccit_ring(uint16_t crc, const uint8_t *buf, size_t bufSize, size_t start, size_t len)
+{
+    while (len > 0)
+    {
+        size_t n = bufSize - start; // bytes until the wrap
+        if (n > len)
+            n = len;
+        crc = crc_ccit_block(crc, &buf[start], n);
+        len -= n;
+        start = 0;
+    }
+    return crc;
+}
@@ -4,12 +4,33 @@
 #define CRC_CCIT_H
 
 #include <stdint.h>
+#include <stddef.h>
 #include <pgmspace.h>
 
 #define CRC_CCIT_INIT_VAL ((uint16_t)0xFFFF)
 
+// Reflected CRC-16/CCITT (polynomial 0x8408), the AX.25 FCS. Bytes are processed LSB first,
+// exactly as the bits go over the air, so this is interchangeable with a bit-by-bit update.
 extern const uint16_t crc_ccit_table[256];
 
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * Update crc with len bytes, no final inversion.
+ */
+uint16_t crc_ccit_block(uint16_t crc, const uint8_t *data, size_t len);
+
+/*
+ * Same over a circular buffer of bufSize bytes, starting at start.
+ */
+uint16_t crc_ccit_ring(uint16_t crc, const uint8_t *buf, size_t bufSize, size_t start, size_t len);
+
+#ifdef __cplusplus
+}
+#endif
+
 inline uint16_t update_crc_ccit(uint8_t c, uint16_t prev_crc) {
     //return (prev_crc >> 8) ^ pgm_read_word(&crc_ccit_table[(prev_crc ^ c) & 0xff]);
     return (prev_crc >> 8) ^ crc_ccit_table[(prev_crc ^ c) & 0xff];
@@ -6,10 +6,9 @@
 #include "AX25.h"
 
 size_t ctxbufflen;
-size_t frame_len = 0;
 uint8_t *ctxbuffer;
 
-static uint8_t serialBuffer[AX25_MAX_FRAME_LEN]; // Buffer for holding incoming serial data
+static uint8_t serialBuffer[AX25_MAX_FRAME_LEN]; // Buffer for kiss_parse()
 AX25Ctx testkiss;
 extern AX25Ctx AX25;
 extern void aprs_msg_callback(struct AX25Msg *msg);
@@ -21,7 +20,30 @@ uint8_t command = CMD_UNKNOWN;
 
 extern struct Ax25ProtoConfig Ax25Config;
 
-uint8_t p = 63;
+/**
+ * Apply a KISS parameter command (TXDELAY, P, SLOTTIME, TXTAIL) to the running AX.25 layer
+ */
+static void kiss_set_param(uint8_t cmd, uint8_t value)
+{
+    switch (cmd)
+    {
+    case CMD_TXDELAY:
+        Ax25TxDelay(value * 10);
+        break;
+    case CMD_TXTAIL:
+        Ax25TxTail(value * 10);
+        break;
+    case CMD_SLOTTIME:
+        Ax25Csma(value * 10, Ax25Config.persist);
+        break;
+    case CMD_P:
+        Ax25Csma(Ax25Config.slotTime, value);
+        break;
+    default:
+        return;
+    }
+    log_d("[KISS] cmd %d = %d", cmd, value);
+}
 
 int kiss_wrapper(uint8_t *pkg, uint8_t *buf, size_t len)
 {
@@ -81,71 +103,73 @@ int kiss_wrapper(uint8_t *pkg)
     return size;
 }
 
-void kiss_serial(uint8_t sbyte)
+void kiss_decoder_init(KissDecoder *d)
 {
+    d->len = 0;
+    d->inFrame = false;
+    d->escape = false;
+    d->command = CMD_UNKNOWN;
+}
 
-    if (IN_FRAME && sbyte == FEND && command == CMD_DATA)
+size_t kiss_decode(KissDecoder *d, uint8_t sbyte)
+{
+    if (d->inFrame && sbyte == FEND && d->command == CMD_DATA)
     {
-        IN_FRAME = false;
-        Ax25WriteTxFrame(serialBuffer, frame_len);
-        log_d("[KISS] Received packet! %d Byte", frame_len);
-        // ax25_init(&AX25, aprs_msg_callback);
-        // AX25.frame_len = frame_len;
-        // memcpy(AX25.buf, serialBuffer, frame_len);
-        // ax25_decode(&AX25);
+        d->inFrame = false;
+        return d->len;
     }
     else if (sbyte == FEND)
     {
-        IN_FRAME = true;
-        command = CMD_UNKNOWN;
-        frame_len = 0;
+        d->inFrame = true;
+        d->command = CMD_UNKNOWN;
+        d->len = 0;
     }
-    else if (IN_FRAME && frame_len < AX25_MAX_FRAME_LEN)
+    else if (d->inFrame && d->len < AX25_MAX_FRAME_LEN)
     {
         // Have a look at the command byte first
-        if (frame_len == 0 && command == CMD_UNKNOWN)
+        if (d->len == 0 && d->command == CMD_UNKNOWN)
         {
             // MicroModem supports only one HDLC port, so we
             // strip off the port nibble of the command byte
-            sbyte = sbyte & 0x0F;
-            command = sbyte;
+            d->command = sbyte & 0x0F;
         }
-        else if (command == CMD_DATA)
+        else if (d->command == CMD_DATA)
         {
             if (sbyte == FESC)
             {
-                ESCAPE = true;
+                d->escape = true;
             }
             else
             {
-                if (ESCAPE)
+                if (d->escape)
                 {
                     if (sbyte == TFEND)
                         sbyte = FEND;
                     if (sbyte == TFESC)
                         sbyte = FESC;
-                    ESCAPE = false;
+                    d->escape = false;
                 }
-                serialBuffer[frame_len++] = sbyte;
+                d->buf[d->len++] = sbyte;
             }
         }
-        else if (command == CMD_TXDELAY)
-        {
-            Ax25Config.txDelayLength = sbyte * 10UL;
-        }
-        else if (command == CMD_TXTAIL)
-        {
-            Ax25Config.txTailLength = sbyte * 10;
-        }
-        else if (command == CMD_SLOTTIME)
-        {
-            Ax25Config.quietTime = sbyte * 10;
-        }
-        else if (command == CMD_P)
+        else
         {
-            p = sbyte;
+            kiss_set_param(d->command, sbyte);
         }
     }
+    return 0;
+}
+
+static KissDecoder serialDecoder = {{0}, 0, false, false, CMD_UNKNOWN};
+
+void kiss_serial(uint8_t sbyte)
+{
+    size_t len = kiss_decode(&serialDecoder, sbyte);
+    if (len > 0)
+    {
+        Ax25WriteTxFrame(serialDecoder.buf, len);
+        log_d("[KISS] Received packet! %d Byte", len);
+    }
 }
 
 size_t kiss_parse(uint8_t *buf, uint8_t *raw, size_t len)
@@ -196,21 +220,9 @@ size_t kiss_parse(uint8_t *buf, uint8_t *raw, size_t len)
                     serialBuffer[frame_len++] = sbyte;
                 }
             }
-            else if (command == CMD_TXDELAY)
-            {
-                Ax25Config.txDelayLength = sbyte * 10UL;
-            }
-            else if (command == CMD_TXTAIL)
-            {
-                Ax25Config.txTailLength = sbyte * 10;
-            }
-            else if (command == CMD_SLOTTIME)
-            {
-                Ax25Config.quietTime = sbyte * 10;
-            }
-            else if (command == CMD_P)
+            else
             {
-                p = sbyte;
+                kiss_set_param(command, sbyte);
             }
         }
     }
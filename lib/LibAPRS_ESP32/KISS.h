@@ -20,11 +20,28 @@
 #define CMD_RETURN 0xFF
 
 #define AX25_MAX_FRAME_LEN 329
+#define KISS_MAX_ENCODED_LEN (2 * AX25_MAX_FRAME_LEN + 3) // every byte escaped, plus FEND, command and FEND
+
+// KISS receive state of one host stream, each stream needs its own
+typedef struct
+{
+    uint8_t buf[AX25_MAX_FRAME_LEN];
+    size_t len;
+    bool inFrame;
+    bool escape;
+    uint8_t command;
+} KissDecoder;
 
 //void kiss_csma(AX25Ctx *ctx, uint8_t *buf, size_t len);
 int kiss_wrapper(uint8_t *pkg);
 int kiss_wrapper(uint8_t *pkg,uint8_t *buf,size_t len);
 void kiss_serial(uint8_t sbyte);
+void kiss_decoder_init(KissDecoder *d);
+/**
+ * Feed one byte from a host, parameter commands are applied as they arrive
+ * @return Length of the data frame in d->buf once its closing FEND is seen, otherwise 0
+ */
+size_t kiss_decode(KissDecoder *d, uint8_t sbyte);
 size_t kiss_parse(uint8_t *buf,uint8_t *raw,size_t len);
 
 #endif
\ No newline at end of file
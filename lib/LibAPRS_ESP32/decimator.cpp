@@ -0,0 +1,102 @@
+#include "decimator.h"
+#include <string.h>
+
+// Hamming-windowed sinc, fc = 4000 Hz, DECIMATOR_TAPS_PER_PHASE taps per output phase, unity DC gain (sum = 32768).
+// Flat to 2200 Hz (-0.1 dB), about -60 dB from 6900 Hz up, so nothing aliases into the AFSK band.
+static const int16_t decimator19200[16] = {
+	-43, 153, 349, -353, -1738, -419, 5861, 12574, 12574, 5861, -419, -1738, -353, 349, 153, -43};
+
+static const int16_t decimator28800[24] = {
+	-42, 25, 146, 251, 118, -411, -1079, -1137, 209, 3065, 6461, 8778,
+	8778, 6461, 3065, 209, -1137, -1079, -411, 118, 251, 146, 25, -42};
+
+static const int16_t decimator38400[32] = {
+	-35, -4, 50, 128, 192, 164, -27, -380, -768, -943, -623, 371, 1991, 3922, 5658, 6688,
+	6688, 5658, 3922, 1991, 371, -623, -943, -768, -380, -27, 164, 192, 128, 50, -4, -35};
+
+bool DecimatorInit(struct Decimator *dec, uint8_t ratio)
+{
+#ifdef CONFIG_IDF_TARGET_ESP32S3
+	if (dec->ratio > 1)
+		dsps_fird_s16_aexx_free(&dec->fir); // release the coefficient copy made by the previous init
+#endif
+	memset(dec, 0, sizeof(*dec));
+	dec->ratio = ratio;
+
+	switch (ratio)
+	{
+	case 1:
+		return true;
+	case 2:
+		dec->coeffs = decimator19200;
+		dec->taps = sizeof(decimator19200) / sizeof(*decimator19200);
+		break;
+	case 3:
+		dec->coeffs = decimator28800;
+		dec->taps = sizeof(decimator28800) / sizeof(*decimator28800);
+		break;
+	case 4:
+		dec->coeffs = decimator38400;
+		dec->taps = sizeof(decimator38400) / sizeof(*decimator38400);
+		break;
+	default:
+		dec->ratio = 0;
+		return false;
+	}
+
+#ifdef CONFIG_IDF_TARGET_ESP32S3
+	// coefficients are symmetric, so the tap order used by the PIE implementation does not matter
+	if (dsps_fird_init_s16(&dec->fir, (int16_t *)dec->coeffs, dec->delay, dec->taps, ratio, 0, 0) != ESP_OK)
+	{
+		dec->ratio = 0;
+		return false;
+	}
+#endif
+	return true;
+}
+
+size_t DecimatorProcess(struct Decimator *dec, const int16_t *in, size_t count, int16_t *out)
+{
+	if (dec->ratio == 0)
+		return 0;
+
+	if (dec->ratio == 1)
+	{
+		if (out != in)
+			memmove(out, in, count * sizeof(*in));
+		return count;
+	}
+
+#ifdef CONFIG_IDF_TARGET_ESP32S3
+	return dsps_fird_s16(&dec->fir, in, out, count / dec->ratio);
+#else
+	size_t produced = 0;
+	const uint8_t taps = dec->taps;
+
+	for (size_t i = 0; (i + dec->ratio) <= count; i += dec->ratio)
+	{
+		// push ratio new samples, the input is consumed before the output slot is written, so in-place works
+		for (uint8_t r = 0; r < dec->ratio; r++)
+		{
+			if (dec->delayIdx == 0)
+				dec->delayIdx = taps;
+			dec->delayIdx--;
+			dec->delay[dec->delayIdx] = in[i + r];
+			dec->delay[dec->delayIdx + taps] = in[i + r];
+		}
+
+		const int16_t *window = &dec->delay[dec->delayIdx];
+		int32_t sum = 1 << 14; // round to nearest, like dsps_fird_s16()
+		for (uint8_t k = 0; k < taps; k++)
+			sum += (int32_t)dec->coeffs[k] * window[k];
+		sum >>= 15;
+
+		if (sum > INT16_MAX)
+			sum = INT16_MAX;
+		else if (sum < INT16_MIN)
+			sum = INT16_MIN;
+		out[produced++] = (int16_t)sum;
+	}
+	return produced;
+#endif
+}
@@ -0,0 +1,55 @@
+#ifndef DECIMATOR_H_
+#define DECIMATOR_H_
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+
+#ifdef CONFIG_IDF_TARGET_ESP32S3
+#include <dsps_fir.h>
+#endif
+
+#define DECIMATOR_OUTPUT_RATE 9600
+#define DECIMATOR_MAX_RATIO 4
+#define DECIMATOR_TAPS_PER_PHASE 8
+#define DECIMATOR_MAX_TAPS (DECIMATOR_MAX_RATIO * DECIMATOR_TAPS_PER_PHASE)
+
+/**
+ * @brief Stateful decimating FIR (ADC rate -> 9600 Hz)
+ * Only every ratio-th output is computed, which is the same amount of work as a polyphase
+ * structure with ratio branches of DECIMATOR_TAPS_PER_PHASE taps. The delay line is kept
+ * between calls, so consecutive blocks are filtered as one continuous stream.
+ */
+struct Decimator
+{
+	const int16_t *coeffs; // Q15 low-pass coefficients, symmetric
+	uint8_t taps;
+	uint8_t ratio;
+#ifdef CONFIG_IDF_TARGET_ESP32S3
+	fir_s16_t fir;
+	int16_t delay[DECIMATOR_MAX_TAPS + 8] __attribute__((aligned(16)));
+#else
+	int16_t delay[2 * DECIMATOR_MAX_TAPS]; // each sample is stored at idx and idx + taps, newest first
+	uint8_t delayIdx;
+#endif
+};
+
+/**
+ * @brief Initialize decimator and clear its history
+ * @param[out] *dec Decimator state
+ * @param[in] ratio Decimation ratio, 1 (pass-through) to DECIMATOR_MAX_RATIO
+ * @return True on success, false if the ratio is not supported
+ */
+bool DecimatorInit(struct Decimator *dec, uint8_t ratio);
+
+/**
+ * @brief Low-pass filter and decimate a block of samples
+ * @param[in,out] *dec Decimator state
+ * @param[in] *in Input samples
+ * @param[in] count Number of input samples, must be a multiple of the ratio
+ * @param[out] *out Output samples, count / ratio of them. May be the same buffer as the input
+ * @return Number of output samples
+ */
+size_t DecimatorProcess(struct Decimator *dec, const int16_t *in, size_t count, int16_t *out);
+
+#endif /* DECIMATOR_H_ */
@@ -0,0 +1,270 @@
+#include <Arduino.h>
+#include <stdlib.h>
+#include <string.h>
+#include "dupecheck.h"
+
+#define FNV64_OFFSET 0xCBF29CE484222325ULL
+#define FNV64_PRIME 0x100000001B3ULL
+
+static inline uint64_t fnvByte(uint64_t h, uint8_t b)
+{
+	return (h ^ b) * FNV64_PRIME;
+}
+
+static uint64_t fnvBytes(uint64_t h, const uint8_t *p, size_t len)
+{
+	for(size_t i = 0; i < len; i++)
+		h = fnvByte(h, p[i]);
+	return h;
+}
+
+/**
+ * @brief Information field length without trailing spaces and line ends, some gateways strip them
+ */
+static size_t infoLength(const uint8_t *info, size_t len)
+{
+	while((len > 0) && ((info[len - 1] == ' ') || (info[len - 1] == '\r') || (info[len - 1] == '\n')))
+		len--;
+	return len;
+}
+
+/**
+ * @brief Hash an AX.25 callsign as it is written in TNC2 text, "CALL-SSID"
+ */
+static uint64_t hashCall(uint64_t h, const AX25Call *call, bool ssid)
+{
+	for(uint8_t i = 0; (i < sizeof(call->call)) && (call->call[i] != 0) && (call->call[i] != ' '); i++)
+		h = fnvByte(h, call->call[i]);
+	if(ssid && (call->ssid > 0))
+	{
+		char s[4];
+		int n = snprintf(s, sizeof(s), "-%u", call->ssid & 0x0F);
+		h = fnvBytes(h, (const uint8_t*)s, n);
+	}
+	return h;
+}
+
+uint64_t DupeHashAx25(const AX25Msg *msg)
+{
+	uint64_t h = FNV64_OFFSET;
+	h = hashCall(h, &msg->src, true);
+	h = fnvByte(h, '>');
+	h = hashCall(h, &msg->dst, false); //the destination SSID is a path for some digipeaters
+	h = fnvByte(h, ':');
+	return fnvBytes(h, msg->info, infoLength(msg->info, msg->len));
+}
+
+bool DupeHashTnc2(const char *tnc2, size_t len, uint64_t *hash)
+{
+	const char *end = tnc2 + len;
+	const char *gt = (const char*)memchr(tnc2, '>', len);
+	if(gt == NULL)
+		return false;
+	const char *colon = (const char*)memchr(gt, ':', end - gt);
+	if(colon == NULL)
+		return false;
+
+	uint64_t h = fnvBytes(FNV64_OFFSET, (const uint8_t*)tnc2, gt - tnc2);
+	h = fnvByte(h, '>');
+	for(const char *p = gt + 1; (p < colon) && (*p != ',') && (*p != '-'); p++)
+		h = fnvByte(h, *p);
+	h = fnvByte(h, ':');
+	*hash = fnvBytes(h, (const uint8_t*)(colon + 1), infoLength((const uint8_t*)(colon + 1), end - colon - 1));
+	return true;
+}
+
+struct DupeTable DupeTableInit(uint16_t capacity, uint32_t windowMs)
+{
+	struct DupeTable t;
+	memset(&t, 0, sizeof(t));
+	t.capacity = capacity;
+	t.window = windowMs;
+	return t;
+}
+
+/**
+ * @brief Allocate the table on first use
+ */
+static bool dupeAlloc(struct DupeTable *t, uint32_t now)
+{
+	if(t->entries != NULL)
+		return true;
+	if((t->capacity == 0) || (t->capacity > 16384))
+		return false;
+
+	uint32_t size = 1;
+	while(size < 2U * t->capacity) //at most half full, probes stay short
+		size <<= 1;
+#ifdef BOARD_HAS_PSRAM
+	t->entries = (struct DupeEntry*)ps_calloc(t->capacity, sizeof(*t->entries));
+	t->slots = (uint16_t*)ps_calloc(size, sizeof(*t->slots));
+	if((t->entries == NULL) || (t->slots == NULL)) //no PSRAM found, fall back to internal RAM
+#endif
+	{
+		free(t->entries);
+		free(t->slots);
+		t->entries = (struct DupeEntry*)calloc(t->capacity, sizeof(*t->entries));
+		t->slots = (uint16_t*)calloc(size, sizeof(*t->slots));
+	}
+	if((t->entries == NULL) || (t->slots == NULL))
+	{
+		free(t->entries);
+		free(t->slots);
+		t->entries = NULL;
+		t->slots = NULL;
+		log_e("Duplicate table allocation failed");
+		return false;
+	}
+	memset(t->slots, 0xFF, size * sizeof(*t->slots));
+	t->mask = size - 1;
+	for(uint16_t i = 0; i < t->capacity; i++)
+		t->entries[i].next = (i + 1 < t->capacity) ? i + 1 : DUPE_NONE;
+	t->freeList = 0;
+	t->count = 0;
+	for(uint8_t i = 0; i < DUPE_WHEEL_SLOTS; i++)
+		t->wheelHead[i] = t->wheelTail[i] = DUPE_NONE;
+	//an entry is dropped when its slot comes round again, DUPE_WHEEL_SLOTS - 1 full ticks later at least
+	t->tick = (t->window + DUPE_WHEEL_SLOTS - 2) / (DUPE_WHEEL_SLOTS - 1);
+	if(t->tick == 0)
+		t->tick = 1;
+	t->lastTick = now / t->tick;
+	return true;
+}
+
+/**
+ * @brief Take an entry out of the open addressing table, shifting later entries of its probe run back
+ */
+static void tableRemove(struct DupeTable *t, uint16_t idx)
+{
+	uint16_t pos = t->entries[idx].hash & t->mask;
+	while(t->slots[pos] != idx)
+		pos = (pos + 1) & t->mask;
+	t->slots[pos] = DUPE_NONE;
+
+	uint16_t j = pos;
+	while(1)
+	{
+		j = (j + 1) & t->mask;
+		if(t->slots[j] == DUPE_NONE)
+			break;
+		uint16_t home = t->entries[t->slots[j]].hash & t->mask;
+		if(((j - home) & t->mask) < ((j - pos) & t->mask))
+			continue; //home is between the hole and this slot, it can not move
+		t->slots[pos] = t->slots[j];
+		t->slots[j] = DUPE_NONE;
+		pos = j;
+	}
+	t->entries[idx].next = t->freeList;
+	t->freeList = idx;
+	t->count--;
+}
+
+static void expireSlot(struct DupeTable *t, uint8_t slot)
+{
+	uint16_t idx = t->wheelHead[slot];
+	while(idx != DUPE_NONE)
+	{
+		uint16_t next = t->entries[idx].next;
+		tableRemove(t, idx);
+		idx = next;
+	}
+	t->wheelHead[slot] = t->wheelTail[slot] = DUPE_NONE;
+}
+
+/**
+ * @brief Drop the entries of every tick that has left the window since the last call
+ */
+static void advance(struct DupeTable *t, uint32_t now)
+{
+	uint32_t nowTick = now / t->tick;
+	uint32_t elapsed = nowTick - t->lastTick;
+	if(elapsed == 0)
+		return;
+	if(elapsed >= DUPE_WHEEL_SLOTS) //also when time went back
+	{
+		for(uint8_t i = 0; i < DUPE_WHEEL_SLOTS; i++)
+			expireSlot(t, i);
+	}
+	else
+	{
+		//the slot of a new tick still holds the entries of DUPE_WHEEL_SLOTS ticks ago
+		for(uint32_t k = t->lastTick + 1; k != nowTick + 1; k++)
+			expireSlot(t, k % DUPE_WHEEL_SLOTS);
+	}
+	t->lastTick = nowTick;
+}
+
+/**
+ * @brief Drop the oldest entry to make room
+ */
+static void evictOldest(struct DupeTable *t)
+{
+	for(uint8_t i = 1; i <= DUPE_WHEEL_SLOTS; i++)
+	{
+		uint8_t slot = (t->lastTick + i) % DUPE_WHEEL_SLOTS; //oldest tick first, the current one last
+		uint16_t idx = t->wheelHead[slot];
+		if(idx == DUPE_NONE)
+			continue;
+		t->wheelHead[slot] = t->entries[idx].next;
+		if(t->wheelHead[slot] == DUPE_NONE)
+			t->wheelTail[slot] = DUPE_NONE;
+		tableRemove(t, idx);
+		t->evicted++;
+		return;
+	}
+}
+
+bool DupeFind(struct DupeTable *t, uint64_t hash, uint32_t now)
+{
+	t->checks++;
+	if(t->entries == NULL)
+		return false;
+	advance(t, now);
+	uint16_t pos = hash & t->mask;
+	while(t->slots[pos] != DUPE_NONE)
+	{
+		if(t->entries[t->slots[pos]].hash == hash)
+		{
+			t->dupes++;
+			return true;
+		}
+		pos = (pos + 1) & t->mask;
+	}
+	return false;
+}
+
+bool DupeAdd(struct DupeTable *t, uint64_t hash, uint32_t now)
+{
+	if(!dupeAlloc(t, now))
+		return false;
+	advance(t, now);
+	if(t->count >= t->capacity)
+		evictOldest(t);
+
+	uint16_t idx = t->freeList;
+	t->freeList = t->entries[idx].next;
+	t->count++;
+	t->entries[idx].hash = hash;
+	t->entries[idx].next = DUPE_NONE;
+
+	uint8_t slot = t->lastTick % DUPE_WHEEL_SLOTS;
+	if(t->wheelTail[slot] == DUPE_NONE)
+		t->wheelHead[slot] = idx;
+	else
+		t->entries[t->wheelTail[slot]].next = idx;
+	t->wheelTail[slot] = idx;
+
+	uint16_t pos = hash & t->mask;
+	while(t->slots[pos] != DUPE_NONE)
+		pos = (pos + 1) & t->mask;
+	t->slots[pos] = idx;
+	return true;
+}
+
+bool DupeCheck(struct DupeTable *t, uint64_t hash, uint32_t now)
+{
+	if(DupeFind(t, hash, now))
+		return true;
+	DupeAdd(t, hash, now);
+	return false;
+}
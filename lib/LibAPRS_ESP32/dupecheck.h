@@ -0,0 +1,84 @@
+#ifndef DUPECHECK_H_
+#define DUPECHECK_H_
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+#include "AX25.h"
+
+#define DUPE_WHEEL_SLOTS 32 //expiry time wheel, an entry lives the window rounded up to window/(DUPE_WHEEL_SLOTS - 1)
+#define DUPE_NONE 0xFFFF //empty table slot or end of a list
+
+/**
+ * @brief One packet seen inside the window
+ */
+struct DupeEntry
+{
+	uint64_t hash;
+	uint16_t next; //next entry of the same wheel slot, oldest first, or of the free list
+};
+
+/**
+ * @brief Duplicate packet window
+ * @details Entries live in a pool, an open addressing table of pool indexes finds them by hash.
+ * The time wheel lists them by the tick they were added in, so expiry only visits
+ * the entries that are due. Memory is allocated on first use, see DupeTableInit().
+ */
+struct DupeTable
+{
+	uint16_t capacity; //entries, the oldest one is dropped when the window holds more
+	uint32_t window; //ms
+	uint32_t tick; //ms per wheel slot
+	uint32_t lastTick; //tick the wheel was last advanced to
+	struct DupeEntry *entries;
+	uint16_t *slots; //open addressing table of entry indexes
+	uint16_t mask; //table size - 1
+	uint16_t freeList;
+	uint16_t count;
+	uint16_t wheelHead[DUPE_WHEEL_SLOTS];
+	uint16_t wheelTail[DUPE_WHEEL_SLOTS];
+	uint32_t checks; //DupeFind() calls
+	uint32_t dupes; //packets found in the window
+	uint32_t evicted; //dropped before their time, the window was full
+};
+
+/**
+ * @brief Empty window, to initialize a static table with
+ * @param capacity Most entries held at a time, up to 16384
+ * @param windowMs Time a packet is remembered
+ */
+struct DupeTable DupeTableInit(uint16_t capacity, uint32_t windowMs);
+
+/**
+ * @brief Hash of a packet as the duplicate check sees it: source, destination without SSID
+ * and information field without trailing spaces or line ends. The path is ignored, so a packet
+ * heard again through another digipeater, or from APRS-IS, has the same hash.
+ */
+uint64_t DupeHashAx25(const AX25Msg *msg);
+
+/**
+ * @brief Same hash from a TNC2 text packet, "SRC>DST,PATH:info"
+ * @param[out] *hash Hash of the packet
+ * @return False if the text is not a packet, there is nothing to check then
+ */
+bool DupeHashTnc2(const char *tnc2, size_t len, uint64_t *hash);
+
+/**
+ * @brief Check whether a packet was seen inside the window
+ * @param now Current time in ms
+ */
+bool DupeFind(struct DupeTable *t, uint64_t hash, uint32_t now);
+
+/**
+ * @brief Remember a packet for the window
+ * @return False if the table could not be allocated
+ */
+bool DupeAdd(struct DupeTable *t, uint64_t hash, uint32_t now);
+
+/**
+ * @brief Check and remember a packet
+ * @return True if it was seen inside the window already
+ */
+bool DupeCheck(struct DupeTable *t, uint64_t hash, uint32_t now);
+
+#endif /* DUPECHECK_H_ */
@@ -26,7 +26,6 @@ along with VP-Digi.  If not, see <http://www.gnu.org/licenses/>.
 #define FX25_RS_FCR 1
 
 #define FX25_PREGENERATE_POLYS
-#define FX25_MAX_DISTANCE 10 //maximum Hamming distance when comparing tags
 
 const struct Fx25Mode Fx25ModeList[11] =
 {
@@ -45,14 +44,37 @@ const struct Fx25Mode Fx25ModeList[11] =
 
 
 
-const struct Fx25Mode* Fx25GetModeForTag(uint64_t tag)
+static uint8_t tagDistance = FX25_TAG_DISTANCE_DEFAULT; //maximum Hamming distance when comparing tags
+
+const struct Fx25Mode* Fx25GetModeForTag(uint64_t tag, uint8_t *distance)
 {
+	//called for every received bit of every decoder, so a mode is rejected
+	//by the upper 32 bits alone when they already differ too much
+	const struct Fx25Mode *best = NULL;
+	uint8_t bestDistance = tagDistance + 1;
 	for(uint8_t i = 0; i < sizeof(Fx25ModeList) / sizeof(*Fx25ModeList); i++)
 	{
-		if(__builtin_popcountll(tag ^ Fx25ModeList[i].tag) <= FX25_MAX_DISTANCE)
-			return &Fx25ModeList[i];
+		uint64_t diff = tag ^ Fx25ModeList[i].tag;
+		uint8_t d = __builtin_popcount((uint32_t)(diff >> 32));
+		if(d >= bestDistance)
+			continue;
+		d += __builtin_popcount((uint32_t)diff);
+		if(d < bestDistance)
+		{
+			best = &Fx25ModeList[i];
+			bestDistance = d;
+			if(d == 0)
+				break;
+		}
 	}
-	return NULL;
+	if((best != NULL) && (distance != NULL))
+		*distance = bestDistance;
+	return best;
+}
+
+void Fx25TagDistance(uint8_t bits)
+{
+	tagDistance = (bits > FX25_TAG_DISTANCE_MAX) ? FX25_TAG_DISTANCE_MAX : bits;
 }
 
 const struct Fx25Mode* Fx25GetModeForSize(uint16_t size)
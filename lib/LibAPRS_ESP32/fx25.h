@@ -26,6 +26,8 @@ along with VP-Digi.  If not, see <http://www.gnu.org/licenses/>.
 #include <stdbool.h>
 
 #define FX25_MAX_BLOCK_SIZE 255
+#define FX25_TAG_DISTANCE_DEFAULT 10 //default max bit errors in a received correlation tag
+#define FX25_TAG_DISTANCE_MAX 15 //tags are at least 32 bits apart, up to 15 bit errors still give a unique match
 
 struct Fx25Mode
 {
@@ -38,10 +40,18 @@ extern const struct Fx25Mode Fx25ModeList[11];
 
 /**
  * @brief Get FX.25 mode for given correlation tag
+ * @details The mode with the closest tag is returned if it differs in no more bits than the tag distance limit
  * @param tag FX.25 correlation tag
+ * @param *distance Output number of bits the tag differs from the mode tag, may be NULL
  * @return FX.25 mode structure pointer or NULL if not a FX.25 tag
  */
-const struct Fx25Mode* Fx25GetModeForTag(uint64_t tag);
+const struct Fx25Mode* Fx25GetModeForTag(uint64_t tag, uint8_t *distance);
+
+/**
+ * @brief Set the number of bit errors allowed in a received correlation tag
+ * @param bits Max Hamming distance, limited to FX25_TAG_DISTANCE_MAX. 0 - exact match only
+ */
+void Fx25TagDistance(uint8_t bits);
 
 /**
  * @brief Get FX.25 mode for given payload size
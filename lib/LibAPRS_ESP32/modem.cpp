@@ -22,7 +22,7 @@ along with VP-Digi.  If not, see <http://www.gnu.org/licenses/>.
 #include "modem.h"
 #include <stdlib.h>
 #include <stdbool.h>
-#include "ax25.h"
+#include "AX25.h"
 #include "common.h"
 #include "esp_dsp.h"
 #include <dsps_fir.h>
@@ -66,7 +66,7 @@ along with VP-Digi.  If not, see <http://www.gnu.org/licenses/>.
 #define DCD300_TUNE 0.74f
 
 #define N1200 8 // samples per symbol @ fs=9600, oversampling = 38400 Hz
-#define N9600 1 // fs=38400, oversampling = 38400 Hz
+#define N9600 4 // fs=38400, oversampling = 38400 Hz
 #define N300 32 // fs=9600, oversampling = 38400 Hz
 #define NMAX 32 // keep this value equal to the biggest Nx
 
@@ -94,9 +94,8 @@ along with VP-Digi.  If not, see <http://www.gnu.org/licenses/>.
 
 struct ModemDemodConfig ModemConfig;
 
-static uint8_t N;						 // samples per symbol
 static enum ModemTxTestMode txTestState; // current TX test mode
-static uint8_t demodCount;				 // actual number of parallel demodulators
+static uint8_t demodCount;				 // actual number of parallel demodulators, all ports together
 // static uint16_t dacSine[DAC_SINE_SIZE];										   // sine samples for DAC
 static uint8_t dacSineIdx;													   // current sine sample index
 static volatile uint16_t samples[MODEM_LL_OVERSAMPLING_FACTOR];				   // very raw received samples, filled directly by DMA
@@ -108,9 +107,30 @@ float baudRate;																   // baudrate
 static uint16_t markStep;													   // mark timer step
 static uint16_t spaceStep;													   // space timer step
 static uint16_t baudRateStep;												   // baudrate timer step
-static int16_t coeffHiI[NMAX], coeffLoI[NMAX], coeffHiQ[NMAX], coeffLoQ[NMAX]; // correlator IQ coefficients
-static uint8_t dcd = 0;														   // multiplexed DCD state from both demodulators
-static uint32_t lfsr = 0xFFFFF;												   // LFSR for 9600 Bd
+static uint32_t txLfsr = 0xFFFFF;											   // TX LFSR for 9600 Bd
+
+/**
+ * @brief Receive side of one audio input
+ * Each port has its own modem type and a consecutive range of the demodulator bank.
+ * Port 0 is the radio that also transmits, port 1 is an optional second receiver.
+ */
+struct ModemPort
+{
+	enum ModemType modem;
+	uint8_t N;			// samples per symbol
+	uint8_t firstDemod; // first demodulator of this port
+	uint8_t demodCount; // number of demodulators of this port
+	uint8_t dcd;		// multiplexed DCD state from the port demodulators
+	uint32_t lfsr;		// RX LFSR for 9600 Bd
+	int16_t coeffHiI[NMAX]; // correlator IQ coefficients
+	int16_t coeffLoI[NMAX];
+	int16_t coeffHiQ[NMAX];
+	int16_t coeffLoQ[NMAX];
+};
+
+static struct ModemPort ports[MODEM_MAX_PORTS];
+static uint8_t portCount = 1;
+static uint8_t demodPort[MODEM_MAX_DEMODULATOR_COUNT]; // port of each demodulator
 
 /**
  * @brief BPF filter with 2200 Hz tone 6 dB preemphasis (it actually attenuates 1200 Hz tone by 6 dB)
@@ -205,6 +225,19 @@ static const int16_t lpf1200[15] =
 // seems like there is almost no difference between N=9 and any higher order
 static const int16_t lpf9600[9] = {497, 2360, 7178, 13992, 17478, 13992, 7178, 2360, 497};
 
+#define TX9600_SHAPE_SYMBOLS 5													 // TX pulse span in symbols, the shaping table has 2^N rows
+#define TX9600_SAMPLES_PER_SYMBOL (CONFIG_AFSK_DAC_SAMPLERATE / 9600)			 // DAC samples per 9600 Bd symbol
+#define TX9600_SHAPE_ROLLOFF 0.5f												 // raised cosine roll-off factor
+#define TX9600_SHAPE_AMPLITUDE 110												 // peak level swing around the DAC midpoint (127)
+
+/**
+ * @brief 9600 Bd TX raised cosine shaping table
+ * One DAC level for every pattern of the last TX9600_SHAPE_SYMBOLS scrambled symbols (newest in bit 0)
+ * and every sample position within the middle symbol, built once by tx9600ShapeInit()
+ */
+static uint8_t tx9600Shape[1 << TX9600_SHAPE_SYMBOLS][TX9600_SAMPLES_PER_SYMBOL];
+static uint8_t txSymbols; // last scrambled TX symbols, newest in bit 0
+
 #define LPF_MAX_TAPS 15
 
 #define FILTER_MAX_TAPS ((LPF_MAX_TAPS > BPF_MAX_TAPS) ? LPF_MAX_TAPS : BPF_MAX_TAPS)
@@ -213,7 +246,8 @@ struct Filter
 {
 	int16_t *coeffs;
 	uint8_t taps;
-	int32_t samples[FILTER_MAX_TAPS];
+	int32_t samples[2 * FILTER_MAX_TAPS]; // each sample is stored at idx and idx + taps, newest first
+	uint8_t samplesIdx;
 	uint8_t gainShift;
 };
 
@@ -221,10 +255,11 @@ struct DemodState
 {
 	uint8_t rawSymbols;	 // raw, unsynchronized symbols
 	uint8_t syncSymbols; // synchronized symbols
+	uint8_t weakSymbols; // synchronized symbols sampled from a 2 of 3 vote (low confidence)
 
 	enum ModemPrefilter prefilter;
 	struct Filter bpf;
-	int16_t correlatorSamples[NMAX];
+	int16_t correlatorSamples[2 * NMAX]; // each sample is stored at idx and idx + N, so the last N samples are always contiguous
 	uint8_t correlatorSamplesIdx;
 	struct Filter lpf;
 
@@ -246,24 +281,67 @@ struct DemodState
 
 	int16_t peak;
 	int16_t valley;
+
+	int32_t slicerGain; // mark correlator output gain relative to space, 256 = 1.0
 };
 
 static struct DemodState demodState[MODEM_MAX_DEMODULATOR_COUNT];
 
-static void decode(uint8_t symbol, uint8_t demod, uint16_t mV);
-static int32_t demodulate(int16_t sample, struct DemodState *dem);
+enum BankFilter
+{
+	BANK_FILTER_PRIMARY = 0, // emphasis filter chosen for the configured audio input
+	BANK_FILTER_FLAT,		 // no pre/deemphasis
+	BANK_FILTER_OPPOSITE,	 // the other emphasis filter
+};
 
-static int32_t filter(struct Filter *filter, int32_t input)
+/**
+ * @brief 1200 Bd demodulator bank profile
+ * Slots differ in emphasis filter, PLL/DCD tuning and mark/space slicer balance, so that
+ * at least one of them copes with the audio twist and clock of a given transmitter.
+ * Slots 0 and 1 are the original primary/flat pair.
+ */
+struct DemodProfile
+{
+	enum BankFilter filter;
+	float pllLockedTune;
+	float pllNotLockedTune;
+	float dcdTune;
+	uint16_t slicerGain; // 256 = 1.0
+};
+
+static const struct DemodProfile demodBank1200[] =
+	{
+		{BANK_FILTER_PRIMARY, PLL1200_LOCKED_TUNE, PLL1200_NOT_LOCKED_TUNE, DCD1200_TUNE, 256},
+		{BANK_FILTER_FLAT, PLL1200_LOCKED_TUNE, PLL1200_NOT_LOCKED_TUNE, DCD1200_TUNE, 256},
+		{BANK_FILTER_FLAT, PLL1200_LOCKED_TUNE, PLL1200_NOT_LOCKED_TUNE, DCD1200_TUNE, 362}, // mark +3 dB
+		{BANK_FILTER_FLAT, PLL1200_LOCKED_TUNE, PLL1200_NOT_LOCKED_TUNE, DCD1200_TUNE, 181}, // mark -3 dB
+		{BANK_FILTER_OPPOSITE, PLL1200_LOCKED_TUNE, PLL1200_NOT_LOCKED_TUNE, DCD1200_TUNE, 256},
+		{BANK_FILTER_PRIMARY, 0.82f, 0.60f, 0.82f, 256}, // slower PLL, for noisy but stable clocks
+		{BANK_FILTER_FLAT, 0.65f, 0.45f, 0.65f, 256},	 // faster PLL, for drifting clocks
+		{BANK_FILTER_FLAT, PLL1200_LOCKED_TUNE, PLL1200_NOT_LOCKED_TUNE, DCD1200_TUNE, 512}, // mark +6 dB
+};
+
+static void decode(struct ModemPort *port, uint8_t symbol, uint8_t demod, uint16_t mV);
+static inline uint8_t demodulate(const struct ModemPort *port, int16_t sample, struct DemodState *dem);
+
+#define MODEM_DECODE_CHUNK 64
+static uint8_t symbolBuffer[MODEM_MAX_DEMODULATOR_COUNT][MODEM_DECODE_CHUNK]; // demodulated symbols of the current chunk, bit 0: tone, bit 1: DCD
+
+static inline int32_t filter(struct Filter *filter, int32_t input)
 {
 	int32_t out = 0;
 
-	for (uint8_t i = filter->taps - 1; i > 0; i--)
-		filter->samples[i] = filter->samples[i - 1]; // shift old samples
+	// move the window one sample back instead of shifting the whole delay line
+	if (filter->samplesIdx == 0)
+		filter->samplesIdx = filter->taps;
+	filter->samplesIdx--;
+	filter->samples[filter->samplesIdx] = input; // store new sample
+	filter->samples[filter->samplesIdx + filter->taps] = input;
 
-	filter->samples[0] = input; // store new sample
+	const int32_t *window = &filter->samples[filter->samplesIdx];
 	for (uint8_t i = 0; i < filter->taps; i++)
 	{
-		out += (int32_t)filter->coeffs[i] * filter->samples[i];
+		out += (int32_t)filter->coeffs[i] * window[i];
 	}
 	// dsps_dotprod_s16_ae32(filter->coeffs,(int16_t *)filter->samples,)
 	return out >> filter->gainShift;
@@ -279,9 +357,28 @@ uint8_t ModemGetDemodulatorCount(void)
 	return demodCount;
 }
 
+uint8_t ModemGetPortCount(void)
+{
+	return portCount;
+}
+
+enum ModemType ModemGetPortType(uint8_t port)
+{
+	if (port >= portCount)
+		port = 0;
+	return ports[port].modem;
+}
+
+uint8_t ModemGetDemodulatorPort(uint8_t modem)
+{
+	if (modem >= MODEM_MAX_DEMODULATOR_COUNT)
+		return 0;
+	return demodPort[modem];
+}
+
 uint8_t ModemDcdState(void)
 {
-	return dcd;
+	return ports[0].dcd;
 }
 
 uint8_t ModemIsTxTestOngoing(void)
@@ -320,57 +417,89 @@ static void setDcd(bool state)
 	}
 }
 
-static inline uint8_t descramble(uint8_t in)
+static inline uint8_t descramble(uint32_t *lfsr, uint8_t in)
 {
 	// G3RUH descrambling (x^17+x^12+1)
-	uint8_t bit = ((lfsr & 0x10000) > 0) ^ ((lfsr & 0x800) > 0) ^ (in > 0);
+	uint8_t bit = ((*lfsr & 0x10000) > 0) ^ ((*lfsr & 0x800) > 0) ^ (in > 0);
 
-	lfsr <<= 1;
-	lfsr |= in;
+	*lfsr <<= 1;
+	*lfsr |= in;
 	return bit;
 }
 
 static inline uint8_t scramble(uint8_t in)
 {
 	// G3RUH scrambling (x^17+x^12+1)
-	uint8_t bit = ((lfsr & 0x10000) > 0) ^ ((lfsr & 0x800) > 0) ^ (in > 0);
+	uint8_t bit = ((txLfsr & 0x10000) > 0) ^ ((txLfsr & 0x800) > 0) ^ (in > 0);
 
-	lfsr <<= 1;
-	lfsr |= bit;
+	txLfsr <<= 1;
+	txLfsr |= bit;
 	return bit;
 }
 
 /**
- * @brief ISR for demodulator
+ * @brief Decode a block of received samples
+ * The block is processed in chunks, stage by stage: every demodulator first runs amplitude tracking,
+ * band-pass filter, correlator, DCD and low-pass filter over the whole chunk, keeping its state hot,
+ * then bit recovery and NRZI decoding run sample by sample across all demodulators, so that frames
+ * reach the AX.25 layer in the same order as with per-sample processing.
+ * @param port Port (audio input) the samples come from
+ * @param[in] *samples Received samples, no more than 13 bits
+ * @param[in] count Number of samples
+ * @param[in] mVrms Input RMS level passed to the AX.25 layer
  */
-
-void MODEM_DECODE(int16_t sample, uint16_t mVrms)
+void ModemDecodeBlock(uint8_t port, const int16_t *samples, size_t count, uint16_t mVrms)
 {
-	// each sample is 12 bits, output sample is 13 bits
-	// int32_t sample = ((samples[0] + samples[1] + samples[2] + samples[3]) >> 1) - 4095; //calculate input sample (decimation)
-	// int32_t sample = samples[0]-4095;
-
-	bool partialDcd = false;
+	if (port >= portCount)
+		return;
+	struct ModemPort *p = &ports[port];
+	uint8_t first = p->firstDemod;
+	uint8_t last = p->firstDemod + p->demodCount;
 
-	for (uint8_t i = 0; i < demodCount; i++)
+	while (count > 0)
 	{
-		uint8_t symbol = (demodulate(sample, (struct DemodState *)&demodState[i]) > 0); // demodulate sample
+		size_t n = (count > MODEM_DECODE_CHUNK) ? MODEM_DECODE_CHUNK : count;
 
-		decode(symbol, i, mVrms); // recover bits, decode NRZI and call higher level function
-		if (demodState[i].dcd)
-			partialDcd = true;
+		for (uint8_t i = first; i < last; i++)
+		{
+			struct DemodState *dem = &demodState[i];
+			uint8_t *out = symbolBuffer[i];
+			for (size_t k = 0; k < n; k++)
+			{
+				out[k] = demodulate(p, samples[k], dem);
+				out[k] |= (dem->dcd << 1);
+			}
+		}
+
+		for (size_t k = 0; k < n; k++)
+		{
+			for (uint8_t i = first; i < last; i++)
+				decode(p, symbolBuffer[i][k], i, mVrms); // recover bits, decode NRZI and call higher level function
+		}
+
+		samples += n;
+		count -= n;
 	}
 
-	if (partialDcd) // DCD on any of the demodulators
+	p->dcd = 0;
+	for (uint8_t i = first; i < last; i++)
 	{
-		setDcd(true);
-		dcd = 1;
+		if (demodState[i].dcd) // DCD on any of the port demodulators
+			p->dcd = 1;
 	}
-	else // no DCD on both demodulators
+
+	bool anyDcd = false;
+	for (uint8_t i = 0; i < portCount; i++)
 	{
-		setDcd(false);
-		dcd = 0;
+		if (ports[i].dcd)
+			anyDcd = true;
 	}
+	setDcd(anyDcd);
+}
+
+void MODEM_DECODE(int16_t sample, uint16_t mVrms)
+{
+	ModemDecodeBlock(0, &sample, 1, mVrms);
 }
 
 /**
@@ -388,18 +517,18 @@ uint8_t MODEM_BAUDRATE_TIMER_HANDLER(void)
 		{
 			currentSymbol ^= 1; // change symbol - NRZI encoding
 		}
+		if (ModemConfig.modem == MODEM_9600)
+		{
+			scrambledSymbol = scramble(currentSymbol); // the scrambler runs once per symbol, not per DAC sample
+			txSymbols = (txSymbols << 1) | scrambledSymbol;
+		}
 		sampleIndex = baudRateStep;
 	}
 
 	if (ModemConfig.modem == MODEM_9600)
 	{
-		scrambledSymbol = scramble(currentSymbol);
-		// if(ModemConfig.usePWM)
-		sinwave = scrambledSymbol ? 240 : 20;
-		// else
-		//	sinwave = scrambledSymbol ? 15 : 0;
-
-		// sinwave = filter(&demodState[0].lpf, sinwave);
+		// pulse shaping is a single lookup: last TX9600_SHAPE_SYMBOLS symbols and the sample position within the symbol
+		sinwave = tx9600Shape[txSymbols & ((1 << TX9600_SHAPE_SYMBOLS) - 1)][(baudRateStep - sampleIndex) % TX9600_SAMPLES_PER_SYMBOL];
 	}
 	else
 	{
@@ -419,13 +548,59 @@ uint8_t MODEM_BAUDRATE_TIMER_HANDLER(void)
 	return sinwave;
 }
 
+static volatile bool txRendering = false; // ModemTxRender() is running, ModemTransmitStop() only marks the end of the bitstream
+static volatile bool txRenderEnd = false;
+
+size_t ModemTxRender(int16_t *out, size_t count)
+{
+	size_t n = 0;
+	txRenderEnd = false;
+	txRendering = true;
+	while (n < count)
+	{
+		uint8_t sinwave = MODEM_BAUDRATE_TIMER_HANDLER();
+		if (txRenderEnd) // the last bit has been sent, this sample is past the end
+			break;
+		// same level as the sigma-delta duty used by the timer ISR (-85 ~ 85), scaled to 16 bits
+		out[n++] = (int16_t)((((sinwave - 127) * 12) >> 4) * 256);
+	}
+	txRendering = false;
+	return n;
+}
+
+/**
+ * @brief Correlate the last N samples with mark and space IQ coefficients
+ * @param[in] *port Port holding N and the coefficients
+ * @param[in] *window Last N samples, oldest first
+ * @param[out] *loI, *loQ, *hiI, *hiQ Correlator outputs (scaled down by 2^14)
+ */
+static inline void correlate(const struct ModemPort *port, const int16_t *window, int32_t *loI, int32_t *loQ, int32_t *hiI, int32_t *hiQ)
+{
+	int32_t outLoI = 0, outLoQ = 0, outHiI = 0, outHiQ = 0;
+
+	for (uint8_t i = 0; i < port->N; i++)
+	{
+		int32_t t = window[i];
+		outLoI += t * port->coeffLoI[i];
+		outLoQ += t * port->coeffLoQ[i];
+		outHiI += t * port->coeffHiI[i];
+		outHiQ += t * port->coeffHiQ[i];
+	}
+
+	*loI = outLoI >> 14;
+	*loQ = outLoQ >> 14;
+	*hiI = outHiI >> 14;
+	*hiQ = outHiQ >> 14;
+}
+
 /**
  * @brief Demodulate received sample (4x oversampling)
+ * @param[in] *port Port the demodulator belongs to
  * @param[in] sample Received sample, no more than 13 bits
  * @param[in] *dem Demodulator state
  * @return Current tone (0 or 1)
  */
-static int32_t demodulate(int16_t sample, struct DemodState *dem)
+static inline uint8_t demodulate(const struct ModemPort *port, int16_t sample, struct DemodState *dem)
 {
 	// input signal amplitude tracking
 	if (sample >= dem->peak)
@@ -446,36 +621,28 @@ static int32_t demodulate(int16_t sample, struct DemodState *dem)
 		dem->valley -= (((int32_t)(AMP_TRACKING_DECAY * (float)32768) * (int32_t)(dem->valley - sample)) >> 15);
 	}
 
-	if (ModemConfig.modem != MODEM_9600)
+	if (port->modem != MODEM_9600)
 	{
+		int16_t in;
 		if (dem->prefilter != PREFILTER_NONE) // filter is used
 		{
-			dem->correlatorSamples[dem->correlatorSamplesIdx++] = filter(&dem->bpf, sample);
+			in = filter(&dem->bpf, sample);
 		}
 		else // no pre/deemphasis
 		{
-			dem->correlatorSamples[dem->correlatorSamplesIdx++] = sample;
+			in = sample;
 		}
 
-		dem->correlatorSamplesIdx %= N;
-
-		int32_t outLoI = 0, outLoQ = 0, outHiI = 0, outHiQ = 0; // output values after correlating
-
-		for (uint8_t i = 0; i < N; i++)
-		{
-			int16_t t = dem->correlatorSamples[(dem->correlatorSamplesIdx + i) % N]; // read sample
-			outLoI += t * coeffLoI[i];												 // correlate sample
-			outLoQ += t * coeffLoQ[i];
-			outHiI += t * coeffHiI[i];
-			outHiQ += t * coeffHiQ[i];
-		}
+		// store the sample twice, so that the window of the last N samples never wraps
+		dem->correlatorSamples[dem->correlatorSamplesIdx] = in;
+		dem->correlatorSamples[dem->correlatorSamplesIdx + port->N] = in;
+		if (++dem->correlatorSamplesIdx >= port->N)
+			dem->correlatorSamplesIdx = 0;
 
-		outHiI >>= 14;
-		outHiQ >>= 14;
-		outLoI >>= 14;
-		outLoQ >>= 14;
+		int32_t outLoI, outLoQ, outHiI, outHiQ; // output values after correlating
+		correlate(port, &dem->correlatorSamples[dem->correlatorSamplesIdx], &outLoI, &outLoQ, &outHiI, &outHiQ);
 
-		sample = (abs(outLoI) + abs(outLoQ)) - (abs(outHiI) + abs(outHiQ));
+		sample = (((abs(outLoI) + abs(outLoQ)) * dem->slicerGain) >> 8) - (abs(outHiI) + abs(outHiQ));
 	}
 
 	// DCD using "PLL"
@@ -526,10 +693,11 @@ static int32_t demodulate(int16_t sample, struct DemodState *dem)
 
 /**
  * @brief Decode received symbol: bit recovery, NRZI decoding and pass the decoded bit to higher level protocol
- * @param[in] symbol Received symbol
+ * @param[in] *port Port the demodulator belongs to
+ * @param[in] symbol Received symbol in bit 0, demodulator DCD state for this sample in bit 1
  * @param demod Demodulator index
  */
-static void decode(uint8_t symbol, uint8_t demod, uint16_t mV)
+static void decode(struct ModemPort *port, uint8_t symbol, uint8_t demod, uint16_t mV)
 {
 	struct DemodState *dem = (struct DemodState *)&demodState[demod];
 
@@ -546,34 +714,38 @@ static void decode(uint8_t symbol, uint8_t demod, uint16_t mV)
 	if ((dem->pll < 0) && (previous > 0)) // PLL counter overflow, sample symbol, decode NRZI and process in higher layer
 	{
 		dem->syncSymbols <<= 1; // shift recovered (received, synchronized) bit register
+		dem->weakSymbols <<= 1;
 
 		uint8_t sym = dem->rawSymbols & 0x07;							  // take last three symbols for sampling. Seems that 1 symbol is not enough, but 3 symbols work well
+		if ((sym != 0b111) && (sym != 0b000))							  // samples disagree, keep it as soft information for CRC recovery
+			dem->weakSymbols |= 1;
 		if (sym == 0b111 || sym == 0b110 || sym == 0b101 || sym == 0b011) // if there are 2 or 3 ones, then the received symbol is 1
 			sym = 1;
 		else
 			sym = 0;
 
-		if (ModemConfig.modem == MODEM_9600)
-			sym = descramble(sym); // descramble
+		if (port->modem == MODEM_9600)
+			sym = descramble(&port->lfsr, sym); // descramble
 
 		dem->syncSymbols |= sym;
 
-		// NRZI decoding
+		// NRZI decoding, the decoded bit depends on both symbols, so it is as weak as the number of weak symbols among them
+		uint8_t weak = (dem->weakSymbols & 1) + ((dem->weakSymbols >> 1) & 1);
 		if (((dem->syncSymbols & 0x03) == 0b11) || ((dem->syncSymbols & 0x03) == 0b00)) // two last symbols are the same - no symbol transition - decoded bit 1
 		{
 
-			Ax25BitParse(1, demod, mV);
+			Ax25BitParse(1, demod, mV, weak);
 		}
 		else // symbol transition - decoded bit 0
 		{
-			Ax25BitParse(0, demod, mV);
+			Ax25BitParse(0, demod, mV, weak);
 		}
 	}
 
 	if (((dem->rawSymbols & 0x03) == 0b10) || ((dem->rawSymbols & 0x03) == 0b01)) // if there was a symbol transition, adjust PLL
 	{
 		// avoid floating point operations. Multiply by n-bit value and shift by n bits
-		if (!dem->dcd) // PLL not locked
+		if (!(symbol & 2)) // PLL not locked
 		{
 			dem->pll = ((int64_t)dem->pll * (int64_t)dem->pllNotLockedTune) >> PLL_TUNE_BITS; // adjust PLL faster
 		}
@@ -635,6 +807,11 @@ void ModemTransmitStart(void)
  */
 void ModemTransmitStop(void)
 {
+	if (txRendering) // called by Ax25GetTxBit() while rendering ahead, the caller stops TX once the audio is out
+	{
+		txRenderEnd = true;
+		return;
+	}
 	DAC_TimerEnable(false);
 	AFSK_FlushFifo();        // Discard stale samples accumulated before/during TX
 	hw_afsk_dac_isr = false; // Re-enable ADC FIFO filling (s_conv_done_cb gate)
@@ -644,16 +821,72 @@ void ModemTransmitStop(void)
 }
 
 /**
- * @brief Initialize AFSK module
+ * @brief Build the 9600 Bd TX shaping table
+ * Every entry is the sum of raised cosine pulses of the symbols in the pattern, sampled at the DAC rate
+ * and delayed by half of the pulse span, so the middle symbol is the one being output.
  */
-void ModemInit(void)
+static void tx9600ShapeInit(void)
 {
-	memset(demodState, 0, sizeof(demodState));
+	static bool done = false;
+	if (done)
+		return;
 
-	if (ModemConfig.modem > MODEM_9600)
-		ModemConfig.modem = MODEM_1200;
+	float level[1 << TX9600_SHAPE_SYMBOLS][TX9600_SAMPLES_PER_SYMBOL];
+	float max = 0.f;
+	for (uint8_t pattern = 0; pattern < (1 << TX9600_SHAPE_SYMBOLS); pattern++)
+	{
+		for (uint8_t k = 0; k < TX9600_SAMPLES_PER_SYMBOL; k++)
+		{
+			float sum = 0.f;
+			for (uint8_t j = 0; j < TX9600_SHAPE_SYMBOLS; j++) // j = 0 is the newest symbol
+			{
+				// time from the center of symbol j in symbol periods
+				float t = ((float)k + 0.5f) / (float)TX9600_SAMPLES_PER_SYMBOL - 0.5f - (float)(TX9600_SHAPE_SYMBOLS / 2) + (float)j;
+				float h = 1.f;
+				if (fabsf(t) > 1e-6f)
+					h = sinf(3.1416f * t) / (3.1416f * t);
+				float d = 1.f - 4.f * TX9600_SHAPE_ROLLOFF * TX9600_SHAPE_ROLLOFF * t * t;
+				if (fabsf(d) > 1e-6f)
+					h *= cosf(3.1416f * TX9600_SHAPE_ROLLOFF * t) / d;
+				else
+					h *= 3.1416f / 4.f;
+				sum += ((pattern >> j) & 1) ? h : -h;
+			}
+			level[pattern][k] = sum;
+			if (fabsf(sum) > max)
+				max = fabsf(sum);
+		}
+	}
 
-	if ((ModemConfig.modem == MODEM_1200) || (ModemConfig.modem == MODEM_1200_V23))
+	for (uint8_t pattern = 0; pattern < (1 << TX9600_SHAPE_SYMBOLS); pattern++)
+	{
+		for (uint8_t k = 0; k < TX9600_SAMPLES_PER_SYMBOL; k++)
+			tx9600Shape[pattern][k] = 127 + (int16_t)lroundf(level[pattern][k] * (float)TX9600_SHAPE_AMPLITUDE / max);
+	}
+	done = true;
+}
+
+/**
+ * @brief Set up the demodulators and correlator of one port
+ * @param[out] *port Port state
+ * @param modem Modem type of the port
+ * @param flatAudioIn 1 if the port audio input is flat (unfiltered)
+ * @param first Index of the first demodulator available to the port
+ * @param maxDemods Number of demodulators available to the port
+ * @param[out] *mark, *space, *baud Mark and space frequency and baudrate of the port modem
+ * @return Number of demodulators used by the port
+ */
+static uint8_t initPort(struct ModemPort *port, enum ModemType modem, uint8_t flatAudioIn, uint8_t first, uint8_t maxDemods, float *mark, float *space, float *baud)
+{
+	struct DemodState *bank = &demodState[first];
+	uint8_t count = 1;
+
+	port->modem = modem;
+	port->firstDemod = first;
+	port->dcd = 0;
+	port->lfsr = 0xFFFFF;
+
+	if ((modem == MODEM_1200) || (modem == MODEM_1200_V23))
 	{
 		// use one modem in FX.25 mode
 		// FX.25 (RS) functions are not reentrant
@@ -667,133 +900,186 @@ void ModemInit(void)
 		// 			demodCount = 1;
 		// 		else
 
-		demodCount = 2;
-		N = N1200;
-		baudRate = 1200.f;
-
-		demodState[0].pllStep = PLL1200_STEP;
-		demodState[0].pllLockedTune = PLL1200_LOCKED_TUNE * (float)((uint32_t)1 << PLL_TUNE_BITS);
-		demodState[0].pllNotLockedTune = PLL1200_NOT_LOCKED_TUNE * (float)((uint32_t)1 << PLL_TUNE_BITS);
-		demodState[0].dcdMax = DCD1200_MAXPULSE;
-		demodState[0].dcdThres = DCD1200_THRES;
-		demodState[0].dcdInc = DCD1200_INC;
-		demodState[0].dcdDec = DCD1200_DEC;
-		demodState[0].dcdTune = DCD1200_TUNE * (float)((uint32_t)1 << PLL_TUNE_BITS);
-
-		demodState[1].pllStep = PLL1200_STEP;
-		demodState[1].pllLockedTune = PLL1200_LOCKED_TUNE * (float)((uint32_t)1 << PLL_TUNE_BITS);
-		demodState[1].pllNotLockedTune = PLL1200_NOT_LOCKED_TUNE * (float)((uint32_t)1 << PLL_TUNE_BITS);
-		demodState[1].dcdMax = DCD1200_MAXPULSE;
-		demodState[1].dcdThres = DCD1200_THRES;
-		demodState[1].dcdInc = DCD1200_INC;
-		demodState[1].dcdDec = DCD1200_DEC;
-		demodState[1].dcdTune = DCD1200_TUNE * (float)((uint32_t)1 << PLL_TUNE_BITS);
-
-		demodState[1].prefilter = PREFILTER_NONE;
-		demodState[1].lpf.coeffs = (int16_t *)lpf1200;
-		demodState[1].lpf.taps = sizeof(lpf1200) / sizeof(*lpf1200);
-		demodState[1].lpf.gainShift = 15;
-
-		demodState[0].lpf.coeffs = (int16_t *)lpf1200;
-		demodState[0].lpf.taps = sizeof(lpf1200) / sizeof(*lpf1200);
-		demodState[0].lpf.gainShift = 15;
-		demodState[0].prefilter = PREFILTER_NONE;
-
-		if (ModemConfig.flatAudioIn) // when used with flat audio input, use deemphasis and flat modems
+		count = ModemConfig.demodCount;
+		if (count == 0)
+			count = MODEM_DEFAULT_DEMODULATOR_COUNT;
+		if (count > maxDemods)
+			count = maxDemods;
+		if (count > (sizeof(demodBank1200) / sizeof(*demodBank1200)))
+			count = sizeof(demodBank1200) / sizeof(*demodBank1200);
+		port->N = N1200;
+		*baud = 1200.f;
+
+		// select primary and opposite emphasis filters for the configured audio input
+		enum ModemPrefilter primaryPrefilter, oppositePrefilter;
+		const int16_t *primaryBpf, *oppositeBpf;
+		if (flatAudioIn) // when used with flat audio input, use deemphasis and flat modems
 		{
 #ifdef ENABLE_FX25
 			if (Ax25Config.fx25)
-				demodState[0].prefilter = PREFILTER_NONE;
+				primaryPrefilter = PREFILTER_NONE;
 			else
 #endif
-				demodState[0].prefilter = PREFILTER_DEEMPHASIS;
-			demodState[0].bpf.coeffs = (int16_t *)bpf1200Inv;
-			demodState[0].bpf.taps = sizeof(bpf1200Inv) / sizeof(*bpf1200Inv);
-			demodState[0].bpf.gainShift = 15;
+				primaryPrefilter = PREFILTER_DEEMPHASIS;
+			primaryBpf = bpf1200Inv;
+			oppositePrefilter = PREFILTER_PREEMPHASIS;
+			oppositeBpf = bpf1200;
 		}
 		else // when used with normal (filtered) audio input, use flat and preemphasis modems
 		{
-			demodState[0].prefilter = PREFILTER_PREEMPHASIS;
-			demodState[0].bpf.coeffs = (int16_t *)bpf1200;
-			demodState[0].bpf.taps = sizeof(bpf1200) / sizeof(*bpf1200);
-			demodState[0].bpf.gainShift = 15;
+			primaryPrefilter = PREFILTER_PREEMPHASIS;
+			primaryBpf = bpf1200;
+			oppositePrefilter = PREFILTER_DEEMPHASIS;
+			oppositeBpf = bpf1200Inv;
+		}
+
+		for (uint8_t i = 0; i < count; i++)
+		{
+			const struct DemodProfile *profile = &demodBank1200[i];
+			struct DemodState *dem = &bank[i];
+
+			dem->pllStep = PLL1200_STEP;
+			dem->pllLockedTune = profile->pllLockedTune * (float)((uint32_t)1 << PLL_TUNE_BITS);
+			dem->pllNotLockedTune = profile->pllNotLockedTune * (float)((uint32_t)1 << PLL_TUNE_BITS);
+			dem->dcdMax = DCD1200_MAXPULSE;
+			dem->dcdThres = DCD1200_THRES;
+			dem->dcdInc = DCD1200_INC;
+			dem->dcdDec = DCD1200_DEC;
+			dem->dcdTune = profile->dcdTune * (float)((uint32_t)1 << PLL_TUNE_BITS);
+			dem->slicerGain = profile->slicerGain;
+
+			dem->lpf.coeffs = (int16_t *)lpf1200;
+			dem->lpf.taps = sizeof(lpf1200) / sizeof(*lpf1200);
+			dem->lpf.gainShift = 15;
+
+			if (profile->filter == BANK_FILTER_PRIMARY)
+			{
+				dem->prefilter = primaryPrefilter;
+				dem->bpf.coeffs = (int16_t *)primaryBpf;
+			}
+			else if (profile->filter == BANK_FILTER_OPPOSITE)
+			{
+				dem->prefilter = oppositePrefilter;
+				dem->bpf.coeffs = (int16_t *)oppositeBpf;
+			}
+			else
+			{
+				dem->prefilter = PREFILTER_NONE;
+				dem->bpf.coeffs = (int16_t *)bpf1200;
+			}
+			dem->bpf.taps = sizeof(bpf1200) / sizeof(*bpf1200);
+			dem->bpf.gainShift = 15;
 		}
 
-		if (ModemConfig.modem == MODEM_1200) // Bell 202
+		if (modem == MODEM_1200) // Bell 202
 		{
-			markFreq = 1200.f;
-			spaceFreq = 2200.f;
+			*mark = 1200.f;
+			*space = 2200.f;
 		}
 		else // V.23
 		{
-			markFreq = 1300.f;
-			spaceFreq = 2100.f;
+			*mark = 1300.f;
+			*space = 2100.f;
 		}
 	}
-	else if (ModemConfig.modem == MODEM_300)
-	{
-		demodCount = 1;
-		N = N300;
-		baudRate = 300.f;
-		markFreq = 1600.f;
-		spaceFreq = 1800.f;
-
-		demodState[0].pllStep = PLL300_STEP;
-		demodState[0].pllLockedTune = PLL300_LOCKED_TUNE * (float)((uint32_t)1 << PLL_TUNE_BITS);
-		demodState[0].pllNotLockedTune = PLL300_NOT_LOCKED_TUNE * (float)((uint32_t)1 << PLL_TUNE_BITS);
-		demodState[0].dcdMax = DCD300_MAXPULSE;
-		demodState[0].dcdThres = DCD300_THRES;
-		demodState[0].dcdInc = DCD300_INC;
-		demodState[0].dcdDec = DCD300_DEC;
-		demodState[0].dcdTune = DCD300_TUNE * (float)((uint32_t)1 << PLL_TUNE_BITS);
-
-		demodState[0].prefilter = PREFILTER_FLAT;
-		demodState[0].bpf.coeffs = (int16_t *)bpf300;
-		demodState[0].bpf.taps = sizeof(bpf300) / sizeof(*bpf300);
-		demodState[0].bpf.gainShift = 16;
-		demodState[0].lpf.coeffs = (int16_t *)lpf300;
-		demodState[0].lpf.taps = sizeof(lpf300) / sizeof(*lpf300);
-		demodState[0].lpf.gainShift = 15;
+	else if (modem == MODEM_300)
+	{
+		port->N = N300;
+		*baud = 300.f;
+		*mark = 1600.f;
+		*space = 1800.f;
+
+		bank[0].pllStep = PLL300_STEP;
+		bank[0].pllLockedTune = PLL300_LOCKED_TUNE * (float)((uint32_t)1 << PLL_TUNE_BITS);
+		bank[0].pllNotLockedTune = PLL300_NOT_LOCKED_TUNE * (float)((uint32_t)1 << PLL_TUNE_BITS);
+		bank[0].dcdMax = DCD300_MAXPULSE;
+		bank[0].dcdThres = DCD300_THRES;
+		bank[0].dcdInc = DCD300_INC;
+		bank[0].dcdDec = DCD300_DEC;
+		bank[0].dcdTune = DCD300_TUNE * (float)((uint32_t)1 << PLL_TUNE_BITS);
+
+		bank[0].slicerGain = 256;
+		bank[0].prefilter = PREFILTER_FLAT;
+		bank[0].bpf.coeffs = (int16_t *)bpf300;
+		bank[0].bpf.taps = sizeof(bpf300) / sizeof(*bpf300);
+		bank[0].bpf.gainShift = 16;
+		bank[0].lpf.coeffs = (int16_t *)lpf300;
+		bank[0].lpf.taps = sizeof(lpf300) / sizeof(*lpf300);
+		bank[0].lpf.gainShift = 15;
+	}
+	else if (modem == MODEM_9600)
+	{
+		port->N = N9600;
+		*baud = 9600.f;
+		*mark = 38400.f / (float)DAC_SINE_SIZE; // use as DAC sample rate
+
+		bank[0].pllStep = PLL9600_STEP;
+		bank[0].pllLockedTune = PLL9600_LOCKED_TUNE * (float)((uint32_t)1 << PLL_TUNE_BITS);
+		bank[0].pllNotLockedTune = PLL9600_NOT_LOCKED_TUNE * (float)((uint32_t)1 << PLL_TUNE_BITS);
+		bank[0].dcdMax = DCD9600_MAXPULSE;
+		bank[0].dcdThres = DCD9600_THRES;
+		bank[0].dcdInc = DCD9600_INC;
+		bank[0].dcdDec = DCD9600_DEC;
+		bank[0].dcdTune = DCD9600_TUNE * (float)((uint32_t)1 << PLL_TUNE_BITS);
+
+		bank[0].slicerGain = 256;
+		bank[0].prefilter = PREFILTER_NONE;
+		bank[0].lpf.coeffs = (int16_t *)lpf9600;
+		bank[0].lpf.taps = sizeof(lpf9600) / sizeof(*lpf9600);
+		bank[0].lpf.gainShift = 16;
 	}
-	else if (ModemConfig.modem == MODEM_9600)
-	{
-		demodCount = 1;
-		N = N9600;
-		baudRate = 9600.f;
-		markFreq = 38400.f / (float)DAC_SINE_SIZE; // use as DAC sample rate
-
-		demodState[0].pllStep = PLL9600_STEP;
-		demodState[0].pllLockedTune = PLL9600_LOCKED_TUNE * (float)((uint32_t)1 << PLL_TUNE_BITS);
-		demodState[0].pllNotLockedTune = PLL9600_NOT_LOCKED_TUNE * (float)((uint32_t)1 << PLL_TUNE_BITS);
-		demodState[0].dcdMax = DCD9600_MAXPULSE;
-		demodState[0].dcdThres = DCD9600_THRES;
-		demodState[0].dcdInc = DCD9600_INC;
-		demodState[0].dcdDec = DCD9600_DEC;
-		demodState[0].dcdTune = DCD9600_TUNE * (float)((uint32_t)1 << PLL_TUNE_BITS);
-
-		demodState[0].prefilter = PREFILTER_NONE;
-		// this filter will be used for RX and TX
-		demodState[0].lpf.coeffs = (int16_t *)lpf9600;
-		demodState[0].lpf.taps = sizeof(lpf9600) / sizeof(*lpf9600);
-		demodState[0].lpf.gainShift = 16;
+
+	for (uint8_t i = 0; i < port->N; i++) // calculate correlator coefficients
+	{
+		port->coeffLoI[i] = 4095.f * cosf(2.f * 3.1416f * (float)i / (float)port->N * *mark / *baud);
+		port->coeffLoQ[i] = 4095.f * sinf(2.f * 3.1416f * (float)i / (float)port->N * *mark / *baud);
+		port->coeffHiI[i] = 4095.f * cosf(2.f * 3.1416f * (float)i / (float)port->N * *space / *baud);
+		port->coeffHiQ[i] = 4095.f * sinf(2.f * 3.1416f * (float)i / (float)port->N * *space / *baud);
+	}
+
+	port->demodCount = count;
+	for (uint8_t i = first; i < first + count; i++)
+		demodPort[i] = port - ports;
+	return count;
+}
+
+/**
+ * @brief Initialize AFSK module
+ */
+void ModemInit(void)
+{
+	memset(demodState, 0, sizeof(demodState));
+	memset(demodPort, 0, sizeof(demodPort));
+
+	if (ModemConfig.modem > MODEM_9600)
+		ModemConfig.modem = MODEM_1200;
+	if (ModemConfig.port1Modem > MODEM_9600)
+		ModemConfig.port1Modem = MODEM_1200;
+
+	// with two ports each of them gets half of the demodulator bank
+	portCount = (ModemConfig.ports >= MODEM_MAX_PORTS) ? MODEM_MAX_PORTS : 1;
+	uint8_t maxDemods = MODEM_MAX_DEMODULATOR_COUNT / portCount;
+
+	// port 0 also transmits, so its modem sets the TX tones and baudrate
+	demodCount = initPort(&ports[0], ModemConfig.modem, ModemConfig.flatAudioIn, 0, maxDemods, &markFreq, &spaceFreq, &baudRate);
+	if (portCount > 1)
+	{
+		float mark = 0.f, space = 0.f, baud = 0.f;
+		demodCount += initPort(&ports[1], ModemConfig.port1Modem, ModemConfig.port1FlatAudioIn, demodCount, maxDemods, &mark, &space, &baud);
+		log_d("Port 1 modem %d, %d demodulators", ports[1].modem, ports[1].demodCount);
 	}
 
+	if (ModemConfig.modem == MODEM_9600)
+		tx9600ShapeInit();
+
 	markStep = (uint16_t)(DIV_ROUND(SIN_LEN * (uint32_t)markFreq, CONFIG_AFSK_DAC_SAMPLERATE));
 	spaceStep = (uint16_t)(DIV_ROUND(SIN_LEN * (uint32_t)spaceFreq, CONFIG_AFSK_DAC_SAMPLERATE));
 	baudRateStep = CONFIG_AFSK_DAC_SAMPLERATE / (uint32_t)baudRate;
 
 	log_d("markStep %d spaceStep %d baudRateStep %d", markStep, spaceStep, baudRateStep);
 
-	for (uint8_t i = 0; i < N; i++) // calculate correlator coefficients
-	{
-		coeffLoI[i] = 4095.f * cosf(2.f * 3.1416f * (float)i / (float)N * markFreq / baudRate);
-		coeffLoQ[i] = 4095.f * sinf(2.f * 3.1416f * (float)i / (float)N * markFreq / baudRate);
-		coeffHiI[i] = 4095.f * cosf(2.f * 3.1416f * (float)i / (float)N * spaceFreq / baudRate);
-		coeffHiQ[i] = 4095.f * sinf(2.f * 3.1416f * (float)i / (float)N * spaceFreq / baudRate);
-	}
-
 	if (ModemConfig.usePWM)
 	{
 		// MODEM_LL_PWM_INITIALIZE();
 	}
-}
\ No newline at end of file
+}
@@ -21,11 +21,23 @@ along with VP-Digi.  If not, see <http://www.gnu.org/licenses/>.
 #define DRIVERS_MODEM_H_
 
 #include <stdint.h>
-
-//number of maximum parallel demodulators
-//each demodulator must be explicitly configured in code
-//currently used only for 1200 Bd modem
-#define MODEM_MAX_DEMODULATOR_COUNT 2
+#include <stddef.h>
+
+//number of maximum parallel demodulators (size of the demodulator bank)
+//the actual number is selected at runtime with ModemConfig.demodCount
+//currently used only for 1200 Bd modem, other modems use one demodulator
+//with two RX ports the bank is split evenly between them
+#ifdef CONFIG_IDF_TARGET_ESP32S3
+#define MODEM_MAX_DEMODULATOR_COUNT 8
+#define MODEM_DEFAULT_DEMODULATOR_COUNT 4
+#else
+#define MODEM_MAX_DEMODULATOR_COUNT 4
+#define MODEM_DEFAULT_DEMODULATOR_COUNT 2
+#endif
+
+//number of audio inputs (ports) decoded at the same time
+//port 0 is the radio that also transmits, port 1 is an optional second receiver
+#define MODEM_MAX_PORTS 2
 
 enum ModemType
 {
@@ -49,6 +61,10 @@ struct ModemDemodConfig
 	enum ModemType modem;
 	uint8_t usePWM : 1; //0 - use R2R, 1 - use PWM
 	uint8_t flatAudioIn : 1; //0 - normal (deemphasized) audio input, 1 - flat audio (unfiltered) input
+	uint8_t demodCount; //number of parallel 1200 Bd demodulators, 0 - MODEM_DEFAULT_DEMODULATOR_COUNT
+	uint8_t ports; //number of RX ports, 0 or 1 - port 0 only, 2 - port 1 is decoded as well
+	enum ModemType port1Modem; //modem type of port 1
+	uint8_t port1FlatAudioIn : 1; //audio input type of port 1, as flatAudioIn
 };
 
 extern struct ModemDemodConfig ModemConfig;
@@ -71,17 +87,37 @@ enum ModemPrefilter
 void ModemGetSignalLevel(uint8_t modem, int8_t *peak, int8_t *valley, uint8_t *level);
 
 /**
- * @brief Get current modem baudrate
+ * @brief Get current modem baudrate of the TX port (port 0)
  * @return Baudrate
  */
 float ModemGetBaudrate(void);
 
 /**
- * @brief Get count of demodulators running in parallel
+ * @brief Get count of demodulators running in parallel, all ports together
  * @return Count of demodulators
  */
 uint8_t ModemGetDemodulatorCount(void);
 
+/**
+ * @brief Get number of RX ports being decoded
+ * @return 1 or 2
+ */
+uint8_t ModemGetPortCount(void);
+
+/**
+ * @brief Get modem type of a port
+ * @param port Port number
+ * @return Modem type
+ */
+enum ModemType ModemGetPortType(uint8_t port);
+
+/**
+ * @brief Get the port a demodulator belongs to
+ * @param modem Modem (demodulator) number
+ * @return Port number
+ */
+uint8_t ModemGetDemodulatorPort(uint8_t modem);
+
 /**
  * @brief Get prefilter type (preemphasis, deemphasis etc.) for given modem
  * @param modem Modem number
@@ -90,7 +126,7 @@ uint8_t ModemGetDemodulatorCount(void);
 enum ModemPrefilter ModemGetFilterType(uint8_t modem);
 
 /**
- * @brief Get current DCD state
+ * @brief Get current DCD state of the TX port (port 0)
  * @return 1 if channel busy, 0 if free
  */
 uint8_t ModemDcdState(void);
@@ -145,7 +181,27 @@ void ModemTransmitStop(void);
  */
 void ModemInit(void);
 
+/**
+ * @brief Decode a block of received samples (9600 Hz for 300/1200 Bd, 38400 Hz for 9600 Bd)
+ * @param port Port (audio input) the samples come from
+ * @param[in] *samples Received samples, no more than 13 bits
+ * @param[in] count Number of samples
+ * @param[in] mVrms Input RMS level passed to the AX.25 layer
+ */
+void ModemDecodeBlock(uint8_t port, const int16_t *samples, size_t count, uint16_t mVrms);
+
 void MODEM_DECODE(int16_t sample,uint16_t mVrms);
 uint8_t MODEM_BAUDRATE_TIMER_HANDLER(void);
 
+/**
+ * @brief Render TX audio ahead of time
+ * @details Runs the same bit source, NRZI and tone generator as the per-sample timer handler for a whole block,
+ * so the waveform can be streamed by DMA. When the last bit has been rendered the function returns early and
+ * ModemTransmitStop() is not called, the caller must call it once the rendered audio has been played.
+ * @param[out] *out Signed 16-bit samples at CONFIG_AFSK_DAC_SAMPLERATE
+ * @param[in] count Max number of samples
+ * @return Number of samples rendered, less than count when the transmission has ended
+ */
+size_t ModemTxRender(int16_t *out, size_t count);
+
 #endif
\ No newline at end of file
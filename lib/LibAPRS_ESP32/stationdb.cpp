@@ -0,0 +1,317 @@
+#include <Arduino.h>
+#include <stdlib.h>
+#include <string.h>
+#include "stationdb.h"
+
+#define FNV32_OFFSET 0x811C9DC5UL
+#define FNV32_PRIME 0x01000193UL
+
+static uint32_t hashKey(const char *key, size_t len)
+{
+	uint32_t h = FNV32_OFFSET;
+	for(size_t i = 0; i < len; i++)
+		h = (h ^ (uint8_t)key[i]) * FNV32_PRIME;
+	return h;
+}
+
+struct StationDb StationDbInit(uint16_t capacity)
+{
+	struct StationDb t;
+	memset(&t, 0, sizeof(t));
+	t.capacity = capacity;
+	return t;
+}
+
+/**
+ * @brief Allocate the index on first use
+ */
+static bool stationDbAlloc(struct StationDb *t)
+{
+	if(t->entries != NULL)
+		return true;
+	if((t->capacity == 0) || (t->capacity > 16384))
+		return false;
+
+	uint32_t size = 1;
+	while(size < 2U * t->capacity) //at most half full, probes stay short
+		size <<= 1;
+#ifdef BOARD_HAS_PSRAM
+	t->entries = (struct StationDbEntry*)ps_calloc(t->capacity, sizeof(*t->entries));
+	t->buckets = (struct StationDbBucket*)ps_calloc(t->capacity + 1, sizeof(*t->buckets));
+	t->slots = (uint16_t*)ps_calloc(size, sizeof(*t->slots));
+	if((t->entries == NULL) || (t->buckets == NULL) || (t->slots == NULL)) //no PSRAM found, fall back to internal RAM
+#endif
+	{
+		free(t->entries);
+		free(t->buckets);
+		free(t->slots);
+		t->entries = (struct StationDbEntry*)calloc(t->capacity, sizeof(*t->entries));
+		t->buckets = (struct StationDbBucket*)calloc(t->capacity + 1, sizeof(*t->buckets));
+		t->slots = (uint16_t*)calloc(size, sizeof(*t->slots));
+	}
+	if((t->entries == NULL) || (t->buckets == NULL) || (t->slots == NULL))
+	{
+		free(t->entries);
+		free(t->buckets);
+		free(t->slots);
+		t->entries = NULL;
+		t->buckets = NULL;
+		t->slots = NULL;
+		log_e("Station index allocation failed");
+		return false;
+	}
+	memset(t->slots, 0xFF, size * sizeof(*t->slots));
+	t->mask = size - 1;
+	for(uint16_t i = 0; i < t->capacity; i++)
+		t->entries[i].next = (i + 1 < t->capacity) ? i + 1 : STATIONDB_NONE;
+	for(uint16_t i = 0; i <= t->capacity; i++)
+		t->buckets[i].next = (i < t->capacity) ? i + 1 : STATIONDB_NONE;
+	t->freeList = 0;
+	t->freeBuckets = 0;
+	t->count = 0;
+	t->recentHead = t->recentTail = STATIONDB_NONE;
+	t->countHead = t->countTail = STATIONDB_NONE;
+	return true;
+}
+
+/**
+ * @brief Take an entry out of the open addressing table, shifting later entries of its probe run back
+ */
+static void tableRemove(struct StationDb *t, uint16_t idx)
+{
+	uint16_t pos = t->entries[idx].hash & t->mask;
+	while(t->slots[pos] != idx)
+		pos = (pos + 1) & t->mask;
+	t->slots[pos] = STATIONDB_NONE;
+
+	uint16_t j = pos;
+	while(1)
+	{
+		j = (j + 1) & t->mask;
+		if(t->slots[j] == STATIONDB_NONE)
+			break;
+		uint16_t home = t->entries[t->slots[j]].hash & t->mask;
+		if(((j - home) & t->mask) < ((j - pos) & t->mask))
+			continue; //home is between the hole and this slot, it can not move
+		t->slots[pos] = t->slots[j];
+		t->slots[j] = STATIONDB_NONE;
+		pos = j;
+	}
+}
+
+static void recentUnlink(struct StationDb *t, uint16_t idx)
+{
+	struct StationDbEntry *e = &t->entries[idx];
+	if(e->prev != STATIONDB_NONE)
+		t->entries[e->prev].next = e->next;
+	else
+		t->recentHead = e->next;
+	if(e->next != STATIONDB_NONE)
+		t->entries[e->next].prev = e->prev;
+	else
+		t->recentTail = e->prev;
+}
+
+static void recentPush(struct StationDb *t, uint16_t idx)
+{
+	struct StationDbEntry *e = &t->entries[idx];
+	e->prev = STATIONDB_NONE;
+	e->next = t->recentHead;
+	if(t->recentHead != STATIONDB_NONE)
+		t->entries[t->recentHead].prev = idx;
+	else
+		t->recentTail = idx;
+	t->recentHead = idx;
+}
+
+/**
+ * @brief Take a bucket from the free list and put it in front of another one
+ * @param before Bucket with the next lower count, STATIONDB_NONE for the lowest count
+ */
+static uint16_t bucketNew(struct StationDb *t, uint32_t count, uint16_t before)
+{
+	uint16_t b = t->freeBuckets;
+	struct StationDbBucket *k = &t->buckets[b];
+	t->freeBuckets = k->next;
+	k->count = count;
+	k->head = k->tail = STATIONDB_NONE;
+	k->next = before;
+	k->prev = (before != STATIONDB_NONE) ? t->buckets[before].prev : t->countTail;
+	if(k->prev != STATIONDB_NONE)
+		t->buckets[k->prev].next = b;
+	else
+		t->countHead = b;
+	if(before != STATIONDB_NONE)
+		t->buckets[before].prev = b;
+	else
+		t->countTail = b;
+	return b;
+}
+
+/**
+ * @brief Take an entry out of its bucket, an empty bucket goes back to the free list
+ */
+static void countUnlink(struct StationDb *t, uint16_t idx)
+{
+	struct StationDbEntry *e = &t->entries[idx];
+	struct StationDbBucket *k = &t->buckets[e->bucket];
+	if(e->countPrev != STATIONDB_NONE)
+		t->entries[e->countPrev].countNext = e->countNext;
+	else
+		k->head = e->countNext;
+	if(e->countNext != STATIONDB_NONE)
+		t->entries[e->countNext].countPrev = e->countPrev;
+	else
+		k->tail = e->countPrev;
+	if(k->head != STATIONDB_NONE)
+		return;
+
+	if(k->prev != STATIONDB_NONE)
+		t->buckets[k->prev].next = k->next;
+	else
+		t->countHead = k->next;
+	if(k->next != STATIONDB_NONE)
+		t->buckets[k->next].prev = k->prev;
+	else
+		t->countTail = k->prev;
+	k->next = t->freeBuckets;
+	t->freeBuckets = e->bucket;
+}
+
+static void countAppend(struct StationDb *t, uint16_t idx, uint16_t b)
+{
+	struct StationDbEntry *e = &t->entries[idx];
+	struct StationDbBucket *k = &t->buckets[b];
+	e->bucket = b;
+	e->count = k->count;
+	e->countNext = STATIONDB_NONE;
+	e->countPrev = k->tail;
+	if(k->tail != STATIONDB_NONE)
+		t->entries[k->tail].countNext = idx;
+	else
+		k->head = idx;
+	k->tail = idx;
+}
+
+uint16_t StationDbFind(struct StationDb *t, const char *key, size_t len)
+{
+	if((t->entries == NULL) || (len == 0) || (len > STATIONDB_KEY_MAX))
+		return STATIONDB_NONE;
+	t->lookups++;
+	uint32_t hash = hashKey(key, len);
+	uint16_t pos = hash & t->mask;
+	while(t->slots[pos] != STATIONDB_NONE)
+	{
+		struct StationDbEntry *e = &t->entries[t->slots[pos]];
+		if((e->hash == hash) && (e->keyLen == len) && (memcmp(e->key, key, len) == 0))
+			return t->slots[pos];
+		pos = (pos + 1) & t->mask;
+	}
+	return STATIONDB_NONE;
+}
+
+uint16_t StationDbAdd(struct StationDb *t, const char *key, size_t len)
+{
+	if((len == 0) || (len > STATIONDB_KEY_MAX) || !stationDbAlloc(t))
+		return STATIONDB_NONE;
+	if(t->freeList == STATIONDB_NONE)
+	{
+		StationDbRemove(t, t->recentTail);
+		t->evicted++;
+	}
+
+	uint16_t idx = t->freeList;
+	struct StationDbEntry *e = &t->entries[idx];
+	t->freeList = e->next;
+	e->hash = hashKey(key, len);
+	e->keyLen = len;
+	memcpy(e->key, key, len);
+
+	uint16_t pos = e->hash & t->mask;
+	while(t->slots[pos] != STATIONDB_NONE)
+		pos = (pos + 1) & t->mask;
+	t->slots[pos] = idx;
+	recentPush(t, idx);
+	uint16_t b = t->countTail;
+	if((b == STATIONDB_NONE) || (t->buckets[b].count != 1))
+		b = bucketNew(t, 1, STATIONDB_NONE);
+	countAppend(t, idx, b);
+	t->count++;
+	return idx;
+}
+
+void StationDbTouch(struct StationDb *t, uint16_t slot)
+{
+	if((t->entries == NULL) || (slot >= t->capacity) || (t->entries[slot].keyLen == 0) || (t->recentHead == slot))
+		return;
+	recentUnlink(t, slot);
+	recentPush(t, slot);
+}
+
+uint32_t StationDbCount(struct StationDb *t, uint16_t slot)
+{
+	if((t->entries == NULL) || (slot >= t->capacity) || (t->entries[slot].keyLen == 0))
+		return 0;
+	struct StationDbEntry *e = &t->entries[slot];
+	uint16_t b = e->bucket;
+	uint32_t count = e->count + 1;
+	if(count == 0) //stays at the top
+		return e->count;
+	uint16_t up = t->buckets[b].prev;
+	if((up == STATIONDB_NONE) || (t->buckets[up].count != count))
+		up = bucketNew(t, count, b);
+	countUnlink(t, slot);
+	countAppend(t, slot, up);
+	return count;
+}
+
+void StationDbRemove(struct StationDb *t, uint16_t slot)
+{
+	if((t->entries == NULL) || (slot >= t->capacity) || (t->entries[slot].keyLen == 0))
+		return;
+	tableRemove(t, slot);
+	recentUnlink(t, slot);
+	countUnlink(t, slot);
+	struct StationDbEntry *e = &t->entries[slot];
+	e->keyLen = 0;
+	e->next = t->freeList;
+	t->freeList = slot;
+	t->count--;
+}
+
+uint16_t StationDbFirst(const struct StationDb *t, enum StationDbOrder order)
+{
+	if(t->entries == NULL)
+		return STATIONDB_NONE;
+	switch(order)
+	{
+		case STATIONDB_RECENT:
+			return t->recentHead;
+		case STATIONDB_OLDEST:
+			return t->recentTail;
+		case STATIONDB_COUNT:
+			return (t->countHead != STATIONDB_NONE) ? t->buckets[t->countHead].head : STATIONDB_NONE;
+	}
+	return STATIONDB_NONE;
+}
+
+uint16_t StationDbNext(const struct StationDb *t, uint16_t slot, enum StationDbOrder order)
+{
+	if((t->entries == NULL) || (slot >= t->capacity) || (t->entries[slot].keyLen == 0))
+		return STATIONDB_NONE;
+	const struct StationDbEntry *e = &t->entries[slot];
+	switch(order)
+	{
+		case STATIONDB_RECENT:
+			return e->next;
+		case STATIONDB_OLDEST:
+			return e->prev;
+		case STATIONDB_COUNT:
+			if(e->countNext != STATIONDB_NONE)
+				return e->countNext;
+			if(t->buckets[e->bucket].next != STATIONDB_NONE)
+				return t->buckets[t->buckets[e->bucket].next].head;
+			return STATIONDB_NONE;
+	}
+	return STATIONDB_NONE;
+}
@@ -0,0 +1,122 @@
+#ifndef STATIONDB_H_
+#define STATIONDB_H_
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+
+#define STATIONDB_KEY_MAX 24 //longest key, callsign, object name and packet type fit
+#define STATIONDB_NONE 0xFFFF //no entry, empty table slot or end of a list
+
+/**
+ * @brief Orders a table can be walked in, all kept up to date on every change
+ */
+enum StationDbOrder
+{
+	STATIONDB_RECENT, //most recently added or touched first
+	STATIONDB_OLDEST, //least recently added or touched first, the next one to be evicted
+	STATIONDB_COUNT, //highest count first, equal counts in the order they reached it
+};
+
+/**
+ * @brief One keyed entry, its index is the record slot of the table it indexes
+ */
+struct StationDbEntry
+{
+	uint32_t hash;
+	uint32_t count;
+	uint8_t keyLen; //0 for a free entry
+	char key[STATIONDB_KEY_MAX];
+	uint16_t prev; //recent list, towards the most recent
+	uint16_t next; //recent list towards the oldest, or free list
+	uint16_t bucket; //count bucket the entry is in
+	uint16_t countPrev; //entries of the same bucket
+	uint16_t countNext;
+};
+
+/**
+ * @brief All entries with the same count
+ */
+struct StationDbBucket
+{
+	uint32_t count;
+	uint16_t prev; //bucket with the next higher count
+	uint16_t next; //bucket with the next lower count, or free list
+	uint16_t head;
+	uint16_t tail;
+};
+
+/**
+ * @brief Exact match index for tables of records found by name, like the last heard list
+ * @details The records stay where they are, the index hands out their slots. An open addressing
+ * table of entry indexes finds a key, an intrusive list keeps the entries from the most recent
+ * to the oldest one, which is evicted when the table is full. Count buckets keep the entries
+ * sorted by count, a count goes up by one at a time and the entry only moves to the next bucket.
+ * Memory is allocated on first use, see StationDbInit().
+ */
+struct StationDb
+{
+	uint16_t capacity; //slots of the indexed table
+	struct StationDbEntry *entries;
+	struct StationDbBucket *buckets; //capacity + 1, a count going up needs its new bucket before the old one is freed
+	uint16_t *slots; //open addressing table of entry indexes
+	uint16_t mask; //table size - 1
+	uint16_t freeList;
+	uint16_t freeBuckets;
+	uint16_t count;
+	uint16_t recentHead;
+	uint16_t recentTail;
+	uint16_t countHead; //bucket with the highest count
+	uint16_t countTail;
+	uint32_t lookups; //StationDbFind() calls
+	uint32_t evicted; //entries dropped to make room
+};
+
+/**
+ * @brief Empty index, to initialize a static one with
+ * @param capacity Slots of the indexed table, up to 16384
+ */
+struct StationDb StationDbInit(uint16_t capacity);
+
+/**
+ * @brief Find a key
+ * @return Slot, STATIONDB_NONE if the key is not there
+ */
+uint16_t StationDbFind(struct StationDb *t, const char *key, size_t len);
+
+/**
+ * @brief Add a key that is not there yet, as the most recent entry with count 1
+ * @details A full table drops its oldest entry, the caller reuses the record of the slot returned.
+ * @return Slot, STATIONDB_NONE if the key is too long or the index could not be allocated
+ */
+uint16_t StationDbAdd(struct StationDb *t, const char *key, size_t len);
+
+/**
+ * @brief Make an entry the most recent one
+ */
+void StationDbTouch(struct StationDb *t, uint16_t slot);
+
+/**
+ * @brief Count an entry once more
+ * @return New count
+ */
+uint32_t StationDbCount(struct StationDb *t, uint16_t slot);
+
+/**
+ * @brief Drop an entry, its slot is handed out again
+ */
+void StationDbRemove(struct StationDb *t, uint16_t slot);
+
+/**
+ * @brief First entry in an order
+ * @return Slot, STATIONDB_NONE if the index is empty
+ */
+uint16_t StationDbFirst(const struct StationDb *t, enum StationDbOrder order);
+
+/**
+ * @brief Entry after a slot in an order
+ * @return Slot, STATIONDB_NONE after the last one
+ */
+uint16_t StationDbNext(const struct StationDb *t, uint16_t slot, enum StationDbOrder order);
+
+#endif /* STATIONDB_H_ */
@@ -0,0 +1,99 @@
+#include <string.h>
+#include "tnc2.h"
+
+void LineReaderInit(struct LineReader *r)
+{
+	//overflows keeps counting across streams
+	r->start = 0;
+	r->scan = 0;
+	r->end = 0;
+	r->discard = false;
+}
+
+size_t LineReaderSpace(struct LineReader *r, char **at)
+{
+	if(r->start > 0) //move the unfinished line to the front
+	{
+		memmove(r->buf, &r->buf[r->start], r->end - r->start);
+		r->end -= r->start;
+		r->start = 0;
+	}
+	if(r->end == sizeof(r->buf)) //full without a line end, drop what there is and skip to the line end
+	{
+		if(!r->discard)
+			r->overflows++;
+		r->discard = true;
+		r->end = 0;
+		r->scan = 0;
+	}
+	*at = &r->buf[r->end];
+	return sizeof(r->buf) - r->end;
+}
+
+void LineReaderCommit(struct LineReader *r, size_t n)
+{
+	r->end += n;
+}
+
+char *LineReaderNext(struct LineReader *r, size_t *len)
+{
+	while(r->start + r->scan < r->end)
+	{
+		char *line = &r->buf[r->start];
+		char *nl = (char*)memchr(line + r->scan, '\n', r->end - r->start - r->scan);
+		if(nl == NULL)
+		{
+			r->scan = r->end - r->start; //search only the new bytes next time
+			return NULL;
+		}
+		size_t n = nl - line;
+		r->start += n + 1;
+		r->scan = 0;
+		if(r->discard) //end of a line that did not fit
+		{
+			r->discard = false;
+			continue;
+		}
+		*nl = 0;
+		if((n > 0) && (line[n - 1] == '\r'))
+			line[--n] = 0;
+		*len = n;
+		return line;
+	}
+	return NULL;
+}
+
+bool Tnc2Parse(const char *line, size_t len, struct Tnc2View *v)
+{
+	if((len == 0) || (line[0] == '#'))
+		return false;
+	const char *end = line + len;
+	const char *gt = (const char*)memchr(line, '>', len);
+	if((gt == NULL) || (gt == line) || (gt - line > 9))
+		return false;
+	const char *colon = (const char*)memchr(gt, ':', end - gt);
+	if(colon == NULL)
+		return false;
+
+	v->src = line;
+	v->srcLen = gt - line;
+	v->dst = gt + 1;
+	const char *comma = (const char*)memchr(v->dst, ',', colon - v->dst);
+	if(comma != NULL)
+	{
+		v->dstLen = comma - v->dst;
+		v->path = comma + 1;
+		v->pathLen = colon - v->path;
+	}
+	else
+	{
+		v->dstLen = colon - v->dst;
+		v->path = colon;
+		v->pathLen = 0;
+	}
+	if((v->dstLen == 0) || (v->dstLen > 9))
+		return false;
+	v->info = colon + 1;
+	v->infoLen = end - v->info;
+	return true;
+}
@@ -0,0 +1,65 @@
+#ifndef TNC2_H_
+#define TNC2_H_
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+
+#define TNC2_LINE_MAX 512 //longest APRS-IS line, CR LF included
+
+/**
+ * @brief Assembles lines from a byte stream in a fixed buffer
+ * @details Bytes are read straight into the buffer, complete lines are handed out in place.
+ * A line longer than the buffer is dropped up to its end.
+ */
+struct LineReader
+{
+	char buf[TNC2_LINE_MAX];
+	uint16_t start; //first byte not handed out yet
+	uint16_t scan; //bytes from start already searched for a line end
+	uint16_t end; //bytes in buf
+	bool discard; //inside a line that did not fit
+	uint32_t overflows; //lines dropped for being too long
+};
+
+/**
+ * @brief View of a TNC2 packet, "SRC>DST,PATH:info", pointing into the line
+ */
+struct Tnc2View
+{
+	const char *src;
+	uint8_t srcLen;
+	const char *dst;
+	uint8_t dstLen;
+	const char *path; //after the comma following DST, empty if there is no path
+	uint16_t pathLen;
+	const char *info; //NUL terminated when the line is
+	uint16_t infoLen;
+};
+
+void LineReaderInit(struct LineReader *r);
+
+/**
+ * @brief Free room at the end of the buffer, read new bytes there and pass their count to LineReaderCommit()
+ * @param[out] **at Where to write
+ * @return Free bytes, the buffer is compacted first when that makes room
+ */
+size_t LineReaderSpace(struct LineReader *r, char **at);
+
+void LineReaderCommit(struct LineReader *r, size_t n);
+
+/**
+ * @brief Take the next complete line
+ * @param[out] *len Line length without the line end
+ * @return The line, NUL terminated in the buffer in place of its line end, valid until the next
+ * LineReaderSpace() call. NULL if no complete line is buffered.
+ */
+char *LineReaderNext(struct LineReader *r, size_t *len);
+
+/**
+ * @brief Split a TNC2 line into its parts, without copying
+ * @return False for server comments ('#') and lines that are not packets
+ */
+bool Tnc2Parse(const char *line, size_t len, struct Tnc2View *v);
+
+#endif /* TNC2_H_ */
@@ -20,7 +20,7 @@ along with LwFEC.  If not, see <http://www.gnu.org/licenses/>.
 
 #include <stdint.h>
 
-extern const uint8_t GfExp[255];
+extern const uint8_t GfExp[510]; //exponent table, repeated once to take indexes up to 509
 extern const uint8_t GfLog[256];
 
 /**
@@ -58,7 +58,7 @@ static inline uint8_t GfMul(uint8_t x, uint8_t y)
     //fast multiplication using lookup tables
     //we know that log(x)+log(y)=log(x*y), and b^log(a)=a, when b is the logarithm base
     //so b^(log(x)+log(y))=b^log(x*y)=x*y, where b is the logarithm base
-    return GfExp[(GfLog[x] + GfLog[y]) % 255];
+    return GfExp[GfLog[x] + GfLog[y]]; //the sum is at most 508, the exponent table is long enough to skip the modulo
 }
 
 /**
@@ -74,7 +74,7 @@ static inline uint8_t GfDiv(uint8_t dividend, uint8_t divisor)
     if(dividend == 0)
         return 0; //trivial division of 0
     //similarly to multiplication, x/y=b^(log(x)-log(y)), where b is the logarithm base
-    return GfExp[(255 + GfLog[dividend] - GfLog[divisor]) % 255];
+    return GfExp[255 + GfLog[dividend] - GfLog[divisor]];
 }
 
 /**
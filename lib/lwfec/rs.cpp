@@ -19,429 +19,295 @@ along with LwFEC.  If not, see <http://www.gnu.org/licenses/>.
 #include "gf.h"
 #include <string.h>
 
-#define RS_USE_ALTERNATIVE_BM //use alternative Berlekamp-Massey implementation. Seems to be a bit faster
-//#define RS_USE_HORNER //use standard polynomial evalution method (Horner scheme) instead of Chien search. A bit slower
-
-
 /*
 This implementation aims for:
 1. Minimal RAM usage
 2. No malloc() (no heap usage)
 3. No big stack allocated arrays
-All arrays used internally by functions are either declared as static
-or they use the common buffer declared below. This buffer must be used with caution.
-All functions that use this buffer can only use it to store function-scope data.
+All arrays used internally by functions are declared as static.
+
+The decoder works on logarithms wherever a value is multiplied by consecutive powers of the same element
+(syndromes, Chien search, Forney's algorithm). The exponent is then stepped by an addition and each term
+is a single table lookup, without multiplications or a modulo in the inner loops.
 */
-static uint8_t commonBuffer[4 * RS_MAX_REDUNDANCY_BYTES + 4];
 
 /**
  * @brief Calculates message syndromes
+ * 
+ * Each nonzero byte is added to all syndromes in one pass: S_i += d * a^((fcr + i) * p), where p is the byte power.
+ * The exponent grows by p from one syndrome to the next, and zero bytes (the padding) are skipped.
  * @param *rs RS instance
- * @param data Input block (length = N)
- * @param size Block size = N
- * @param out Output syndromes (length = T)
+ * @param *data Input block (length = N)
+ * @param *out Output syndromes (length = T)
+ * @return True if all syndromes are zero, that is if the block is correct
  */
-static void syndromes(struct LwFecRS *rs, uint8_t *data, uint8_t size, uint8_t *out)
+static bool syndromes(struct LwFecRS *rs, uint8_t *data, uint8_t *out)
 {
-    for(uint8_t i = 0; i < rs->T; i++)
+    memset(out, 0, rs->T);
+    for(uint16_t j = 0; j < RS_BLOCK_SIZE; j++)
     {
-        out[i] = GfPolyEval(data, size, GfPow2(i + rs->fcr));
-    }
-}
-
-/**
- * @brief Calculate the error evaulator (list of erroneous positions)
- * @param *locator Error locator polynomial
- * @param locatorSize Error locator polynomial length <= T
- * @param out List of erroneous positions (error evaulator) (length = locatorSize - 1)
- * @return True on success, else the "out" buffer must be invalidated and the block is uncorrectable
- */
-static bool errorEvaluator(uint8_t *locator, uint8_t locatorSize, uint8_t *out)
-{
-    /*
-     * This function basically looks for error locator polynomial roots.
-     * First implementation uses brute-force polynomial evaluation with GfPolyEval, which uses Horner's method underneath
-     * Seconds implementation uses Chien search
-     */
-    uint8_t pos = 0;
-    for(uint8_t i = 0; i < RS_BLOCK_SIZE; i++)
-    {   
-        #ifdef RS_USE_HORNER
-        //standard evalution with Horner's method
-        //evaluate at 2^i. GfPow() can be used, but taking values from exp table directly is faster
-        if(GfPolyEval(locator, locatorSize, GfPow2(i % 255)) == 0) //if 2^i is the root of the locator polynomial, it determines the error position
-        {
-            if(pos < (locatorSize - 1))
-                out[pos] = RS_BLOCK_SIZE - i - 1; //calculate error position
-            else
-                break;
-            pos++;
-        }
-        #else
-        //evalution with Chien search
-        uint8_t lambda = 0;
-        for(uint8_t j = 0; j < locatorSize; j++)
+        if(data[j] == 0)
+            continue;
+        uint8_t power = RS_BLOCK_SIZE - 1 - j; //the first byte is the highest degree term
+        uint16_t e = (GfLog[data[j]] + (uint16_t)rs->fcr * power) % 255;
+        for(uint8_t i = 0; i < rs->T; i++)
         {
-            lambda ^= GfPow2((GfLog[locator[locatorSize - j - 1]] + i * j) % 255);
+            out[i] ^= GfExp[e];
+            e += power;
+            if(e >= 255)
+                e -= 255;
         }
-        if(lambda == 0) 
-            out[pos++] = RS_BLOCK_SIZE - i - 1; 
-        #endif
     }
 
-
-    if(pos != (locatorSize - 1))
-        return false;
-
-    return true;
+    uint8_t err = 0;
+    for(uint8_t i = 0; i < rs->T; i++)
+        err |= out[i];
+    return err == 0;
 }
 
-
 /**
- * @brief Calculates the error locator polynomial
+ * @brief Calculates the error locator polynomial using Berlekamp-Massey algorithm
  * @param *rs RS instance
- * @param *syndromes Syndrome polynomial (length = T)
- * @param *out Output error locator buffer
- * @param outSize Error locator polynomial buffer length <= T
- * @return True if success, else the "out" buffer must be invalidated and the block is uncorrectable
+ * @param *syn Syndrome polynomial (length = T)
+ * @param *out Output error locator buffer (length = T + 1), lowest degree term first
+ * @return Number of errors (locator degree) or 0 if the block is uncorrectable
  */
-static bool errorLocator(struct LwFecRS *rs, uint8_t *syndromes, uint8_t *out, uint8_t *outSize)
+static uint8_t errorLocator(struct LwFecRS *rs, uint8_t *syn, uint8_t *out)
 {
-    /*
-     * The error locator polynomial is calculated using Berlekamp-Massey algorithm.
-     * Two implementations are written here:
-     * 1. directly adapted from Wikipedia (https://en.wikipedia.org/wiki/Berlekamp%E2%80%93Massey_algorithm)
-     * 2. adapted/ported from Python from Wikiversity "Reed-Solomon codes for coders" 
-     * (https://en.wikiversity.org/wiki/Reed%E2%80%93Solomon_codes_for_coders#Error_correction)
-     * Both implementations work just fine.
-    */
-#ifndef RS_USE_ALTERNATIVE_BM
+    static uint8_t prev[RS_MAX_REDUNDANCY_BYTES + 1]; //locator before the last length change
+    static uint8_t tmp[RS_MAX_REDUNDANCY_BYTES + 1];
+
+    memset(out, 0, rs->T + 1);
+    memset(prev, 0, rs->T + 1);
+    out[0] = 1;
+    prev[0] = 1;
+
     uint8_t L = 0; //number of assumed errors
-    uint8_t m = 1; //number of iterations since L, B and b were updated
-    uint8_t b = 1; //last discrepancy delta
-
-    //4 variables of RS_MAX_REDUNDANCY_BYTES + 1 each
-    // static uint8_t B[RS_MAX_REDUNDANCY_BYTES + 1]; //last locator polynomial
-    // static uint8_t C[RS_MAX_REDUNDANCY_BYTES + 1]; //current locator polynomial
-    // static uint8_t T[RS_MAX_REDUNDANCY_BYTES + 1]; //temporary polynomial
-    // static uint8_t T2[RS_MAX_REDUNDANCY_BYTES + 1]; //temporary polynomial
-    uint8_t *B = commonBuffer;
-    uint8_t *C = B + RS_MAX_REDUNDANCY_BYTES + 1;
-    uint8_t *T = C + RS_MAX_REDUNDANCY_BYTES + 1;
-    uint8_t *T2 = T + RS_MAX_REDUNDANCY_BYTES + 1;
-
-    //initialize B and C polynomials with the constant term
-    memset(B, 0, rs->T + 1);
-    B[0] = 1;
-    memset(C, 0, rs->T + 1);
-    C[0] = 1;
-    memset(T, 0, rs->T + 1);
-    memset(T2, 0, rs->T + 1);
+    uint8_t m = 1; //number of iterations since L and prev were updated
+    uint8_t b = 1; //discrepancy at the last length change
 
     for(uint8_t i = 0; i < rs->T; i++)
     {
-        uint8_t d = syndromes[i];
+        uint8_t delta = syn[i];
         for(uint8_t j = 1; j <= L; j++)
         {
-            d = GfAdd(d, GfMul(C[j], syndromes[i - j])); //calculate discrepancy delta
+            if((out[j] != 0) && (syn[i - j] != 0))
+                delta ^= GfExp[GfLog[out[j]] + GfLog[syn[i - j]]];
         }
-        if(d == 0) //no error
+        if(delta == 0)
         {
             m++;
+            continue;
         }
-        else if((L << 1) <= i)
-        {
-            memcpy(T, C, rs->T); //store C polynomial in T
-            //in general, C(x)=C(x)-(d/b)*B(x)*x^m
-            //first B(x)=B(x)*x^m
-            //here we store polynomials as the lowest degree term first
-            //multipyling it by x^m shifts the polynomial coefficient by m places right
-            //so swap places starting from the last element and fill first m places with zeros
-            for(uint8_t j = 0; j < (rs->T - m); j++)
-            {
-                B[rs->T - j - 1] = B[rs->T - j - m - 1];
-            }
-            for(uint8_t j = 0; j < m; j++)
-                B[j] = 0;
-
-            //then B(x)*d/b
-            GfPolyScale(B, rs->T, GfMul(d, GfInv(b)), B);
-
-            //then C(x)=C(x)-B(x) (subtraction is the same as addition in GF)
-            GfPolyAdd(T, rs->T, B, rs->T, C);
-
-            //store T polynomial in B (previous C to B)
-            memcpy(B, T, rs->T);
 
+        //out(x) -= (delta / b) * x^m * prev(x)
+        uint16_t scale = 255 + GfLog[delta] - GfLog[b];
+        if(scale >= 255)
+            scale -= 255;
+        bool grow = (L << 1) <= i;
+        if(grow)
+            memcpy(tmp, out, rs->T + 1);
+        for(uint8_t j = 0; (j + m) <= rs->T; j++)
+        {
+            if(prev[j] != 0)
+                out[j + m] ^= GfExp[GfLog[prev[j]] + scale];
+        }
+        if(grow)
+        {
             L = i + 1 - L;
-            b = d;
+            memcpy(prev, tmp, rs->T + 1);
+            b = delta;
             m = 1;
         }
         else
-        {
-            //the same as above, but save B in T2 first
-            memcpy(T, C, rs->T);
-            memcpy(T2, B, rs->T);
-            for(uint8_t j = 0; j < (rs->T - m); j++)
-            {
-                B[rs->T - j - 1] = B[rs->T - j - m - 1];
-            }
-            for(uint8_t j = 0; j < m; j++)
-                B[j] = 0;
-            GfPolyScale(B, rs->T, GfMul(d, GfInv(b)), B);
-            GfPolyAdd(T, rs->T, B, rs->T, C);
-            //restore T2 to B
-            memcpy(B, T2, rs->T);
             m++;
-        }
     }
 
-    *outSize = L + 1;
-    memcpy(out, C, rs->T);
-
-    if((L * 2) > rs->T)
-        return false;
-
-    return true;
-#else
-
-    // static uint8_t errLoc[RS_MAX_REDUNDANCY_BYTES + 1];
-    // static uint8_t newLoc[RS_MAX_REDUNDANCY_BYTES + 1];
-    // static uint8_t oldLoc[RS_MAX_REDUNDANCY_BYTES + 1];
-    // static uint8_t tmpLoc[RS_MAX_REDUNDANCY_BYTES + 1];
-    uint8_t *errLoc = commonBuffer;
-    uint8_t *newLoc = errLoc + RS_MAX_REDUNDANCY_BYTES + 1;
-    uint8_t *oldLoc = newLoc + RS_MAX_REDUNDANCY_BYTES + 1;
-    uint8_t *tmpLoc = oldLoc + RS_MAX_REDUNDANCY_BYTES + 1;
-
-    memset(errLoc, 0, rs->T + 1);
-    memset(newLoc, 0, rs->T + 1);
-    memset(oldLoc, 0, rs->T + 1);
-    memset(tmpLoc, 0, rs->T + 1);
-
-    uint8_t newLocLen = 0;
-    uint8_t errLocLen = 1;
-    uint8_t oldLocLen = 1;
+    if((L << 1) > rs->T)
+        return 0;
+    return L;
+}
 
-    errLoc[0] = 1;
-    oldLoc[0] = 1;
+/**
+ * @brief Find the erroneous positions (locator roots) using Chien search
+ * @param *locator Error locator polynomial, lowest degree term first
+ * @param L Locator degree (number of errors)
+ * @param *out List of erroneous positions (length = L)
+ * @return True on success, false if the locator does not have L roots and the block is uncorrectable
+ */
+static bool errorPositions(uint8_t *locator, uint8_t L, uint8_t *out)
+{
+    if(L == 1)
+    {
+        //single error, the root of 1 + a*x is 1/a, so the error is at the power log(a) and no search is needed
+        if(locator[1] == 0)
+            return false;
+        out[0] = RS_BLOCK_SIZE - 1 - GfLog[locator[1]];
+        return true;
+    }
 
-    for(uint8_t i = 0; i < rs->T; i++)
+    //evaluate the locator at a^-i for all i, keeping the exponent of each nonzero term
+    static uint8_t term[RS_MAX_REDUNDANCY_BYTES + 1]; //term degree
+    static uint8_t termLog[RS_MAX_REDUNDANCY_BYTES + 1]; //term exponent at the current a^-i
+    uint8_t terms = 0;
+    for(uint8_t j = 1; j <= L; j++)
     {
-        uint8_t delta = syndromes[i];
-        for(uint8_t j = 1; j < errLocLen; j++)
+        if(locator[j] != 0)
         {
-            delta = GfSub(delta, GfMul(errLoc[j], syndromes[i - j]));
+            term[terms] = j;
+            termLog[terms] = GfLog[locator[j]];
+            terms++;
         }
+    }
 
-        for(uint8_t j = 0; j < oldLocLen; j++)
+    uint8_t pos = 0;
+    for(uint16_t i = 0; i < 255; i++)
+    {
+        uint8_t sum = locator[0];
+        for(uint8_t k = 0; k < terms; k++)
         {
-            oldLoc[oldLocLen - j] = oldLoc[oldLocLen - j - 1];
+            sum ^= GfExp[termLog[k]];
+            uint16_t e = termLog[k] + 255 - term[k]; //multiply the term by a^-degree for the next i
+            termLog[k] = (e >= 255) ? (e - 255) : e;
         }
-        oldLoc[0] = 0;
-
-        oldLocLen++;
-
-        if(delta != 0)
+        if(sum == 0) //a^-i is a root, the error is at the power i
         {
-            if(oldLocLen > errLocLen)
-            {
-                GfPolyScale(oldLoc, oldLocLen, delta, newLoc);
-                newLocLen = oldLocLen;
-                GfPolyScale(errLoc, errLocLen, GfInv(delta), oldLoc);
-                oldLocLen = errLocLen;
-                memcpy(errLoc, newLoc, newLocLen);
-                errLocLen = newLocLen;
-            }
-            GfPolyScale(oldLoc, oldLocLen, delta, newLoc);
-            newLocLen = oldLocLen;
-            memcpy(tmpLoc, errLoc, errLocLen);
-            errLocLen = GfPolyAdd(tmpLoc, errLocLen, newLoc, newLocLen, errLoc);
+            out[pos++] = RS_BLOCK_SIZE - 1 - i;
+            if(pos == L) //all roots found
+                break;
         }
     }
 
-    uint8_t index = 0;
-    for(uint8_t i = 0; i < errLocLen; i++)
-    {
-        if((index == 0) && (errLoc[i] == 0)) //drop leading zeros
-            continue;
-
-        out[index++] = errLoc[i];
-    }
-
-    if(((errLocLen - 1) << 1) > rs->T)
-        return false;
-
-    *outSize = errLocLen;
-    return true;
-#endif
+    return pos == L;
 }
 
 /**
- * @brief Calculates error magnitude (errata) polynomial and fix data
+ * @brief Calculate error magnitudes using Forney's algorithm and fix data
+ * 
+ * The magnitude at X = a^power is X^(1-fcr) * O(1/X) / L'(1/X), where O(x) = S(x) * L(x) mod x^L is the error evaluator
+ * and L'(x) is the formal derivative of the locator. The syndromes are updated with every correction.
  * @param *rs RS instance
  * @param *data Input data block
- * @param size Block size = N
- * @param *syn Syndrome polynomial
- * @param *evaluator Error evaluator polynomial
- * @param errCount Number of errors (error evaulator size)
+ * @param *syn Syndrome polynomial, updated to the syndromes of the corrected block
+ * @param *locator Error locator polynomial, lowest degree term first
+ * @param *positions Erroneous positions
+ * @param L Number of errors
  * @return True on success, false on failure
  */
-static bool fix(struct LwFecRS *rs, uint8_t *data, uint8_t size, uint8_t *syn, uint8_t *evaluator, uint8_t errCount)
+static bool fix(struct LwFecRS *rs, uint8_t *data, uint8_t *syn, uint8_t *locator, uint8_t *positions, uint8_t L)
 {
-    /*
-     * This is based on Forney's algorithm.
-     */
-    //variables of size 3 * RS_MAX_REDUNDANCY_BYTES + 3
-    //static uint8_t locator[RS_MAX_REDUNDANCY_BYTES + 1];
-    //static uint8_t errataEvaluator[2 * RS_MAX_REDUNDANCY_BYTES + 2];
-    uint8_t *locator = commonBuffer;
-    uint8_t *errataEvaluator = locator + RS_MAX_REDUNDANCY_BYTES + 1;
-
-    memset(locator, 0, rs->T + 1);
-    memset(errataEvaluator, 0, 2 * rs->T + 2);
-    
-    locator[0] = 1; //initialize error locator to constant
-    uint8_t locatorSize = 1;
-
-    //use "errataEvaluator" as temporary variable
-    for(uint8_t i = 0; i < errCount; i++)
-    {
-        memcpy(errataEvaluator, locator, rs->T);
-        uint8_t p2[2];
-        p2[1]=1;
-        p2[0]=GfPow(2, size - 1 - evaluator[i]);
-        GfPolyMul(errataEvaluator, locatorSize, p2, 2, locator);
-        locatorSize++;
-    }
-
-    memset(errataEvaluator, 0, 2 * rs->T + 2);
+    static uint8_t evaluator[RS_MAX_REDUNDANCY_BYTES + 1];
 
-    GfPolyInv(syn, rs->T);
-    GfPolyMul(syn, rs->T, locator, locatorSize, errataEvaluator);
-    for(uint8_t i = 0; i < locatorSize; i++)
+    for(uint8_t i = 0; i < L; i++)
     {
-        errataEvaluator[i] = errataEvaluator[rs->T + i];
+        uint8_t o = 0;
+        for(uint8_t j = 0; j <= i; j++)
+        {
+            if((syn[i - j] != 0) && (locator[j] != 0))
+                o ^= GfExp[GfLog[syn[i - j]] + GfLog[locator[j]]];
+        }
+        evaluator[i] = o;
     }
 
-    uint8_t errataPosition[RS_MAX_REDUNDANCY_BYTES];
-    for(uint8_t i = 0; i < errCount; i++)
+    uint16_t xInvFactor = (uint16_t)(256 - rs->fcr) % 255; //exponent of X^(1-fcr) per unit of power
+    for(uint8_t k = 0; k < L; k++)
     {
-        errataPosition[i] = GfPow(2, size - 1 - evaluator[i]);
-    }
+        uint8_t power = RS_BLOCK_SIZE - 1 - positions[k];
+        uint8_t step = (255 - power) % 255; //exponent of 1/X
 
-    uint8_t *errLocPrimePoly = syn; //reuse
-    uint8_t errLocPrimePolyLen = 0;
-    for(uint8_t i = 0; i < errCount; i++)
-    {
-        errLocPrimePolyLen = 0;
-        uint8_t errataInv = GfInv(errataPosition[i]);
-        for(uint8_t j = 0; j < errCount; j++)
+        uint8_t o = 0, d = 0; //O(1/X) and L'(1/X)
+        uint16_t e = 0; //exponent of (1/X)^j
+        for(uint8_t j = 0; j < L; j++)
         {
-            if(j != i)
-            {
-                errLocPrimePoly[errLocPrimePolyLen++] = GfSub(1, GfMul(errataInv, errataPosition[j]));
-            }
-        }
-        uint8_t errLocPrime = 1;
-        for(uint8_t j = 0; j < errLocPrimePolyLen; j++)
-        {
-            errLocPrime = GfMul(errLocPrime, errLocPrimePoly[j]);
+            if(evaluator[j] != 0)
+                o ^= GfExp[GfLog[evaluator[j]] + e];
+            if(((j & 1) == 0) && (locator[j + 1] != 0)) //odd terms of the locator make its derivative
+                d ^= GfExp[GfLog[locator[j + 1]] + e];
+            e += step;
+            if(e >= 255)
+                e -= 255;
         }
+        if(d == 0)
+            return false;
+        if(o == 0)
+            continue; //zero magnitude, nothing to fix
 
-        uint8_t y = GfPolyEval(errataEvaluator, locatorSize, errataInv);
-        //in general y*=errataInv**(fcr-1)
-        //for fcr=0 y*=errataInv**-1=errataPosition
-        //for fcr=1 y does not change
-        if(rs->fcr == 0)
-            y = GfMul(y, errataPosition[i]);
-        else if(rs->fcr > 0)
-            y = GfMul(y, GfPow(errataInv, rs->fcr - 1));
+        uint16_t magLog = (GfLog[o] + xInvFactor * power + 255 - GfLog[d]) % 255;
+        data[positions[k]] ^= GfExp[magLog];
 
-        if(errLocPrime == 0)
+        //remove the error from the syndromes: S_i -= e * X^(fcr + i)
+        uint16_t s = (magLog + (uint16_t)rs->fcr * power) % 255;
+        for(uint8_t i = 0; i < rs->T; i++)
         {
-            return false;
+            syn[i] ^= GfExp[s];
+            s += power;
+            if(s >= 255)
+                s -= 255;
         }
-        data[evaluator[i]] = GfSub(data[evaluator[i]], GfDiv(y, errLocPrime));
     }
 
     return true;
 }
 
-
-/**
- * @brief Check if syndromes are all zero, that is if the message is correct
- * @param *syndromes Syndrome polynomial
- * @param size Syndrome polynomial size (buffer length)
- * @return True if all zero
-*/
-static bool checkSyndromes(uint8_t *syndromes, uint8_t size)
-{
-    bool err = false;
-
-    for(uint8_t i = 0; i < size; i++) //check if all syndromes are 0, if so, the message is correct
-    {
-        if(syndromes[i] != 0)
-        {
-            err = true;
-        }
-    }
-    return !err;
-}
-
 bool RsDecode(struct LwFecRS *rs, uint8_t *data, uint8_t size, uint8_t *fixed)
 {
     if((size > (RS_BLOCK_SIZE - rs->T)) || (rs->T > RS_MAX_REDUNDANCY_BYTES))
         return false;
     
-    //This function needs 3 arrays of RS_MAX_REDUNDANCY_BYTES + 1 each
     static uint8_t syn[RS_MAX_REDUNDANCY_BYTES + 1];
     static uint8_t locator[RS_MAX_REDUNDANCY_BYTES + 1];
-    static uint8_t evaluator[RS_MAX_REDUNDANCY_BYTES + 1];
-    
-    memset(syn, 0, rs->T + 1);
-    memset(locator, 0, rs->T + 1);
-    memset(evaluator, 0, rs->T + 1);
+    static uint8_t positions[RS_MAX_REDUNDANCY_BYTES + 1];
 
     memmove(&data[RS_BLOCK_SIZE - rs->T], &data[size], rs->T);
     memset(&data[size], 0, RS_BLOCK_SIZE - size - rs->T);
     
-    syndromes(rs, data, RS_BLOCK_SIZE, syn); //calculate syndromes
-
-    if(checkSyndromes(syn, rs->T))
+    if(syndromes(rs, data, syn)) //all zero, the block is correct
         return true;
 
-    uint8_t locatorSize = 0;
-
-    if(!errorLocator(rs, syn, locator, &locatorSize)) //calculate error locator polynomial
+    uint8_t errors = errorLocator(rs, syn, locator); //calculate error locator polynomial
+    if(errors == 0)
         return false;
 
-    if(!errorEvaluator(locator, locatorSize, evaluator)) //calculate error evaulator (list of erroneous positions)
+    if(!errorPositions(locator, errors, positions)) //find erroneous positions
         return false;
 
-    if(!fix(rs, data, RS_BLOCK_SIZE, syn, evaluator, locatorSize - 1)) //calculate error magnitude (errata) polynomial and try to fix
+    if(!fix(rs, data, syn, locator, positions, errors)) //calculate error magnitudes and fix
         return false;
 
-    syndromes(rs, data, RS_BLOCK_SIZE, syn); //calculate syndromes again to check if the message has been corrected successfully
-
-    if(checkSyndromes(syn, rs->T))
+    for(uint8_t i = 0; i < rs->T; i++) //check if the message has been corrected successfully
     {
-        *fixed = locatorSize - 1;
-        return true;
+        if(syn[i] != 0)
+            return false;
     }
-    else
-        return false;
+    *fixed = errors;
+    return true;
 }
 
 void RsEncode(struct LwFecRS *rs, uint8_t *data, uint8_t size)
 {
-    if((size > (RS_BLOCK_SIZE - rs->T)) || (rs->T > RS_MAX_REDUNDANCY_BYTES))
+    if((size > (RS_BLOCK_SIZE - rs->T)) || (rs->T > RS_MAX_REDUNDANCY_BYTES) || (rs->T == 0))
         return;
 
-    memset(&data[size], 0, RS_BLOCK_SIZE - size);
-    static uint8_t t[RS_BLOCK_SIZE];
-    memset(t, 0, sizeof(t));
-    memcpy(&data[size], GfPolyDiv(data, RS_BLOCK_SIZE, rs->generator, rs->T + 1, t), rs->T);
+    //divide by the generator polynomial in a shift register, the padding up to N - T is fed as zeros
+    static uint8_t parity[RS_MAX_REDUNDANCY_BYTES];
+    memset(parity, 0, rs->T);
+    for(uint8_t i = 0; i < (RS_BLOCK_SIZE - rs->T); i++)
+    {
+        uint8_t feedback = ((i < size) ? data[i] : 0) ^ parity[0];
+        if(feedback == 0)
+        {
+            memmove(parity, &parity[1], rs->T - 1);
+            parity[rs->T - 1] = 0;
+            continue;
+        }
+        uint8_t f = GfLog[feedback];
+        for(uint8_t j = 0; j < (rs->T - 1); j++)
+            parity[j] = parity[j + 1] ^ ((rs->generator[j + 1] != 0) ? GfExp[f + rs->generatorLog[j + 1]] : 0);
+        parity[rs->T - 1] = (rs->generator[rs->T] != 0) ? GfExp[f + rs->generatorLog[rs->T]] : 0;
+    }
+
+    memcpy(&data[size], parity, rs->T);
+    memset(&data[size + rs->T], 0, RS_BLOCK_SIZE - size - rs->T);
 }
 
 void RsInit(struct LwFecRS *rs, uint8_t T, uint8_t fcr)
@@ -460,6 +326,8 @@ void RsInit(struct LwFecRS *rs, uint8_t T, uint8_t fcr)
         p2[0]=1;
         GfPolyMul(temp, i + 1, p2, 2, rs->generator);
     }
+    for(uint8_t i = 0; i <= T; i++)
+        rs->generatorLog[i] = GfLog[rs->generator[i]];
     rs->T = T;
     rs->fcr = fcr;
 }
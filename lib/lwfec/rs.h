@@ -15,6 +15,9 @@ You should have received a copy of the GNU General Public License
 along with LwFEC.  If not, see <http://www.gnu.org/licenses/>.
 */
 
+#ifndef RS_H_
+#define RS_H_
+
 #include <stdint.h>
 #include <stdbool.h>
 
@@ -30,6 +33,7 @@ along with LwFEC.  If not, see <http://www.gnu.org/licenses/>.
 struct LwFecRS
 {
     uint8_t generator[RS_MAX_REDUNDANCY_BYTES + 1]; //generator polynomial
+    uint8_t generatorLog[RS_MAX_REDUNDANCY_BYTES + 1]; //logarithms of the generator coefficients, for the encoder
     uint8_t T; //number of redundancy/parity bytes
     uint8_t fcr; //first consecutive root index
 };
@@ -65,3 +69,5 @@ void RsEncode(struct LwFecRS *rs, uint8_t *data, uint8_t size);
  * @param fcr First consecutive root index
 */
 void RsInit(struct LwFecRS *rs, uint8_t T, uint8_t fcr);
+
+#endif
@@ -0,0 +1,175 @@
+#include "agwpe.h"
+#include "tcpfanout.h"
+#include <AGW.h>
+#include <AX25.h>
+
+extern void aprsTaskNotify();
+
+// Messages to clients go through the same fan-out as the KISS TCP server. A received frame
+// is built once per message kind and shared by all clients, replies belong to one client.
+// Client queues hold at most AGW_TCP_MAX_CLIENTS * AGW_TCP_CLIENT_QUEUE buffers, a broadcast
+// needs two more.
+#define AGW_TCP_MESSAGES (AGW_TCP_MAX_CLIENTS * AGW_TCP_CLIENT_QUEUE + 2)
+
+typedef struct
+{
+    uint8_t slot;
+    struct AgwSession session; // only used by this client's callbacks
+} agwClient;
+
+typedef struct
+{
+    uint16_t length;
+    uint8_t data[AX25_FRAME_MAX_SIZE];
+} agwTxFrame;
+
+static tcpFanout fanout;
+static agwClient *clients = NULL;
+static agwTxFrame txQueue[AGW_TCP_TX_QUEUE];
+static uint8_t txHead = 0;
+static uint8_t txCount = 0;
+static agwTcpStats stats;
+
+// Session output: a reply to this client
+static void sessionWrite(void *arg, const uint8_t *msg, size_t len)
+{
+    agwClient *c = (agwClient *)arg;
+
+    if (len > AGW_MAX_MESSAGE)
+        return;
+    tcpFanoutLock(&fanout);
+    tcpFanoutMessage *m = tcpFanoutAlloc(&fanout);
+    if (m != NULL)
+    {
+        memcpy(m->data, msg, len);
+        m->length = len;
+        tcpFanoutQueue(&fanout, c->slot, m);
+        tcpFanoutRelease(&fanout, m);
+    }
+    tcpFanoutUnlock(&fanout);
+}
+
+// Session output: a frame to transmit
+static void sessionSend(void *arg, uint8_t port, const uint8_t *frame, size_t len)
+{
+    tcpFanoutLock(&fanout);
+    if ((port == 0) && (txCount < AGW_TCP_TX_QUEUE) && (len <= AX25_FRAME_MAX_SIZE))
+    {
+        agwTxFrame *tx = &txQueue[(txHead + txCount) % AGW_TCP_TX_QUEUE];
+        memcpy(tx->data, frame, len);
+        tx->length = len;
+        txCount++;
+        stats.txFrames++;
+    }
+    else
+    {
+        stats.txDropped++; // RF port 2 is receive only
+    }
+    tcpFanoutUnlock(&fanout);
+    aprsTaskNotify(); // agwTcpPoll() runs in the APRS task
+}
+
+static void onConnect(void *arg, uint8_t slot)
+{
+    clients[slot].slot = slot;
+    AgwInit(&clients[slot].session, sessionWrite, sessionSend, &clients[slot]);
+}
+
+static void onData(void *arg, uint8_t slot, const uint8_t *data, size_t len)
+{
+    AgwReceive(&clients[slot].session, data, len);
+}
+
+bool agwTcpBegin(uint16_t port)
+{
+    static const tcpFanoutConfig cfg = {"AGWPE", AGW_TCP_MAX_CLIENTS, AGW_TCP_CLIENT_QUEUE, AGW_TCP_MESSAGES, AGW_MAX_MESSAGE, onConnect, onData, NULL};
+
+    if (fanout.server != NULL)
+        return true;
+    if (clients == NULL)
+    {
+#ifdef BOARD_HAS_PSRAM
+        clients = (agwClient *)ps_calloc(AGW_TCP_MAX_CLIENTS, sizeof(agwClient));
+#else
+        clients = (agwClient *)calloc(AGW_TCP_MAX_CLIENTS, sizeof(agwClient));
+#endif
+    }
+    if (clients == NULL)
+    {
+        log_e("AGWPE allocation failed");
+        return false;
+    }
+    memset(&stats, 0, sizeof(stats));
+    return tcpFanoutBegin(&fanout, &cfg, port);
+}
+
+void agwTcpBroadcast(uint8_t port, const uint8_t *ax25, size_t len)
+{
+    tcpFanoutMessage *monitorMsg = NULL;
+    tcpFanoutMessage *rawMsg = NULL;
+    bool monitor = false;
+    bool raw = false;
+
+    if (fanout.clientCount == 0)
+        return;
+
+    tcpFanoutLock(&fanout);
+    for (uint8_t i = 0; i < AGW_TCP_MAX_CLIENTS; i++)
+    {
+        if (!tcpFanoutActive(&fanout, i))
+            continue;
+        monitor |= clients[i].session.monitor;
+        raw |= clients[i].session.raw;
+    }
+    // each kind is built once, whatever the number of clients that want it
+    if (monitor && ((monitorMsg = tcpFanoutAlloc(&fanout)) != NULL))
+        monitorMsg->length = AgwMonitorMessage(monitorMsg->data, AGW_MAX_MESSAGE, port, ax25, len);
+    if (raw && ((rawMsg = tcpFanoutAlloc(&fanout)) != NULL))
+        rawMsg->length = AgwRawMessage(rawMsg->data, AGW_MAX_MESSAGE, port, ax25, len);
+    if (((monitorMsg != NULL) && (monitorMsg->length > 0)) || ((rawMsg != NULL) && (rawMsg->length > 0)))
+        stats.frames++;
+    for (uint8_t i = 0; i < AGW_TCP_MAX_CLIENTS; i++)
+    {
+        if (!tcpFanoutActive(&fanout, i))
+            continue;
+        // empty messages are not queued, a client that stopped reading is dropped
+        if (clients[i].session.monitor && (monitorMsg != NULL))
+            tcpFanoutQueue(&fanout, i, monitorMsg);
+        if (clients[i].session.raw && (rawMsg != NULL))
+            tcpFanoutQueue(&fanout, i, rawMsg);
+    }
+    tcpFanoutRelease(&fanout, monitorMsg);
+    tcpFanoutRelease(&fanout, rawMsg);
+    tcpFanoutUnlock(&fanout);
+}
+
+void agwTcpPoll()
+{
+    agwTxFrame tx;
+
+    if (fanout.server == NULL)
+        return;
+    while (txCount > 0)
+    {
+        if (Ax25TxFreeFrames() == 0)
+            break;
+        tcpFanoutLock(&fanout);
+        memcpy(&tx, &txQueue[txHead], sizeof(tx));
+        txHead = (txHead + 1) % AGW_TCP_TX_QUEUE;
+        txCount--;
+        tcpFanoutUnlock(&fanout);
+        Ax25WriteTxFrame(tx.data, tx.length);
+        log_d("[AGWPE] TX frame %d Byte", tx.length);
+    }
+}
+
+void agwTcpGetStats(agwTcpStats *s)
+{
+    tcpFanoutLock(&fanout);
+    memcpy(s, &stats, sizeof(stats));
+    s->clients = fanout.clientCount;
+    s->accepted = fanout.accepted;
+    s->refused = fanout.refused;
+    s->slow = fanout.slow;
+    tcpFanoutUnlock(&fanout);
+}
@@ -0,0 +1,425 @@
+#include "aprsfilter.h"
+#include <math.h>
+#include <ctype.h>
+
+#define EARTH_RADIUS_KM 6371.0f
+#define DEG2RADF(x) ((x) * (float)(M_PI / 180.0))
+
+// A filter string is compiled into parts holding numbers already converted for the test
+// (radians are worked out at match time from degrees, ranges as the haversine of their angle)
+// and the callsigns and names copied into a fixed argument table. Matching a packet then only
+// compares short strings and, for range parts, costs one cosf() and two sinf() per part.
+static float homeLat = NAN;
+static float homeLon = NAN;
+static float homeCosLat = 0;
+static aprsFilterLookup stationLookup = NULL;
+
+void aprsFilterSetHome(float lat, float lon)
+{
+    homeLat = lat;
+    homeLon = lon;
+    homeCosLat = cosf(DEG2RADF(lat));
+}
+
+void aprsFilterSetLookup(aprsFilterLookup lookup)
+{
+    stationLookup = lookup;
+}
+
+static float rangeOf(float km)
+{
+    float s = sinf(km / (2 * EARTH_RADIUS_KM));
+    return s * s;
+}
+
+// Next '/' separated field of a part, NULL after the last one
+static const char *nextField(const char *p, const char *end, size_t *len)
+{
+    if (p >= end)
+        return NULL;
+    const char *slash = (const char *)memchr(p, '/', end - p);
+    if (slash == NULL)
+        slash = end;
+    *len = slash - p;
+    return p;
+}
+
+static bool fieldNumber(const char *p, size_t len, float *value)
+{
+    char num[16];
+    if ((len == 0) || (len >= sizeof(num)))
+        return false;
+    memcpy(num, p, len);
+    num[len] = 0;
+    char *stop;
+    *value = strtof(num, &stop);
+    return (*stop == 0);
+}
+
+static bool addArg(aprsFilter *f, aprsFilterPart *part, const char *p, size_t len)
+{
+    if (f->args >= APRS_FILTER_ARGS)
+        return false;
+    if (len > APRS_FILTER_ARG_LEN)
+        len = APRS_FILTER_ARG_LEN;
+    memcpy(f->arg[f->args], p, len);
+    f->arg[f->args][len] = 0;
+    f->args++;
+    part->argCount++;
+    return true;
+}
+
+static uint16_t typeBits(const char *p, size_t len)
+{
+    uint16_t types = 0;
+    for (size_t i = 0; i < len; i++)
+    {
+        switch (p[i])
+        {
+        case 'p':
+            types |= T_POSITION;
+            break;
+        case 'o':
+            types |= T_OBJECT;
+            break;
+        case 'i':
+            types |= T_ITEM;
+            break;
+        case 'm':
+            types |= T_MESSAGE;
+            break;
+        case 'q':
+            types |= T_QUERY;
+            break;
+        case 's':
+            types |= T_STATUS;
+            break;
+        case 't':
+            types |= T_TELEMETRY;
+            break;
+        case 'u':
+            types |= T_USERDEF;
+            break;
+        case 'n':
+            types |= T_NWS;
+            break;
+        case 'w':
+            types |= T_WX | T_WAVE;
+            break;
+        default:
+            return 0;
+        }
+    }
+    return types;
+}
+
+// One part, "x/field/field...", without the leading '-'
+static bool compilePart(aprsFilter *f, aprsFilterPart *part, const char *p, const char *end)
+{
+    memset(part, 0, sizeof(aprsFilterPart));
+    if ((end - p < 2) || (p[1] != '/'))
+        return false;
+    part->type = tolower(p[0]);
+    part->argFirst = f->args;
+    part->lat = NAN;
+    p += 2;
+
+    const char *field[4];
+    size_t len[4];
+    int n = 0;
+    size_t l;
+    const char *q = p;
+    while ((q = nextField(q, end, &l)) != NULL)
+    {
+        if (n < 4)
+        {
+            field[n] = q;
+            len[n] = l;
+        }
+        n++;
+        q += l + 1;
+    }
+
+    float km;
+    switch (part->type)
+    {
+    case 'r': // r/lat/lon/km
+        if ((n != 3) || !fieldNumber(field[0], len[0], &part->lat) || !fieldNumber(field[1], len[1], &part->lon) ||
+            !fieldNumber(field[2], len[2], &km))
+            return false;
+        part->cosLat = cosf(DEG2RADF(part->lat));
+        part->range = rangeOf(km);
+        return true;
+    case 'm': // m/km around our own position
+        if ((n != 1) || !fieldNumber(field[0], len[0], &km))
+            return false;
+        part->range = rangeOf(km);
+        return true;
+    case 'a': // a/latN/lonW/latS/lonE
+        if ((n != 4) || !fieldNumber(field[0], len[0], &part->lat) || !fieldNumber(field[1], len[1], &part->lon) ||
+            !fieldNumber(field[2], len[2], &part->lat2) || !fieldNumber(field[3], len[3], &part->lon2))
+            return false;
+        return true;
+    case 'f': // f/call/km
+        if ((n != 2) || (len[0] == 0) || !fieldNumber(field[1], len[1], &km))
+            return false;
+        part->range = rangeOf(km);
+        return addArg(f, part, field[0], len[0]);
+    case 't': // t/types or t/types/call/km
+        if (((n != 1) && (n != 3)) || ((part->types = typeBits(field[0], len[0])) == 0))
+            return false;
+        if (n == 1)
+            return true;
+        if ((len[1] == 0) || !fieldNumber(field[2], len[2], &km))
+            return false;
+        part->range = rangeOf(km);
+        return addArg(f, part, field[1], len[1]);
+    case 's': // s/pri/alt/overlay, any of them may be empty
+        if ((n < 1) || (n > 3))
+            return false;
+        for (int i = 0; i < 3; i++)
+            if (!addArg(f, part, (i < n) ? field[i] : "", (i < n) ? len[i] : 0))
+                return false;
+        return true;
+    case 'q': // q/con/I, only the q construct letters are used
+        if ((n < 1) || (n > 2) || (len[0] == 0))
+            return false;
+        return addArg(f, part, field[0], len[0]);
+    case 'b': // b/call1/call2...
+    case 'p': // p/prefix1/prefix2...
+    case 'o': // o/object1/object2...
+    case 'd': // d/digi1/digi2...
+    case 'e': // e/entry1/entry2...
+    case 'u': // u/dest1/dest2...
+        if (n < 1)
+            return false;
+        q = p;
+        while ((q = nextField(q, end, &l)) != NULL)
+        {
+            if ((l > 0) && !addArg(f, part, q, l))
+                return false;
+            q += l + 1;
+        }
+        return part->argCount > 0;
+    default:
+        return false;
+    }
+}
+
+bool aprsFilterCompile(aprsFilter *f, const char *text)
+{
+    aprsFilter next;
+    memset(&next, 0, sizeof(next));
+    const char *p = text;
+    while (*p)
+    {
+        while (*p == ' ')
+            p++;
+        if (*p == 0)
+            break;
+        const char *end = strchr(p, ' ');
+        if (end == NULL)
+            end = p + strlen(p);
+        bool negate = (*p == '-');
+        uint8_t args = next.args;
+        if ((next.parts < APRS_FILTER_PARTS) && compilePart(&next, &next.part[next.parts], p + negate, end))
+        {
+            next.part[next.parts].negate = negate;
+            next.parts++;
+        }
+        else
+        {
+            log_w("APRS filter part '%.*s' not understood", (int)(end - p), p);
+            next.args = args;
+            next.errors++;
+        }
+        p = end;
+    }
+    memcpy(f, &next, sizeof(aprsFilter));
+    return next.errors == 0;
+}
+
+// arg against text, case insensitive for callsigns, a trailing '*' or prefix matches the start only
+static bool argMatch(const char *arg, const char *s, size_t len, bool prefix, bool nocase)
+{
+    size_t n = strlen(arg);
+    if ((n > 0) && (arg[n - 1] == '*'))
+    {
+        n--;
+        prefix = true;
+    }
+    if (prefix ? (len < n) : (len != n))
+        return false;
+    if (nocase)
+        return strncasecmp(arg, s, n) == 0;
+    return strncmp(arg, s, n) == 0;
+}
+
+static bool anyArg(const aprsFilter *f, const aprsFilterPart *part, const char *s, size_t len, bool prefix, bool nocase)
+{
+    for (uint8_t i = 0; i < part->argCount; i++)
+    {
+        uint8_t a = part->argFirst + i;
+        if ((a < APRS_FILTER_ARGS) && argMatch(f->arg[a], s, len, prefix, nocase))
+            return true;
+    }
+    return false;
+}
+
+// Packet position inside range of a centre, haversine compared squared, no asin() or sqrt()
+static bool inRange(const struct pbuf_t *pb, float *pbCosLat, float lat, float lon, float cosLat, float range)
+{
+    if (!(pb->flags & F_HASPOS) || isnan(lat))
+        return false;
+    if (isnan(*pbCosLat))
+        *pbCosLat = cosf(DEG2RADF(pb->lat));
+    float sLat = sinf(DEG2RADF(pb->lat - lat) / 2);
+    float sLon = sinf(DEG2RADF(pb->lng - lon) / 2);
+    return (sLat * sLat + cosLat * *pbCosLat * sLon * sLon) <= range;
+}
+
+// Centre of f/ and t/ parts, looked up again once it is APRS_FILTER_LOOKUP_MS old
+static void lookupCentre(const aprsFilter *f, aprsFilterPart *part)
+{
+    uint32_t now = millis();
+    if ((part->found != 0) && ((now - part->found) < APRS_FILTER_LOOKUP_MS))
+        return;
+    part->found = now | 1;
+    part->lat = NAN;
+    float lat, lon;
+    if ((stationLookup != NULL) && (part->argFirst < APRS_FILTER_ARGS) && stationLookup(f->arg[part->argFirst], &lat, &lon))
+    {
+        part->lon = lon;
+        part->cosLat = cosf(DEG2RADF(lat));
+        part->lat = lat;
+    }
+}
+
+// Path element starting at p, up to the next ',' or the end
+static const char *pathNext(const char *p, const char *end, size_t *len)
+{
+    if (p >= end)
+        return NULL;
+    const char *comma = (const char *)memchr(p, ',', end - p);
+    if (comma == NULL)
+        comma = end;
+    *len = comma - p;
+    return p;
+}
+
+static bool isQConstruct(const char *p, size_t len)
+{
+    return (len == 3) && (p[0] == 'q') && (p[1] == 'A');
+}
+
+static bool matchPart(aprsFilter *f, aprsFilterPart *part, const struct pbuf_t *pb, float *pbCosLat)
+{
+    const char *src = pb->data;
+    size_t srcLen = pb->srccall_end - src;
+    const char *path = pb->dstcall_end + 1;
+    const char *pathEnd = pb->info_start - 1;
+    size_t len;
+    const char *e;
+
+    switch (part->type)
+    {
+    case 'r':
+        return inRange(pb, pbCosLat, part->lat, part->lon, part->cosLat, part->range);
+    case 'm':
+        return inRange(pb, pbCosLat, homeLat, homeLon, homeCosLat, part->range);
+    case 'a':
+        return (pb->flags & F_HASPOS) && (pb->lat <= part->lat) && (pb->lat >= part->lat2) && (pb->lng >= part->lon) &&
+               (pb->lng <= part->lon2);
+    case 'f':
+        lookupCentre(f, part);
+        return inRange(pb, pbCosLat, part->lat, part->lon, part->cosLat, part->range);
+    case 't':
+        if (!(pb->packettype & part->types))
+            return false;
+        if (part->argCount == 0)
+            return true;
+        lookupCentre(f, part);
+        return inRange(pb, pbCosLat, part->lat, part->lon, part->cosLat, part->range);
+    case 'b':
+        return anyArg(f, part, src, srcLen, false, true);
+    case 'p':
+        return anyArg(f, part, src, srcLen, true, true);
+    case 'o':
+        if (!(pb->packettype & (T_OBJECT | T_ITEM)) || (pb->srcname == NULL))
+            return false;
+        len = pb->srcname_len;
+        while ((len > 0) && (pb->srcname[len - 1] == ' '))
+            len--;
+        return anyArg(f, part, pb->srcname, len, false, false);
+    case 'u':
+        return anyArg(f, part, pb->srccall_end + 1, pb->dstcall_end - pb->srccall_end - 1, false, true);
+    case 's':
+    {
+        uint8_t a = part->argFirst;
+        if ((pb->symbol[0] == 0) || (a + 2 >= APRS_FILTER_ARGS))
+            return false;
+        if (pb->symbol[0] == '/')
+            return strchr(f->arg[a], pb->symbol[1]) != NULL;
+        if (strchr(f->arg[a + 1], pb->symbol[1]) == NULL)
+            return false;
+        return (f->arg[a + 2][0] == 0) || (strchr(f->arg[a + 2], pb->symbol[0]) != NULL);
+    }
+    case 'd':
+    {
+        // digipeaters that have handled the packet: up to the last one marked '*', before the q construct
+        const char *used = NULL;
+        for (e = path; (e = pathNext(e, pathEnd, &len)) != NULL; e += len + 1)
+        {
+            if (isQConstruct(e, len))
+                break;
+            if ((len > 0) && (e[len - 1] == '*'))
+                used = e + len;
+        }
+        for (e = path; (used != NULL) && ((e = pathNext(e, used, &len)) != NULL); e += len + 1)
+        {
+            if ((len > 0) && (e[len - 1] == '*'))
+                len--;
+            if (anyArg(f, part, e, len, false, true))
+                return true;
+        }
+        return false;
+    }
+    case 'q':
+    case 'e':
+        // q/: letter of the qAx construct, e/: the station after it, that sent the packet to APRS-IS
+        for (e = path; (e = pathNext(e, pathEnd, &len)) != NULL; e += len + 1)
+        {
+            if (!isQConstruct(e, len))
+                continue;
+            if (part->type == 'q')
+                return (part->argFirst < APRS_FILTER_ARGS) && (strchr(f->arg[part->argFirst], e[2]) != NULL);
+            e += len + 1;
+            return ((e = pathNext(e, pathEnd, &len)) != NULL) && anyArg(f, part, e, len, false, true);
+        }
+        return false;
+    default:
+        return false;
+    }
+}
+
+bool aprsFilterMatch(aprsFilter *f, const struct pbuf_t *pb)
+{
+    uint8_t parts = f->parts;
+    if (parts > APRS_FILTER_PARTS)
+        return false;
+    if ((pb->srccall_end == NULL) || (pb->dstcall_end == NULL) || (pb->info_start == NULL))
+        return false;
+    float pbCosLat = NAN;
+    bool pass = false;
+    // '-' parts are checked even after a match, any of them drops the packet
+    for (uint8_t i = 0; i < parts; i++)
+    {
+        aprsFilterPart *part = &f->part[i];
+        if ((pass && !part->negate) || !matchPart(f, part, pb, &pbCosLat))
+            continue;
+        if (part->negate)
+            return false;
+        pass = true;
+    }
+    return pass;
+}
@@ -0,0 +1,118 @@
+#include "aprsis.h"
+#include <WiFiClient.h>
+
+extern WiFiClient aprsClient;
+
+// Received bytes go straight into the line reader and lines are parsed where they lie.
+// Lines to send are collected in txBuffer by any task, taskNetwork writes them out once
+// per loop, so a burst of packets costs one socket write instead of two per packet.
+static struct LineReader reader;
+static char txBuffer[APRSIS_TX_BUFFER];
+static size_t txLength = 0;
+static uint16_t txLines = 0; // lines in txBuffer
+static aprsIsStats stats;
+static SemaphoreHandle_t txMutex = NULL;
+
+static unsigned long rateTime = 0;
+static aprsIsStats rateLast; // counters at rateTime
+
+// The caller holds txMutex
+static void flushLocked()
+{
+    if (txLength == 0)
+        return;
+    size_t n = aprsClient.write((const uint8_t *)txBuffer, txLength);
+    stats.txWrites++;
+    if (n == txLength)
+    {
+        stats.txLines += txLines;
+        stats.txBytes += n;
+    }
+    else
+    {
+        stats.txDropped += txLines;
+        log_w("APRS-IS write failed, %d lines dropped", txLines);
+    }
+    txLength = 0;
+    txLines = 0;
+}
+
+static void updateRates()
+{
+    unsigned long elapsed = millis() - rateTime;
+    if (elapsed < 1000)
+        return;
+    stats.rxLinesPerSec = (stats.rxLines - rateLast.rxLines) * 1000 / elapsed;
+    stats.rxBytesPerSec = (stats.rxBytes - rateLast.rxBytes) * 1000 / elapsed;
+    stats.txLinesPerSec = (stats.txLines - rateLast.txLines) * 1000 / elapsed;
+    stats.txBytesPerSec = (stats.txBytes - rateLast.txBytes) * 1000 / elapsed;
+    memcpy(&rateLast, &stats, sizeof(stats));
+    rateTime = millis();
+}
+
+void aprsIsReset()
+{
+    if (txMutex == NULL)
+        txMutex = xSemaphoreCreateMutex();
+    LineReaderInit(&reader);
+    xSemaphoreTake(txMutex, portMAX_DELAY);
+    txLength = 0;
+    txLines = 0;
+    xSemaphoreGive(txMutex);
+}
+
+char *aprsIsRead(size_t *len)
+{
+    updateRates();
+    char *line = LineReaderNext(&reader, len);
+    int avail;
+    if ((line == NULL) && ((avail = aprsClient.available()) > 0))
+    {
+        char *at;
+        size_t room = LineReaderSpace(&reader, &at);
+        int n = aprsClient.read((uint8_t *)at, ((size_t)avail < room) ? avail : room);
+        if (n > 0)
+        {
+            LineReaderCommit(&reader, n);
+            stats.rxBytes += n;
+            line = LineReaderNext(&reader, len);
+        }
+        stats.rxOverflows = reader.overflows;
+    }
+    if (line != NULL)
+        stats.rxLines++;
+    return line;
+}
+
+bool aprsIsSend(const char *line, size_t len)
+{
+    if ((txMutex == NULL) || (len + 2 > APRSIS_TX_BUFFER) || !aprsClient.connected())
+    {
+        stats.txDropped++;
+        return false;
+    }
+    xSemaphoreTake(txMutex, portMAX_DELAY);
+    if (txLength + len + 2 > APRSIS_TX_BUFFER)
+        flushLocked();
+    memcpy(&txBuffer[txLength], line, len);
+    txLength += len;
+    txBuffer[txLength++] = '\r';
+    txBuffer[txLength++] = '\n';
+    txLines++;
+    xSemaphoreGive(txMutex);
+    return true;
+}
+
+void aprsIsFlush()
+{
+    if (txMutex == NULL)
+        return;
+    xSemaphoreTake(txMutex, portMAX_DELAY);
+    flushLocked();
+    xSemaphoreGive(txMutex);
+}
+
+void aprsIsGetStats(aprsIsStats *s)
+{
+    memcpy(s, &stats, sizeof(stats));
+}
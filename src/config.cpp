@@ -55,6 +55,7 @@ bool saveConfiguration(const char *filename, const Configuration &config)
     // Set the values in the document
     doc["cpuFreq"] = config.cpuFreq;
     doc["txTimeSlot"] = config.tx_timeslot;
+    doc["txBurstTime"] = config.tx_burst_time;
     doc["syncTime"] = config.synctime;
     doc["timeZone"] = config.timeZone;
     doc["ntpHost"] = config.ntp_host;
@@ -72,6 +73,13 @@ bool saveConfiguration(const char *filename, const Configuration &config)
     }
 
     doc["fx25Mode"] = config.fx25_mode;
+    doc["fx25TagDistance"] = config.fx25_tag_distance;
+    doc["rfDemods"] = config.modem_demods;
+    doc["rfFixBits"] = config.modem_fixbits;
+    doc["rf2Enable"] = config.rf2_en;
+    doc["rf2Gpio"] = config.rf2_adc_gpio;
+    doc["rf2Modem"] = config.rf2_modem_type;
+    doc["rf2AudioLPF"] = config.rf2_audio_lpf;
     doc["rfEnable"] = config.rf_en;
     doc["rfType"] = config.rf_type;
     doc["rfModem"] = config.modem_type;    
@@ -104,11 +112,13 @@ bool saveConfiguration(const char *filename, const Configuration &config)
     doc["igateEn"] = config.igate_en;
     doc["igateBcn"] = config.igate_bcn;
     doc["rf2inet"] = config.rf2inet;
+    doc["rf2inetPorts"] = config.rf2inet_ports;
     doc["inet2rf"] = config.inet2rf;
     doc["igatePos2rf"] = config.igate_loc2rf;
     doc["igatePos2inet"] = config.igate_loc2inet;
     doc["rf2inetFilter"] = config.rf2inetFilter;
     doc["inet2rfFiltger"] = config.inet2rfFilter;
+    doc["inet2rfIsFilter"] = config.inet2rf_filter;
 
     doc["igateSSID"] = config.aprs_ssid;
     doc["igatePort"] = config.aprs_port;
@@ -156,6 +166,7 @@ bool saveConfiguration(const char *filename, const Configuration &config)
 
     // Digi group
     doc["digiEn"] = config.digi_en;
+    doc["digiPorts"] = config.digi_ports;
     doc["digiAuto"] = config.digi_auto;
     doc["digiPos2rf"] = config.digi_loc2rf;
     doc["digiPos2inet"] = config.digi_loc2inet;
@@ -339,6 +350,7 @@ bool saveConfiguration(const char *filename, const Configuration &config)
     doc["dspTX"] = config.tx_display;
     doc["dspRX"] = config.rx_display;
     doc["dspFilter"] = config.dispFilter;
+    doc["dspIsFilter"] = config.disp_filter;
     doc["dspRF"] = config.dispRF;
     doc["dspINET"] = config.dispINET;
     doc["dspFlip"] = config.disp_flip;
@@ -445,6 +457,11 @@ bool saveConfiguration(const char *filename, const Configuration &config)
     doc["extTNCEn"] = config.ext_tnc_enable;
     doc["extTNCCh"] = config.ext_tnc_channel;
     doc["extTNCMode"] = config.ext_tnc_mode;
+    doc["kissTcpEn"] = config.kiss_tcp_en;
+    doc["kissTcpPort"] = config.kiss_tcp_port;
+    doc["kissTcpFilter"] = config.kiss_tcp_filter;
+    doc["agwEn"] = config.agw_en;
+    doc["agwPort"] = config.agw_port;
 
     // Power control
     doc["pwrEn"] = config.pwr_en;
@@ -520,6 +537,7 @@ bool saveConfiguration(const char *filename, const Configuration &config)
     doc["mqttPort"] = config.mqtt_port;
     doc["mqttUser"] = config.mqtt_user;
     doc["mqttPass"] = config.mqtt_pass;
+    doc["mqttFilter"] = config.mqtt_filter;
     #endif
 
     doc["trkMicEType"] = config.trk_mice_type;
@@ -603,6 +621,7 @@ bool loadConfiguration(const char *filename, Configuration &config)
 
         config.cpuFreq = doc["cpuFreq"] | 160;
         config.tx_timeslot = doc["txTimeSlot"] | 2000;
+        config.tx_burst_time = doc["txBurstTime"] | AX25_BURST_TIME_DEFAULT;
         config.synctime = doc["syncTime"];
         config.timeZone = doc["timeZone"];
         strlcpy(config.ntp_host, doc["ntpHost"], sizeof(config.ntp_host));
@@ -622,6 +641,13 @@ bool loadConfiguration(const char *filename, Configuration &config)
         }
 
         config.fx25_mode = doc["fx25Mode"];
+        config.fx25_tag_distance = doc["fx25TagDistance"] | FX25_TAG_DISTANCE_DEFAULT;
+        config.modem_demods = doc["rfDemods"] | 0;
+        config.modem_fixbits = doc["rfFixBits"] | AX25_FIX_BITS_DEFAULT;
+        config.rf2_en = doc["rf2Enable"] | false;
+        config.rf2_adc_gpio = doc["rf2Gpio"] | -1;
+        config.rf2_modem_type = doc["rf2Modem"] | 1;
+        config.rf2_audio_lpf = doc["rf2AudioLPF"] | false;
         config.rf_en = doc["rfEnable"];
         config.rf_type = doc["rfType"];
         config.rf_power = doc["rfPwr"];
@@ -654,11 +680,13 @@ bool loadConfiguration(const char *filename, Configuration &config)
         config.igate_en = doc["igateEn"];
         config.igate_bcn = doc["igateBcn"];
         config.rf2inet = doc["rf2inet"];
+        config.rf2inet_ports = doc["rf2inetPorts"] | RF_PORTS_ALL;
         config.inet2rf = doc["inet2rf"];
         config.igate_loc2rf = doc["igatePos2rf"];
         config.igate_loc2inet = doc["igatePos2inet"];
         config.rf2inetFilter = doc["rf2inetFilter"];
         config.inet2rfFilter = doc["inet2rfFiltger"];
+        strlcpy(config.inet2rf_filter, doc["inet2rfIsFilter"] | "", sizeof(config.inet2rf_filter));
 
         config.aprs_ssid = doc["igateSSID"];
         config.aprs_port = doc["igatePort"];
@@ -698,6 +726,7 @@ bool loadConfiguration(const char *filename, Configuration &config)
         }
         // Digi group
         config.digi_en = doc["digiEn"];
+        config.digi_ports = doc["digiPorts"] | RF_PORT_1;
         config.digi_auto = doc["digiAuto"];
         config.digi_loc2rf = doc["digiPos2rf"];
         config.digi_loc2inet = doc["digiPos2inet"];
@@ -857,6 +886,7 @@ bool loadConfiguration(const char *filename, Configuration &config)
         config.tx_display = doc["dspTX"];
         config.rx_display = doc["dspRX"];
         config.dispFilter = doc["dspFilter"];
+        strlcpy(config.disp_filter, doc["dspIsFilter"] | "", sizeof(config.disp_filter));
         config.dispRF = doc["dspRF"];
         config.dispINET = doc["dspINET"];
         config.disp_flip = doc["dspFlip"];
@@ -961,6 +991,11 @@ bool loadConfiguration(const char *filename, Configuration &config)
         config.ext_tnc_enable = doc["extTNCEn"];
         config.ext_tnc_channel = doc["extTNCCh"];
         config.ext_tnc_mode = doc["extTNCMode"];
+        config.kiss_tcp_en = doc["kissTcpEn"] | false;
+        config.kiss_tcp_port = doc["kissTcpPort"] | KISS_TCP_PORT;
+        strlcpy(config.kiss_tcp_filter, doc["kissTcpFilter"] | "", sizeof(config.kiss_tcp_filter));
+        config.agw_en = doc["agwEn"] | false;
+        config.agw_port = doc["agwPort"] | AGW_TCP_PORT;
 
         // Power control
         config.pwr_en = doc["pwrEn"];
@@ -1035,6 +1070,7 @@ bool loadConfiguration(const char *filename, Configuration &config)
         config.mqtt_port = doc["mqttPort"];
         strlcpy(config.mqtt_user, doc["mqttUser"] | "", sizeof(config.mqtt_user));
         strlcpy(config.mqtt_pass, doc["mqttPass"] | "", sizeof(config.mqtt_pass));
+        strlcpy(config.mqtt_filter, doc["mqttFilter"] | "", sizeof(config.mqtt_filter));
         #endif
 
         config.trk_mice_type = doc["trkMicEType"];
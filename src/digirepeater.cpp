@@ -4,9 +4,13 @@
 RTC_DATA_ATTR digiTLMType digiLog;
 RTC_DATA_ATTR uint8_t digiCount = 0;
 
+// Packets repeated inside the window
+static struct DupeTable digiDupes = DupeTableInit(DIGI_DUPE_ENTRIES, DIGI_DUPE_WINDOW_MS);
+
 extern Configuration config;
+extern statusType status;
 
-int digiProcess(AX25Msg &Packet)
+static int digiRoute(AX25Msg &Packet)
 {
     int idx, j;
     uint8_t ctmp;
@@ -278,4 +282,20 @@ int digiProcess(AX25Msg &Packet)
         }
     }
     return j;
-}
\ No newline at end of file
+}
+
+int digiProcess(AX25Msg &Packet)
+{
+    // The hash ignores the path, so it is taken before the path is changed
+    uint64_t hash = DupeHashAx25(&Packet);
+    if (DupeFind(&digiDupes, hash, millis()))
+    {
+        digiLog.DropRx++;
+        status.dupCount++;
+        return 0;
+    }
+    int ret = digiRoute(Packet);
+    if (ret > 0)
+        DupeAdd(&digiDupes, hash, millis());
+    return ret;
+}
@@ -5519,11 +5519,13 @@ void pkgLastDisp()
     // display.print("2/5");
     display.setTextColor(WHITE);
 
-    sort(pkgList, PKGLISTSIZE);
+    int view[PKGLISTSIZE];
+    int n = pkgListView(view, PKGLISTSIZE, STATIONDB_RECENT);
     k = 0;
-    for (i = 0; i < PKGLISTSIZE; i++)
+    for (i = 0; i < n; i++)
     {
-        pkgListType pkg = getPkgList(i);
+        pkgListType pkg = getPkgList(view[i]);
+        pktBufRelease(pkg.raw); // only the callsign is shown
         if (pkg.time > 0)
         {
             y = 26 + (k * 9);
@@ -5598,11 +5600,13 @@ void pkgCountDisp()
     // display.print("3/5");
     display.setTextColor(WHITE);
 
-    sortPkgDesc(pkgList, PKGLISTSIZE);
+    int view[PKGLISTSIZE];
+    int n = pkgListView(view, PKGLISTSIZE, STATIONDB_COUNT);
     k = 0;
-    for (i = 0; i < PKGLISTSIZE; i++)
+    for (i = 0; i < n; i++)
     {
-        pkgListType pkg = getPkgList(i);
+        pkgListType pkg = getPkgList(view[i]);
+        pktBufRelease(pkg.raw); // only the callsign is shown
         if (pkg.time > 0)
         {
             y = 26 + (k * 9);
@@ -6306,6 +6310,7 @@ void mainDisp(void *pvParameters)
                 {
                     pkgListType pkg = getPkgList(idx);
                     rawDisp = String(pkg.raw);
+                    pktBufRelease(pkg.raw);
                     dispWindow(rawDisp, dispMode, true);
                     selTab = idx;
                     if (menuSel == 0)
@@ -6394,31 +6399,12 @@ void mainDisp(void *pvParameters)
                 {
                     timeHalfSec = millis() + 2000 + disp_delay;
                     saveTimeout = millis();
-                    pkgListType pkg = getPkgList(selTab);
                     if (config.dim == 2)
                         dimTimeout = millis();
-                    if (encoder0Pos > posNow)
-                    {
-                        selTab++;
-                        for (; selTab < PKGLISTSIZE; selTab++)
-                        {
-                            if (pkg.time > 0)
-                                break;
-                        }
-                        if (selTab >= PKGLISTSIZE)
-                            selTab = 0;
-                    }
-                    else
-                    {
-                        selTab--;
-                        for (; selTab >= 0; selTab--)
-                        {
-                            if (pkg.time > 0)
-                                break;
-                        }
-                        if (selTab < 0)
-                            selTab = PKGLISTSIZE - 1;
-                    }
+                    int next = pkgListStep(selTab, encoder0Pos > posNow);
+                    if (next > -1)
+                        selTab = next;
+                    pkgListType pkg = getPkgList(selTab);
                     posNow = encoder0Pos;
 
                     if (pkg.time > 0)
@@ -6426,6 +6412,7 @@ void mainDisp(void *pvParameters)
                         rawDisp = String(pkg.raw);
                         dispWindow(rawDisp, dispMode, false);
                     }
+                    pktBufRelease(pkg.raw);
                 }
             }
 
@@ -7053,13 +7040,7 @@ void dispWindow(String line, uint8_t mode, bool filter)
             if (aprs.packettype & T_TELEMETRY)
             {
                 bool show = false;
-                int idx = tlmList_Find((char *)src_call.c_str());
-                if (idx < 0)
-                {
-                    idx = tlmListOld();
-                    if (idx > -1)
-                        memset(&Telemetry[idx], 0, sizeof(Telemetry_struct));
-                }
+                int idx = tlmListUpdate(src_call.c_str());
                 if (idx > -1)
                 {
                     Telemetry[idx].time = now();
@@ -1971,6 +1971,22 @@ String handleATCommand(String cmd)
         return "OK";
     }
 
+    if (cmd == "AT+MODEM_DEMODS?")
+        return String(config.modem_demods);
+    else if (cmd.startsWith("AT+MODEM_DEMODS="))
+    {
+        config.modem_demods = cmd.substring(16).toInt();
+        return "OK";
+    }
+
+    if (cmd == "AT+MODEM_FIXBITS?")
+        return String(config.modem_fixbits);
+    else if (cmd.startsWith("AT+MODEM_FIXBITS="))
+    {
+        config.modem_fixbits = cmd.substring(17).toInt();
+        return "OK";
+    }
+
     if (cmd == "AT+FX25_MODE?")
         return String(config.fx25_mode);
     else if (cmd.startsWith("AT+FX25_MODE="))
@@ -14,52 +14,19 @@ extern WiFiClient aprsClient;
 extern Configuration config;
 extern statusType status;
 
-// Duplicate packet cache
-static struct DupPacketCache dupCache[DUP_PACKET_CACHE_SIZE];
-static uint8_t dupCacheIndex = 0;
-
-// Simple hash function for packet deduplication
-static void packetHash(AX25Msg &Packet, char *hash)
-{
-    sprintf(hash, "%s%d%d", Packet.src.call, Packet.src.ssid, Packet.len);
-    for(int i = 0; i < std::min(16, (int)Packet.len); i++) {
-        hash[i % 15] ^= Packet.info[i];
-    }
-}
+// Packets gated to APRS-IS inside the window
+static struct DupeTable igateDupes = DupeTableInit(IGATE_DUPE_ENTRIES, IGATE_DUPE_WINDOW_MS);
 
 bool isDuplicatePacket(AX25Msg &Packet)
 {
-    char hash[16];
-    packetHash(Packet, hash);
-
-    unsigned long now = millis();
-    clearExpiredDuplicates();
-
-    for(uint8_t i = 0; i < DUP_PACKET_CACHE_SIZE; i++) {
-        if(dupCache[i].timestamp > 0 && strncmp(dupCache[i].hash, hash, 16) == 0) {
-            log_d("Duplicate packet detected: %s", hash);
-            return true;
-        }
+    if (DupeCheck(&igateDupes, DupeHashAx25(&Packet), millis()))
+    {
+        log_d("Duplicate packet detected: %s-%d", Packet.src.call, Packet.src.ssid);
+        return true;
     }
-
-    // Add to cache
-    strncpy(dupCache[dupCacheIndex].hash, hash, 16);
-    dupCache[dupCacheIndex].timestamp = now;
-    dupCacheIndex = (dupCacheIndex + 1) % DUP_PACKET_CACHE_SIZE;
-
     return false;
 }
 
-void clearExpiredDuplicates(void)
-{
-    unsigned long now = millis();
-    for(uint8_t i = 0; i < DUP_PACKET_CACHE_SIZE; i++) {
-        if(dupCache[i].timestamp > 0 && (now - dupCache[i].timestamp) > DUP_PACKET_TIMEOUT_MS) {
-            dupCache[i].timestamp = 0;
-        }
-    }
-}
-
 int igateProcess(AX25Msg &Packet)
 {
     int idx;
@@ -271,8 +238,7 @@ int igateProcess(AX25Msg &Packet)
         if(i>500 || i>fsize) i=strlen((char*)Raw);
         log_d("RF2INET: %s", Raw);
         if(aprsClient.connected()){
-            aprsClient.write(&Raw[0], i); // Send binary frame packet to APRS-IS (aprsc)
-            aprsClient.write("\r\n");     // Send CR LF the end frame packet
+            aprsIsSend((const char *)&Raw[0], i); // Send binary frame packet to APRS-IS (aprsc)
         }
         status.txCount++;
         free(Raw);
@@ -0,0 +1,118 @@
+#include "kisstcp.h"
+#include "tcpfanout.h"
+#include <KISS.h>
+
+extern void aprsTaskNotify();
+
+// A received frame is KISS encoded once into a fan-out buffer shared by every client queue.
+// Every frame goes to every client in the same order and a dropped client gives its frames
+// back at once, so the queues only hold the newest KISS_TCP_CLIENT_QUEUE frames between
+// them, plus the one being built. A frame that finds no buffer is counted in poolFails.
+#define KISS_TCP_FRAMES (KISS_TCP_CLIENT_QUEUE + 1)
+
+typedef struct
+{
+    uint16_t length;
+    uint8_t data[AX25_MAX_FRAME_LEN];
+} kissRxFrame;
+
+static tcpFanout fanout;
+static KissDecoder decoders[KISS_TCP_MAX_CLIENTS]; // only touched by the callbacks of their client
+static kissRxFrame rxQueue[KISS_TCP_RX_QUEUE];
+static uint8_t rxHead = 0;
+static uint8_t rxCount = 0;
+static kissTcpStats stats;
+
+static void onConnect(void *arg, uint8_t slot)
+{
+    kiss_decoder_init(&decoders[slot]);
+}
+
+static void onData(void *arg, uint8_t slot, const uint8_t *data, size_t len)
+{
+    KissDecoder *decoder = &decoders[slot];
+    for (size_t i = 0; i < len; i++)
+    {
+        size_t frameLen = kiss_decode(decoder, data[i]);
+        if (frameLen == 0)
+            continue;
+        tcpFanoutLock(&fanout);
+        if (rxCount < KISS_TCP_RX_QUEUE)
+        {
+            kissRxFrame *rx = &rxQueue[(rxHead + rxCount) % KISS_TCP_RX_QUEUE];
+            memcpy(rx->data, decoder->buf, frameLen);
+            rx->length = frameLen;
+            rxCount++;
+            stats.rxFrames++;
+        }
+        else
+        {
+            stats.rxDropped++;
+        }
+        tcpFanoutUnlock(&fanout);
+        aprsTaskNotify(); // kissTcpPoll() runs in the APRS task
+    }
+}
+
+bool kissTcpBegin(uint16_t port)
+{
+    static const tcpFanoutConfig cfg = {"KISS TCP", KISS_TCP_MAX_CLIENTS, KISS_TCP_CLIENT_QUEUE, KISS_TCP_FRAMES, KISS_MAX_ENCODED_LEN, onConnect, onData, NULL};
+
+    if (fanout.server != NULL)
+        return true;
+    memset(&stats, 0, sizeof(stats));
+    return tcpFanoutBegin(&fanout, &cfg, port);
+}
+
+void kissTcpBroadcast(const uint8_t *ax25, size_t len)
+{
+    if ((fanout.clientCount == 0) || (len == 0) || (len > AX25_MAX_FRAME_LEN))
+        return;
+
+    tcpFanoutLock(&fanout);
+    tcpFanoutMessage *m = tcpFanoutAlloc(&fanout);
+    if (m != NULL)
+    {
+        m->length = kiss_wrapper(m->data, (uint8_t *)ax25, len);
+        stats.frames++;
+        for (uint8_t i = 0; i < KISS_TCP_MAX_CLIENTS; i++)
+            tcpFanoutQueue(&fanout, i, m);
+        tcpFanoutRelease(&fanout, m);
+    }
+    else
+    {
+        stats.poolFails++;
+    }
+    tcpFanoutUnlock(&fanout);
+}
+
+void kissTcpPoll()
+{
+    kissRxFrame rx;
+
+    if (fanout.server == NULL)
+        return;
+    while (rxCount > 0)
+    {
+        if (Ax25TxFreeFrames() == 0)
+            break;
+        tcpFanoutLock(&fanout);
+        memcpy(&rx, &rxQueue[rxHead], sizeof(rx));
+        rxHead = (rxHead + 1) % KISS_TCP_RX_QUEUE;
+        rxCount--;
+        tcpFanoutUnlock(&fanout);
+        Ax25WriteTxFrame(rx.data, rx.length);
+        log_d("[KISS TCP] TX frame %d Byte", rx.length);
+    }
+}
+
+void kissTcpGetStats(kissTcpStats *s)
+{
+    tcpFanoutLock(&fanout);
+    memcpy(s, &stats, sizeof(stats));
+    s->clients = fanout.clientCount;
+    s->accepted = fanout.accepted;
+    s->refused = fanout.refused;
+    s->slow = fanout.slow;
+    tcpFanoutUnlock(&fanout);
+}
@@ -13,6 +13,7 @@
 #include "main.h"
 #include <LibAPRSesp.h>
 #include <limits.h>
+#include <atomic>
 #include <KISS.h>
 #include "webservice.h"
 #include <WiFiUdp.h>
@@ -290,7 +291,6 @@ void pushTxDisp(uint8_t ch, const char *name, char *info)
 statusType status;
 RTC_DATA_ATTR igateTLMType igateTLM;
 RTC_DATA_ATTR dataTLMType systemTLM;
-txQueueType *txQueue;
 
 RTC_DATA_ATTR double LastLat, LastLng;
 RTC_DATA_ATTR time_t lastTimeStamp;
@@ -1627,6 +1627,7 @@ void defaultConfig()
     config.synctime = true;
     config.timeZone = 7;
     config.tx_timeslot = 2000; // ms
+    config.tx_burst_time = AX25_BURST_TIME_DEFAULT; // ms
 
     config.wifi_mode = WIFI_AP_STA_FIX;
     config.wifi_power = 74; // WIFI_POWER_18.5dBm
@@ -1672,6 +1673,12 @@ void defaultConfig()
     config.volume = 6;
     config.mic = 8;
     config.modem_type = 1;
+    config.modem_demods = 0;
+    config.modem_fixbits = AX25_FIX_BITS_DEFAULT;
+    config.rf2_en = false;
+    config.rf2_adc_gpio = -1;
+    config.rf2_modem_type = 1;
+    config.rf2_audio_lpf = false;
 
     config.adc_atten = 0;
 
@@ -1736,11 +1743,13 @@ void defaultConfig()
     config.igate_bcn = false;
     config.igate_en = false;
     config.rf2inet = true;
+    config.rf2inet_ports = RF_PORTS_ALL;
     config.inet2rf = false;
     config.igate_loc2rf = false;
     config.igate_loc2inet = true;
     config.rf2inetFilter = 0xFFFF; // All
     config.inet2rfFilter = config.digiFilter = FILTER_OBJECT | FILTER_ITEM | FILTER_MESSAGE | FILTER_MICE | FILTER_POSITION | FILTER_WX;
+    config.inet2rf_filter[0] = 0;
     //--APRS-IS
     config.aprs_ssid = 1;
     config.aprs_port = 14580;
@@ -1765,6 +1774,7 @@ void defaultConfig()
 
     // DIGI REPEATER
     config.digi_en = false;
+    config.digi_ports = RF_PORT_1;
     config.digi_auto = false;
     config.digi_loc2rf = true;
     config.digi_loc2inet = false;
@@ -1925,6 +1935,7 @@ config.oled_enable = true;
     config.dispINET = false;
     config.filterDistant = 0;
     config.dispFilter = FILTER_OBJECT | FILTER_ITEM | FILTER_MESSAGE | FILTER_MICE | FILTER_POSITION | FILTER_WX | FILTER_STATUS | FILTER_BUOY | FILTER_QUERY;
+    config.disp_filter[0] = 0;
     config.h_up = true;
     config.tx_display = true;
     config.rx_display = true;
@@ -2244,6 +2255,11 @@ config.oled_enable = true;
     config.ext_tnc_enable = false;
     config.ext_tnc_channel = 0;
     config.ext_tnc_mode = 2;
+    config.kiss_tcp_en = false;
+    config.kiss_tcp_port = KISS_TCP_PORT;
+    config.kiss_tcp_filter[0] = 0;
+    config.agw_en = false;
+    config.agw_port = AGW_TCP_PORT;
 
     sprintf(config.path[0], "TRACE2-2");
     sprintf(config.path[1], "WIDE1-1");
@@ -2272,6 +2288,7 @@ config.oled_enable = true;
     config.mqtt_user[0] = 0;
     config.mqtt_pass[0] = 0;
     config.mqtt_port = 1883;
+    config.mqtt_filter[0] = 0;
 #endif
 
     config.ppp_enable = false;
@@ -2299,6 +2316,7 @@ config.oled_enable = true;
     sprintf(config.host_name, "ESP32APRS_Audio");
 
     config.fx25_mode = 2; // Used modem mode FX.25 RX+TX
+    config.fx25_tag_distance = FX25_TAG_DISTANCE_DEFAULT;
 }
 
 unsigned long NTP_Timeout;
@@ -2330,141 +2348,83 @@ void psramUnlock()
 
 const char *lastTitle = "LAST HEARD";
 
+// Stations, telemetry senders and messages are found by exact key, their lists are
+// walked most recent first or by packet count without sorting the records
+static struct StationDb pkgIndex = StationDbInit(STATIONLISTSIZE);
+static struct StationDb tlmIndex = StationDbInit(TLMLISTSIZE);
+
 int tlmList_Find(char *call)
 {
-    int i;
-    for (i = 0; i < TLMLISTSIZE; i++)
-    {
-        if (strstr(Telemetry[i].callsign, call) != NULL)
-            return i;
-    }
-    return -1;
+    uint16_t i = StationDbFind(&tlmIndex, call, strnlen(call, sizeof(Telemetry[0].callsign) - 1));
+    return (i != STATIONDB_NONE) ? i : -1;
 }
 
-int tlmListOld()
+// Slot of a telemetry sender, a new one takes the slot of the oldest and starts cleared
+int tlmListUpdate(const char *call)
 {
-    int i, ret = 0;
-    time_t minimum = Telemetry[0].time;
-    for (i = 1; i < TLMLISTSIZE; i++)
+    size_t len = strnlen(call, sizeof(Telemetry[0].callsign) - 1);
+    uint16_t i = StationDbFind(&tlmIndex, call, len);
+    if (i == STATIONDB_NONE)
     {
-        if (Telemetry[i].time < minimum)
-        {
-            minimum = Telemetry[i].time;
-            ret = i;
-        }
-        if (Telemetry[i].time > now())
-            Telemetry[i].time = 0;
-    }
-    return ret;
-}
-
-int pkgList_Find(char *call)
-{
-    int i;
-    for (i = 0; i < PKGLISTSIZE; i++)
-    {
-        if (strstr(pkgList[(int)i].calsign, call) != NULL)
-            return i;
+        i = StationDbAdd(&tlmIndex, call, len);
+        if (i == STATIONDB_NONE)
+            return -1;
+        memset(&Telemetry[i], 0, sizeof(Telemetry_struct));
+        memcpy(Telemetry[i].callsign, call, len);
     }
-    return -1;
+    StationDbTouch(&tlmIndex, i);
+    return i;
 }
 
-int pkgList_Find(char *call, uint16_t type)
+// Key of a pkgList entry: callsign, object or item name and packet type
+static size_t pkgListKey(char *key, const char *call, const char *object, uint16_t type)
 {
-    int i;
-    for (i = 0; i < PKGLISTSIZE; i++)
-    {
-        if (pkgList[i].type == type)
-        {
-            if (strstr(pkgList[i].calsign, call) != NULL)
-            {
-                return i;
-            }
-        }
-    }
-    return -1;
+    size_t n = strnlen(call, 10);
+    memcpy(key, call, n);
+    key[n++] = 0;
+    size_t o = strnlen(object, 9);
+    memcpy(&key[n], object, o);
+    n += o;
+    key[n++] = type & 0xFF;
+    key[n++] = type >> 8;
+    return n;
 }
 
 int pkgList_Find(char *call, char *object, uint16_t type)
 {
-    int i;
-    for (i = 0; i < PKGLISTSIZE; i++)
-    {
-        if (pkgList[i].type == type)
-        {
-            if (strnstr(pkgList[i].calsign, call, strlen(call)) != NULL)
-            {
-                if (strnstr(pkgList[i].object, object, strlen(object)) != NULL)
-                    return i;
-            }
-        }
-    }
-    return -1;
+    char key[STATIONDB_KEY_MAX];
+    uint16_t i = StationDbFind(&pkgIndex, key, pkgListKey(key, call, object, type));
+    return (i != STATIONDB_NONE) ? i : -1;
 }
 
-int pkgListOld()
+int pkgList_Find(char *call, uint16_t type)
 {
-    int i, ret = -1;
-    time_t minimum = time(NULL) + 86400; // pkgList[0].time;
-    for (i = 0; i < PKGLISTSIZE; i++)
-    {
-        if (pkgList[(int)i].time < minimum)
-        {
-            minimum = pkgList[(int)i].time;
-            ret = i;
-        }
-    }
-    return ret;
+    return pkgList_Find(call, (char *)"", type);
 }
 
-void sort(pkgListType a[], int size)
+// Fill idx with up to max pkgList slots in a list order, returns how many
+int pkgListView(int *idx, int max, enum StationDbOrder order)
 {
-    pkgListType t;
-    char *ptr1;
-    char *ptr2;
-    char *ptr3;
-    ptr1 = (char *)&t;
+    int n = 0;
     psramLock();
-    for (int i = 0; i < (size - 1); i++)
-    {
-        for (int o = 0; o < (size - (i + 1)); o++)
-        {
-            if (a[o].time < a[o + 1].time)
-            {
-                ptr2 = (char *)&a[o];
-                ptr3 = (char *)&a[o + 1];
-                memcpy(ptr1, ptr2, sizeof(pkgListType));
-                memcpy(ptr2, ptr3, sizeof(pkgListType));
-                memcpy(ptr3, ptr1, sizeof(pkgListType));
-            }
-        }
-    }
+    for (uint16_t i = StationDbFirst(&pkgIndex, order); (i != STATIONDB_NONE) && (n < max); i = StationDbNext(&pkgIndex, i, order))
+        idx[n++] = i;
     psramUnlock();
+    return n;
 }
 
-void sortPkgDesc(pkgListType a[], int size)
+// Next older or newer station than slot idx, wrapping round, -1 if the list is empty
+int pkgListStep(int idx, bool older)
 {
-    pkgListType t;
-    char *ptr1;
-    char *ptr2;
-    char *ptr3;
-    ptr1 = (char *)&t;
+    enum StationDbOrder order = older ? STATIONDB_RECENT : STATIONDB_OLDEST;
     psramLock();
-    for (int i = 0; i < (size - 1); i++)
-    {
-        for (int o = 0; o < (size - (i + 1)); o++)
-        {
-            if (a[o].pkg < a[o + 1].pkg)
-            {
-                ptr2 = (char *)&a[o];
-                ptr3 = (char *)&a[o + 1];
-                memcpy(ptr1, ptr2, sizeof(pkgListType));
-                memcpy(ptr2, ptr3, sizeof(pkgListType));
-                memcpy(ptr3, ptr1, sizeof(pkgListType));
-            }
-        }
-    }
+    uint16_t i = STATIONDB_NONE;
+    if ((idx >= 0) && (idx < STATIONLISTSIZE))
+        i = StationDbNext(&pkgIndex, idx, order);
+    if (i == STATIONDB_NONE)
+        i = StationDbFirst(&pkgIndex, order);
     psramUnlock();
+    return (i != STATIONDB_NONE) ? i : -1;
 }
 
 uint16_t pkgType(const char *raw)
@@ -2600,27 +2560,44 @@ int popTNC2Raw(int &ret)
   if (++raw_idx_rd >= PKGLISTSIZE)
     raw_idx_rd = 0;
   idx = TNC2Raw[raw_idx_rd];
-  if (idx < PKGLISTSIZE)
+  if (idx < STATIONLISTSIZE)
     ret = idx;
   if (raw_count > 0)
     raw_count--;
   return raw_count;
 }
 
+// Copy of an entry, its raw packet is shared and has to be given back with pktBufRelease()
 pkgListType getPkgList(int idx)
 {
     pkgListType ret;
     psramLock();
     memset(&ret, 0, sizeof(pkgListType));
-    if (idx < PKGLISTSIZE)
+    if ((idx >= 0) && (idx < STATIONLISTSIZE))
+    {
         memcpy(&ret, &pkgList[idx], sizeof(pkgListType));
+        pktBufRef(ret.raw);
+    }
     psramUnlock();
     return ret;
 }
 
-int pkgListUpdate(char *call, char *raw, uint16_t type, bool channel, uint16_t audioLvl)
+// Replace the raw packet of an entry. A packet already in a pool buffer is shared, anything
+// else is copied into one. Readers still holding the old packet keep it until they release it.
+static void pkgListSetRaw(pkgListType *pkg, char *raw)
+{
+    size_t len = strlen(raw);
+    char *buf = pktBufOwns(raw) ? pktBufRef(raw) : pktBufDup(raw, len);
+    pktBufRelease(pkg->raw);
+    pkg->raw = buf;
+    pkg->length = len + 1;
+    pkg->currentLength = (buf != NULL) ? pktBufSize(buf) : 0;
+    if (buf == NULL)
+        log_w("No packet buffer for %d bytes, the entry keeps no packet", (int)len);
+}
+
+int pkgListUpdate(char *call, char *raw, uint16_t type, uint8_t channel, uint16_t audioLvl)
 {
-    size_t len;
     if (*call == 0)
         return -1;
     if (*raw == 0)
@@ -2688,21 +2665,23 @@ int pkgListUpdate(char *call, char *raw, uint16_t type, bool channel, uint16_t a
         i = pkgList_Find(callsign, type);
     }
 
-    if (i > PKGLISTSIZE)
+    if (i >= STATIONLISTSIZE)
     {
         psramUnlock();
         return -1;
     }
     if (i > -1)
     { // Found call in old pkg
-        if ((channel == 1) || (channel == pkgList[i].channel))
+        if ((channel == PKG_CHANNEL_INET) || (pkgList[i].channel != PKG_CHANNEL_INET))
         {
+            StationDbTouch(&pkgIndex, i);
             pkgList[i].time = time(NULL);
-            pkgList[i].pkg++;
+            pkgList[i].pkg = StationDbCount(&pkgIndex, i);
             pkgList[i].type = type;
             // memcpy(pkgList[i].object,object,sizeof(object));
-            if (channel == 0)
+            if (channel != PKG_CHANNEL_INET)
             {
+                pkgList[i].channel = channel;
                 pkgList[i].audio_level = (int16_t)audioLvl;
                 //     pkgList[i].rssi = rssi;
                 //     pkgList[i].snr = snr;
@@ -2715,46 +2694,20 @@ int pkgListUpdate(char *call, char *raw, uint16_t type, bool channel, uint16_t a
                 pkgList[i].freqErr = 0;
                 pkgList[i].audio_level = 0;
             }
-            len = strlen(raw);
-            pkgList[i].length = len + 1;
-            if (pkgList[i].raw != NULL)
-            {
-                // Check if reallocation is needed (only if new size is larger)
-                if (pkgList[i].length > pkgList[i].currentLength) {
-                    #ifdef BOARD_HAS_PSRAM
-                    pkgList[i].raw = (char *)ps_realloc(pkgList[i].raw, pkgList[i].length);
-                    #else
-                    pkgList[i].raw = (char *)realloc(pkgList[i].raw, pkgList[i].length);
-                    #endif
-                    pkgList[i].currentLength = pkgList[i].length;
-                }
-            }
-            else
-            {
-                #ifdef BOARD_HAS_PSRAM
-                pkgList[i].raw = (char *)ps_calloc(pkgList[i].length, sizeof(char));
-                #else
-                pkgList[i].raw = (char *)calloc(pkgList[i].length, sizeof(char));
-                #endif
-                pkgList[i].currentLength = pkgList[i].length;
-            }
-            if (pkgList[i].raw)
-            {
-                memset(pkgList[i].raw, 0, pkgList[i].length);
-                memcpy(pkgList[i].raw, raw, len);
-                pkgList[i].raw[len] = 0;
-                log_d("Update: pkgList_idx=%d callsign:%s object:%s", i, callsign, object);
-            }
+            pkgListSetRaw(&pkgList[i], raw);
+            log_d("Update: pkgList_idx=%d callsign:%s object:%s", i, callsign, object);
         }
     }
     else
     {
-        i = pkgListOld(); // Search free in array
-        if (i > PKGLISTSIZE || i < 0)
+        char key[STATIONDB_KEY_MAX];
+        uint16_t slot = StationDbAdd(&pkgIndex, key, pkgListKey(key, callsign, object, type)); // the oldest station makes room
+        if (slot == STATIONDB_NONE)
         {
             psramUnlock();
             return -1;
         }
+        i = slot;
         // memset(&pkgList[i], 0, sizeof(pkgListType));
         pkgList[i].channel = channel;
         pkgList[i].time = time(NULL);
@@ -2769,7 +2722,7 @@ int pkgListUpdate(char *call, char *raw, uint16_t type, bool channel, uint16_t a
         {
             memset(pkgList[i].object, 0, sizeof(pkgList[i].object));
         }
-        if (channel == 0)
+        if (channel != PKG_CHANNEL_INET)
         {
             pkgList[i].audio_level = (int16_t)audioLvl;
             //     pkgList[i].rssi = rssi;
@@ -2784,32 +2737,10 @@ int pkgListUpdate(char *call, char *raw, uint16_t type, bool channel, uint16_t a
             pkgList[i].audio_level = 0;
         }
         // strcpy(pkgList[i].calsign, callsign);
+        memset(pkgList[i].calsign, 0, sizeof(pkgList[i].calsign));
         memcpy(pkgList[i].calsign, callsign, strlen(callsign));
-        len = strlen(raw);
-        pkgList[i].length = len + 1;
-        if (pkgList[i].raw != NULL)
-            {
-                #ifdef BOARD_HAS_PSRAM
-                pkgList[i].raw = (char *)ps_realloc(pkgList[i].raw, pkgList[i].length);
-                #else
-                pkgList[i].raw = (char *)realloc(pkgList[i].raw, pkgList[i].length);
-                #endif
-            }
-            else
-            {
-                #ifdef BOARD_HAS_PSRAM
-                pkgList[i].raw = (char *)ps_calloc(pkgList[i].length, sizeof(char));
-                #else
-                pkgList[i].raw = (char *)calloc(pkgList[i].length, sizeof(char));
-                #endif
-            }
-        if (pkgList[i].raw)
-        {
-            memset(pkgList[i].raw, 0, pkgList[i].length);
-            memcpy(pkgList[i].raw, raw, len);
-            pkgList[i].raw[len] = 0;
-            log_d("New: pkgList_idx=%d callsign:%s object:%s", i, callsign, object);
-        }
+        pkgListSetRaw(&pkgList[i], raw);
+        log_d("New: pkgList_idx=%d callsign:%s object:%s", i, callsign, object);
     }
     psramUnlock();
     lastHeard_Flag = true;
@@ -2817,186 +2748,243 @@ int pkgListUpdate(char *call, char *raw, uint16_t type, bool channel, uint16_t a
     return i;
 }
 
-bool pkgTxDuplicate(AX25Msg ax25)
+// Match a queued packet with the same source callsign and information field
+static bool pkgTxSameInfo(const char *info, size_t len, uint8_t channels, void *arg)
 {
-    psramLock();
+    AX25Msg *ax25 = (AX25Msg *)arg;
     char callsign[12];
-    for (int i = 0; i < PKGTXSIZE; i++)
-    {
-        if (txQueue[i].Active)
-        {
-            if (txQueue[i].Channel & INET_CHANNEL)
-                continue;
+    if (channels & INET_CHANNEL)
+        return false;
 
-            if (ax25.src.ssid > 0)
-                sprintf(callsign, "%s-%d", ax25.src.call, ax25.src.ssid);
-            else
-                sprintf(callsign, "%s", ax25.src.call);
-            if (strncmp(&txQueue[i].Info[0], callsign, strlen(callsign)) >= 0) // Check duplicate src callsign
-            {
-                char *ecs1 = strstr(txQueue[i].Info, ":");
-                if (ecs1 == NULL)
-                    continue;
-                ;
-                if (strncmp(ecs1, (const char *)ax25.info, strlen(ecs1)) >= 0)
-                { // Check duplicate aprs info
-                    txQueue[i].Active = false;
-                    psramUnlock();
-                    return true;
-                }
-            }
-        }
+    if (ax25->src.ssid > 0)
+        sprintf(callsign, "%s-%d", ax25->src.call, ax25->src.ssid);
+    else
+        sprintf(callsign, "%s", ax25->src.call);
+    if (strncmp(info, callsign, strlen(callsign)) >= 0) // Check duplicate src callsign
+    {
+        const char *ecs1 = strstr(info, ":");
+        if (ecs1 == NULL)
+            return false;
+        if (strncmp(ecs1, (const char *)ax25->info, strlen(ecs1)) >= 0) // Check duplicate aprs info
+            return true;
     }
+    return false;
+}
 
-    psramUnlock();
+bool pkgTxDuplicate(AX25Msg ax25)
+{
+    return txQueueCancel(RF_CHANNEL, pkgTxSameInfo, &ax25);
+}
+
+// APRS-IS packets sent to RF inside the window, only used by taskNetwork
+static struct DupeTable inet2rfDupes = DupeTableInit(INET2RF_DUPE_ENTRIES, INET2RF_DUPE_WINDOW_MS);
+
+// A packet that APRS-IS delivers again, e.g. gated by several IGates, goes to RF once
+bool inet2rfDuplicate(const char *line, size_t len)
+{
+    uint64_t hash;
+    if (!DupeHashTnc2(line, len, &hash)) // not a packet, nothing to compare
+        return false;
+    if (DupeCheck(&inet2rfDupes, hash, millis()))
+    {
+        status.dupCount++;
+        return true;
+    }
     return false;
 }
 
-int pkgTxCount()
+// Filters in the APRS-IS syntax from the configuration. Each task that matches packets has its
+// own compiled copies and recompiles them itself after aprsFiltersUpdate(), so a filter is never
+// compiled while it is matched and the f/ and t/ centres cached in its parts belong to one task.
+static std::atomic<uint32_t> aprsFiltersGeneration(1);
+
+typedef struct
+{
+    uint32_t generation; // aprsFiltersGeneration the filters were compiled for, 0 never
+    aprsFilter disp;
+    aprsFilter kiss;
+#ifdef MQTT
+    aprsFilter mqtt;
+#endif
+} rfAprsFilters; // taskAPRS
+
+typedef struct
+{
+    uint32_t generation;
+    aprsFilter disp;
+    aprsFilter inet2rf;
+} inetAprsFilters; // taskNetwork
+
+static rfAprsFilters rfFilters;
+static inetAprsFilters inetFilters;
+
+// Position of a station in the last heard list, for the f/ and t/ filter parts.
+// Called at most once a minute for each of those parts.
+static bool filterStationPos(const char *call, float *lat, float *lon)
 {
-    int count = 0;
-    for (int i = 0; i < PKGTXSIZE; i++)
+    static const uint16_t posTypes[] = {FILTER_POSITION, FILTER_POSITION | FILTER_MICE, FILTER_POSITION | FILTER_WX};
+    static struct pbuf_t pb; // used under psramLock
+    bool found = false;
+    time_t latest = 0;
+    char key[STATIONDB_KEY_MAX];
+    psramLock();
+    for (uint8_t t = 0; t < sizeof(posTypes) / sizeof(posTypes[0]); t++)
     {
-        if (txQueue[i].Active)
+        uint16_t i = StationDbFind(&pkgIndex, key, pkgListKey(key, call, "", posTypes[t]));
+        if ((i == STATIONDB_NONE) || (pkgList[i].raw == NULL) || (found && (pkgList[i].time <= latest)))
+            continue;
+        if (pbufParseTnc2(&pb, pkgList[i].raw, strlen(pkgList[i].raw)) && (pb.flags & F_HASPOS))
         {
-            count++;
+            *lat = pb.lat;
+            *lon = pb.lng;
+            latest = pkgList[i].time;
+            found = true;
         }
     }
-    return count;
+    psramUnlock();
+    return found;
+}
+
+void aprsFiltersUpdate()
+{
+    aprsFilterSetHome(config.igate_lat, config.igate_lon);
+    aprsFilterSetLookup(filterStationPos);
+    aprsFiltersGeneration.fetch_add(1, std::memory_order_release);
+}
+
+// Compile the filters of taskAPRS if the configuration changed, only called by that task
+static void rfAprsFiltersSync()
+{
+    uint32_t generation = aprsFiltersGeneration.load(std::memory_order_acquire);
+    if (rfFilters.generation == generation)
+        return;
+    rfFilters.generation = generation;
+    aprsFilterCompile(&rfFilters.disp, config.disp_filter);
+    aprsFilterCompile(&rfFilters.kiss, config.kiss_tcp_filter);
+#ifdef MQTT
+    aprsFilterCompile(&rfFilters.mqtt, config.mqtt_filter);
+#endif
+}
+
+// Compile the filters of taskNetwork if the configuration changed, only called by that task
+static void inetAprsFiltersSync()
+{
+    uint32_t generation = aprsFiltersGeneration.load(std::memory_order_acquire);
+    if (inetFilters.generation == generation)
+        return;
+    inetFilters.generation = generation;
+    aprsFilterCompile(&inetFilters.disp, config.disp_filter);
+    aprsFilterCompile(&inetFilters.inet2rf, config.inet2rf_filter);
+}
+
+// Fill a packet buffer from a TNC2 line and parse it. A packet that is not APRS still has
+// its addresses and path set, so callsign and path filters work on it.
+bool pbufParseTnc2(struct pbuf_t *pb, const char *line, size_t len)
+{
+    struct Tnc2View v;
+    if ((len >= sizeof(pb->data)) || !Tnc2Parse(line, len, &v))
+        return false;
+    memset(pb, 0, sizeof(struct pbuf_t));
+    memcpy(pb->data, line, len);
+    pb->buf_len = sizeof(pb->data);
+    pb->packet_len = len;
+    pb->srccall_end = pb->data + v.srcLen;
+    pb->dstname = pb->data + (v.dst - line);
+    pb->dstname_len = v.dstLen;
+    pb->dstcall_end = pb->dstname + v.dstLen;
+    const char *ssid = (const char *)memchr(pb->dstname, '-', v.dstLen);
+    pb->dstcall_end_or_ssid = (ssid != NULL) ? ssid : pb->dstcall_end;
+    pb->info_start = pb->data + (v.info - line);
+    aprsParse.parse_aprs(pb);
+    return true;
+}
+
+// An empty filter passes everything. The line is parsed into pb by the first filter that
+// needs it, *parsed keeps the result for the next ones: 0 not yet, 1 parsed, -1 not a packet.
+static bool aprsFilterLine(aprsFilter *f, struct pbuf_t *pb, int8_t *parsed, const char *line, size_t len)
+{
+    if (aprsFilterEmpty(f))
+        return true;
+    if (*parsed == 0)
+        *parsed = pbufParseTnc2(pb, line, len) ? 1 : -1;
+    return (*parsed > 0) && aprsFilterMatch(f, pb);
 }
 
-bool pkgTxPush(const char *info, size_t len, int dly, uint8_t Ch)
+// Wake taskAPRS, used when a frame is received or a packet is queued for TX
+void aprsTaskNotify()
+{
+    if (taskAPRSHandle != NULL)
+        xTaskNotifyGive(taskAPRSHandle);
+}
+
+int pkgTxCount()
+{
+    return txQueueCount();
+}
+
+bool pkgTxPush(const char *info, size_t len, int dly, uint8_t Ch, uint8_t prio)
 {
     char *ecs = strstr(info, ">");
     if (ecs == NULL)
         return false;
-    psramLock();
-    // for (int i = 0; i < PKGTXSIZE; i++)
-    // {
-    //   if (txQueue[i].Active)
-    //   {
-    //     if ((strncmp(&txQueue[i].Info[0], info, info - ecs)==0)) //Check src callsign
-    //     {
-    //       // strcpy(&txQueue[i].Info[0], info);
-    //       memset(txQueue[i].Info, 0, sizeof(txQueue[i].Info));
-    //       memcpy(&txQueue[i].Info[0], info, len);
-    //       txQueue[i].Delay = dly;
-    //       txQueue[i].timeStamp = millis();
-    //       psramUnlock();
-    //       return true;
-    //     }
-    //   }
-    // }
+    bool ret = txQueuePush(info, len, dly, Ch, prio);
+    aprsTaskNotify();
+    return ret;
+}
+
+bool pkgTxSend()
+{
+    char info[TX_QUEUE_INFO_SIZE + 1];
+    size_t len;
 
-    // Add
-    for (int i = 0; i < PKGTXSIZE; i++)
+    if (config.igate_en == false)
     {
-        if (txQueue[i].Active == false)
+        txQueueExpire(INET_CHANNEL, true); // no APRS-IS connection is wanted
+    }
+    else if (aprsClient.connected())
+    {
+        // taskNetwork writes them out together with its next flush
+        while ((len = txQueuePop(INET_CHANNEL, info, sizeof(info))) > 0)
         {
-            if (len > sizeof(txQueue[i].Info))
-                len = sizeof(txQueue[i].Info);
-            memset(txQueue[i].Info, 0, sizeof(txQueue[i].Info));
-            memcpy(&txQueue[i].Info[0], info, len);
-            txQueue[i].length = len;
-            txQueue[i].Delay = dly;
-            txQueue[i].Active = true;
-            txQueue[i].timeStamp = millis();
-            txQueue[i].Channel = Ch;
-            break;
+            aprsIsSend(info, len);
+            log_d("TX->INET: %s", info);
         }
     }
-    psramUnlock();
-    return true;
-}
+    else
+    {
+        txQueueExpire(INET_CHANNEL, false);
+    }
 
-bool pkgTxSend()
-{
-//   if (getReceive())
-//     return false;
-    psramLock();
-    // char info[300];
-    for (int i = 0; i < PKGTXSIZE; i++)
+    // nothing sends TNC2 packets back to the TNC port, they only leave the queue
+    while (txQueuePop(TNC_CHANNEL, info, sizeof(info)) > 0)
+        ;
+
+    // Once a packet is due, packets due within TX_BURST_WINDOW_MS join it in the same
+    // transmission, behind one TXDELAY. The AX.25 layer splits bursts longer than its airtime limit.
+    uint32_t ahead = 0;
+    while ((Ax25TxFreeFrames() > 0) && ((len = txQueuePop(RF_CHANNEL, info, sizeof(info), ahead)) > 0))
     {
-        if (txQueue[i].Active)
+        ahead = TX_BURST_WINDOW_MS;
+        if (config.rf_en)
         {
-            int decTime = millis() - txQueue[i].timeStamp;
-            if (txQueue[i].Channel & INET_CHANNEL)
+            if ((config.rf_type == RF_SR_1WV) || (config.rf_type == RF_SR_1WU) || (config.rf_type == RF_SR_1W350))
             {
-                if (config.igate_en == false)
-                {
-                    txQueue[i].Channel &= ~INET_CHANNEL;
-                }
+                digitalWrite(config.rf_pwr_gpio, LOW);
+                if (config.rf_power ^ !config.rf_pwr_active)
+                    pinMode(config.rf_pwr_gpio, OPEN_DRAIN);
                 else
-                {
-                    if (aprsClient.connected())
-                    {
-                        // Copy data and release mutex before blocking TCP write
-                        char infoTmp[sizeof(txQueue[i].Info)];
-                        memcpy(infoTmp, txQueue[i].Info, txQueue[i].length);
-                        infoTmp[txQueue[i].length] = '\0';
-                        size_t lenTmp = txQueue[i].length;
-                        txQueue[i].Channel &= ~INET_CHANNEL;
-                        psramUnlock();
-
-                        aprsClient.write(infoTmp, lenTmp); // Send binary frame packet to APRS-IS (aprsc)
-                        aprsClient.write("\r\n");           // Send CR LF the end frame packet
-                        log_d("TX->INET: %s", infoTmp);
-
-                        psramLock();
-                        continue;
-                    }
-                }
+                    pinMode(config.rf_pwr_gpio, OUTPUT);
             }
-            if (decTime > txQueue[i].Delay)
-            {
-                if (txQueue[i].Channel & RF_CHANNEL)
-                {
-
-                    psramUnlock();
-                    if (config.rf_en)
-                    {
-                        if ((config.rf_type == RF_SR_1WV) || (config.rf_type == RF_SR_1WU) || (config.rf_type == RF_SR_1W350))
-                        {
-                            digitalWrite(config.rf_pwr_gpio, LOW);
-                            if (config.rf_power ^ !config.rf_pwr_active)
-                                pinMode(config.rf_pwr_gpio, OPEN_DRAIN);
-                            else
-                                pinMode(config.rf_pwr_gpio, OUTPUT);
-                        }
-                        else
-                        {
-                            digitalWrite(config.rf_pwr_gpio, config.rf_power ^ !config.rf_pwr_active); // ON RF Power H/L
-                        }
-                    }
-                    status.txCount++;
-                    log_d("TX->RF[%i]: %s\n", txQueue[i].length, txQueue[i].Info);
-                    APRS_setPreamble(config.preamble * 100); // Send packet to RF
-                    APRS_sendTNC2Pkt((uint8_t *)txQueue[i].Info, txQueue[i].length);
-                    igateTLM.TX++;
-                
-                    // free(info);
-                    //  for (int i = 0; i < 100; i++)
-                    //  {
-                    //      // if (digitalRead(config.rf_ptt_gpio) ^ config.rf_ptt_active)
-                    //      if (!getTransmit())
-                    //          break;
-                    //      delay(50); // TOT 5sec
-                    //  }
-                    // digitalWrite(config.rf_pwr_gpio, !config.rf_pwr_active); // OFF RF Power H/L
-                    // pinMode(config.rf_pwr_gpio, OUTPUT);
-                    psramLock();
-                    txQueue[i].Channel &= ~RF_CHANNEL;
-                }
-            }
-
-            if ((txQueue[i].Channel == 0) || (decTime > 60000))
+            else
             {
-                txQueue[i].Channel = 0;
-                txQueue[i].Active = false;
+                digitalWrite(config.rf_pwr_gpio, config.rf_power ^ !config.rf_pwr_active); // ON RF Power H/L
             }
         }
+        status.txCount++;
+        log_d("TX->RF[%i]: %s\n", len, info);
+        APRS_sendTNC2Pkt((uint8_t *)info, len); // Send packet to RF, TXDELAY is set by afskSetModem()
+        igateTLM.TX++;
     }
-    psramUnlock();
     return true;
 }
 
@@ -3433,6 +3421,7 @@ boolean APRSConnect()
             else
                 login = "user " + String(config.aprs_mycall) + "-" + String(config.aprs_ssid) + " pass " + String(passcode, DEC) + " vers ESP32APRS_Audio V" + String(VERSION) + String(VERSION_BUILD) + " filter " + String(config.aprs_filter);
         }
+        aprsIsReset(); // nothing of an old connection is read or sent on this one
         aprsClient.println(login);
         // Serial.println(login);
         // Serial.println("Success");
@@ -3492,22 +3481,22 @@ void setup()
     // byte *ptr;
     //  setCpuFrequencyMhz(160);
 #ifdef BOARD_HAS_PSRAM
-    pkgList = (pkgListType *)ps_malloc(sizeof(pkgListType) * PKGLISTSIZE);
+    pkgList = (pkgListType *)ps_malloc(sizeof(pkgListType) * STATIONLISTSIZE);
     Telemetry = (TelemetryType *)malloc(sizeof(TelemetryType) * TLMLISTSIZE);
-    txQueue = (txQueueType *)ps_malloc(sizeof(txQueueType) * PKGTXSIZE);
     msgQueue = (msgType *)ps_malloc(sizeof(msgType) * PKGLISTSIZE);
     // TNC2Raw = (int *)ps_malloc(sizeof(int) * PKGTXSIZE);
 #else
-    pkgList = (pkgListType *)malloc(sizeof(pkgListType) * PKGLISTSIZE);
+    pkgList = (pkgListType *)malloc(sizeof(pkgListType) * STATIONLISTSIZE);
     Telemetry = (TelemetryType *)malloc(sizeof(TelemetryType) * TLMLISTSIZE);
-    txQueue = (txQueueType *)malloc(sizeof(txQueueType) * PKGTXSIZE);
     msgQueue = (msgType *)malloc(sizeof(msgType) * PKGLISTSIZE);
     // TNC2Raw = (int *)malloc(sizeof(int) * PKGTXSIZE);
 #endif
 
-    memset(pkgList, 0, sizeof(pkgListType) * PKGLISTSIZE);
+    memset(pkgList, 0, sizeof(pkgListType) * STATIONLISTSIZE);
+    static const uint16_t pktBufCounts[PKTBUF_CLASSES] = {PKTBUF_SMALL_COUNT, PKTBUF_MEDIUM_COUNT, PKTBUF_LARGE_COUNT};
+    pktPoolInit(pktBufCounts);
     memset(Telemetry, 0, sizeof(TelemetryType) * TLMLISTSIZE);
-    memset(txQueue, 0, sizeof(txQueueType) * PKGTXSIZE);
+    txQueueInit(PKGTXSIZE);
     memset(msgQueue, 0, sizeof(msgType) * PKGLISTSIZE);
 
     pinMode(BOOT_PIN, INPUT_PULLUP); // BOOT Button
@@ -3569,6 +3558,7 @@ void setup()
         if (!loadConfiguration("/default.cfg", config))
             defaultConfig();
     }
+    aprsFiltersUpdate();
 
     //setCpuFrequencyMhz(config.cpuFreq);
 
@@ -4258,7 +4248,7 @@ void mqtt_callback(char *topic, byte *payload, unsigned int length)
     }
     else
     {
-        pkgTxPush((const char *)payload_ptr, length, 0, RF_CHANNEL);
+        pkgTxPush((const char *)payload_ptr, length, 0, RF_CHANNEL, TX_PRIO_MSG);
     }
     free(payload_ptr);
 }
@@ -5544,9 +5534,8 @@ void sendIsPkg(char *raw)
     char str[300];
     sprintf(str, "%s-%d>APE32A%s:%s", config.aprs_mycall, config.aprs_ssid, VERSION, raw);
     // client.println(str);
-    String tnc2Raw = String(str);
     if (aprsClient.connected())
-        aprsClient.println(tnc2Raw); // Send packet to Inet
+        aprsIsSend(str, strlen(str)); // Send packet to Inet
     if (config.digi_en)
         pkgTxPush(str, strlen(str), 0, RF_CHANNEL);
 }
@@ -5570,9 +5559,8 @@ void sendIsPkgMsg(char *raw)
     else
         sprintf(str, "%s-%d>APE32A::%s:%s", config.aprs_mycall, config.aprs_ssid, call, raw);
 
-    String tnc2Raw = String(str);
     if (aprsClient.connected())
-        aprsClient.println(tnc2Raw); // Send packet to Inet
+        aprsIsSend(str, strlen(str)); // Send packet to Inet
 }
 
 void sendTelemetry_0(char *raw, bool header)
@@ -5657,7 +5645,7 @@ void sendTelemetry_0(char *raw, bool header)
         SendMode |= RF_CHANNEL;
     if (config.tlm0_2inet)
         SendMode |= INET_CHANNEL;
-    pkgTxPush(str, strlen(str), 0, SendMode);
+    pkgTxPush(str, strlen(str), 0, SendMode, TX_PRIO_TLM);
 
 #if 1
     if (config.tlm0_2rf)
@@ -5666,7 +5654,7 @@ void sendTelemetry_0(char *raw, bool header)
         // char *rawP = (char *)malloc(rawData.length());
         //  rawData.toCharArray(rawP, rawData.length());
         // memcpy(rawP, rawData.c_str(), rawData.length());
-        pkgTxPush(str, strlen(str), 0, RF_CHANNEL);
+        pkgTxPush(str, strlen(str), 0, RF_CHANNEL, TX_PRIO_TLM);
         // pushTxDisp(TXCH_RF, "TX DIGI POS", sts);
         // free(rawP);
     }
@@ -5676,7 +5664,7 @@ void sendTelemetry_0(char *raw, bool header)
         if (aprsClient.connected())
         {
             status.txCount++;
-            aprsClient.printf("%s\r\n", str); // Send packet to Inet
+            aprsIsSend(str, strlen(str)); // Send packet to Inet
             // pushTxDisp(TXCH_TCP, "TX DIGI POS", sts);
         }
     }
@@ -5738,7 +5726,7 @@ void sendTelemetry_trk(char *raw)
         SendMode |= RF_CHANNEL;
     if (config.trk_loc2inet)
         SendMode |= INET_CHANNEL;
-    pkgTxPush(str, strlen(str), 1000, SendMode);
+    pkgTxPush(str, strlen(str), 1000, SendMode, TX_PRIO_TLM);
 
     // if (config.trk_loc2rf)
     // { // TLM SEND TO RF
@@ -5810,7 +5798,7 @@ void sendTelemetry_igate(char *raw)
         SendMode |= RF_CHANNEL;
     if (config.igate_loc2inet)
         SendMode |= INET_CHANNEL;
-    pkgTxPush(str, strlen(str), 0, SendMode);
+    pkgTxPush(str, strlen(str), 0, SendMode, TX_PRIO_TLM);
     // if (config.igate_loc2rf)
     // { // TLM SEND TO RF
     //     pkgTxPush(str, strlen(str), 0);
@@ -5875,7 +5863,7 @@ void sendTelemetry_digi(char *raw)
         SendMode |= RF_CHANNEL;
     if (config.digi_loc2inet)
         SendMode |= INET_CHANNEL;
-    pkgTxPush(str, strlen(str), 0, SendMode);
+    pkgTxPush(str, strlen(str), 0, SendMode, TX_PRIO_TLM);
     // if (config.digi_loc2rf)
     // { // TLM SEND TO RF
     //     pkgTxPush(str, strlen(str), 0);
@@ -6406,8 +6394,7 @@ void taskSerial(void *pvParameters)
                     if (config.rf2inet && aprsClient.connected())
                     {
                         // RF->INET
-                        aprsClient.write(&rawP[0], strlen(rawP)); // Send binary frame packet to APRS-IS (aprsc)
-                        aprsClient.write("\r\n");                 // Send CR LF the end frame packet
+                        aprsIsSend(rawP, strlen(rawP)); // Send packet to APRS-IS (aprsc)
                         status.rf2inet++;
                         // igateTLM.RF2INET++;
                         // igateTLM.RX++;
@@ -6488,8 +6475,7 @@ void taskSerial(void *pvParameters)
                                 if (config.rf2inet && aprsClient.connected())
                                 {
                                     // RF->INET
-                                    aprsClient.write(&rawP[0], strlen(rawP)); // Send binary frame packet to APRS-IS (aprsc)
-                                    aprsClient.write("\r\n");                 // Send CR LF the end frame packet
+                                    aprsIsSend(rawP, strlen(rawP)); // Send packet to APRS-IS (aprsc)
                                     status.rf2inet++;
                                     // igateTLM.RF2INET++;
                                     // igateTLM.RX++;
@@ -6580,6 +6566,7 @@ void taskAPRS(void *pvParameters)
     uint16_t type = 0;
     bool newIGatePkg = false;
     bool newDigiPkg = false;
+    static struct pbuf_t rfPkt; // received frame parsed for the APRS-IS syntax filters
     uint8_t *buf;
     uint16_t size = 0;
     int8_t peak = 0;
@@ -6587,6 +6574,7 @@ void taskAPRS(void *pvParameters)
     uint8_t signalLevel = 0;
     uint8_t fixed = 0;
     uint16_t mV = 0;
+    uint8_t rxPort = 0;
 
     // PacketBuffer.clean();
     adcEn = 0;
@@ -6603,6 +6591,7 @@ void taskAPRS(void *pvParameters)
     tx_counter = tx_interval - 10;
 
     initInterval = true;
+    Ax25SetRxNotify(aprsTaskNotify);
     AFSKInitAct = true;
     log_d("Task APRS has been start");
     for (;;)
@@ -6652,8 +6641,16 @@ void taskAPRS(void *pvParameters)
             tx_counter = tx_interval - 10;
         }
         timerAPRS = micros() - timerAPRS_old;
-        vTaskDelay(10 / portTICK_PERIOD_MS);
+        // Sleep until a frame is received or a packet is queued. Timers, TX and Bluetooth
+        // still need polling, quickly while there is work pending and slowly when idle.
+        TickType_t aprsWait = APRS_TASK_IDLE_MS / portTICK_PERIOD_MS;
+        if (Ax25NewRxFrames())
+            aprsWait = 0;
+        else if (pttOff || getTransmit() || Ax25TxBusy() || (pkgTxCount() > 0) || (adcEn != 0) || (dacEn != 0) || config.bt_master)
+            aprsWait = 10 / portTICK_PERIOD_MS;
+        ulTaskNotifyTake(pdTRUE, aprsWait);
         timerAPRS_old = micros();
+        now = millis(); // the wait may have taken the whole idle period
 
         if (now > msgInterval)
         {
@@ -6739,6 +6736,8 @@ void taskAPRS(void *pvParameters)
         // {
         // Transmit in timeslot if enabled
         pkgTxSend();
+        kissTcpPoll(); // frames from KISS TCP and AGWPE clients go straight to the AX.25 TX buffer
+        agwTcpPoll();
         Ax25TransmitBuffer(); // transmit buffer (will return if nothing to be transmitted)
         Ax25TransmitCheck();  // check for pending transmission request
 
@@ -7087,8 +7086,18 @@ void taskAPRS(void *pvParameters)
         // if (PacketBuffer.getCount() > 0)
         if (Ax25NewRxFrames())
         {
-            if (Ax25ReadNextRxFrame(&buf, &size, &peak, &valley, &signalLevel, &fixed, &mV))
-            {
+            // the frame is used in place and stays in the RX pool until it is released below
+            struct Ax25RxFrame *rxFrame = Ax25BorrowRxFrame();
+            if (rxFrame != NULL)
+            {
+                buf = rxFrame->data;
+                size = rxFrame->size;
+                peak = rxFrame->peak;
+                valley = rxFrame->valley;
+                signalLevel = rxFrame->level;
+                fixed = rxFrame->corrected;
+                mV = rxFrame->mVrms;
+                rxPort = rxFrame->port;
                 String tnc2 = "";
                 // นำข้อมูลแพ็จเกจจาก TNC ออกจากคิว
                 ax25_decode(buf, size, mV, &incomingPacket);                
@@ -7110,6 +7119,8 @@ void taskAPRS(void *pvParameters)
                     log_d("Peak:%d Valley:%d Signal:%d mV:%d", peak, valley, signalLevel, mV);
                     log_d("RX TNC2: %s", tnc2.c_str());
                     type = pkgType((const char *)incomingPacket.info);
+                    int8_t parsed = 0; // rfPkt, for the APRS-IS syntax filters
+                    rfAprsFiltersSync();
                     newIGatePkg = true;
                     newDigiPkg = true;
                     if (config.ext_tnc_enable)
@@ -7168,6 +7179,10 @@ void taskAPRS(void *pvParameters)
                             }
                         }
                     }
+                    if (config.kiss_tcp_en && aprsFilterLine(&rfFilters.kiss, &rfPkt, &parsed, tnc2.c_str(), tnc2.length()))
+                        kissTcpBroadcast(buf, size);
+                    if (config.agw_en)
+                        agwTcpBroadcast(rxPort, buf, size);
 #ifdef BLUETOOTH
                     if (config.bt_master)
                     { // Output TNC2RAW to BT Serial
@@ -7203,7 +7218,8 @@ void taskAPRS(void *pvParameters)
 #endif
 
 #ifdef MQTT
-                    if (config.en_mqtt && clientMQTT.connected() && (config.mqtt_topic_flag & MQTT_TOPIC_TNC))
+                    if (config.en_mqtt && clientMQTT.connected() && (config.mqtt_topic_flag & MQTT_TOPIC_TNC) &&
+                        aprsFilterLine(&rfFilters.mqtt, &rfPkt, &parsed, tnc2.c_str(), tnc2.length()))
                     {
                         log_d("Publish MQTT Topic: %s Payload: %s", config.mqtt_topic, tnc2.c_str());
                         clientMQTT.publish(config.mqtt_topic, tnc2.c_str());
@@ -7211,7 +7227,7 @@ void taskAPRS(void *pvParameters)
 #endif
                     // SerialBT.println(tnc2);
                     // uint16_t type = pkgType((char *)incomingPacket.info);
-                    if (!(type & FILTER_THIRDPARTY))
+                    if (!(type & FILTER_THIRDPARTY) && aprsFilterLine(&rfFilters.disp, &rfPkt, &parsed, tnc2.c_str(), tnc2.length()))
                     {
                         char call[11];
                         if (incomingPacket.src.ssid > 0)
@@ -7219,13 +7235,10 @@ void taskAPRS(void *pvParameters)
                         else
                             sprintf(call, "%s", incomingPacket.src.call);
 
-                        char *rawP = (char *)calloc(tnc2.length() + 1, sizeof(char));
+                        char *rawP = pktBufDup(tnc2.c_str(), tnc2.length()); // shared with the last heard list
                         if (rawP)
                         {
-                            memset(rawP, 0, tnc2.length() + 1);
-                            tnc2.toCharArray(rawP, tnc2.length(), 0);
-                            // memcpy(rawP, tnc2.c_str(), tnc2.length());
-                            int idx = pkgListUpdate(call, rawP, type, 0, incomingPacket.mVrms);
+                            int idx = pkgListUpdate(call, rawP, type, rxPort ? PKG_CHANNEL_RF2 : PKG_CHANNEL_RF, incomingPacket.mVrms);
 
 #if defined OLED || defined ST7735_160x80 || defined GUI_LCD
                             if ((config.oled_enable) && (idx > -1))
@@ -7243,7 +7256,7 @@ void taskAPRS(void *pvParameters)
                             }
 #endif
                             handle_ws(rawP, tnc2.length(), incomingPacket.mVrms);
-                            free(rawP);
+                            pktBufRelease(rawP);
                         }
                     }
 
@@ -7260,6 +7273,7 @@ void taskAPRS(void *pvParameters)
                 {
                     status.errorCount++;
                 }
+                Ax25ReleaseRxFrame(rxFrame);
             }
         }
 
@@ -7502,7 +7516,7 @@ void taskAPRS(void *pvParameters)
             {
                 newIGatePkg = false;
                 // if (config.rf2inet && aprsClient.connected())
-                if (config.rf2inet)
+                if (config.rf2inet && (config.rf2inet_ports & (1 << rxPort)))
                 {
                     int ret = 0;
                     // uint16_t type = pkgType((const char *)&incomingPacket.info[0]);
@@ -7772,8 +7786,8 @@ void taskAPRS(void *pvParameters)
                 // uint16_t type = pkgType((const char *)&incomingPacket.info[0]);
                 Sleep_Activate &= ~ACTIVATE_DIGI;
                 StandByTick = millis() + (config.pwr_stanby_delay * 1000);
-                // Digi repeater filter
-                if ((type & config.digiFilter))
+                // Digi repeater filter, only ports chosen for the digi are repeated on the TX radio
+                if ((type & config.digiFilter) && (config.digi_ports & (1 << rxPort)))
                 {
                     // Packet recheck
                     pkgTxDuplicate(incomingPacket); // Search duplicate in tx and drop packet for renew
@@ -7814,7 +7828,7 @@ void taskAPRS(void *pvParameters)
                         // char *rawP = (char *)calloc(digiPkg.length()+1, sizeof(char));
                         //  digiPkg.toCharArray(rawP, digiPkg.length());
                         // memcpy(rawP, digiPkg.c_str(), digiPkg.length());
-                        pkgTxPush(digiPkg.c_str(), digiPkg.length(), digiDelay, RF_CHANNEL);
+                        pkgTxPush(digiPkg.c_str(), digiPkg.length(), digiDelay, RF_CHANNEL, TX_PRIO_DIGI);
                         digiPkg.clear();
                         // pkgTxPush(rawP, digiPkg.length(), digiDelay, RF_CHANNEL);
                         sprintf(sts, "--src call--\n%s\nDelay: %dms.", incomingPacket.src.call, digiDelay);
@@ -7871,7 +7885,7 @@ void taskAPRS(void *pvParameters)
                         SendMode |= RF_CHANNEL;
                     if (config.wx_2inet)
                         SendMode |= INET_CHANNEL;
-                    pkgTxPush(rawData.c_str(), rawData.length(), 0, SendMode);
+                    pkgTxPush(rawData.c_str(), rawData.length(), 0, SendMode, TX_PRIO_TLM);
 //                     if (config.wx_2rf)
 //                     { // WX SEND POSITION TO RF
 //                         char *rawP = (char *)calloc(rawData.length(), sizeof(char));
@@ -8037,7 +8051,11 @@ void taskAPRS(void *pvParameters)
 void taskAPRSPoll(void *pvParameters)
 {
     vTaskDelay(1000 / portTICK_PERIOD_MS);
-    afskSetModem(config.modem_type, config.audio_lpf, config.tx_timeslot, config.preamble * 100, config.fx25_mode);
+    afskSetPort2(config.rf2_en ? config.rf2_adc_gpio : -1, config.rf2_modem_type, config.rf2_audio_lpf);
+    afskSetModem(config.modem_type, config.audio_lpf, config.tx_timeslot, config.preamble * 100, config.fx25_mode, config.modem_demods);
+    Ax25FixBits(config.modem_fixbits);
+    Fx25TagDistance(config.fx25_tag_distance);
+    Ax25BurstTime(config.tx_burst_time);
     afskSetSQL(config.rf_sql_gpio, config.rf_sql_active);
     afskSetPTT(config.rf_ptt_gpio, config.rf_ptt_active);
     afskSetPWR(config.rf_pwr_gpio, config.rf_pwr_active);
@@ -8055,15 +8073,15 @@ void taskAPRSPoll(void *pvParameters)
 
     for (;;)
     {
-        if (config.modem_type == 3)
-            vTaskDelay(1 / portTICK_PERIOD_MS);
-        else
-            vTaskDelay(3 / portTICK_PERIOD_MS);
-
         if (AFSKInitAct == true)
         {
+            AFSK_WaitForSamples(); // sleeps until the ADC callback reports a full block
             AFSK_Poll(false, LOW);
         }
+        else
+        {
+            vTaskDelay(10 / portTICK_PERIOD_MS);
+        }
     }
 }
 
@@ -8554,6 +8572,11 @@ void taskNetwork(void *pvParameters)
 #endif
         webService();
 
+    if (config.kiss_tcp_en)
+        kissTcpBegin(config.kiss_tcp_port);
+    if (config.agw_en)
+        agwTcpBegin(config.agw_port);
+
     // wireguard_ctx_t ctx = {0};
     esp_err_t err;
     // #ifdef PPPOS
@@ -8742,128 +8765,86 @@ void taskNetwork(void *pvParameters)
                 }
                 else
                 {
-                    if (aprsClient.available())
+                    // Lines are parsed where they were received, nothing is allocated for them
+                    size_t lineLen;
+                    char *line;
+                    static struct pbuf_t isPkt; // parsed once for the APRS-IS syntax filters, only used by this task
+                    inetAprsFiltersSync();
+                    for (int n = 0; (n < APRSIS_RX_BURST) && ((line = aprsIsRead(&lineLen)) != NULL); n++)
                     {
-                        pingTimeout = millis() + 300000;                // Reset ping timout
-                        String line = aprsClient.readStringUntil('\n'); // อ่านค่าที่ Server ตอบหลับมาทีละบรรทัด
+                        pingTimeout = millis() + 300000; // Reset ping timout
                         status.isCount++;
-                        int start_val = line.indexOf(">", 0); // หาตำแหน่งแรกของ >
-                        if (start_val > 3)
-                        {
-                            String src_call = line.substring(0, start_val);
-                            String msg_call = "::" + src_call;
+                        struct Tnc2View pkt;
+                        if (!Tnc2Parse(line, lineLen, &pkt) || (pkt.srcLen <= 3))
+                            continue; // server comment
 
-                            status.allCount++;
-                            igateTLM.RX++;
+                        status.allCount++;
+                        igateTLM.RX++;
+                        log_d("INET: %s\n", line);
+
+                        uint16_t type = pkgType(pkt.info);
+                        int8_t parsed = 0;
+                        if (type & FILTER_MESSAGE)
+                        {
+                            handleIncomingAPRS(String(line));
+                        }
+                        const char *dstssid = strchr(line + 1, '-'); // get SSID -
+                        if (dstssid == NULL)
+                            dstssid = strchr(line + 1, ' '); // get ssid space
+                        char ssid = (dstssid != NULL) ? dstssid[1] : 0;
 
-                            log_d("INET: %s\n", line.c_str());
-                            start_val = line.indexOf(":", 10); // Search of info in ax25
-                            if (start_val > 5)
+                        if (ssid > 47 && ssid < 58)
+                        {
+                            char call[15];
+                            memset(call, 0, sizeof(call));
+                            memcpy(call, pkt.src, pkt.srcLen);
+                            if ((type & config.dispFilter) && aprsFilterLine(&inetFilters.disp, &isPkt, &parsed, line, lineLen))
                             {
-                                String info = line.substring(start_val + 1);
-                                size_t rawSize = line.length();
-                                char *raw = (char *)calloc(rawSize + 1, sizeof(char));
-                                if (raw)
+                                int idx = pkgListUpdate(call, line, type, 1, 0);
+#if defined OLED || defined ST7735_160x80 || defined GUI_LCD
+                                if (idx > -1)
                                 {
-                                    memset(raw, 0, rawSize + 1);
-                                    memcpy(raw, info.c_str(), info.length());
-
-                                    uint16_t type = pkgType(&raw[0]);
-                                    if (type & FILTER_MESSAGE)
+                                    // Put queue affter filter for display popup
+                                    if (config.rx_display && config.dispINET && (type & config.dispFilter))
                                     {
-                                        handleIncomingAPRS(line);
+                                        #ifdef GUI_LCD
+                                        int cnt = pushTNC2Raw(idx);
+                                        log_d("INET_putQueueDisp:[pkgList_idx=%d/queue=%d,Type=%d] %s\n", idx, cnt, type, call);
+                                        #else
+                                        dispBuffer.push(line);
+                                        log_d("INET_putQueueDisp:[pkgList_idx=%d/queue=%d,Type=%d] %s\n", idx, dispBuffer.getCount(), type, call);
+                                        #endif
                                     }
-                                    int start_dstssid = line.indexOf("-", 1); // get SSID -
-                                    if (start_dstssid < 0)
-                                        start_dstssid = line.indexOf(" ", 1); // get ssid space
-                                    char ssid = 0;
-                                    if (start_dstssid > 0)
-                                        ssid = line.charAt(start_dstssid + 1);
-
-                                    if (ssid > 47 && ssid < 58)
-                                    {
-                                        size_t len = src_call.length();
-                                        char call[15];
-                                        memset(call, 0, sizeof(call));
-                                        if (len > 15)
-                                            len = 15;
-                                        memcpy(call, src_call.c_str(), len);
-                                        call[14] = 0;
-                                        memset(raw, 0, rawSize + 1);
-                                        memcpy(raw, line.c_str(), line.length());
-                                        if (type & config.dispFilter)
-                                        {
-                                            int idx = pkgListUpdate(call, raw, type, 1, 0);
-                                            // int cnt = 0;
-                                            // if (idx > -1)
-                                            // {
-                                            // // Put queue affter filter for display popup
-                                            // if (config.rx_display && config.dispINET)
-                                            // {
-                                            //     cnt = pushTNC2Raw(idx);
-                                            //     log_d("INET_putQueueDisp:[pkgList_idx=%d/queue=%d,Type=%d] %s\n", idx, cnt, type, call);
-                                            // }
-                                            // }
-
-#if defined OLED || defined ST7735_160x80 || defined GUI_LCD
-                                            if (idx > -1)
-                                            {
-                                                // Put queue affter filter for display popup
-                                                if (config.rx_display && config.dispINET && (type & config.dispFilter))
-                                                {
-                                                    #ifdef GUI_LCD
-                                                    int cnt = pushTNC2Raw(idx);
-                                                    log_d("INET_putQueueDisp:[pkgList_idx=%d/queue=%d,Type=%d] %s\n", idx, cnt, type, call);
-                                                    #else
-                                                    dispBuffer.push(line.c_str());
-                                                    log_d("INET_putQueueDisp:[pkgList_idx=%d/queue=%d,Type=%d] %s\n", idx, dispBuffer.getCount(), type, call);
-                                                    #endif
-                                                }
-                                            }
+                                }
 #endif
-                                        }
-                                        // INET2RF affter filter
-                                        if (config.inet2rf)
-                                        {
-                                            if (type & config.inet2rfFilter)
-                                            {
-                                                String tnc2Raw = "";
-                                                char *strtmp = (char *)calloc(350, sizeof(char));
-                                                if (strtmp)
-                                                {
-                                                    if (config.aprs_ssid == 0)
-                                                        sprintf(strtmp, "%s>APE32A", config.aprs_mycall);
-                                                    else
-                                                        sprintf(strtmp, "%s-%d>APE32A", config.aprs_mycall, config.aprs_ssid);
-                                                    tnc2Raw = String(strtmp);
-                                                    tnc2Raw += ",RFONLY"; // fix path to rf only not send loop to inet
-                                                    tnc2Raw += ":}";      // 3rd-party frame
-                                                    tnc2Raw += line;
-                                                    pkgTxPush(tnc2Raw.c_str(), tnc2Raw.length(), 0, RF_CHANNEL);
-                                                    char sts[50];
-                                                    sprintf(sts, "--SRC CALL--\n%s\n", src_call.c_str());
+                            }
+                            // INET2RF affter filter
+                            if (config.inet2rf && (type & config.inet2rfFilter) && aprsFilterLine(&inetFilters.inet2rf, &isPkt, &parsed, line, lineLen) &&
+                                !inet2rfDuplicate(line, lineLen))
+                            {
+                                static char tnc2Raw[TNC2_LINE_MAX + 32]; // only used by this task
+                                int len;
+                                // fix path to rf only not send loop to inet, 3rd-party frame
+                                if (config.aprs_ssid == 0)
+                                    len = snprintf(tnc2Raw, sizeof(tnc2Raw), "%s>APE32A,RFONLY:}%s", config.aprs_mycall, line);
+                                else
+                                    len = snprintf(tnc2Raw, sizeof(tnc2Raw), "%s-%d>APE32A,RFONLY:}%s", config.aprs_mycall, config.aprs_ssid, line);
+                                if (len >= (int)sizeof(tnc2Raw))
+                                    len = sizeof(tnc2Raw) - 1;
+                                pkgTxPush(tnc2Raw, len, 0, RF_CHANNEL, TX_PRIO_MSG);
+                                char sts[50];
+                                snprintf(sts, sizeof(sts), "--SRC CALL--\n%s\n", call);
 #if defined OLED || defined ST7735_160x80 || defined GUI_LCD
-                                                    if (config.oled_enable)
-                                                        pushTxDisp(TXCH_3PTY, "TX INET->RF", sts);
-#endif
-                                                    status.inet2rf++;
-                                                    igateTLM.INET2RF++;
-                                                    log_d("INET2RF: %s\n", line);
-                                                    free(strtmp);
-                                                }
-                                                tnc2Raw.clear();
-                                            }
-                                        }
-                                    }
-                                    free(raw);
-                                }
-                                info.clear();
+                                if (config.oled_enable)
+                                    pushTxDisp(TXCH_3PTY, "TX INET->RF", sts);
+#endif
+                                status.inet2rf++;
+                                igateTLM.INET2RF++;
+                                log_d("INET2RF: %s\n", line);
                             }
-                            src_call.clear();
-                            msg_call.clear();
                         }
-                        line.clear();
                     }
+                    aprsIsFlush(); // lines queued by every task since the last loop, in one write
                 }
             }
 
@@ -9529,13 +9510,7 @@ void dispWindow(String line, uint8_t mode, bool filter)
             if (aprs.packettype & T_TELEMETRY)
             {
                 bool show = false;
-                int idx = tlmList_Find((char *)src_call.c_str());
-                if (idx < 0)
-                {
-                    idx = tlmListOld();
-                    if (idx > -1)
-                        memset(&Telemetry[idx], 0, sizeof(Telemetry_struct));
-                }
+                int idx = tlmListUpdate(src_call.c_str());
                 if (idx > -1)
                 {
                     Telemetry[idx].time = now();
@@ -10087,13 +10062,7 @@ void dispWindow(String line, uint8_t mode, bool filter)
             if (aprs.packettype & T_TELEMETRY)
             {
                 bool show = false;
-                int idx = tlmList_Find((char *)src_call.c_str());
-                if (idx < 0)
-                {
-                    idx = tlmListOld();
-                    if (idx > -1)
-                        memset(&Telemetry[idx], 0, sizeof(Telemetry_struct));
-                }
+                int idx = tlmListUpdate(src_call.c_str());
                 if (idx > -1)
                 {
                     Telemetry[idx].time = now();
@@ -10668,13 +10637,7 @@ void dispWindow(String line, uint8_t mode, bool filter)
             if (aprs.packettype & T_TELEMETRY)
             {
                 bool show = false;
-                int idx = tlmList_Find((char *)src_call.c_str());
-                if (idx < 0)
-                {
-                    idx = tlmListOld();
-                    if (idx > -1)
-                        memset(&Telemetry[idx], 0, sizeof(Telemetry_struct));
-                }
+                int idx = tlmListUpdate(src_call.c_str());
                 if (idx > -1)
                 {
                     Telemetry[idx].time = now();
@@ -11367,7 +11330,8 @@ void pkgLastDisp()
 {
 
     uint8_t k = 0;
-    int i;
+    int i, n;
+    int view[PKGLISTSIZE];
     // char list[4];
     int x, y;
     String str;
@@ -11381,18 +11345,18 @@ void pkgLastDisp()
     display.setCursor(15, 1);
     display.print("STATION");
     display.setTextColor(WHITE);
-    sort(pkgList, PKGLISTSIZE);
+    n = pkgListView(view, PKGLISTSIZE, STATIONDB_RECENT);
     k = 0;
-    for (i = 0; i < PKGLISTSIZE; i++)
+    for (i = 0; i < n; i++)
     {
-        if (pkgList[i].time > 0)
+        if (pkgList[view[i]].time > 0)
         {
             y = 12 + (k * 9);
             display.setCursor(0, y);
-            pkgList[i].calsign[10] = 0;
+            pkgList[view[i]].calsign[10] = 0;
             display.setTextColor(WHITE);
             display.setCursor(0, y);
-            display.printf("%d:%s", i + 1, pkgList[i].calsign);
+            display.printf("%d:%s", i + 1, pkgList[view[i]].calsign);
             k++;
             if (k >= 3)
                 break;
@@ -11425,19 +11389,19 @@ void pkgLastDisp()
     // display.print("2/5");
     // display.setTextColor(WHITE);
 
-    sort(pkgList, PKGLISTSIZE);
+    n = pkgListView(view, PKGLISTSIZE, STATIONDB_RECENT);
     k = 0;
-    for (i = 0; i < PKGLISTSIZE; i++)
+    for (i = 0; i < n; i++)
     {
-        if (pkgList[i].time > 0)
+        if (pkgList[view[i]].time > 0)
         {
             y = 18 + (k * 9);
             // display.drawBitmap(3, y, &SYMBOL[0][0], 11, 6, WHITE);
             display.fillRoundRect(2, y, 7, 8, 2, WHITE);
             display.setCursor(3, y);
-            pkgList[i].calsign[10] = 0;
+            pkgList[view[i]].calsign[10] = 0;
             display.setTextColor(BLACK);
-            switch (pkgList[i].type)
+            switch (pkgList[view[i]].type)
             {
             case PKG_OBJECT:
                 display.print("O");
@@ -11466,13 +11430,13 @@ void pkgLastDisp()
             }
             display.setTextColor(WHITE);
             display.setCursor(10, y);
-            display.print(pkgList[i].calsign);
+            display.print(pkgList[view[i]].calsign);
             display.setCursor(126 - 48, y);
             // display.printf("%02d:%02d:%02d", hour(pkgList[i].time), minute(pkgList[i].time), second(pkgList[i].time));
 
             // time_t tm = pkgList[i].time;
             struct tm tmstruct;
-            localtime_r(&pkgList[i].time, &tmstruct);
+            localtime_r(&pkgList[view[i]].time, &tmstruct);
             String str = String(tmstruct.tm_hour, DEC) + ":" + String(tmstruct.tm_min, DEC) + ":" + String(tmstruct.tm_sec, DEC);
             display.print(str);
             // str = String(hour(pkgList[i].time),DEC) + ":" + String(minute(pkgList[i].time), DEC) + ":" + String(second(pkgList[i].time), DEC);
@@ -11502,19 +11466,19 @@ void pkgLastDisp()
     display.print("2");
     display.setTextColor(WHITE);
 
-    sort(pkgList, PKGLISTSIZE);
+    n = pkgListView(view, PKGLISTSIZE, STATIONDB_RECENT);
     k = 0;
-    for (i = 0; i < PKGLISTSIZE; i++)
+    for (i = 0; i < n; i++)
     {
-        if (pkgList[i].time > 0)
+        if (pkgList[view[i]].time > 0)
         {
             y = 18 + (k * 10);
             // display.drawBitmap(3, y, &SYMBOL[0][0], 11, 6, WHITE);
             display.fillRoundRect(2, y, 7, 8, 2, WHITE);
             display.setCursor(3, y);
-            pkgList[i].calsign[10] = 0;
+            pkgList[view[i]].calsign[10] = 0;
             display.setTextColor(BLACK);
-            switch (pkgList[i].type)
+            switch (pkgList[view[i]].type)
             {
             case PKG_OBJECT:
                 display.print("O");
@@ -11543,11 +11507,11 @@ void pkgLastDisp()
             }
             display.setTextColor(WHITE);
             display.setCursor(12, y);
-            display.print(pkgList[i].calsign);
+            display.print(pkgList[view[i]].calsign);
             display.setCursor(158 - 48, y);
 
             struct tm tmstruct;
-            localtime_r(&pkgList[i].time, &tmstruct);
+            localtime_r(&pkgList[view[i]].time, &tmstruct);
             String str = String(tmstruct.tm_hour, DEC) + ":" + String(tmstruct.tm_min, DEC) + ":" + String(tmstruct.tm_sec, DEC);
             display.print(str);
             k++;
@@ -11564,7 +11528,8 @@ void pkgCountDisp()
 
     // uint8 wifi = 0, k = 0, l;
     uint k = 0;
-    int i;
+    int i, n;
+    int view[PKGLISTSIZE];
     // char list[4];
     int x, y;
     String str;
@@ -11578,18 +11543,18 @@ void pkgCountDisp()
     display.setCursor(15, 1);
     display.print("TOP PKG");
     display.setTextColor(WHITE);
-    sortPkgDesc(pkgList, PKGLISTSIZE);
+    n = pkgListView(view, PKGLISTSIZE, STATIONDB_COUNT);
     k = 0;
-    for (i = 0; i < PKGLISTSIZE; i++)
+    for (i = 0; i < n; i++)
     {
-        if (pkgList[i].time > 0)
+        if (pkgList[view[i]].time > 0)
         {
             y = 12 + (k * 9);
             display.setCursor(0, y);
-            pkgList[i].calsign[10] = 0;
+            pkgList[view[i]].calsign[10] = 0;
             display.setTextColor(WHITE);
             display.setCursor(0, y);
-            display.printf("%d:%s", i + 1, pkgList[i].calsign);
+            display.printf("%d:%s", i + 1, pkgList[view[i]].calsign);
             k++;
             if (k >= 3)
                 break;
@@ -11624,20 +11589,20 @@ void pkgCountDisp()
     // display.print("3/5");
     // display.setTextColor(WHITE);
 
-    sortPkgDesc(pkgList, PKGLISTSIZE);
+    n = pkgListView(view, PKGLISTSIZE, STATIONDB_COUNT);
     k = 0;
-    for (i = 0; i < PKGLISTSIZE; i++)
+    for (i = 0; i < n; i++)
     {
-        if (pkgList[i].time > 0)
+        if (pkgList[view[i]].time > 0)
         {
             y = 18 + (k * 9);
             // display.drawBitmapV(2, y-1, &SYMBOL[pkgList[i].symbol][0], 11, 8, WHITE);
-            pkgList[i].calsign[10] = 0;
+            pkgList[view[i]].calsign[10] = 0;
             display.fillRoundRect(2, y, 7, 8, 2, WHITE);
             display.setCursor(3, y);
-            pkgList[i].calsign[10] = 0;
+            pkgList[view[i]].calsign[10] = 0;
             display.setTextColor(BLACK);
-            switch (pkgList[i].type)
+            switch (pkgList[view[i]].type)
             {
             case PKG_OBJECT:
                 display.print("O");
@@ -11666,8 +11631,8 @@ void pkgCountDisp()
             }
             display.setTextColor(WHITE);
             display.setCursor(10, y);
-            display.print(pkgList[i].calsign);
-            str = String(pkgList[i].pkg, DEC);
+            display.print(pkgList[view[i]].calsign);
+            str = String(pkgList[view[i]].pkg, DEC);
             x = str.length() * 6;
             display.setCursor(126 - x, y);
             display.print(str);
@@ -11693,20 +11658,20 @@ void pkgCountDisp()
     display.print("3");
     display.setTextColor(WHITE);
 
-    sortPkgDesc(pkgList, PKGLISTSIZE);
+    n = pkgListView(view, PKGLISTSIZE, STATIONDB_COUNT);
     k = 0;
-    for (i = 0; i < PKGLISTSIZE; i++)
+    for (i = 0; i < n; i++)
     {
-        if (pkgList[i].time > 0)
+        if (pkgList[view[i]].time > 0)
         {
             y = 18 + (k * 10);
             // display.drawBitmapV(2, y-1, &SYMBOL[pkgList[i].symbol][0], 11, 8, WHITE);
-            pkgList[i].calsign[10] = 0;
+            pkgList[view[i]].calsign[10] = 0;
             display.fillRoundRect(2, y, 7, 8, 2, WHITE);
             display.setCursor(3, y);
-            pkgList[i].calsign[10] = 0;
+            pkgList[view[i]].calsign[10] = 0;
             display.setTextColor(BLACK);
-            switch (pkgList[i].type)
+            switch (pkgList[view[i]].type)
             {
             case PKG_OBJECT:
                 display.print("O");
@@ -11735,8 +11700,8 @@ void pkgCountDisp()
             }
             display.setTextColor(WHITE);
             display.setCursor(10, y);
-            display.print(pkgList[i].calsign);
-            str = String(pkgList[i].pkg, DEC);
+            display.print(pkgList[view[i]].calsign);
+            str = String(pkgList[view[i]].pkg, DEC);
             x = str.length() * 6;
             display.setCursor(158 - x, y);
             display.print(str);
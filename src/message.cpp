@@ -236,55 +236,35 @@ String aesDecryptBase64WithIV(const String &b64, const uint8_t key[16], const ch
     return result;
 }
 
-void pkgMsgSort(msgType a[])
+// Messages are found by callsign, ID and direction, the least recently updated one makes room
+static struct StationDb msgIndex = StationDbInit(PKGLISTSIZE);
+
+static size_t pkgMsgKey(char *key, const char *call, uint16_t msgID, bool rxtx)
 {
-    msgType t;
-    char *ptr1;
-    char *ptr2;
-    char *ptr3;
-    ptr1 = (char *)&t;
-psramLock();
-    for (int i = 0; i < (PKGLISTSIZE - 1); i++)
-    {
-        for (int o = 0; o < (PKGLISTSIZE - (i + 1)); o++)
-        {
-            if (a[o].time > a[o + 1].time)
-            {
-                ptr2 = (char *)&a[o];
-                ptr3 = (char *)&a[o + 1];
-                memcpy(ptr1, ptr2, sizeof(msgType));
-                memcpy(ptr2, ptr3, sizeof(msgType));
-                memcpy(ptr3, ptr1, sizeof(msgType));
-            }
-        }
-    }
-    psramUnlock();
+    size_t n = strnlen(call, 10);
+    memcpy(key, call, n);
+    key[n++] = msgID & 0xFF;
+    key[n++] = msgID >> 8;
+    key[n++] = rxtx;
+    return n;
 }
 
-int pkgMsg_Find(const char *call, uint16_t msgID, bool rxtx)
+// Fill idx with up to max msgQueue slots, oldest update first, returns how many
+int pkgMsgView(int *idx, int max)
 {
-    int i;
-    for (i = 0; i < PKGLISTSIZE; i++)
-    {
-        if ((strstr(msgQueue[(int)i].callsign, call) != NULL) && (msgQueue[(int)i].msgID == msgID) && (msgQueue[(int)i].rxtx == rxtx))
-            return i;
-    }
-    return -1;
+    int n = 0;
+    psramLock();
+    for (uint16_t i = StationDbFirst(&msgIndex, STATIONDB_OLDEST); (i != STATIONDB_NONE) && (n < max); i = StationDbNext(&msgIndex, i, STATIONDB_OLDEST))
+        idx[n++] = i;
+    psramUnlock();
+    return n;
 }
 
-int pkgMsgOld()
+int pkgMsg_Find(const char *call, uint16_t msgID, bool rxtx)
 {
-    int i, ret = -1;
-    time_t minimum = time(NULL) + 86400; // pkgList[0].time;
-    for (i = 0; i < PKGLISTSIZE; i++)
-    {
-        if (msgQueue[(int)i].time < minimum)
-        {
-            minimum = msgQueue[(int)i].time;
-            ret = i;
-        }
-    }
-    return ret;
+    char key[STATIONDB_KEY_MAX];
+    uint16_t i = StationDbFind(&msgIndex, key, pkgMsgKey(key, call, msgID, rxtx));
+    return (i != STATIONDB_NONE) ? i : -1;
 }
 
 msgType getMsgList(int idx)
@@ -292,8 +272,11 @@ msgType getMsgList(int idx)
     msgType ret;
     psramLock();
     memset(&ret, 0, sizeof(msgType));
-    if (idx < PKGLISTSIZE)
+    if ((idx >= 0) && (idx < PKGLISTSIZE))
+    {
         memcpy(&ret, &msgQueue[idx], sizeof(msgType));
+        pktBufRef(ret.text); // shared, given back with pktBufRelease()
+    }
     psramUnlock();
     return ret;
 }
@@ -320,18 +303,21 @@ int pkgMsgUpdate(const char *call, const char *raw, uint16_t msg_id, int8_t ack,
     int i = -1;
     // if (ack > 0) // Check ACK to update
     //{
-    i = pkgMsg_Find(call, msg_id, rxtx);
+    i = pkgMsg_Find(callsign, msg_id, rxtx);
     //}
 
     if (i < 0)
     {
-        i = pkgMsgOld(); // Search free in array
-        if (i > PKGLISTSIZE || i < 0)
+        char key[STATIONDB_KEY_MAX];
+        uint16_t slot = StationDbAdd(&msgIndex, key, pkgMsgKey(key, callsign, msg_id, rxtx));
+        if (slot == STATIONDB_NONE)
         {
             psramUnlock();
             return -1;
         }
+        i = slot;
     }
+    StationDbTouch(&msgIndex, i);
 
     msgQueue[i].time = time(NULL);
     msgQueue[i].msgID = msg_id;
@@ -343,21 +329,10 @@ int pkgMsgUpdate(const char *call, const char *raw, uint16_t msg_id, int8_t ack,
     memcpy(msgQueue[i].callsign, callsign, strlen(callsign));
     len = strlen(raw);
     msgQueue[i].length = len + 1;
-    if (msgQueue[i].text != NULL)
-    {
-        msgQueue[i].text = (char *)realloc(msgQueue[i].text, msgQueue[i].length);
-        log_d("Realloc: msgQueue[%d] callsign:%s msgID:%d ack:%i", i, callsign, msg_id, ack);
-    }
-    else
-    {
-        msgQueue[i].text = (char *)calloc(msgQueue[i].length, sizeof(char));
-        log_d("Calloc: msgQueue[%d] callsign:%s msgID:%d ack:%i", i, callsign, msg_id, ack);
-    }
+    pktBufRelease(msgQueue[i].text); // readers holding the old text keep it until they release it
+    msgQueue[i].text = pktBufDup(raw, len);
     if (msgQueue[i].text)
     {
-        memset(msgQueue[i].text, 0, msgQueue[i].length);
-        memcpy(msgQueue[i].text, raw, len);
-        //msgQueue[i].text[len] = 0;
         log_d("New: msgQueue[%d] callsign:%s msgID:%d ack:%i", i, msgQueue[i].callsign, msgQueue[i].msgID, msgQueue[i].ack);
     }
     //}
@@ -426,7 +401,7 @@ void sendAPRSMessage(const String &toCall, const String &message, bool encrypt)
         SendMode |= RF_CHANNEL;
     if (config.msg_inet)
         SendMode |= INET_CHANNEL;
-    pkgTxPush(packet.c_str(), packet.length(), 0, SendMode);
+    pkgTxPush(packet.c_str(), packet.length(), 0, SendMode, TX_PRIO_MSG);
     log_d("Send APRS Message to %s msgID %d TNC2: %s", toCall.c_str(), msgID, packet.c_str());
     if (config.msg_retry == 0)
         pkgMsgUpdate(toCall.c_str(), message.c_str(), msgID, -2, false); // -2=No retry
@@ -480,7 +455,7 @@ void sendAPRSMessageRetry()
                 SendMode |= RF_CHANNEL;
             if (config.msg_inet)
                 SendMode |= INET_CHANNEL;
-            pkgTxPush(packet.c_str(), packet.length(), 0, SendMode);
+            pkgTxPush(packet.c_str(), packet.length(), 0, SendMode, TX_PRIO_MSG);
             log_d("Retry APRS Message msgQueue[%i] to %s msgID %d ack left %i TNC2: %s", i, msgQueue[i].callsign, msgQueue[i].msgID, msgQueue[i].ack, packet.c_str());
             //pkgMsgUpdate(msgQueue[i].callsign, msgQueue[i].text, msgQueue[i].msgID, msgQueue[i].ack);
             // log_d(">> " + packet);
@@ -515,7 +490,7 @@ void sendAPRSAck(const String &toCall, const String &msgNo)
         SendMode |= RF_CHANNEL;
     if (config.msg_inet)
         SendMode |= INET_CHANNEL;
-    pkgTxPush(packet.c_str(), packet.length(), 0, SendMode);
+    pkgTxPush(packet.c_str(), packet.length(), 0, SendMode, TX_PRIO_MSG);
     log_d("Send APRS ACK to %s msgNo %s TNC2: %s", toCall.c_str(), msgNo.c_str(), packet.c_str());
 }
 
@@ -0,0 +1,170 @@
+#include "pktbuf.h"
+
+// Each class is one block of equal buffers with a free list. A buffer is preceded by its
+// header, so a holder only keeps the text pointer. References are counted, the station
+// list, the web pages and the RX path share one copy of a packet instead of each
+// allocating its own.
+#define PKTBUF_NONE 0xFFFF
+
+typedef struct
+{
+    uint16_t refs; // holders, free when 0
+    uint16_t next; // free list
+    uint8_t cls;
+    uint8_t reserved[3];
+} pktBufHeader;
+
+typedef struct
+{
+    uint8_t *base;
+    size_t stride; // header and buffer, a multiple of 4
+    uint16_t freeList;
+    pktPoolStats stats;
+} pktClass;
+
+static const uint16_t classSize[PKTBUF_CLASSES] = {PACKETLEN_MAX_SMALL, PACKETLEN_MAX_MEDIUM, PACKETLEN_MAX_LARGE};
+static pktClass classes[PKTBUF_CLASSES];
+static portMUX_TYPE poolMux = portMUX_INITIALIZER_UNLOCKED;
+
+static inline pktBufHeader *headerOf(const char *buf)
+{
+    return (pktBufHeader *)(buf - sizeof(pktBufHeader));
+}
+
+static inline pktBufHeader *headerAt(pktClass *c, uint16_t idx)
+{
+    return (pktBufHeader *)(c->base + idx * c->stride);
+}
+
+bool pktPoolInit(const uint16_t counts[PKTBUF_CLASSES])
+{
+    bool ok = true;
+    for (uint8_t k = 0; k < PKTBUF_CLASSES; k++)
+    {
+        pktClass *c = &classes[k];
+        if (c->base != NULL)
+            continue;
+        memset(c, 0, sizeof(pktClass));
+        c->stride = (sizeof(pktBufHeader) + classSize[k] + 3) & ~3;
+        c->freeList = PKTBUF_NONE;
+        c->stats.size = classSize[k];
+        if (counts[k] == 0)
+            continue;
+#ifdef BOARD_HAS_PSRAM
+        c->base = (uint8_t *)ps_calloc(counts[k], c->stride);
+        if (c->base == NULL) // no PSRAM found, fall back to internal RAM
+#endif
+            c->base = (uint8_t *)calloc(counts[k], c->stride);
+        if (c->base == NULL)
+        {
+            log_e("Packet buffer class %d: %d x %d bytes allocation failed", k, counts[k], classSize[k]);
+            ok = false;
+            continue;
+        }
+        c->stats.count = counts[k];
+        for (uint16_t i = 0; i < counts[k]; i++)
+        {
+            pktBufHeader *h = headerAt(c, i);
+            h->cls = k;
+            h->next = (i + 1 < counts[k]) ? i + 1 : PKTBUF_NONE;
+        }
+        c->freeList = 0;
+    }
+    return ok;
+}
+
+char *pktBufAlloc(size_t len)
+{
+    uint8_t want = 0;
+    while ((want < PKTBUF_CLASSES) && (len + 1 > classSize[want]))
+        want++;
+    if (want == PKTBUF_CLASSES)
+        return NULL;
+
+    char *buf = NULL;
+    portENTER_CRITICAL(&poolMux);
+    for (uint8_t k = want; k < PKTBUF_CLASSES; k++)
+    {
+        pktClass *c = &classes[k];
+        if (c->freeList == PKTBUF_NONE)
+            continue;
+        pktBufHeader *h = headerAt(c, c->freeList);
+        c->freeList = h->next;
+        h->refs = 1;
+        c->stats.allocs++;
+        if (k != want)
+            c->stats.spills++;
+        if (++c->stats.used > c->stats.peak)
+            c->stats.peak = c->stats.used;
+        buf = (char *)(h + 1);
+        break;
+    }
+    if (buf == NULL)
+        classes[want].stats.fails++;
+    portEXIT_CRITICAL(&poolMux);
+    return buf;
+}
+
+char *pktBufDup(const char *data, size_t len)
+{
+    char *buf = pktBufAlloc(len);
+    if (buf != NULL)
+    {
+        memcpy(buf, data, len);
+        buf[len] = 0;
+    }
+    return buf;
+}
+
+char *pktBufRef(char *buf)
+{
+    if (buf == NULL)
+        return NULL;
+    portENTER_CRITICAL(&poolMux);
+    headerOf(buf)->refs++;
+    portEXIT_CRITICAL(&poolMux);
+    return buf;
+}
+
+void pktBufRelease(char *buf)
+{
+    if (buf == NULL)
+        return;
+    pktBufHeader *h = headerOf(buf);
+    portENTER_CRITICAL(&poolMux);
+    if ((h->refs > 0) && (--h->refs == 0))
+    {
+        pktClass *c = &classes[h->cls];
+        h->next = c->freeList;
+        c->freeList = ((uint8_t *)h - c->base) / c->stride;
+        c->stats.used--;
+    }
+    portEXIT_CRITICAL(&poolMux);
+}
+
+bool pktBufOwns(const char *buf)
+{
+    for (uint8_t k = 0; k < PKTBUF_CLASSES; k++)
+    {
+        const pktClass *c = &classes[k];
+        if ((c->base == NULL) || ((const uint8_t *)buf < c->base))
+            continue;
+        size_t offset = (const uint8_t *)buf - c->base;
+        if ((offset < c->stats.count * c->stride) && ((offset % c->stride) == sizeof(pktBufHeader)))
+            return true;
+    }
+    return false;
+}
+
+size_t pktBufSize(const char *buf)
+{
+    return classSize[headerOf(buf)->cls];
+}
+
+void pktPoolGetStats(pktPoolStats stats[PKTBUF_CLASSES])
+{
+    portENTER_CRITICAL(&poolMux);
+    for (uint8_t k = 0; k < PKTBUF_CLASSES; k++)
+        stats[k] = classes[k].stats;
+    portEXIT_CRITICAL(&poolMux);
+}
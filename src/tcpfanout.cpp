@@ -0,0 +1,248 @@
+#include "tcpfanout.h"
+#include <AsyncTCP.h>
+
+static void messageRelease(tcpFanout *f, uint8_t idx)
+{
+    if (f->messages[idx].refs > 0)
+        f->messages[idx].refs--;
+}
+
+// Write queued messages while the socket has room, the caller holds the lock
+static void clientFlush(tcpFanout *f, tcpFanoutClient *c)
+{
+    bool added = false;
+    while ((c->count > 0) && !c->drop)
+    {
+        tcpFanoutMessage *m = &f->messages[c->queue[c->head]];
+        size_t room = c->client->space();
+        if (room == 0)
+            break;
+        size_t len = m->length - c->offset;
+        if (len > room)
+            len = room;
+        size_t n = c->client->add((const char *)&m->data[c->offset], len);
+        if (n == 0)
+            break;
+        added = true;
+        c->offset += n;
+        if (c->offset >= m->length)
+        {
+            messageRelease(f, c->queue[c->head]);
+            c->head = (c->head + 1) % f->cfg.queueLen;
+            c->count--;
+            c->offset = 0;
+        }
+    }
+    if (added)
+        c->client->send();
+}
+
+// Give back every message still queued for a client, the caller holds the lock
+static void clientClear(tcpFanout *f, tcpFanoutClient *c)
+{
+    while (c->count > 0)
+    {
+        messageRelease(f, c->queue[c->head]);
+        c->head = (c->head + 1) % f->cfg.queueLen;
+        c->count--;
+    }
+    c->offset = 0;
+}
+
+// A client that stopped reading is closed by the TCP task, its messages are given back now
+// so that it does not hold pool buffers until then
+static void clientDrop(tcpFanout *f, tcpFanoutClient *c)
+{
+    c->drop = true;
+    clientClear(f, c);
+    f->slow++;
+}
+
+static void onAck(void *arg, AsyncClient *client, size_t len, uint32_t time)
+{
+    tcpFanoutClient *c = (tcpFanoutClient *)arg;
+    tcpFanoutLock(c->server);
+    if (c->client == client)
+        clientFlush(c->server, c);
+    tcpFanoutUnlock(c->server);
+}
+
+// Clients marked as slow are closed here, in the TCP task like all their other callbacks
+static void onPoll(void *arg, AsyncClient *client)
+{
+    tcpFanoutClient *c = (tcpFanoutClient *)arg;
+    if (c->drop)
+        client->close();
+}
+
+static void onData(void *arg, AsyncClient *client, void *data, size_t len)
+{
+    tcpFanoutClient *c = (tcpFanoutClient *)arg;
+    tcpFanout *f = c->server;
+    // only this client's callbacks touch its state in the server
+    if (f->cfg.onData != NULL)
+        f->cfg.onData(f->cfg.arg, c->slot, (const uint8_t *)data, len);
+}
+
+static void onDisconnect(void *arg, AsyncClient *client)
+{
+    tcpFanoutClient *c = (tcpFanoutClient *)arg;
+    if (c != NULL)
+    {
+        tcpFanout *f = c->server;
+        tcpFanoutLock(f);
+        if (c->client == client)
+        {
+            clientClear(f, c);
+            c->client = NULL;
+            f->clientCount--;
+        }
+        tcpFanoutUnlock(f);
+        log_d("%s client %s disconnected", f->cfg.name, client->remoteIP().toString().c_str());
+    }
+    delete client;
+}
+
+static void onClient(void *arg, AsyncClient *client)
+{
+    tcpFanout *f = (tcpFanout *)arg;
+    tcpFanoutClient *c = NULL;
+    tcpFanoutLock(f);
+    for (uint8_t i = 0; i < f->cfg.maxClients; i++)
+    {
+        if (f->clients[i].client == NULL)
+        {
+            c = &f->clients[i];
+            c->client = client;
+            c->head = 0;
+            c->count = 0;
+            c->offset = 0;
+            c->drop = false;
+            if (f->cfg.onConnect != NULL)
+                f->cfg.onConnect(f->cfg.arg, i);
+            f->clientCount++;
+            f->accepted++;
+            break;
+        }
+    }
+    if (c == NULL)
+        f->refused++;
+    tcpFanoutUnlock(f);
+
+    client->onDisconnect(onDisconnect, c);
+    if (c == NULL)
+    {
+        log_w("%s client %s refused, %d clients connected", f->cfg.name, client->remoteIP().toString().c_str(), f->cfg.maxClients);
+        client->close(true);
+        return;
+    }
+    client->onData(onData, c);
+    client->onAck(onAck, c);
+    client->onPoll(onPoll, c);
+    client->setNoDelay(true);
+    log_d("%s client %s connected", f->cfg.name, client->remoteIP().toString().c_str());
+}
+
+bool tcpFanoutBegin(tcpFanout *f, const tcpFanoutConfig *cfg, uint16_t port)
+{
+    if (f->server != NULL)
+        return true;
+    if ((cfg->maxClients == 0) || (cfg->queueLen == 0) || (cfg->queueLen > TCP_FANOUT_QUEUE_MAX))
+        return false;
+    memcpy(&f->cfg, cfg, sizeof(tcpFanoutConfig));
+    if (f->mutex == NULL)
+        f->mutex = xSemaphoreCreateMutex();
+    uint8_t *data = NULL;
+#ifdef BOARD_HAS_PSRAM
+    f->messages = (tcpFanoutMessage *)ps_calloc(cfg->messages, sizeof(tcpFanoutMessage));
+    f->clients = (tcpFanoutClient *)ps_calloc(cfg->maxClients, sizeof(tcpFanoutClient));
+    data = (uint8_t *)ps_calloc(cfg->messages, cfg->messageSize);
+#else
+    f->messages = (tcpFanoutMessage *)calloc(cfg->messages, sizeof(tcpFanoutMessage));
+    f->clients = (tcpFanoutClient *)calloc(cfg->maxClients, sizeof(tcpFanoutClient));
+    data = (uint8_t *)calloc(cfg->messages, cfg->messageSize);
+#endif
+    if ((f->messages == NULL) || (f->clients == NULL) || (data == NULL) || (f->mutex == NULL))
+    {
+        free(f->messages);
+        free(f->clients);
+        free(data);
+        f->messages = NULL;
+        f->clients = NULL;
+        log_e("%s allocation failed", cfg->name);
+        return false;
+    }
+    for (uint8_t i = 0; i < cfg->messages; i++)
+        f->messages[i].data = &data[i * cfg->messageSize];
+    for (uint8_t i = 0; i < cfg->maxClients; i++)
+    {
+        f->clients[i].server = f;
+        f->clients[i].slot = i;
+    }
+    f->clientCount = 0;
+    f->accepted = 0;
+    f->refused = 0;
+    f->slow = 0;
+    f->server = new AsyncServer(port);
+    f->server->onClient(onClient, f);
+    f->server->begin();
+    log_d("%s server on port %d", cfg->name, port);
+    return true;
+}
+
+void tcpFanoutLock(tcpFanout *f)
+{
+    if (f->mutex != NULL)
+        xSemaphoreTake(f->mutex, portMAX_DELAY);
+}
+
+void tcpFanoutUnlock(tcpFanout *f)
+{
+    if (f->mutex != NULL)
+        xSemaphoreGive(f->mutex);
+}
+
+tcpFanoutMessage *tcpFanoutAlloc(tcpFanout *f)
+{
+    for (uint8_t i = 0; i < f->cfg.messages; i++)
+    {
+        tcpFanoutMessage *m = &f->messages[i];
+        if (m->refs == 0)
+        {
+            m->refs = 1;
+            m->length = 0;
+            return m;
+        }
+    }
+    return NULL;
+}
+
+void tcpFanoutRelease(tcpFanout *f, tcpFanoutMessage *m)
+{
+    if (m != NULL)
+        messageRelease(f, m - f->messages);
+}
+
+bool tcpFanoutActive(const tcpFanout *f, uint8_t slot)
+{
+    return (f->clients != NULL) && (slot < f->cfg.maxClients) && (f->clients[slot].client != NULL) && !f->clients[slot].drop;
+}
+
+bool tcpFanoutQueue(tcpFanout *f, uint8_t slot, tcpFanoutMessage *m)
+{
+    if (!tcpFanoutActive(f, slot) || (m->length == 0))
+        return false;
+    tcpFanoutClient *c = &f->clients[slot];
+    if (c->count >= f->cfg.queueLen)
+    {
+        // the client stopped reading, it must not hold the sender back
+        clientDrop(f, c);
+        log_w("%s client %s dropped, not reading", f->cfg.name, c->client->remoteIP().toString().c_str());
+        return false;
+    }
+    c->queue[(c->head + c->count) % f->cfg.queueLen] = m - f->messages;
+    c->count++;
+    m->refs++;
+    clientFlush(f, c);
+    return true;
+}
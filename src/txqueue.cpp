@@ -0,0 +1,331 @@
+#include "txqueue.h"
+#include "main.h"
+
+// A packet waits in one slot, shared by every channel it is queued for.
+// Each channel keeps one min-heap per priority class, ordered by due time
+// and then by arrival, holding the slot numbers.
+typedef struct
+{
+    uint8_t channels; // channels still to send, the slot is free when 0
+    uint8_t prio;
+    uint16_t length;
+    uint32_t seq; // arrival order, also tells a re-used slot apart
+    char info[TX_QUEUE_INFO_SIZE + 1];
+} txSlot;
+
+typedef struct
+{
+    uint32_t due;
+    uint32_t seq;
+    uint8_t slot;
+} txEntry;
+
+typedef struct
+{
+    txEntry *entry;
+    uint16_t count;
+} txHeap;
+
+static txSlot *slots = NULL;
+static txEntry *entries = NULL;
+static txHeap heaps[TX_QUEUE_CHANNELS][TX_PRIO_COUNT];
+static uint16_t slotCount = 0;
+static uint16_t slotUsed = 0;
+static uint16_t slotPeak = 0;
+static uint32_t seqNext = 0;
+static txQueueClassStats classStats[TX_PRIO_COUNT];
+static SemaphoreHandle_t txQueueMutex = NULL;
+
+static inline bool entryBefore(const txEntry *a, const txEntry *b)
+{
+    if (a->due != b->due)
+        return (int32_t)(a->due - b->due) < 0;
+    return (int32_t)(a->seq - b->seq) < 0;
+}
+
+static void heapSiftUp(txHeap *h, uint16_t i)
+{
+    txEntry e = h->entry[i];
+    while (i > 0)
+    {
+        uint16_t parent = (i - 1) / 2;
+        if (!entryBefore(&e, &h->entry[parent]))
+            break;
+        h->entry[i] = h->entry[parent];
+        i = parent;
+    }
+    h->entry[i] = e;
+}
+
+static void heapSiftDown(txHeap *h, uint16_t i)
+{
+    txEntry e = h->entry[i];
+    for (;;)
+    {
+        uint16_t child = 2 * i + 1;
+        if (child >= h->count)
+            break;
+        if ((child + 1 < h->count) && entryBefore(&h->entry[child + 1], &h->entry[child]))
+            child++;
+        if (!entryBefore(&h->entry[child], &e))
+            break;
+        h->entry[i] = h->entry[child];
+        i = child;
+    }
+    h->entry[i] = e;
+}
+
+static void heapRemoveAt(txHeap *h, uint16_t i)
+{
+    h->count--;
+    if (i == h->count)
+        return;
+    h->entry[i] = h->entry[h->count];
+    if ((i > 0) && entryBefore(&h->entry[i], &h->entry[(i - 1) / 2]))
+        heapSiftUp(h, i);
+    else
+        heapSiftDown(h, i);
+}
+
+static inline int channelIndex(uint8_t ch)
+{
+    if (ch & RF_CHANNEL)
+        return 0;
+    if (ch & INET_CHANNEL)
+        return 1;
+    return 2;
+}
+
+static inline uint8_t channelBit(int idx)
+{
+    static const uint8_t bits[TX_QUEUE_CHANNELS] = {RF_CHANNEL, INET_CHANNEL, TNC_CHANNEL};
+    return bits[idx];
+}
+
+// Remove one channel from a slot, the slot is released with its last channel
+static void slotRelease(uint8_t slot, uint8_t ch)
+{
+    slots[slot].channels &= ~ch;
+    if (slots[slot].channels == 0)
+        slotUsed--;
+}
+
+// Remove a slot from every channel queue it is still in, used when it is evicted
+static void slotEvict(uint8_t slot)
+{
+    for (int c = 0; c < TX_QUEUE_CHANNELS; c++)
+    {
+        if (!(slots[slot].channels & channelBit(c)))
+            continue;
+        txHeap *h = &heaps[c][slots[slot].prio];
+        for (uint16_t i = 0; i < h->count; i++)
+        {
+            if (h->entry[i].slot == slot)
+            {
+                heapRemoveAt(h, i);
+                break;
+            }
+        }
+    }
+    slots[slot].channels = 0;
+    slotUsed--;
+}
+
+bool txQueueInit(uint16_t size)
+{
+    if (size > 255)
+        size = 255;
+    if (txQueueMutex == NULL)
+        txQueueMutex = xSemaphoreCreateMutex();
+#ifdef BOARD_HAS_PSRAM
+    slots = (txSlot *)ps_calloc(size, sizeof(txSlot));
+#else
+    slots = (txSlot *)calloc(size, sizeof(txSlot));
+#endif
+    entries = (txEntry *)calloc((size_t)size * TX_QUEUE_CHANNELS * TX_PRIO_COUNT, sizeof(txEntry));
+    if ((slots == NULL) || (entries == NULL) || (txQueueMutex == NULL))
+    {
+        log_e("TX queue allocation failed");
+        return false;
+    }
+    for (int c = 0; c < TX_QUEUE_CHANNELS; c++)
+    {
+        for (int p = 0; p < TX_PRIO_COUNT; p++)
+        {
+            heaps[c][p].entry = &entries[((size_t)c * TX_PRIO_COUNT + p) * size];
+            heaps[c][p].count = 0;
+        }
+    }
+    slotCount = size;
+    slotUsed = 0;
+    slotPeak = 0;
+    memset(classStats, 0, sizeof(classStats));
+    return true;
+}
+
+bool txQueuePush(const char *info, size_t len, int dly, uint8_t ch, uint8_t prio)
+{
+    ch &= (RF_CHANNEL | INET_CHANNEL | TNC_CHANNEL);
+    if ((slots == NULL) || (ch == 0) || (len == 0))
+        return false;
+    if (prio >= TX_PRIO_COUNT)
+        prio = TX_PRIO_COUNT - 1;
+    if (len > TX_QUEUE_INFO_SIZE)
+        len = TX_QUEUE_INFO_SIZE;
+
+    xSemaphoreTake(txQueueMutex, portMAX_DELAY);
+    if (slotUsed >= slotCount)
+    {
+        // full: make room by evicting the newest packet of the lowest class below this one
+        int victim = -1;
+        for (uint16_t i = 0; i < slotCount; i++)
+        {
+            if ((slots[i].channels == 0) || (slots[i].prio <= prio))
+                continue;
+            if ((victim < 0) || (slots[i].prio > slots[victim].prio) ||
+                ((slots[i].prio == slots[victim].prio) && ((int32_t)(slots[i].seq - slots[victim].seq) > 0)))
+                victim = i;
+        }
+        if (victim < 0)
+        {
+            classStats[prio].dropped++;
+            xSemaphoreGive(txQueueMutex);
+            log_w("TX queue full, dropped class %d packet: %.*s", prio, (int)len, info);
+            return false;
+        }
+        classStats[slots[victim].prio].dropped++;
+        log_w("TX queue full, evicted class %d packet: %s", slots[victim].prio, slots[victim].info);
+        slotEvict(victim);
+    }
+
+    uint8_t slot = 0;
+    while (slots[slot].channels != 0)
+        slot++;
+    txSlot *s = &slots[slot];
+    memcpy(s->info, info, len);
+    s->info[len] = '\0';
+    s->length = len;
+    s->prio = prio;
+    s->channels = ch;
+    s->seq = seqNext++;
+
+    uint32_t now = millis();
+    for (int c = 0; c < TX_QUEUE_CHANNELS; c++)
+    {
+        if (!(ch & channelBit(c)))
+            continue;
+        txHeap *h = &heaps[c][prio];
+        h->entry[h->count].due = (channelBit(c) == RF_CHANNEL) ? now + (uint32_t)dly : now;
+        h->entry[h->count].seq = s->seq;
+        h->entry[h->count].slot = slot;
+        h->count++;
+        heapSiftUp(h, h->count - 1);
+    }
+    classStats[prio].queued++;
+    if (++slotUsed > slotPeak)
+        slotPeak = slotUsed;
+    xSemaphoreGive(txQueueMutex);
+    return true;
+}
+
+size_t txQueuePop(uint8_t ch, char *info, size_t size, uint32_t ahead)
+{
+    if ((slots == NULL) || (size == 0))
+        return 0;
+    int c = channelIndex(ch);
+    size_t len = 0;
+
+    xSemaphoreTake(txQueueMutex, portMAX_DELAY);
+    uint32_t now = millis();
+    for (int p = 0; p < TX_PRIO_COUNT; p++)
+    {
+        txHeap *h = &heaps[c][p];
+        if ((h->count == 0) || ((int32_t)(now + ahead - h->entry[0].due) < 0))
+            continue;
+        txEntry e = h->entry[0];
+        heapRemoveAt(h, 0);
+
+        txSlot *s = &slots[e.slot];
+        len = (s->length < size - 1) ? s->length : size - 1;
+        memcpy(info, s->info, len);
+        info[len] = '\0';
+
+        uint32_t delay = ((int32_t)(now - e.due) > 0) ? now - e.due : 0; // taken ahead of time counts as no delay
+        classStats[p].sent++;
+        classStats[p].delaySum += delay;
+        if (delay > classStats[p].delayMax)
+            classStats[p].delayMax = delay;
+        slotRelease(e.slot, channelBit(c));
+        break;
+    }
+    xSemaphoreGive(txQueueMutex);
+    return len;
+}
+
+void txQueueExpire(uint8_t ch, bool all)
+{
+    if (slots == NULL)
+        return;
+    int c = channelIndex(ch);
+
+    xSemaphoreTake(txQueueMutex, portMAX_DELAY);
+    uint32_t now = millis();
+    for (int p = 0; p < TX_PRIO_COUNT; p++)
+    {
+        txHeap *h = &heaps[c][p];
+        // the heap top is the oldest due time, so expired packets are always found there
+        while ((h->count > 0) && (all || ((int32_t)(now - h->entry[0].due) > TX_QUEUE_EXPIRE_MS)))
+        {
+            uint8_t slot = h->entry[0].slot;
+            heapRemoveAt(h, 0);
+            classStats[p].expired++;
+            log_d("TX queue expired on channel %d: %s", channelBit(c), slots[slot].info);
+            slotRelease(slot, channelBit(c));
+        }
+    }
+    xSemaphoreGive(txQueueMutex);
+}
+
+bool txQueueCancel(uint8_t ch, bool (*match)(const char *info, size_t len, uint8_t channels, void *arg), void *arg)
+{
+    if (slots == NULL)
+        return false;
+    int c = channelIndex(ch);
+
+    xSemaphoreTake(txQueueMutex, portMAX_DELAY);
+    for (int p = 0; p < TX_PRIO_COUNT; p++)
+    {
+        txHeap *h = &heaps[c][p];
+        for (uint16_t i = 0; i < h->count; i++)
+        {
+            uint8_t slot = h->entry[i].slot;
+            if (match(slots[slot].info, slots[slot].length, slots[slot].channels, arg))
+            {
+                heapRemoveAt(h, i);
+                classStats[p].replaced++;
+                slotRelease(slot, channelBit(c));
+                xSemaphoreGive(txQueueMutex);
+                return true;
+            }
+        }
+    }
+    xSemaphoreGive(txQueueMutex);
+    return false;
+}
+
+int txQueueCount()
+{
+    return slotUsed;
+}
+
+void txQueueGetStats(txQueueStats *stats)
+{
+    if (txQueueMutex != NULL)
+        xSemaphoreTake(txQueueMutex, portMAX_DELAY);
+    memcpy(stats->cls, classStats, sizeof(classStats));
+    stats->used = slotUsed;
+    stats->peak = slotPeak;
+    stats->size = slotCount;
+    if (txQueueMutex != NULL)
+        xSemaphoreGive(txQueueMutex);
+}
@@ -91,7 +91,7 @@ bool getCSV2Wx(String stream)
         uint8_t SendMode = 0;
         if (config.wx_2rf) SendMode |= RF_CHANNEL;
         if (config.wx_2inet) SendMode |= INET_CHANNEL;
-        pkgTxPush(strData, lng, 0,SendMode);
+        pkgTxPush(strData, lng, 0,SendMode, TX_PRIO_TLM);
         // if (config.wx_2rf)
         // { // WX SEND POSITION TO RF
         //     pkgTxPush(strData, lng, 0);
@@ -1025,7 +1025,7 @@ void handle_symbol(AsyncWebServerRequest *request)
 void handle_sysinfo(AsyncWebServerRequest *request)
 {
 	// Using dynamic memory allocation instead of String
-	char *html = allocateStringMemory(1024); // Initial buffer size, adjust as needed
+	char *html = allocateStringMemory(5888); // Initial buffer size, adjust as needed
 	if (!html)
 	{
 		return; // Memory allocation failed
@@ -1092,6 +1092,147 @@ void handle_sysinfo(AsyncWebServerRequest *request)
 	strcat(html, "</tr>\n");
 	strcat(html, "</table>\n");
 
+	if (config.rf_en)
+	{
+		// RF decoder bank: frames stored by the first decoder to hit / all decodes per decoder
+		struct Ax25RxStats rxStats;
+		Ax25GetRxStats(&rxStats);
+		uint8_t demods = ModemGetDemodulatorCount();
+		uint8_t ports = ModemGetPortCount();
+		strcat(html, "<br /><table style=\"table-layout: fixed;border-collapse: unset;border-radius: 10px;border-color: #ee800a;border-style: ridge;border-spacing: 1px;border-width: 4px;background: #ee800a;\">\n");
+		strcat(html, "<tr>\n");
+		strcat(html, "<th><span><b>RX Frames</b></span></th>\n");
+		strcat(html, "<th><span>CRC Err</span></th>\n");
+		strcat(html, "<th><span>Dup</span></th>\n");
+		strcat(html, "<th><span>FX.25 Frm/Fix/Tag</span></th>\n");
+		strcat(html, "<th><span>Bit Fix</span></th>\n");
+		strcat(html, "<th><span>ADC Ovr/Undr</span></th>\n");
+		strcat(html, "<th><span>RX Pool</span></th>\n");
+		strcat(html, "<th><span>TX/Frames</span></th>\n");
+		strcat(html, "<th><span>Airtime(s)</span></th>\n");
+		strcat(html, "<th><span>Defer Busy/P/Force</span></th>\n");
+		strcat(html, "<th><span>TX DMA Fail</span></th>\n");
+		for (uint8_t i = 0; i < demods; i++)
+		{
+			if (ports > 1)
+				snprintf(temp_buffer, sizeof(temp_buffer), "<th><span>P%d DEC%d</span></th>\n", ModemGetDemodulatorPort(i) + 1, i);
+			else
+				snprintf(temp_buffer, sizeof(temp_buffer), "<th><span>DEC%d</span></th>\n", i);
+			strcat(html, temp_buffer);
+		}
+		strcat(html, "</tr>\n");
+		strcat(html, "<tr>\n");
+		// FX.25: frames, bytes corrected, frames received despite bit errors in the correlation tag
+		if (ports > 1) // frames per RF port
+			snprintf(temp_buffer, sizeof(temp_buffer), "<td><b>%u (%u/%u)</b></td>\n", rxStats.frames, rxStats.portFrames[0], rxStats.portFrames[1]);
+		else
+			snprintf(temp_buffer, sizeof(temp_buffer), "<td><b>%u</b></td>\n", rxStats.frames);
+		strcat(html, temp_buffer);
+		snprintf(temp_buffer, sizeof(temp_buffer), "<td><b>%u</b></td>\n<td><b>%u</b></td>\n<td><b>%u/%u/%u</b></td>\n",
+				 rxStats.crcErrors, rxStats.duplicates, rxStats.fx25Frames, rxStats.fx25Corrected, rxStats.fx25TagFixed);
+		strcat(html, temp_buffer);
+		snprintf(temp_buffer, sizeof(temp_buffer), "<td><b>%u</b></td>\n", rxStats.bitFixes);
+		strcat(html, temp_buffer);
+		uint32_t fifoOverruns, fifoUnderruns;
+		AFSK_GetFifoStats(&fifoOverruns, &fifoUnderruns);
+		snprintf(temp_buffer, sizeof(temp_buffer), "<td><b>%u/%u</b></td>\n", fifoOverruns, fifoUnderruns);
+		strcat(html, temp_buffer);
+		// RX frame pool: used/peak/size, dropped frames
+		snprintf(temp_buffer, sizeof(temp_buffer), "<td><b>%u/%u/%u Drop:%u</b></td>\n", rxStats.poolUsed, rxStats.poolPeak, rxStats.poolSize, rxStats.overruns);
+		strcat(html, temp_buffer);
+		// channel access: transmissions/frames and bursts cut at the airtime limit, airtime, slots deferred for a busy channel, by persistence, forced TX
+		struct Ax25TxStats ax25Tx;
+		Ax25GetTxStats(&ax25Tx);
+		snprintf(temp_buffer, sizeof(temp_buffer), "<td><b>%u/%u Cut:%u</b></td>\n<td><b>%.1f</b></td>\n<td><b>%u/%u/%u</b></td>\n",
+				 ax25Tx.transmissions, ax25Tx.frames, ax25Tx.burstCuts, (float)ax25Tx.airtimeMs / 1000.f, ax25Tx.busyDefers, ax25Tx.persistDefers, ax25Tx.forced);
+		strcat(html, temp_buffer);
+		// transmissions sent by the DAC timer because the I2S TX channel could not be opened
+		uint32_t txDmaFallbacks;
+		AFSK_GetTxStats(&txDmaFallbacks);
+		snprintf(temp_buffer, sizeof(temp_buffer), "<td><b>%u</b></td>\n", txDmaFallbacks);
+		strcat(html, temp_buffer);
+		for (uint8_t i = 0; i < demods; i++)
+		{
+			snprintf(temp_buffer, sizeof(temp_buffer), "<td><b>%u/%u</b></td>\n", rxStats.slotFirst[i], rxStats.slotDecoded[i]);
+			strcat(html, temp_buffer);
+		}
+		strcat(html, "</tr>\n");
+		strcat(html, "</table>\n");
+	}
+
+	// TX scheduler: slots used/peak/size, then per class sent, dropped, expired and due-to-send delay
+	txQueueStats txStats;
+	txQueueGetStats(&txStats);
+	static const char *txClassName[TX_PRIO_COUNT] = {"Digi", "Msg", "Beacon", "TLM"};
+	strcat(html, "<br /><table style=\"table-layout: fixed;border-collapse: unset;border-radius: 10px;border-color: #ee800a;border-style: ridge;border-spacing: 1px;border-width: 4px;background: #ee800a;\">\n");
+	strcat(html, "<tr>\n");
+	strcat(html, "<th><span><b>TX Queue</b></span></th>\n");
+	for (uint8_t i = 0; i < TX_PRIO_COUNT; i++)
+	{
+		snprintf(temp_buffer, sizeof(temp_buffer), "<th><span>%s Sent/Drop/Exp</span></th>\n", txClassName[i]);
+		strcat(html, temp_buffer);
+	}
+	strcat(html, "</tr>\n");
+	strcat(html, "<tr>\n");
+	snprintf(temp_buffer, sizeof(temp_buffer), "<td><b>%u/%u/%u</b></td>\n", txStats.used, txStats.peak, txStats.size);
+	strcat(html, temp_buffer);
+	for (uint8_t i = 0; i < TX_PRIO_COUNT; i++)
+	{
+		const txQueueClassStats *cls = &txStats.cls[i];
+		snprintf(temp_buffer, sizeof(temp_buffer), "<td><b>%u/%u/%u %u/%ums</b></td>\n", cls->sent, cls->dropped, cls->expired,
+				 cls->sent ? cls->delaySum / cls->sent : 0, cls->delayMax);
+		strcat(html, temp_buffer);
+	}
+	strcat(html, "</tr>\n");
+	strcat(html, "</table>\n");
+
+	// APRS-IS stream: line and byte rates over the last second, totals, long lines dropped, lines per socket write
+	aprsIsStats isStats;
+	aprsIsGetStats(&isStats);
+	strcat(html, "<br /><table style=\"table-layout: fixed;border-collapse: unset;border-radius: 10px;border-color: #ee800a;border-style: ridge;border-spacing: 1px;border-width: 4px;background: #ee800a;\">\n");
+	strcat(html, "<tr>\n");
+	strcat(html, "<th><span><b>APRS-IS</b></span></th>\n");
+	strcat(html, "<th><span>Lines/s</span></th>\n");
+	strcat(html, "<th><span>Bytes/s</span></th>\n");
+	strcat(html, "<th><span>Lines</span></th>\n");
+	strcat(html, "<th><span>Overflow/Drop</span></th>\n");
+	strcat(html, "<th><span>Writes</span></th>\n");
+	strcat(html, "</tr>\n");
+	strcat(html, "<tr>\n");
+	strcat(html, "<td><b>RX</b></td>\n");
+	snprintf(temp_buffer, sizeof(temp_buffer), "<td><b>%u</b></td><td><b>%u</b></td><td><b>%u</b></td><td><b>%u</b></td><td><b>-</b></td>\n",
+			 isStats.rxLinesPerSec, isStats.rxBytesPerSec, isStats.rxLines, isStats.rxOverflows);
+	strcat(html, temp_buffer);
+	strcat(html, "</tr>\n");
+	strcat(html, "<tr>\n");
+	strcat(html, "<td><b>TX</b></td>\n");
+	snprintf(temp_buffer, sizeof(temp_buffer), "<td><b>%u</b></td><td><b>%u</b></td><td><b>%u</b></td><td><b>%u</b></td><td><b>%u</b></td>\n",
+			 isStats.txLinesPerSec, isStats.txBytesPerSec, isStats.txLines, isStats.txDropped, isStats.txWrites);
+	strcat(html, temp_buffer);
+	strcat(html, "</tr>\n");
+	strcat(html, "</table>\n");
+
+	// Packet buffer pool: each size class with its buffers in use, high-water mark, and requests
+	// that went to a larger class or found none free
+	pktPoolStats poolStats[PKTBUF_CLASSES];
+	pktPoolGetStats(poolStats);
+	strcat(html, "<br /><table style=\"table-layout: fixed;border-collapse: unset;border-radius: 10px;border-color: #ee800a;border-style: ridge;border-spacing: 1px;border-width: 4px;background: #ee800a;\">\n");
+	strcat(html, "<tr>\n");
+	strcat(html, "<th><span><b>Packet Buffers</b></span></th>\n");
+	strcat(html, "<th><span>Used</span></th>\n");
+	strcat(html, "<th><span>Peak</span></th>\n");
+	strcat(html, "<th><span>Size</span></th>\n");
+	strcat(html, "<th><span>Allocs</span></th>\n");
+	strcat(html, "<th><span>Spill/Fail</span></th>\n");
+	strcat(html, "</tr>\n");
+	for (int k = 0; k < PKTBUF_CLASSES; k++)
+	{
+		snprintf(temp_buffer, sizeof(temp_buffer), "<tr>\n<td><b>%u bytes</b></td><td><b>%u</b></td><td><b>%u</b></td><td><b>%u</b></td><td><b>%u</b></td><td><b>%u/%u</b></td>\n</tr>\n",
+				 poolStats[k].size, poolStats[k].used, poolStats[k].peak, poolStats[k].count, poolStats[k].allocs, poolStats[k].spills, poolStats[k].fails);
+		strcat(html, temp_buffer);
+	}
+	strcat(html, "</table>\n");
+
 	// request->send(200, "text/html", html); // send to someones browser when asked
 	AsyncWebServerResponse *response = request->beginResponse(200, "text/html", (const char *)html);
 	response->addHeader("Sysinfo", "content");
@@ -1152,11 +1293,11 @@ void event_lastHeard(bool gethtml)
 	localtime_r(&timeNow, &tmNow);
 //strcat(webString, "  { time: \"21:54:23\", icon: \"91-1.png\", callsign: \"HS5TQA-7\", path: \"RF: WIDE1-1\", dx: 0.0, packet: 2, audio: -19.6 },\n");
 	strcpy(html, "[");
-	for (int i = 0; i < PKGLISTSIZE; i++)
+	int view[PKGLISTSIZE];
+	int n = pkgListView(view, PKGLISTSIZE, STATIONDB_RECENT);
+	for (int i = 0; i < n; i++)
 	{
-		if (i >= PKGLISTSIZE)
-			break;
-		pkgListType pkg = getPkgList(i);
+		pkgListType pkg = getPkgList(view[i]);
 		if (pkg.time > 0)
 		{
 			// if (pkg.raw == nullptr || pkg.length == 0)
@@ -1175,12 +1316,13 @@ void event_lastHeard(bool gethtml)
 			// 	continue;
 
 			int packet = pkg.pkg;
-			char *pos_gt = strchr(pkg.raw, '>'); // Find first position of '>'
-			char *pos_colon = strchr(pkg.raw, ':');
-			if(pos_gt == nullptr || pos_colon == nullptr)
-				continue;
-			if(pos_colon < pos_gt)
+			char *pos_gt = (pkg.raw != nullptr) ? strchr(pkg.raw, '>') : nullptr; // Find first position of '>'
+			char *pos_colon = (pkg.raw != nullptr) ? strchr(pkg.raw, ':') : nullptr;
+			if(pos_gt == nullptr || pos_colon == nullptr || pos_colon < pos_gt)
+			{
+				pktBufRelease(pkg.raw);
 				continue;
+			}
 			int start_val = pos_gt ? (pos_gt - pkg.raw) : -1;
 			if (start_val > 3 && start_val < 10)
 			{
@@ -1401,6 +1543,7 @@ void event_lastHeard(bool gethtml)
 				}
 			}
 		}
+		pktBufRelease(pkg.raw);
 	}
 	html[strlen(html) - 1] = '\0'; // Remove the last comma
 	if (html[0] == '[')
@@ -1464,12 +1607,11 @@ String event_chatMessage(bool gethtml)
 	strcat(html, "<th style=\"width:20pt\">msgID</th>\n");
 	strcat(html, "</tr>\n");
 
-	pkgMsgSort(msgQueue);
-	for (int i = 0; i < PKGLISTSIZE; i++)
+	int view[PKGLISTSIZE];
+	int n = pkgMsgView(view, PKGLISTSIZE);
+	for (int i = 0; i < n; i++)
 	{
-		if (i >= PKGLISTSIZE)
-			break;
-		msgType pkg = getMsgList(i);
+		msgType pkg = getMsgList(view[i]);
 		if (pkg.time > 0)
 		{
 			// String line = String(pkg.text); // Not needed anymore
@@ -1511,7 +1653,8 @@ String event_chatMessage(bool gethtml)
 			strcat(html, "</td>");
 
 			strcat(html, "<td style=\"text-align: left;\">");
-			strcat(html, pkg.text);
+			if (pkg.text != NULL)
+				strcat(html, pkg.text);
 			strcat(html, "</td>");
 
 			if (pkg.ack > 0)
@@ -1535,6 +1678,7 @@ String event_chatMessage(bool gethtml)
 			snprintf(temp_buffer, sizeof(temp_buffer), "<td>%d</td></tr>\n", pkg.msgID);
 			strcat(html, temp_buffer);
 		}
+		pktBufRelease(pkg.text);
 	}
 
 	size_t html_len = strlen(html);
@@ -2172,6 +2316,10 @@ void handle_radio(AsyncWebServerRequest *request)
 	{
 		bool hpf = 0;
 		bool lpf = 0;
+		bool rf2En = 0;
+		bool rf2Lpf = 0;
+		bool rf2Digi = 0;
+		bool rf2Inet = 0;
 		for (uint8_t i = 0; i < request->args(); i++)
 		{
 			if (request->argName(i) == "HPF")
@@ -2204,6 +2352,14 @@ void handle_radio(AsyncWebServerRequest *request)
 					}
 				}
 			}
+			if (request->argName(i) == "burstTime")
+			{
+				if (request->arg(i) != "")
+				{
+					if (isValidNumber(request->arg(i)))
+						config.tx_burst_time = constrain(request->arg(i).toInt(), 0, 60000);
+				}
+			}
 			if (request->argName(i) == "preamble")
 			{
 				if (request->arg(i) != "")
@@ -2230,9 +2386,74 @@ void handle_radio(AsyncWebServerRequest *request)
 						config.fx25_mode = request->arg(i).toInt();
 				}
 			}
+			if (request->argName(i) == "modem_demods")
+			{
+				if (request->arg(i) != "")
+				{
+					if (isValidNumber(request->arg(i)))
+						config.modem_demods = request->arg(i).toInt();
+				}
+			}
+			if (request->argName(i) == "fx25_tagdist")
+			{
+				if (request->arg(i) != "")
+				{
+					if (isValidNumber(request->arg(i)))
+						config.fx25_tag_distance = constrain(request->arg(i).toInt(), 0, FX25_TAG_DISTANCE_MAX);
+				}
+			}
+			if (request->argName(i) == "modem_fixbits")
+			{
+				if (request->arg(i) != "")
+				{
+					if (isValidNumber(request->arg(i)))
+						config.modem_fixbits = request->arg(i).toInt();
+				}
+			}
+			if (request->argName(i) == "rf2Enable")
+			{
+				if (strcmp(request->arg(i).c_str(), "OK") == 0)
+					rf2En = true;
+			}
+			if (request->argName(i) == "rf2_adc_gpio")
+			{
+				if (request->arg(i) != "")
+				{
+					if (isValidNumber(request->arg(i)))
+						config.rf2_adc_gpio = request->arg(i).toInt();
+				}
+			}
+			if (request->argName(i) == "rf2_modem_type")
+			{
+				if (request->arg(i) != "")
+				{
+					if (isValidNumber(request->arg(i)))
+						config.rf2_modem_type = request->arg(i).toInt();
+				}
+			}
+			if (request->argName(i) == "rf2LPF")
+			{
+				if (strcmp(request->arg(i).c_str(), "OK") == 0)
+					rf2Lpf = true;
+			}
+			if (request->argName(i) == "rf2Digi")
+			{
+				if (strcmp(request->arg(i).c_str(), "OK") == 0)
+					rf2Digi = true;
+			}
+			if (request->argName(i) == "rf2Inet")
+			{
+				if (strcmp(request->arg(i).c_str(), "OK") == 0)
+					rf2Inet = true;
+			}
 		}
 		config.audio_hpf = hpf;
 		config.audio_lpf = lpf;
+		// the second RF port sets up the ADC scan pattern, it is applied after a restart
+		config.rf2_en = rf2En;
+		config.rf2_audio_lpf = rf2Lpf;
+		config.digi_ports = rf2Digi ? (config.digi_ports | RF_PORT_2) : (config.digi_ports & ~RF_PORT_2);
+		config.rf2inet_ports = rf2Inet ? (config.rf2inet_ports | RF_PORT_2) : (config.rf2inet_ports & ~RF_PORT_2);
 		// Using dynamic memory allocation instead of String
 		char *html = allocateStringMemory(64); // Small buffer for "OK"
 		if (html)
@@ -2242,12 +2463,15 @@ void handle_radio(AsyncWebServerRequest *request)
 			free(html);							   // Free the allocated memory
 		}
 		saveConfiguration("/default.cfg", config);
-		afskSetModem(config.modem_type, config.audio_lpf, config.tx_timeslot, config.preamble * 100, config.fx25_mode);
+		afskSetModem(config.modem_type, config.audio_lpf, config.tx_timeslot, config.preamble * 100, config.fx25_mode, config.modem_demods);
+		Ax25FixBits(config.modem_fixbits);
+		Fx25TagDistance(config.fx25_tag_distance);
+		Ax25BurstTime(config.tx_burst_time);
 	}
 	else
 	{
 		// Using dynamic memory allocation instead of String
-		char *html = allocateStringMemory(12000); // Initial buffer size, adjust as needed
+		char *html = allocateStringMemory(14000); // Initial buffer size, adjust as needed
 		if (!html)
 		{
 			return; // Memory allocation failed
@@ -2543,6 +2767,32 @@ void handle_radio(AsyncWebServerRequest *request)
 		strcat(html, "</select>  (FX.25 = AX.25 + FEC)\n");
 		strcat(html, "</td>\n");
 		strcat(html, "<tr>\n");
+		strcat(html, "<td align=\"right\"><b>FX.25 Tag Errors:</b></td>\n");
+		snprintf(temp_buffer, sizeof(temp_buffer), "<td style=\"text-align: left;\"><input type=\"number\" name=\"fx25_tagdist\" min=\"0\" max=\"%d\" value=\"%d\" /> (bit errors allowed in a correlation tag, 0 = exact match)</td>\n", FX25_TAG_DISTANCE_MAX, config.fx25_tag_distance);
+		strcat(html, temp_buffer);
+		strcat(html, "</tr>\n");
+		strcat(html, "<tr>\n");
+		strcat(html, "<td align=\"right\"><b>Demodulators:</b></td>\n");
+		strcat(html, "<td style=\"text-align: left;\">\n");
+		strcat(html, "<select name=\"modem_demods\" id=\"modem_demods\">\n");
+		for (int i = 0; i <= MODEM_MAX_DEMODULATOR_COUNT; i++)
+		{
+			snprintf(temp_buffer, sizeof(temp_buffer), "<option value=\"%d\" %s>", i, (config.modem_demods == i) ? "selected" : "");
+			strcat(html, temp_buffer);
+			if (i == 0)
+				snprintf(temp_buffer, sizeof(temp_buffer), "AUTO (%d)</option>\n", MODEM_DEFAULT_DEMODULATOR_COUNT);
+			else
+				snprintf(temp_buffer, sizeof(temp_buffer), "%d</option>\n", i);
+			strcat(html, temp_buffer);
+		}
+		strcat(html, "</select>  (parallel 1200 Bd decoders)\n");
+		strcat(html, "</td>\n");
+		strcat(html, "<tr>\n");
+		strcat(html, "<td align=\"right\"><b>Fix Bits:</b></td>\n");
+		snprintf(temp_buffer, sizeof(temp_buffer), "<td style=\"text-align: left;\"><input type=\"number\" name=\"modem_fixbits\" min=\"0\" max=\"1000\" value=\"%d\" /> (CRC recovery attempts per bad frame, 0 = off)</td>\n", config.modem_fixbits);
+		strcat(html, temp_buffer);
+		strcat(html, "</tr>\n");
+		strcat(html, "<tr>\n");
 		// strcat(html, "<td align=\"right\"><b>Audio HPF:</b></td>\n");
 		// char strFlag[32] = "";
 		// if (config.audio_hpf)
@@ -2562,11 +2812,52 @@ void handle_radio(AsyncWebServerRequest *request)
 		}
 		strcat(html, "</tr>\n");
 		strcat(html, "<tr>\n");
+		strcat(html, "<td align=\"right\"><b>RF Port 2:</b></td>\n");
+		snprintf(temp_buffer, sizeof(temp_buffer), "<td style=\"text-align: left;\"><label class=\"switch\"><input type=\"checkbox\" name=\"rf2Enable\" value=\"OK\" %s><span class=\"slider round\"></span></label><label style=\"vertical-align: bottom;font-size: 8pt;\"><i> *Receive only second radio, applied after restart</i></label></td>\n", config.rf2_en ? "checked" : "");
+		strcat(html, temp_buffer);
+		strcat(html, "</tr>\n");
+		strcat(html, "<tr>\n");
+		strcat(html, "<td align=\"right\"><b>RF2 ADC GPIO:</b></td>\n");
+		snprintf(temp_buffer, sizeof(temp_buffer), "<td style=\"text-align: left;\"><input type=\"number\" name=\"rf2_adc_gpio\" min=\"-1\" max=\"39\" value=\"%d\" /> (ADC1 pin, -1 = off)</td>\n", config.rf2_adc_gpio);
+		strcat(html, temp_buffer);
+		strcat(html, "</tr>\n");
+		strcat(html, "<tr>\n");
+		strcat(html, "<td align=\"right\"><b>RF2 Modem Type:</b></td>\n");
+		strcat(html, "<td style=\"text-align: left;\">\n");
+		strcat(html, "<select name=\"rf2_modem_type\" id=\"rf2_modem_type\">\n");
+		#ifdef CONFIG_IDF_TARGET_ESP32S3
+		for (int i = 0; i < 4; i++)
+		#else
+		for (int i = 0; i < 3; i++)
+		#endif
+		{
+			snprintf(temp_buffer, sizeof(temp_buffer), "<option value=\"%d\" %s>%s</option>\n", i, (config.rf2_modem_type == i) ? "selected" : "", MODEM_TYPE[i]);
+			strcat(html, temp_buffer);
+		}
+		strcat(html, "</select>\n");
+		strcat(html, "</td>\n");
+		strcat(html, "</tr>\n");
+		strcat(html, "<tr>\n");
+		strcat(html, "<td align=\"right\"><b>RF2 Deemphasis:</b></td>\n");
+		snprintf(temp_buffer, sizeof(temp_buffer), "<td style=\"text-align: left;\"><label class=\"switch\"><input type=\"checkbox\" name=\"rf2LPF\" value=\"OK\" %s><span class=\"slider round\"></span></label></td>\n", config.rf2_audio_lpf ? "checked" : "");
+		strcat(html, temp_buffer);
+		strcat(html, "</tr>\n");
+		strcat(html, "<tr>\n");
+		strcat(html, "<td align=\"right\"><b>RF2 Routing:</b></td>\n");
+		snprintf(temp_buffer, sizeof(temp_buffer), "<td style=\"text-align: left;\"><input type=\"checkbox\" name=\"rf2Inet\" value=\"OK\" %s/>IGate to APRS-IS <input type=\"checkbox\" name=\"rf2Digi\" value=\"OK\" %s/>Digipeat on RF port 1</td>\n", (config.rf2inet_ports & RF_PORT_2) ? "checked" : "", (config.digi_ports & RF_PORT_2) ? "checked" : "");
+		strcat(html, temp_buffer);
+		strcat(html, "</tr>\n");
+		strcat(html, "<tr>\n");
 		strcat(html, "<td align=\"right\"><b>TX Time Slot:</b></td>\n");
 
 		snprintf(temp_buffer, sizeof(temp_buffer), "<td style=\"text-align: left;\"><input type=\"number\" name=\"timeSlot\" min=\"0\" max=\"99999\"\nstep=\"100\" value=\"%d\" /> mSec.</td>\n", config.tx_timeslot);
 		strcat(html, temp_buffer);
 
+		strcat(html, "</tr>\n");
+		strcat(html, "<tr>\n");
+		strcat(html, "<td align=\"right\"><b>TX Burst Time:</b></td>\n");
+		snprintf(temp_buffer, sizeof(temp_buffer), "<td style=\"text-align: left;\"><input type=\"number\" name=\"burstTime\" min=\"0\" max=\"60000\" step=\"100\" value=\"%d\" /> mSec. (max airtime of one transmission, 0 = one frame each)</td>\n", config.tx_burst_time);
+		strcat(html, temp_buffer);
 		strcat(html, "</tr>\n");
 		strcat(html, "<tr>\n");
 		strcat(html, "<td align=\"right\"><b>Preamble:</b></td>\n");
@@ -2954,6 +3245,10 @@ void handle_mqtt(AsyncWebServerRequest *request)
 					strcpy(config.mqtt_subscribe, request->arg(i).c_str());
 				}
 			}
+			if (request->argName(i) == "mqttFilter")
+			{
+				strlcpy(config.mqtt_filter, request->arg(i).c_str(), sizeof(config.mqtt_filter));
+			}
 
 			if (request->argName(i) == "TopicTNC")
 			{
@@ -3023,6 +3318,7 @@ void handle_mqtt(AsyncWebServerRequest *request)
 		}
 
 		config.en_mqtt = mqttEn;
+		aprsFiltersUpdate();
 		clientMQTT.disconnect();
 		// Using dynamic memory allocation instead of String
 		char *html = allocateStringMemory(256); // Buffer for response message
@@ -3179,6 +3475,12 @@ void handle_mqtt(AsyncWebServerRequest *request)
 		strcat(html, "</tr></table></fieldset>\n");
 		strcat(html, "</td></tr>\n");
 
+		strcat(html, "<tr>\n");
+		strcat(html, "<td align=\"right\"><b>TNC Topic Filter:</b></td>\n");
+		snprintf(temp_buffer, sizeof(temp_buffer), "<td style=\"text-align: left;\"><input size=\"50\" maxlength=\"%d\" name=\"mqttFilter\" type=\"text\" value=\"%s\" /><br /><i style=\"font-size: 8pt;\">APRS-IS filter syntax for the packets published, empty for all</i></td>\n", APRS_FILTER_TEXT - 1, config.mqtt_filter);
+		strcat(html, temp_buffer);
+		strcat(html, "</tr>\n");
+
 		strcat(html, "<tr>\n");
 		strcat(html, "<td align=\"right\"><b>Subscription:</b></td>\n");
 		snprintf(temp_buffer, sizeof(temp_buffer), "<td style=\"text-align: left;\"><input size=\"50\" maxlength=\"32\" name=\"subscribe\" type=\"text\" value=\"%s\" /></td>\n", config.mqtt_subscribe);
@@ -3853,6 +4155,8 @@ void handle_mod(AsyncWebServerRequest *request)
 	else if (request->hasArg("commitTNC"))
 	{
 		bool En = false;
+		bool kissTcpEn = false;
+		bool agwEn = false;
 		for (uint8_t i = 0; i < request->args(); i++)
 		{
 			// Serial.print("SERVER ARGS ");
@@ -3885,9 +4189,45 @@ void handle_mod(AsyncWebServerRequest *request)
 					config.ext_tnc_mode = request->arg(i).toInt();
 				}
 			}
+
+			if (request->argName(i) == "kissTcpEnable")
+			{
+				if (String(request->arg(i)) == "OK")
+					kissTcpEn = true;
+			}
+
+			if (request->argName(i) == "kissTcpPort")
+			{
+				if (isValidNumber(request->arg(i)))
+				{
+					config.kiss_tcp_port = request->arg(i).toInt();
+				}
+			}
+
+			if (request->argName(i) == "kissTcpFilter")
+			{
+				strlcpy(config.kiss_tcp_filter, request->arg(i).c_str(), sizeof(config.kiss_tcp_filter));
+			}
+
+			if (request->argName(i) == "agwEnable")
+			{
+				if (String(request->arg(i)) == "OK")
+					agwEn = true;
+			}
+
+			if (request->argName(i) == "agwPort")
+			{
+				if (isValidNumber(request->arg(i)))
+				{
+					config.agw_port = request->arg(i).toInt();
+				}
+			}
 		}
 
 		config.ext_tnc_enable = En;
+		config.kiss_tcp_en = kissTcpEn;
+		config.agw_en = agwEn;
+		aprsFiltersUpdate();
 		saveConfiguration("/default.cfg", config);
 		String html = "OK";
 		request->send(200, "text/html", html);
@@ -4431,7 +4771,7 @@ void handle_mod(AsyncWebServerRequest *request)
 	else
 	{
 		// Allocate memory for the HTML string
-		char *html = allocateStringMemory(22000); // Start with 8KB, adjust as needed
+		char *html = allocateStringMemory(24600); // Start with 8KB, adjust as needed
 		if (html == NULL)
 		{
 			request->send(500, "text/html", "Memory allocation failed");
@@ -5409,6 +5749,49 @@ void handle_mod(AsyncWebServerRequest *request)
 		strcat(html, "</td>\n");
 		strcat(html, "</tr>\n");
 
+		strcat(html, "<tr>\n");
+		strcpy(enFlage, "");
+		if (config.kiss_tcp_en)
+			strcpy(enFlage, "checked");
+		strcat(html, "<td align=\"right\"><b>KISS TCP</b></td>\n");
+		strcat(html, "<td style=\"text-align: left;\"><label class=\"switch\"><input type=\"checkbox\" name=\"kissTcpEnable\" value=\"OK\" ");
+		strcat(html, enFlage);
+		strcat(html, "><span class=\"slider round\"></span></label></td>\n");
+		strcat(html, "</tr>\n");
+
+		strcat(html, "<tr>\n");
+		strcat(html, "<td align=\"right\"><b>TCP PORT:</b></td>\n");
+		kissTcpStats kissStats;
+		kissTcpGetStats(&kissStats);
+		char kissTcpHtml[512];
+		snprintf(kissTcpHtml, sizeof(kissTcpHtml), "<td style=\"text-align: left;\"><input type=\"number\" name=\"kissTcpPort\" min=\"1\" max=\"65535\" value=\"%d\" /><br /><i style=\"font-size: 8pt;\">%d clients, applied after restart</i></td>\n", config.kiss_tcp_port, kissStats.clients);
+		strcat(html, kissTcpHtml);
+		strcat(html, "</tr>\n");
+
+		strcat(html, "<tr>\n");
+		strcat(html, "<td align=\"right\"><b>KISS Filter:</b></td>\n");
+		snprintf(kissTcpHtml, sizeof(kissTcpHtml), "<td style=\"text-align: left;\"><input maxlength=\"%d\" size=\"30\" name=\"kissTcpFilter\" type=\"text\" value=\"%s\" /><br /><i style=\"font-size: 8pt;\">APRS-IS filter syntax, empty for all frames</i></td>\n", APRS_FILTER_TEXT - 1, config.kiss_tcp_filter);
+		strcat(html, kissTcpHtml);
+		strcat(html, "</tr>\n");
+
+		strcat(html, "<tr>\n");
+		strcpy(enFlage, "");
+		if (config.agw_en)
+			strcpy(enFlage, "checked");
+		strcat(html, "<td align=\"right\"><b>AGWPE</b></td>\n");
+		strcat(html, "<td style=\"text-align: left;\"><label class=\"switch\"><input type=\"checkbox\" name=\"agwEnable\" value=\"OK\" ");
+		strcat(html, enFlage);
+		strcat(html, "><span class=\"slider round\"></span></label></td>\n");
+		strcat(html, "</tr>\n");
+
+		strcat(html, "<tr>\n");
+		strcat(html, "<td align=\"right\"><b>AGW PORT:</b></td>\n");
+		agwTcpStats agwStats;
+		agwTcpGetStats(&agwStats);
+		snprintf(kissTcpHtml, sizeof(kissTcpHtml), "<td style=\"text-align: left;\"><input type=\"number\" name=\"agwPort\" min=\"1\" max=\"65535\" value=\"%d\" /><br /><i style=\"font-size: 8pt;\">%d clients, applied after restart</i></td>\n", config.agw_port, agwStats.clients);
+		strcat(html, kissTcpHtml);
+		strcat(html, "</tr>\n");
+
 		strcat(html, "<tr><td colspan=\"2\" align=\"right\">\n");
 		strcat(html, "<input class=\"button\" id=\"submitTNC\" name=\"commitTNC\" type=\"submit\" value=\"Apply\" maxlength=\"80\"/>\n");
 		strcat(html, "<input type=\"hidden\" name=\"commitTNC\"/>\n");
@@ -7348,7 +7731,16 @@ void handle_igate(AsyncWebServerRequest *request)
 						config.inet2rfFilter |= FILTER_POSITION;
 				}
 			}
+			if (request->argName(i) == "inet2rfIsFilter")
+			{
+				strlcpy(config.inet2rf_filter, request->arg(i).c_str(), sizeof(config.inet2rf_filter));
+			}
+			if (request->argName(i) == "dispIsFilter")
+			{
+				strlcpy(config.disp_filter, request->arg(i).c_str(), sizeof(config.disp_filter));
+			}
 		}
+		aprsFiltersUpdate();
 		String html;
 		if (saveConfiguration("/default.cfg", config))
 		{
@@ -7838,6 +8230,19 @@ void handle_igate(AsyncWebServerRequest *request)
 		strcat(html, "</tr></table></fieldset>\n");
 		strcat(html, "</td></tr>\n");
 
+		strcat(html, "<tr>\n");
+		strcat(html, "<td align=\"right\"><b>INET2RF APRS Filter:</b></td>\n");
+		snprintf(tempHtml, sizeof(tempHtml), "<td style=\"text-align: left;\"><input maxlength=\"%d\" size=\"50\" name=\"inet2rfIsFilter\" type=\"text\" value=\"%s\" /><br /><i style=\"font-size: 8pt;\">APRS-IS filter syntax, e.g. r/13.75/100.5/50 b/HS5* -t/w, checked here on top of the types above. Empty for none.</i></td>\n",
+				 APRS_FILTER_TEXT - 1, config.inet2rf_filter);
+		strcat(html, tempHtml);
+		strcat(html, "</tr>\n");
+		strcat(html, "<tr>\n");
+		strcat(html, "<td align=\"right\"><b>Last Heard APRS Filter:</b></td>\n");
+		snprintf(tempHtml, sizeof(tempHtml), "<td style=\"text-align: left;\"><input maxlength=\"%d\" size=\"50\" name=\"dispIsFilter\" type=\"text\" value=\"%s\" /><br /><i style=\"font-size: 8pt;\">Packets from RF and APRS-IS shown in last heard and on the display, on top of the display filter. Empty for all.</i></td>\n",
+				 APRS_FILTER_TEXT - 1, config.disp_filter);
+		strcat(html, tempHtml);
+		strcat(html, "</tr>\n");
+
 		strcat(html, "<tr><td colspan=\"2\" align=\"right\">\n");
 		strcat(html, "<div><button class=\"button\" type='submit' id='submitIGATEfilter'  name=\"commitIGATEfilter\"> Apply Change </button></div>\n");
 		strcat(html, "<input type=\"hidden\" name=\"commitIGATEfilter\"/>\n");
@@ -0,0 +1,1807 @@
+/*
+ Host-side replay harness for the RX chain (modem -> AX.25 -> FX.25).
+
+ Feeds one or more WAV recordings through ModemDecodeBlock() exactly as
+ AFSK_Poll() does on the target (9600 Hz input for 300/1200 Bd, 38400 Hz for
+ 9600 Bd, 12-bit signed samples) and reports decoded frames, CRC failures,
+ FX.25 corrections and decoder throughput. With -r the recording is fed at
+ the ADC rate through the RX decimator first, with -p it is decoded on a
+ second RX port as well, like a second radio on the other ADC input; -t checks the decimator
+ against a floating point reference, -c checks the table driven CRC
+ against a bitwise one and -e checks the Reed-Solomon coder against the
+ original LwFEC implementation; -q runs an AGWPE client stub against the
+ AGW session code, with its frames going through the modem and back,
+ -u checks the duplicate packet window against an exact reference, -i
+ checks the APRS-IS line reader and TNC2 parser, -j the APRS-IS filter engine,
+ -y the station index of the last heard list and -z the packet buffer pool.
+
+ Build and run:
+   pio run -e native
+   .pio/build/native/program -m 1 -x 1 -v recording.wav
+*/
+
+#include <Arduino.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <unistd.h>
+#include <chrono>
+#include <vector>
+#include <string>
+#include <list>
+#include <map>
+
+#include "modem.h"
+#include "AX25.h"
+#include "fx25.h"
+#include "decimator.h"
+#include "CRC-CCIT.h"
+#include "AFSK.h"
+#include "rs.h"
+#include "rs_reference.h"
+#include "AGW.h"
+#include "dupecheck.h"
+#include "tnc2.h"
+#include "aprsfilter.h"
+#include "stationdb.h"
+#include "pktbuf.h"
+
+#ifndef BV
+#define BV(n) _BV(n) //used by AX25_REPEATED()
+#endif
+
+/* -------------------------------------------------------------------------- */
+/* Target glue: everything the modem/AX.25 sources expect from AFSK.cpp       */
+/* -------------------------------------------------------------------------- */
+
+volatile bool hw_afsk_dac_isr = false;
+volatile bool pttOff = false;
+volatile int8_t adcEn = 0;
+volatile int8_t dacEn = 0;
+
+static unsigned long hostMillis = 0; //simulated time, advanced by the sample clock
+
+unsigned long millis(void)
+{
+	return hostMillis;
+}
+
+void delay(unsigned long ms)
+{
+	hostMillis += ms;
+}
+
+long random(long min, long max)
+{
+	if (max <= min)
+		return min;
+	return min + (rand() % (max - min));
+}
+
+void digitalWrite(uint8_t pin, uint8_t val)
+{
+}
+
+void IRAM_ATTR LED_Status2(uint8_t red, uint8_t green, uint8_t blue)
+{
+}
+
+void setPtt(bool state)
+{
+}
+
+void AFSK_TimerEnable(bool sts)
+{
+}
+
+void DAC_TimerEnable(bool sts)
+{
+}
+
+void AFSK_FlushFifo(void)
+{
+}
+
+/* -------------------------------------------------------------------------- */
+/* WAV input                                                                  */
+/* -------------------------------------------------------------------------- */
+
+struct WavData
+{
+	uint32_t sampleRate;
+	std::vector<int16_t> samples; //first channel only
+};
+
+static uint32_t readLe32(const uint8_t *p)
+{
+	return (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+static uint16_t readLe16(const uint8_t *p)
+{
+	return (uint16_t)p[0] | ((uint16_t)p[1] << 8);
+}
+
+static bool loadWav(const char *path, struct WavData *wav)
+{
+	FILE *f = fopen(path, "rb");
+	if (f == NULL)
+	{
+		fprintf(stderr, "%s: cannot open\n", path);
+		return false;
+	}
+
+	std::vector<uint8_t> raw;
+	uint8_t chunk[4096];
+	size_t n;
+	while ((n = fread(chunk, 1, sizeof(chunk), f)) > 0)
+		raw.insert(raw.end(), chunk, chunk + n);
+	fclose(f);
+
+	if ((raw.size() < 12) || memcmp(&raw[0], "RIFF", 4) || memcmp(&raw[8], "WAVE", 4))
+	{
+		fprintf(stderr, "%s: not a RIFF/WAVE file\n", path);
+		return false;
+	}
+
+	uint16_t format = 0, channels = 0, bits = 0;
+	wav->sampleRate = 0;
+	wav->samples.clear();
+
+	size_t pos = 12;
+	while (pos + 8 <= raw.size())
+	{
+		uint32_t size = readLe32(&raw[pos + 4]);
+		const uint8_t *body = &raw[pos + 8];
+		if (pos + 8 + size > raw.size())
+			size = raw.size() - pos - 8; //truncated recording, use what is there
+
+		if (!memcmp(&raw[pos], "fmt ", 4) && (size >= 16))
+		{
+			format = readLe16(body);
+			channels = readLe16(body + 2);
+			wav->sampleRate = readLe32(body + 4);
+			bits = readLe16(body + 14);
+		}
+		else if (!memcmp(&raw[pos], "data", 4))
+		{
+			if ((format != 1) || (channels == 0) || ((bits != 8) && (bits != 16)))
+			{
+				fprintf(stderr, "%s: only 8/16-bit PCM is supported\n", path);
+				return false;
+			}
+			uint32_t frameSize = channels * (bits / 8);
+			for (uint32_t i = 0; i + frameSize <= size; i += frameSize)
+			{
+				if (bits == 16)
+					wav->samples.push_back((int16_t)readLe16(body + i));
+				else
+					wav->samples.push_back((int16_t)(((int)body[i] - 128) << 8));
+			}
+		}
+		pos += 8 + size + (size & 1);
+	}
+
+	if (wav->sampleRate == 0)
+	{
+		fprintf(stderr, "%s: no fmt chunk\n", path);
+		return false;
+	}
+	return true;
+}
+
+/**
+ * @brief Resample to the modem input rate and scale to the 12-bit range used by AFSK_Poll()
+ */
+static void prepareSamples(const struct WavData *wav, uint32_t rate, int gainShift, std::vector<int16_t> *out)
+{
+	out->clear();
+	if (wav->samples.empty())
+		return;
+
+	double step = (double)wav->sampleRate / (double)rate;
+	size_t count = (size_t)((double)wav->samples.size() / step);
+	out->reserve(count);
+	for (size_t i = 0; i < count; i++)
+	{
+		double t = (double)i * step;
+		size_t k = (size_t)t;
+		double frac = t - (double)k;
+		int32_t a = wav->samples[k];
+		int32_t b = (k + 1 < wav->samples.size()) ? wav->samples[k + 1] : a;
+		int32_t s = (int32_t)((double)a + (double)(b - a) * frac);
+		out->push_back((int16_t)(s >> gainShift));
+	}
+}
+
+static void writeLe32(FILE *f, uint32_t v)
+{
+	uint8_t b[4] = {(uint8_t)v, (uint8_t)(v >> 8), (uint8_t)(v >> 16), (uint8_t)(v >> 24)};
+	fwrite(b, 1, 4, f);
+}
+
+static void writeLe16(FILE *f, uint16_t v)
+{
+	uint8_t b[2] = {(uint8_t)v, (uint8_t)(v >> 8)};
+	fwrite(b, 1, 2, f);
+}
+
+static bool saveWav(const char *path, uint32_t sampleRate, const std::vector<int16_t> &samples)
+{
+	FILE *f = fopen(path, "wb");
+	if (f == NULL)
+	{
+		fprintf(stderr, "%s: cannot create\n", path);
+		return false;
+	}
+	uint32_t dataSize = samples.size() * sizeof(int16_t);
+	fwrite("RIFF", 1, 4, f);
+	writeLe32(f, 36 + dataSize);
+	fwrite("WAVEfmt ", 1, 8, f);
+	writeLe32(f, 16);
+	writeLe16(f, 1); //PCM
+	writeLe16(f, 1); //mono
+	writeLe32(f, sampleRate);
+	writeLe32(f, sampleRate * sizeof(int16_t));
+	writeLe16(f, sizeof(int16_t));
+	writeLe16(f, 16);
+	fwrite("data", 1, 4, f);
+	writeLe32(f, dataSize);
+	for (size_t i = 0; i < samples.size(); i++)
+		writeLe16(f, (uint16_t)samples[i]);
+	fclose(f);
+	return true;
+}
+
+/* -------------------------------------------------------------------------- */
+
+static void printFrame(uint8_t *frame, uint16_t size, uint8_t corrected)
+{
+	AX25Msg msg;
+	memset(&msg, 0, sizeof(msg));
+	ax25_decode(frame, size, 0, &msg);
+
+	printf("  %s", msg.src.call);
+	if (msg.src.ssid)
+		printf("-%d", msg.src.ssid);
+	printf(">%s", msg.dst.call);
+	if (msg.dst.ssid)
+		printf("-%d", msg.dst.ssid);
+	for (uint8_t i = 0; i < msg.rpt_count; i++)
+	{
+		printf(",%s", msg.rpt_list[i].call);
+		if (msg.rpt_list[i].ssid)
+			printf("-%d", msg.rpt_list[i].ssid);
+		if (AX25_REPEATED(&msg, i))
+			printf("*");
+	}
+	printf(":%.*s", (int)msg.len, (const char *)msg.info);
+	if (corrected != AX25_NOT_FX25)
+		printf("  [FX.25, %d fixed]", corrected);
+	printf("\n");
+}
+
+/**
+ * @brief Compare the decimator with a double precision FIR over the same stream fed in random block sizes
+ * @return Number of ratios whose output differs by more than 1 LSB
+ */
+static int decimatorSelfTest(void)
+{
+	int failures = 0;
+	for (uint8_t ratio = 2; ratio <= DECIMATOR_MAX_RATIO; ratio++)
+	{
+		static struct Decimator dec;
+		DecimatorInit(&dec, ratio);
+
+		// two AFSK tones, an out of band tone and noise, about 12 bits peak
+		uint32_t rate = DECIMATOR_OUTPUT_RATE * ratio;
+		std::vector<int16_t> in(rate);
+		for (size_t i = 0; i < in.size(); i++)
+		{
+			double t = (double)i / rate;
+			double v = 700 * sin(2 * M_PI * 1200 * t) + 700 * sin(2 * M_PI * 2200 * t) + 400 * sin(2 * M_PI * 7300 * t);
+			in[i] = (int16_t)(v + (rand() % 401) - 200);
+		}
+
+		std::vector<int16_t> out(in.size() / ratio);
+		size_t produced = 0;
+		for (size_t i = 0; i < in.size();)
+		{
+			size_t n = ratio * (1 + rand() % 64);
+			if (i + n > in.size())
+				n = in.size() - i;
+			std::vector<int16_t> block(in.begin() + i, in.begin() + i + n);
+			size_t got = DecimatorProcess(&dec, block.data(), n, block.data()); //in place, as in AFSK_Poll()
+			for (size_t k = 0; k < got; k++)
+				out[produced + k] = block[k];
+			produced += got;
+			i += n;
+		}
+
+		int maxError = 0;
+		for (size_t m = 0; m < produced; m++)
+		{
+			double ref = 0;
+			for (uint8_t k = 0; k < dec.taps; k++)
+			{
+				int64_t idx = (int64_t)m * ratio + ratio - 1 - k;
+				if (idx >= 0)
+					ref += (double)dec.coeffs[k] / 32768.0 * in[idx];
+			}
+			int error = abs((int)lround(ref) - out[m]);
+			if (error > maxError)
+				maxError = error;
+		}
+
+		bool ok = (produced == out.size()) && (maxError <= 1);
+		printf("decimator %u:1 (%u Hz, %u taps): %zu samples, max error %d LSB: %s\n",
+			   ratio, rate, dec.taps, produced, maxError, ok ? "OK" : "FAIL");
+		if (!ok)
+			failures++;
+	}
+	return failures;
+}
+
+/**
+ * @brief Bit by bit reflected CRC-CCITT, the reference the table driven code is checked against
+ */
+static uint16_t crcBitwise(uint16_t crc, const uint8_t *data, size_t len)
+{
+	for (size_t i = 0; i < len; i++)
+	{
+		for (uint8_t b = 0; b < 8; b++)
+		{
+			if ((crc ^ (data[i] >> b)) & 1)
+				crc = (crc >> 1) ^ 0x8408;
+			else
+				crc >>= 1;
+		}
+	}
+	return crc;
+}
+
+/**
+ * @brief Check the table driven CRC against the X.25 check value and the bitwise reference, then benchmark both
+ * @return Number of failed checks
+ */
+static int crcSelfTest(void)
+{
+	int failures = 0;
+
+	static const uint8_t check[] = "123456789";
+	uint16_t crc = crc_ccit_block(CRC_CCIT_INIT_VAL, check, 9) ^ 0xFFFF;
+	printf("crc check value: %04X (expected 906E): %s\n", crc, (crc == 0x906E) ? "OK" : "FAIL");
+	if (crc != 0x906E)
+		failures++;
+
+	std::vector<uint8_t> buf(4096);
+	for (size_t i = 0; i < buf.size(); i++)
+		buf[i] = rand();
+
+	int mismatches = 0;
+	for (int n = 0; n < 1000; n++)
+	{
+		size_t len = rand() % 400;
+		size_t start = rand() % buf.size();
+		size_t first = (start + len > buf.size()) ? (buf.size() - start) : len;
+		uint16_t ref = crcBitwise(CRC_CCIT_INIT_VAL, &buf[start], first);
+		ref = crcBitwise(ref, &buf[0], len - first);
+		if (crc_ccit_ring(CRC_CCIT_INIT_VAL, buf.data(), buf.size(), start, len) != ref)
+			mismatches++;
+		if ((first == len) && (crc_ccit_block(CRC_CCIT_INIT_VAL, &buf[start], len) != ref))
+			mismatches++;
+	}
+	printf("crc random buffers: %d mismatches: %s\n", mismatches, mismatches ? "FAIL" : "OK");
+	if (mismatches)
+		failures++;
+
+	const int rounds = 2000;
+	volatile uint16_t sink = 0;
+	auto t0 = std::chrono::steady_clock::now();
+	for (int n = 0; n < rounds; n++)
+		sink = crcBitwise(sink, buf.data(), buf.size());
+	auto t1 = std::chrono::steady_clock::now();
+	for (int n = 0; n < rounds; n++)
+		sink = crc_ccit_block(sink, buf.data(), buf.size());
+	auto t2 = std::chrono::steady_clock::now();
+	double mb = (double)rounds * buf.size() / 1e6;
+	double bitwise = mb / std::chrono::duration<double>(t1 - t0).count();
+	double table = mb / std::chrono::duration<double>(t2 - t1).count();
+	printf("crc throughput: bitwise %.1f MB/s, table %.1f MB/s (%.1fx)\n", bitwise, table, table / bitwise);
+	return failures;
+}
+
+/**
+ * @brief Check the Reed-Solomon coder against the original LwFEC code for every FX.25 mode, then benchmark both
+ * @details Blocks get 0 to T/2 + 2 byte errors, so uncorrectable blocks are covered too
+ * @return Number of failed checks
+ */
+static int rsSelfTest(void)
+{
+	const int blocks = 4000;
+	const uint8_t fcr = 1; //FX25_RS_FCR
+	int failures = 0;
+	double refTotal = 0, optTotal = 0;
+
+	for (const struct Fx25Mode &mode : Fx25ModeList)
+	{
+		struct LwFecRS rs, ref;
+		RsInit(&rs, mode.T, fcr);
+		RsReference::RsInit(&ref, mode.T, fcr);
+
+		std::vector<uint8_t> clean((size_t)blocks * RS_BLOCK_SIZE), corrupted((size_t)blocks * RS_BLOCK_SIZE);
+		int encodeMismatches = 0;
+		for (int n = 0; n < blocks; n++)
+		{
+			uint8_t *c = &clean[(size_t)n * RS_BLOCK_SIZE];
+			uint8_t refBlock[RS_BLOCK_SIZE];
+			for (int i = 0; i < mode.K; i++)
+				c[i] = refBlock[i] = rand();
+			RsEncode(&rs, c, mode.K);
+			RsReference::RsEncode(&ref, refBlock, mode.K);
+			if (memcmp(c, refBlock, RS_BLOCK_SIZE))
+				encodeMismatches++;
+
+			//corrupt distinct bytes of the K + T transmitted ones
+			uint8_t *b = &corrupted[(size_t)n * RS_BLOCK_SIZE];
+			memcpy(b, c, RS_BLOCK_SIZE);
+			int errors = n % (mode.T / 2 + 3);
+			for (int e = 0; e < errors;)
+			{
+				int pos = rand() % (mode.K + mode.T);
+				if (b[pos] != c[pos])
+					continue;
+				b[pos] ^= 1 + rand() % 255;
+				e++;
+			}
+		}
+
+		int mismatches = 0, refFailsFixed = 0, corrected = 0, failed = 0;
+		for (int n = 0; n < blocks; n++)
+		{
+			uint8_t refBlock[RS_BLOCK_SIZE], optBlock[RS_BLOCK_SIZE];
+			memcpy(refBlock, &corrupted[(size_t)n * RS_BLOCK_SIZE], RS_BLOCK_SIZE);
+			memcpy(optBlock, refBlock, RS_BLOCK_SIZE);
+			uint8_t refFixed = 0, optFixed = 0;
+			bool refOk = RsReference::RsDecode(&ref, refBlock, mode.K, &refFixed);
+			bool optOk = RsDecode(&rs, optBlock, mode.K, &optFixed);
+			if (optOk)
+				corrected++;
+			else
+				failed++;
+			if (refOk != optOk)
+			{
+				//the original Chien search takes zero locator coefficients as 1 and gives up on some correctable blocks
+				if (!refOk && !memcmp(optBlock, &clean[(size_t)n * RS_BLOCK_SIZE], mode.K))
+					refFailsFixed++;
+				else
+					mismatches++;
+			}
+			else if (optOk && ((refFixed != optFixed) || memcmp(refBlock, optBlock, RS_BLOCK_SIZE)))
+				mismatches++;
+		}
+
+		std::vector<uint8_t> work(corrupted);
+		auto t0 = std::chrono::steady_clock::now();
+		for (int n = 0; n < blocks; n++)
+		{
+			uint8_t fixed;
+			RsReference::RsDecode(&ref, &work[(size_t)n * RS_BLOCK_SIZE], mode.K, &fixed);
+		}
+		auto t1 = std::chrono::steady_clock::now();
+		work = corrupted;
+		auto t2 = std::chrono::steady_clock::now();
+		for (int n = 0; n < blocks; n++)
+		{
+			uint8_t fixed;
+			RsDecode(&rs, &work[(size_t)n * RS_BLOCK_SIZE], mode.K, &fixed);
+		}
+		auto t3 = std::chrono::steady_clock::now();
+		double refTime = std::chrono::duration<double>(t1 - t0).count();
+		double optTime = std::chrono::duration<double>(t3 - t2).count();
+		refTotal += refTime;
+		optTotal += optTime;
+
+		printf("rs K=%3u T=%2u: %d blocks, %d decoded, %d uncorrectable, %d encode / %d decode mismatches, %d fixed where the original failed: %s\n",
+			   mode.K, mode.T, blocks, corrected, failed, encodeMismatches, mismatches, refFailsFixed,
+			   (encodeMismatches || mismatches) ? "FAIL" : "OK");
+		printf("  decode %.1f us/block original, %.1f us/block optimized (%.1fx)\n",
+			   refTime * 1e6 / blocks, optTime * 1e6 / blocks, refTime / optTime);
+		if (encodeMismatches || mismatches)
+			failures++;
+	}
+	printf("rs decode total: original %.3f s, optimized %.3f s (%.1fx)\n", refTotal, optTotal, refTotal / optTotal);
+	return failures;
+}
+
+/**
+ * @brief Store a callsign in AX.25 address format
+ */
+static void putCall(uint8_t *out, const char *call, uint8_t ssid, bool last)
+{
+	for (uint8_t i = 0; i < 6; i++)
+		out[i] = ((*call) ? *call++ : ' ') << 1;
+	out[6] = 0x60 | (ssid << 1) | (last ? 1 : 0);
+}
+
+/**
+ * @brief Check FX.25 correlation tag matching with bit errors
+ * @details FX.25 frames from the TX path are fed bit by bit into the receiver with 0 to FX25_TAG_DISTANCE_MAX + 2
+ * bits of the tag flipped. Up to the tag distance limit every frame must come out of the FX.25 decoder,
+ * beyond it none may (the embedded AX.25 frame is still received without FEC).
+ * @param distance Tag distance limit
+ * @return Number of failed checks
+ */
+static int tagSelfTest(uint8_t distance)
+{
+	const int trials = 200;
+	int failures = 0;
+
+	ModemInit();
+	Ax25Init(2);
+	Fx25Init();
+	Fx25TagDistance(distance);
+	Ax25Csma(Ax25Config.slotTime, 255);
+
+	//one FX.25 transmission as the bit sequence before NRZI, the same bits the receiver gets after NRZI decoding
+	uint8_t frame[AX25_FRAME_MAX_SIZE];
+	putCall(&frame[0], "APRS", 0, false);
+	putCall(&frame[7], "N0CALL", 1, false);
+	putCall(&frame[14], "WIDE1", 1, true);
+	frame[21] = AX25_CTRL_UI;
+	frame[22] = AX25_PID_NOLAYER3;
+	uint16_t size = 23 + sprintf((char *)&frame[23], "!1234.56N/12345.67E-tag test");
+	const struct Fx25Mode *mode = Fx25GetModeForSize(size + 4 + (size / 5) + 1);
+	Ax25WriteTxFrame(frame, size);
+	Ax25TransmitBuffer();
+	hostMillis += Ax25Config.quietTime + 1;
+	Ax25TransmitCheck();
+	std::vector<uint8_t> bits;
+	while (Ax25TxBusy() && (bits.size() < 100000))
+		bits.push_back(Ax25GetTxBit());
+	bits.insert(bits.end(), 64, 0); //idle after the frame
+
+	size_t tagStart = 0;
+	for (; tagStart + 64 <= bits.size(); tagStart++)
+	{
+		uint64_t tag = 0;
+		for (int i = 0; i < 64; i++)
+			tag |= (uint64_t)bits[tagStart + i] << i;
+		if (tag == mode->tag)
+			break;
+	}
+	if (tagStart + 64 > bits.size())
+	{
+		printf("fx25 tag not found in the TX bit stream: FAIL\n");
+		return 1;
+	}
+
+	for (uint8_t errors = 0; errors <= FX25_TAG_DISTANCE_MAX + 2; errors++)
+	{
+		Ax25ClearRxStats();
+		for (int n = 0; n < trials; n++)
+		{
+			std::vector<uint8_t> rx(bits);
+			for (uint8_t e = 0; e < errors;)
+			{
+				size_t pos = tagStart + rand() % 64;
+				if (rx[pos] != bits[pos])
+					continue;
+				rx[pos] ^= 1;
+				e++;
+			}
+			for (uint8_t bit : rx)
+				Ax25BitParse(bit, 0, 0, 0);
+			struct Ax25RxFrame *f;
+			while ((f = Ax25BorrowRxFrame()) != NULL)
+				Ax25ReleaseRxFrame(f);
+		}
+		struct Ax25RxStats stats;
+		Ax25GetRxStats(&stats);
+		bool ok = (errors <= distance) ? ((stats.fx25Frames == trials) && (stats.fx25TagFixed == (errors ? trials : 0)))
+									   : (stats.fx25Frames == 0);
+		printf("fx25 tag with %2u bit errors: %3u/%d FX.25 frames, %3u with tag errors, %3u frames in total: %s\n",
+			   errors, stats.fx25Frames, trials, stats.fx25TagFixed, stats.frames, ok ? "OK" : "FAIL");
+		if (!ok)
+			failures++;
+	}
+	return failures;
+}
+
+/**
+ * @brief Transmit everything in the AX.25 TX buffer and append the rendered audio
+ * @param[out] *out Audio at CONFIG_AFSK_DAC_SAMPLERATE, followed by a gap of silence
+ */
+static void renderTxBuffer(std::vector<int16_t> *out)
+{
+	Ax25TransmitBuffer();
+	hostMillis += Ax25Config.quietTime + 1;
+	Ax25TransmitCheck();
+
+	int16_t block[256];
+	size_t got;
+	do
+	{
+		got = ModemTxRender(block, 256);
+		out->insert(out->end(), block, block + got);
+	} while (got == 256);
+	ModemTransmitStop();
+	out->insert(out->end(), CONFIG_AFSK_DAC_SAMPLERATE / 4, 0); //gap between transmissions
+}
+
+/**
+ * @brief Render test packets with the TX path (the same ModemTxRender() the DMA engine streams)
+ * @param[out] *out Rendered audio at CONFIG_AFSK_DAC_SAMPLERATE, 16-bit
+ * @return True on success
+ */
+static bool renderTxPackets(int count, std::vector<int16_t> *out)
+{
+	out->assign(CONFIG_AFSK_DAC_SAMPLERATE / 2, 0); //lead-in silence
+	Ax25Csma(Ax25Config.slotTime, 255); //transmit in the first free slot, the channel is always free here
+	struct Ax25TxStats before, after;
+	Ax25GetTxStats(&before);
+	for (int n = 0; n < count; n++)
+	{
+		uint8_t frame[AX25_FRAME_MAX_SIZE];
+		putCall(&frame[0], "APRS", 0, false);
+		putCall(&frame[7], "N0CALL", 1, false);
+		putCall(&frame[14], "WIDE1", 1, true);
+		frame[21] = AX25_CTRL_UI;
+		frame[22] = AX25_PID_NOLAYER3;
+		uint16_t size = 23 + sprintf((char *)&frame[23], "!1234.56N/12345.67E-test packet %d", n);
+
+		if (Ax25WriteTxFrame(frame, size) == NULL)
+		{
+			fprintf(stderr, "TX buffer full\n");
+			return false;
+		}
+		renderTxBuffer(out);
+	}
+	Ax25GetTxStats(&after);
+	if ((after.frames - before.frames) != (uint32_t)count) //plain and FX.25 frames are both counted
+	{
+		fprintf(stderr, "TX counted %u frames, sent %d\n", after.frames - before.frames, count);
+		return false;
+	}
+	return true;
+}
+
+/* -------------------------------------------------------------------------- */
+/* AGWPE session test                                                         */
+/* -------------------------------------------------------------------------- */
+
+struct AgwStub
+{
+	std::vector<std::vector<uint8_t>> replies; //messages the session wrote to the client
+	std::vector<std::vector<uint8_t>> sent; //frames the session handed to the TX path
+};
+
+static void agwStubWrite(void *arg, const uint8_t *msg, size_t len)
+{
+	((struct AgwStub *)arg)->replies.push_back(std::vector<uint8_t>(msg, msg + len));
+}
+
+static void agwStubSend(void *arg, uint8_t port, const uint8_t *frame, size_t len)
+{
+	((struct AgwStub *)arg)->sent.push_back(std::vector<uint8_t>(frame, frame + len));
+	if (Ax25WriteTxFrame((uint8_t *)frame, len) == NULL)
+		fprintf(stderr, "TX buffer full\n");
+}
+
+/**
+ * @brief Send a message the way a client does, split into small writes to test reassembly
+ */
+static void agwStubRequest(struct AgwSession *s, uint8_t kind, const char *from, const char *to, const void *data, uint32_t len)
+{
+	uint8_t msg[AGW_MAX_MESSAGE];
+	AgwBuildHeader(msg, 0, kind, 0, from, to, len);
+	memcpy(&msg[AGW_HEADER_SIZE], data, len);
+	for (uint32_t i = 0; i < AGW_HEADER_SIZE + len; i += 7)
+		AgwReceive(s, &msg[i], (AGW_HEADER_SIZE + len - i < 7) ? AGW_HEADER_SIZE + len - i : 7);
+}
+
+/**
+ * @brief Check the reply to the last request
+ * @return True if there is exactly one new reply of the kind, *data set to its data
+ */
+static bool agwStubReply(struct AgwStub *stub, size_t *seen, uint8_t kind, const uint8_t **data, uint32_t *len)
+{
+	if (stub->replies.size() != *seen + 1)
+		return false;
+	const std::vector<uint8_t> &m = stub->replies[(*seen)++];
+	uint8_t k;
+	*len = AgwParseHeader(m.data(), NULL, &k, NULL, NULL, NULL);
+	*data = &m[AGW_HEADER_SIZE];
+	return (k == kind) && (m.size() == AGW_HEADER_SIZE + *len);
+}
+
+static bool agwCheck(const char *what, bool ok)
+{
+	printf("agw %-44s %s\n", what, ok ? "OK" : "FAIL");
+	return ok;
+}
+
+/**
+ * @brief Drive an AGWPE session like a client would: query the TNC, register, transmit with
+ * 'M', 'V' and 'K' through the modem, then decode the audio and check the monitor and raw
+ * messages built from the received frames
+ * @return Number of failed checks
+ */
+static int agwSelfTest()
+{
+	static struct AgwSession session;
+	struct AgwStub stub;
+	size_t seen = 0;
+	const uint8_t *data;
+	uint32_t len;
+	int failures = 0;
+
+	ModemInit();
+	Ax25Init(0);
+	AgwInit(&session, agwStubWrite, agwStubSend, &stub);
+
+	agwStubRequest(&session, 'R', NULL, NULL, NULL, 0);
+	failures += !agwCheck("'R' version", agwStubReply(&stub, &seen, 'R', &data, &len) && (len == 8) && ((data[0] | (data[1] << 8)) == 2005));
+	agwStubRequest(&session, 'G', NULL, NULL, NULL, 0);
+	failures += !agwCheck("'G' port information", agwStubReply(&stub, &seen, 'G', &data, &len) && (strncmp((const char *)data, "1;Port1 1200 Bd AFSK;", len) == 0));
+	agwStubRequest(&session, 'g', NULL, NULL, NULL, 0);
+	failures += !agwCheck("'g' port capabilities", agwStubReply(&stub, &seen, 'g', &data, &len) && (len == 12) && (data[0] == 0));
+	agwStubRequest(&session, 'X', "N0CALL-1", NULL, NULL, 0);
+	failures += !agwCheck("'X' register", agwStubReply(&stub, &seen, 'X', &data, &len) && (len == 1) && (data[0] == 1));
+	agwStubRequest(&session, 'X', "N0CALL-1", NULL, NULL, 0);
+	failures += !agwCheck("'X' register again fails", agwStubReply(&stub, &seen, 'X', &data, &len) && (len == 1) && (data[0] == 0));
+	agwStubRequest(&session, 'x', "N0CALL-1", NULL, NULL, 0);
+	failures += !agwCheck("'x' unregister", (session.callCount == 0) && (stub.replies.size() == seen));
+	agwStubRequest(&session, 'm', NULL, NULL, NULL, 0);
+	agwStubRequest(&session, 'k', NULL, NULL, NULL, 0);
+	failures += !agwCheck("'m' and 'k' toggles", session.monitor && session.raw);
+
+	//one of each transmit kind, they go out in one burst
+	const char *info = "!1234.56N/12345.67E-agw M";
+	agwStubRequest(&session, 'M', "N0CALL-1", "APRS", info, strlen(info));
+	uint8_t via[64] = {2}; //digipeater count, callsigns, info
+	strcpy((char *)&via[1], "WIDE1-1");
+	strcpy((char *)&via[1 + AGW_CALL_SIZE], "WIDE2-2");
+	len = 1 + 2 * AGW_CALL_SIZE + sprintf((char *)&via[1 + 2 * AGW_CALL_SIZE], ">agw V");
+	agwStubRequest(&session, 'V', "N0CALL-2", "APRS", via, len);
+	uint8_t raw[64] = {0}; //KISS data command of port 0
+	putCall(&raw[1], "APRS", 0, false);
+	putCall(&raw[8], "N0CALL", 3, true);
+	raw[15] = AX25_CTRL_UI;
+	raw[16] = 0xCF; //NET/ROM, UI frames of any protocol are monitored
+	len = 17 + sprintf((char *)&raw[17], ">agw K");
+	agwStubRequest(&session, 'K', NULL, NULL, raw, len);
+	failures += !agwCheck("'M', 'V' and 'K' frames queued", (stub.sent.size() == 3) && (stub.replies.size() == seen) &&
+														  (stub.sent[2].size() == len - 1) && !memcmp(stub.sent[2].data(), &raw[1], len - 1));
+
+	struct WavData wav;
+	wav.sampleRate = CONFIG_AFSK_DAC_SAMPLERATE;
+	wav.samples.assign(CONFIG_AFSK_DAC_SAMPLERATE / 2, 0);
+	Ax25Csma(Ax25Config.slotTime, 255);
+	renderTxBuffer(&wav.samples);
+	std::vector<int16_t> samples;
+	prepareSamples(&wav, 9600, 4, &samples);
+	ModemInit();
+	Ax25Init(0);
+	Ax25Config.allowNonAprs = 1; //receive the NET/ROM frame too
+	for (size_t i = 0; i < samples.size(); i += 96)
+		ModemDecodeBlock(0, &samples[i], (samples.size() - i < 96) ? samples.size() - i : 96, 0);
+
+	static const char *monitors[] = {
+		" 1:Fm N0CALL-1 To APRS <UI pid=F0 Len=25 >",
+		" 1:Fm N0CALL-2 To APRS Via WIDE1-1,WIDE2-2 <UI pid=F0 Len=6 >",
+		" 1:Fm N0CALL-3 To APRS <UI pid=CF Len=6 >",
+	};
+	const char *infos[] = {info, ">agw V", ">agw K"};
+	size_t received = 0;
+	struct Ax25RxFrame *frame;
+	while ((frame = Ax25BorrowRxFrame()) != NULL)
+	{
+		uint8_t msg[AGW_MAX_MESSAGE];
+		char what[64], from[AGW_CALL_SIZE + 1], to[AGW_CALL_SIZE + 1];
+		uint8_t port, kind;
+		bool ok = (received < stub.sent.size()) && (frame->size == stub.sent[received].size()) &&
+				  !memcmp(frame->data, stub.sent[received].data(), frame->size);
+
+		size_t size = AgwMonitorMessage(msg, sizeof(msg), frame->port, frame->data, frame->size);
+		len = AgwParseHeader(msg, &port, &kind, NULL, from, to);
+		const char *text = (const char *)&msg[AGW_HEADER_SIZE];
+		ok = ok && (size == AGW_HEADER_SIZE + len) && (kind == 'U') && (port == 0) && !strcmp(to, "APRS") && (text[len - 1] == 0) &&
+			 !strncmp(text, monitors[received], strlen(monitors[received])) && (strstr(text, "]\r") != NULL);
+		if (ok)
+		{
+			const char *body = strstr(text, "]\r") + 2;
+			ok = (strlen(body) == strlen(infos[received]) + 1) && !strncmp(body, infos[received], strlen(infos[received])) && (body[strlen(body) - 1] == '\r');
+		}
+
+		size = AgwRawMessage(msg, sizeof(msg), frame->port, frame->data, frame->size);
+		len = AgwParseHeader(msg, &port, &kind, NULL, NULL, NULL);
+		ok = ok && (kind == 'K') && (len == frame->size + 1u) && (msg[AGW_HEADER_SIZE] == 0) && !memcmp(&msg[AGW_HEADER_SIZE + 1], frame->data, frame->size);
+
+		snprintf(what, sizeof(what), "frame %zu 'U' and 'K' messages", received + 1);
+		failures += !agwCheck(what, ok);
+		received++;
+		Ax25ReleaseRxFrame(frame);
+	}
+	failures += !agwCheck("all frames received", received == stub.sent.size());
+	return failures;
+}
+
+/**
+ * @brief Render test packets with the TX path into a WAV file
+ * @return 0 on success
+ */
+static int renderTx(const char *path, int count)
+{
+	std::vector<int16_t> out;
+	if (!renderTxPackets(count, &out) || !saveWav(path, CONFIG_AFSK_DAC_SAMPLERATE, out))
+		return 1;
+	printf("%s: %d packets, %zu samples at %u Hz\n", path, count, out.size(), CONFIG_AFSK_DAC_SAMPLERATE);
+	return 0;
+}
+
+/* -------------------------------------------------------------------------- */
+/* Duplicate check test                                                       */
+/* -------------------------------------------------------------------------- */
+
+// Hash of a line that is known to be a packet
+static uint64_t dupeTnc2Hash(const char *s, size_t len)
+{
+	uint64_t h = 0;
+	DupeHashTnc2(s, len, &h);
+	return h;
+}
+
+/**
+ * @brief Replay a busy channel through a duplicate window and compare it with an exact reference
+ * @details Packets arrive at 100 per second for 10 minutes. A quarter of them are copies of
+ * an earlier packet, up to two windows later and with another path, as heard through other
+ * digipeaters or from APRS-IS.
+ * @return Number of failed checks
+ */
+static int dupeSelfTest(void)
+{
+	const uint32_t window = 30000;
+	const int rate = 100;
+	const int seconds = 600;
+	static struct DupeTable table = DupeTableInit(4096, window);
+	int failures = 0;
+
+	//the path and the destination SSID do not count, the source SSID and the information field do
+	AX25Msg msg;
+	memset(&msg, 0, sizeof(msg));
+	strcpy(msg.src.call, "N0CALL");
+	msg.src.ssid = 9;
+	strcpy(msg.dst.call, "APRS");
+	msg.dst.ssid = 2;
+	msg.len = sprintf((char *)msg.info, "!1234.56N/12345.67E>test  \r");
+	const char *same[] = {"N0CALL-9>APRS:!1234.56N/12345.67E>test", "N0CALL-9>APRS-1,WIDE1*,WIDE2-1:!1234.56N/12345.67E>test",
+						  "N0CALL-9>APRS,TCPIP*,qAC,T2TEST:!1234.56N/12345.67E>test \r\n"};
+	const char *other[] = {"N0CALL-8>APRS:!1234.56N/12345.67E>test", "N0CALL-9>APZ:!1234.56N/12345.67E>test",
+						   "N0CALL-9>APRS:!1234.56N/12345.67E>tesT"};
+	bool ok = true;
+	for (const char *s : same)
+		ok = ok && (dupeTnc2Hash(s, strlen(s)) == DupeHashAx25(&msg));
+	for (const char *s : other)
+		ok = ok && (dupeTnc2Hash(s, strlen(s)) != DupeHashAx25(&msg));
+	printf("dupe hash ignores path and destination SSID: %s\n", ok ? "OK" : "FAIL");
+	failures += !ok;
+
+	//text that is not a packet has no hash, so it is never taken for a duplicate
+	uint64_t none;
+	const char *bad[] = {"# aprsc 2.1.19", "N0CALL-9 APRS:no source end", "N0CALL-9>APRS no info"};
+	ok = true;
+	for (const char *s : bad)
+		ok = ok && !DupeHashTnc2(s, strlen(s), &none);
+	printf("dupe hash skips lines that are not packets: %s\n", ok ? "OK" : "FAIL");
+	failures += !ok;
+
+	srand(1);
+	std::vector<std::string> lines;
+	std::vector<uint32_t> times;
+	std::vector<int> original; //the packet each line is a copy of, itself if it is new
+	for (int i = 0; i < rate * seconds; i++)
+	{
+		uint32_t now = 1000 + (uint32_t)i * 1000 / rate;
+		char line[128];
+		int copyOf = -1;
+		if ((i > 0) && ((rand() % 4) == 0))
+		{
+			//a copy of a packet from up to two windows ago
+			int back = 1 + rand() % (2 * window * rate / 1000);
+			copyOf = (i > back) ? original[i - back] : original[0];
+			const std::string &o = lines[copyOf];
+			size_t colon = o.find(':');
+			snprintf(line, sizeof(line), "%.*s,WIDE%d*%s", (int)o.find(','), o.c_str(), 1 + rand() % 2, o.c_str() + colon);
+		}
+		else
+			snprintf(line, sizeof(line), "N%dTST-%d>APRS,WIDE1-1:!%04d.%02dN/%05d.%02dE>seq %d", rand() % 500, rand() % 16,
+					 rand() % 9000, rand() % 100, rand() % 18000, rand() % 100, i);
+		lines.push_back(line);
+		times.push_back(now);
+		original.push_back((copyOf >= 0) ? copyOf : i);
+	}
+
+	std::vector<uint32_t> remembered(lines.size(), 0); //reference: when each original was last remembered, 0 if never
+	uint32_t tickSlack = 2 * ((window + DUPE_WHEEL_SLOTS - 2) / (DUPE_WHEEL_SLOTS - 1));
+	int missed = 0, extra = 0, uncertain = 0, peak = 0;
+	double elapsed = 0;
+	for (size_t i = 0; i < lines.size(); i++)
+	{
+		auto t0 = std::chrono::steady_clock::now();
+		bool dupe = DupeCheck(&table, dupeTnc2Hash(lines[i].c_str(), lines[i].size()), times[i]);
+		elapsed += std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+		if (table.count > peak)
+			peak = table.count;
+
+		uint32_t &first = remembered[original[i]];
+		bool expected = (first != 0) && ((times[i] - first) < window);
+		bool possible = (first != 0) && ((times[i] - first) <= window + tickSlack);
+		if (dupe && !possible)
+			extra++;
+		else if (!dupe && expected)
+			missed++;
+		else if (dupe != expected)
+			uncertain++;
+		if (!dupe)
+			first = times[i];
+	}
+	ok = (missed == 0) && (extra == 0) && (table.evicted == 0);
+	printf("dupe %d packets in %d s: %u dupes, %d missed, %d wrong, %d within a wheel tick of the window end, peak %d/%u entries, %u evicted: %s\n",
+		   (int)lines.size(), seconds, table.dupes, missed, extra, uncertain, peak, table.capacity, table.evicted, ok ? "OK" : "FAIL");
+	printf("dupe check time: %.0f ns per packet, %.0f packets/s\n", elapsed * 1e9 / lines.size(), lines.size() / elapsed);
+	failures += !ok;
+
+	//a window too small for the channel drops the oldest entries first and keeps working
+	static struct DupeTable small = DupeTableInit(256, window);
+	for (size_t i = 0; i < lines.size(); i++)
+		DupeCheck(&small, dupeTnc2Hash(lines[i].c_str(), lines[i].size()), times[i]);
+	ok = (small.count == small.capacity) && (small.evicted > 0) && DupeFind(&small, dupeTnc2Hash(lines.back().c_str(), lines.back().size()), times.back());
+	printf("dupe small window: %u evicted, newest still found: %s\n", small.evicted, ok ? "OK" : "FAIL");
+	failures += !ok;
+	return failures;
+}
+
+/**
+ * @brief Feed an APRS-IS stream through the line reader in chunks of random size, as TCP delivers it
+ * @details The stream mixes packets, server comments, LF and CR LF line ends and lines too long
+ * for the buffer. Every packet must come out parsed into the fields it was built from, the long
+ * lines must be dropped without taking the next line with them. The same stream is also read the
+ * way the firmware did before, a String grown byte by byte and copied for the fields.
+ * @return Number of failed checks
+ */
+static int aprsIsSelfTest(void)
+{
+	struct Expected
+	{
+		std::string src, dst, path, info;
+		bool packet;
+	};
+	std::vector<Expected> expected;
+	std::string stream;
+	int tooLong = 0;
+	srand(7);
+	for (int i = 0; i < 200000; i++)
+	{
+		int kind = rand() % 100;
+		char line[TNC2_LINE_MAX + 200];
+		if (kind == 0)
+		{
+			//longer than the buffer, its start looks like a packet
+			int n = TNC2_LINE_MAX + rand() % 150;
+			memset(line, 'x', n);
+			memcpy(line, "LONG>APRS:", 10);
+			line[n] = 0;
+			tooLong++;
+		}
+		else
+		{
+			Expected e;
+			if (kind < 5)
+			{
+				snprintf(line, sizeof(line), "# aprsc 2.1.19 17 Oct 2026 12:%02d:%02d GMT T2TEST 1.2.3.4:14580", rand() % 60, rand() % 60);
+				e.packet = false;
+			}
+			else
+			{
+				char src[16], dst[16], path[64], info[256];
+				snprintf(src, sizeof(src), "N%dTS-%d", rand() % 1000, rand() % 16);
+				snprintf(dst, sizeof(dst), (rand() % 2) ? "APRS" : "APE32A-%d", rand() % 16);
+				if (rand() % 8)
+					snprintf(path, sizeof(path), "WIDE1-1,qAR,T2GATE%d", rand() % 100);
+				else
+					path[0] = 0;
+				int n = snprintf(info, sizeof(info), "!%04d.%02dN/%05d.%02dE>", rand() % 9000, rand() % 100, rand() % 18000, rand() % 100);
+				for (int c = rand() % 180; c > 0; c--)
+					info[n++] = ' ' + rand() % 95;
+				info[n] = 0;
+				snprintf(line, sizeof(line), "%s>%s%s%s:%s", src, dst, path[0] ? "," : "", path, info);
+				e.src = src;
+				e.dst = dst;
+				e.path = path;
+				e.info = info;
+				e.packet = true;
+			}
+			expected.push_back(e);
+		}
+		stream += line;
+		stream += (rand() % 4) ? "\r\n" : "\n";
+	}
+
+	//line reader, chunks up to a TCP segment as aprsClient.read() hands them out
+	struct LineReader reader;
+	memset(&reader, 0, sizeof(reader));
+	LineReaderInit(&reader);
+	size_t pos = 0, idx = 0;
+	int wrong = 0, packets = 0;
+	auto t0 = std::chrono::steady_clock::now();
+	while (pos < stream.size())
+	{
+		char *at;
+		size_t room = LineReaderSpace(&reader, &at);
+		size_t n = 1 + rand() % 1460;
+		if (n > room)
+			n = room;
+		if (n > stream.size() - pos)
+			n = stream.size() - pos;
+		memcpy(at, &stream[pos], n);
+		pos += n;
+		LineReaderCommit(&reader, n);
+		size_t len;
+		char *line;
+		while ((line = LineReaderNext(&reader, &len)) != NULL)
+		{
+			struct Tnc2View v;
+			bool packet = Tnc2Parse(line, len, &v);
+			if (idx >= expected.size())
+			{
+				wrong++;
+				continue;
+			}
+			const Expected &e = expected[idx++];
+			if (packet != e.packet)
+				wrong++;
+			else if (packet && ((e.src != std::string(v.src, v.srcLen)) || (e.dst != std::string(v.dst, v.dstLen)) ||
+								(e.path != std::string(v.path, v.pathLen)) || (e.info != std::string(v.info, v.infoLen)) ||
+								(strlen(line) != len)))
+				wrong++;
+			packets += packet;
+		}
+	}
+	double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+	bool ok = (wrong == 0) && (idx == expected.size()) && (reader.overflows == (uint32_t)tooLong);
+	printf("aprsis %d lines, %d packets, %d too long: %d wrong, %d missing, %u overflows: %s\n", (int)expected.size() + tooLong, packets,
+		   tooLong, wrong, (int)(expected.size() - idx), reader.overflows, ok ? "OK" : "FAIL");
+
+	//the former reader: a String grown byte by byte up to the line end, fields copied out of it
+	static volatile size_t fields; //keeps the copies from being optimized away
+	fields = 0;
+	t0 = std::chrono::steady_clock::now();
+	std::string line;
+	for (size_t i = 0; i < stream.size(); i++)
+	{
+		char c = stream[i];
+		if (c != '\n')
+		{
+			line += c;
+			continue;
+		}
+		size_t gt = line.find('>');
+		size_t colon = line.find(':');
+		if ((line[0] != '#') && (gt != std::string::npos) && (colon != std::string::npos))
+		{
+			std::string src = line.substr(0, gt);
+			std::string info = line.substr(colon + 1);
+			fields += src.size() + info.size();
+		}
+		line = std::string();
+	}
+	double baseline = std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+	printf("aprsis read and parse: %.0f lines/s, %.1f MB/s (String copies: %.0f lines/s)\n", expected.size() / elapsed,
+		   stream.size() / elapsed / 1e6, expected.size() / baseline);
+	return !ok;
+}
+
+/**
+ * @brief Packet as ParseAPRS::parse_aprs() leaves it, with the parsed fields given by the caller
+ */
+static void filterPacket(struct pbuf_t *pb, const char *line, uint16_t type, float lat, float lon, const char *symbol,
+						 const char *name)
+{
+	memset(pb, 0, sizeof(*pb));
+	pb->packet_len = strlen(line);
+	memcpy(pb->data, line, pb->packet_len);
+	const char *gt = strchr(pb->data, '>');
+	const char *colon = strchr(gt, ':');
+	const char *comma = (const char *)memchr(gt, ',', colon - gt);
+	pb->srccall_end = gt;
+	pb->dstcall_end = comma ? comma : colon;
+	pb->info_start = colon + 1;
+	pb->packettype = type | T_ALL;
+	if (!isnan(lat))
+	{
+		pb->lat = lat;
+		pb->lng = lon;
+		pb->flags |= F_HASPOS;
+	}
+	if (symbol)
+		strcpy(pb->symbol, symbol);
+	if (name)
+	{
+		pb->srcname = strstr(pb->data, name);
+		pb->srcname_len = strlen(name);
+	}
+}
+
+static bool filterStation(const char *call, float *lat, float *lon)
+{
+	if (strcasecmp(call, "HS5TQA-9") != 0)
+		return false;
+	*lat = 13.78f;
+	*lon = 100.55f;
+	return true;
+}
+
+/**
+ * @brief Check every filter type against hand parsed packets, then time a typical filter on a busy feed
+ * @return Number of failed checks
+ */
+static int filterSelfTest(void)
+{
+	struct pbuf_t pos, obj, msg, wx, far, dig;
+	filterPacket(&pos, "HS5TQA-7>APE32A,WIDE1-1,qAR,HS5TQA-10:!1345.00N/10030.00E>test", T_POSITION, 13.75f, 100.5f, "/>", NULL);
+	filterPacket(&obj, "HS1ABC>APRS,TCPIP*,qAC,T2THAI:;REPEATER*111111z1345.00N/10031.00Er145.000", T_OBJECT | T_POSITION, 13.75f,
+				 100.52f, "/r", "REPEATER");
+	filterPacket(&msg, "E27XYZ>APDR16,TCPIP*,qAC,T2ASIA::HS5TQA-7 :hello{1", T_MESSAGE, NAN, 0, "/]", NULL);
+	filterPacket(&wx, "HS2WX>APRS,HS3DIG*,WIDE2-1,qAR,HS2IG:@171200z1500.00N\\10100.00E_090/005g010t088", T_WX | T_POSITION,
+				 15.0f, 101.0f, "\\_", NULL);
+	filterPacket(&far, "N0CALL>APRS,qAS,W1GATE:!4000.00N/07500.00W-", T_POSITION, 40.0f, -75.0f, "/-", NULL);
+	filterPacket(&dig, "HS9ZZZ>APRS,HS3DIG,HS4DIG*,WIDE2,qAO,HS9IG:>status", T_STATUS, NAN, 0, NULL, NULL);
+	struct
+	{
+		const char *filter;
+		const struct pbuf_t *pb;
+		bool pass;
+	} cases[] = {
+		{"r/13.75/100.5/10", &pos, true},
+		{"r/13.75/100.5/10", &obj, true},
+		{"r/13.75/100.5/10", &wx, false},
+		{"r/13.75/100.5/200", &wx, true},
+		{"r/13.75/100.5/10000", &msg, false},
+		{"m/10", &pos, true},
+		{"m/10", &far, false},
+		{"a/14/100/13/101", &pos, true},
+		{"a/14/100/13/101", &wx, false},
+		{"f/HS5TQA-9/10", &pos, true},
+		{"f/HS5TQA-9/1", &pos, false},
+		{"f/NOBODY/1000", &pos, false},
+		{"b/HS5TQA-7", &pos, true},
+		{"b/hs5tqa-7", &pos, true},
+		{"b/HS5TQA", &pos, false},
+		{"b/HS5TQA*", &pos, true},
+		{"b/N0CALL/HS5*", &far, true},
+		{"p/HS/E2", &msg, true},
+		{"p/HS", &msg, false},
+		{"o/REPEATER", &obj, true},
+		{"o/REPEAT*", &obj, true},
+		{"o/REPEAT", &obj, false},
+		{"o/HS1ABC", &obj, false},
+		{"t/m", &msg, true},
+		{"t/poi", &msg, false},
+		{"t/w", &wx, true},
+		{"t/o", &obj, true},
+		{"t/p/HS5TQA-9/10", &pos, true},
+		{"t/p/HS5TQA-9/10", &far, false},
+		{"s/>", &pos, true},
+		{"s/-", &pos, false},
+		{"s//_", &wx, true},
+		{"s//_/5", &wx, false},
+		{"d/HS3DIG", &wx, true},
+		{"d/HS3DIG", &dig, true},
+		{"d/HS4DIG", &dig, true},
+		{"d/WIDE2", &dig, false},
+		{"d/HS3DIG", &pos, false},
+		{"q/R", &pos, true},
+		{"q/CX", &pos, false},
+		{"q/CX", &obj, true},
+		{"q/O", &dig, true},
+		{"e/HS5TQA-10", &pos, true},
+		{"e/T2*", &obj, true},
+		{"e/T2*", &pos, false},
+		{"u/APE32*", &pos, true},
+		{"u/APRS", &pos, false},
+		{"r/13.75/100.5/50 -t/w", &pos, true},
+		{"r/13.75/100.5/500 -t/w", &wx, false},
+		{"t/pm -b/E27XYZ", &msg, false},
+		{"-b/E27XYZ", &pos, false},
+		{"b/HS5TQA-7 -p/N0", &pos, true},
+		{"x/1 b/HS5TQA-7", &pos, true},
+	};
+	aprsFilterSetHome(13.76f, 100.51f);
+	aprsFilterSetLookup(filterStation);
+	int failures = 0;
+	static aprsFilter filter;
+	for (auto &c : cases)
+	{
+		aprsFilterCompile(&filter, c.filter);
+		if (aprsFilterMatch(&filter, c.pb) != c.pass)
+		{
+			printf("filter '%s' on %s: %s expected\n", c.filter, c.pb->data, c.pass ? "pass" : "drop");
+			failures++;
+		}
+	}
+	bool ok = (failures == 0);
+	printf("filter %d cases: %d wrong: %s\n", (int)(sizeof(cases) / sizeof(cases[0])), failures, ok ? "OK" : "FAIL");
+
+	ok = !aprsFilterCompile(&filter, "r/13/100 b/ t/z x/1 p/HS") && (filter.parts == 1) && (filter.errors == 4) &&
+		 aprsFilterCompile(&filter, "") && aprsFilterEmpty(&filter);
+	printf("filter errors skip the part only: %s\n", ok ? "OK" : "FAIL");
+	failures += !ok;
+
+	//a full feed seen by an IGate gating its area, its friends and messages, but no weather
+	const char *typical = "m/50 r/13.75/100.5/100 f/HS5TQA-9/20 b/HS5TQA* p/E2 t/m -t/w -d/WIDE7*";
+	aprsFilterCompile(&filter, typical);
+	struct pbuf_t *feed[] = {&pos, &obj, &msg, &wx, &far, &dig};
+	const int rounds = 200000;
+	int passed = 0;
+	auto t0 = std::chrono::steady_clock::now();
+	for (int i = 0; i < rounds; i++)
+		for (struct pbuf_t *pb : feed)
+			passed += aprsFilterMatch(&filter, pb);
+	double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+	int n = rounds * (int)(sizeof(feed) / sizeof(feed[0]));
+	printf("filter '%s': %d/%d passed, %.0f ns per packet\n", typical, passed, n, elapsed * 1e9 / n);
+	return failures;
+}
+
+/**
+ * @brief Heard list workload against a reference LRU list
+ * @details Stations are heard with a skewed rate from a population larger than the table, like an
+ * IGate on a busy feed. Every lookup, eviction and both list orders are checked against the
+ * reference, then the index is timed against the linear strstr() scan it replaces.
+ * @return Number of failed checks
+ */
+static int stationSelfTest(void)
+{
+	const uint16_t capacity = 2048;
+	const int population = 6000;
+	const int updates = 300000;
+	static struct StationDb db = StationDbInit(capacity);
+	int failures = 0;
+
+	//a callsign is never found by a part of it
+	static struct StationDb exact = StationDbInit(4);
+	uint16_t a = StationDbAdd(&exact, "HS5TQA-7", 8);
+	bool ok = (StationDbFind(&exact, "HS5T", 4) == STATIONDB_NONE) && (StationDbFind(&exact, "HS5TQA-7", 8) == a);
+	uint16_t b = StationDbAdd(&exact, "HS5T", 4);
+	ok = ok && (b != a) && (StationDbFind(&exact, "HS5T", 4) == b) && (StationDbFind(&exact, "HS5TQA-7", 8) == a);
+	printf("station exact match: %s\n", ok ? "OK" : "FAIL");
+	failures += !ok;
+
+	std::vector<std::string> calls;
+	char call[16];
+	for (int i = 0; i < population; i++)
+	{
+		snprintf(call, sizeof(call), "%c%c%d%c%c-%d", 'A' + i % 26, 'A' + (i / 26) % 26, i % 10, 'A' + (i / 260) % 26, 'A' + i % 7, i % 16);
+		calls.push_back(call);
+	}
+	srand(2);
+	std::vector<int> heard;
+	for (int i = 0; i < updates; i++)
+	{
+		int r = rand() % population;
+		heard.push_back((rand() % 4) ? r % (population / 20) : r); //most packets come from a few stations
+	}
+
+	std::list<int> recent; //reference, most recent first
+	std::map<int, std::list<int>::iterator> where;
+	std::map<int, uint32_t> counts;
+	std::vector<int> slotOf(population, -1);
+	int wrong = 0;
+	for (int s : heard)
+	{
+		const std::string &c = calls[s];
+		uint16_t i = StationDbFind(&db, c.c_str(), c.size());
+		bool known = where.count(s) > 0;
+		if (known != (i != STATIONDB_NONE) || (known && (i != slotOf[s])))
+			wrong++;
+		if (known)
+		{
+			StationDbTouch(&db, i);
+			if (StationDbCount(&db, i) != ++counts[s])
+				wrong++;
+			recent.erase(where[s]);
+		}
+		else
+		{
+			int oldest = (recent.size() == capacity) ? recent.back() : -1;
+			i = StationDbAdd(&db, c.c_str(), c.size());
+			if (oldest >= 0)
+			{
+				if (i != slotOf[oldest])
+					wrong++;
+				recent.pop_back();
+				where.erase(oldest);
+				counts.erase(oldest);
+				slotOf[oldest] = -1;
+			}
+			slotOf[s] = i;
+			counts[s] = 1;
+		}
+		recent.push_front(s);
+		where[s] = recent.begin();
+	}
+
+	std::vector<uint16_t> order;
+	for (int s : recent)
+		order.push_back(slotOf[s]);
+	size_t n = 0;
+	for (uint16_t i = StationDbFirst(&db, STATIONDB_RECENT); i != STATIONDB_NONE; i = StationDbNext(&db, i, STATIONDB_RECENT), n++)
+		wrong += (n >= order.size()) || (order[n] != i);
+	wrong += (n != order.size());
+	n = 0;
+	for (uint16_t i = StationDbFirst(&db, STATIONDB_OLDEST); i != STATIONDB_NONE; i = StationDbNext(&db, i, STATIONDB_OLDEST), n++)
+		wrong += (n >= order.size()) || (order[order.size() - 1 - n] != i);
+	wrong += (n != order.size());
+
+	std::vector<uint32_t> countOfSlot(capacity, 0);
+	for (auto &c : counts)
+		countOfSlot[slotOf[c.first]] = c.second;
+	uint32_t last = UINT32_MAX, top = 0;
+	n = 0;
+	for (uint16_t i = StationDbFirst(&db, STATIONDB_COUNT); i != STATIONDB_NONE; i = StationDbNext(&db, i, STATIONDB_COUNT), n++)
+	{
+		wrong += (countOfSlot[i] == 0) || (countOfSlot[i] > last);
+		last = countOfSlot[i];
+		if (n == 0)
+			top = last;
+	}
+	wrong += (n != counts.size());
+	ok = (wrong == 0) && (db.count == capacity);
+	printf("station %d packets from %d stations in %u slots: %u evicted, top count %u, %d wrong: %s\n", updates, population,
+		   capacity, db.evicted, top, wrong, ok ? "OK" : "FAIL");
+	failures += !ok;
+
+	//the heard list as it was: the table scanned with strstr() for every packet
+	std::vector<std::string> table(capacity);
+	for (int s : recent)
+		table[slotOf[s]] = calls[s];
+	int found = 0;
+	const int rounds = 20000;
+	auto t0 = std::chrono::steady_clock::now();
+	for (int r = 0; r < rounds; r++)
+	{
+		const std::string &c = calls[heard[r]];
+		for (uint16_t i = 0; i < capacity; i++)
+			if (strstr(table[i].c_str(), c.c_str()) != NULL)
+			{
+				found++;
+				break;
+			}
+	}
+	double scan = std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count() / rounds;
+	t0 = std::chrono::steady_clock::now();
+	for (int r = 0; r < updates; r++)
+	{
+		const std::string &c = calls[heard[r]];
+		found += StationDbFind(&db, c.c_str(), c.size()) != STATIONDB_NONE;
+	}
+	double hashed = std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count() / updates;
+	printf("station lookup in %u slots: %.0f ns indexed, %.0f ns scanned (%d found)\n", capacity, hashed * 1e9, scan * 1e9, found);
+	return failures;
+}
+
+/**
+ * @brief Packet buffer pool as the last heard list uses it
+ * @details 2048 stations are updated with packets of the lengths aprsc measured on APRS-IS,
+ * each update shares the RX buffer with the list and sometimes with a web page still showing
+ * the old packet. At the end every buffer has to be back except one per station. Then the
+ * classes are run empty to check the spill to a larger class and the failure count.
+ * @return Number of failed checks
+ */
+static int poolSelfTest(void)
+{
+	const uint16_t counts[PKTBUF_CLASSES] = {1600, 800, 64};
+	const int stations = 2048;
+	const int updates = 300000;
+	int failures = 0;
+	pktPoolInit(counts);
+
+	char *a = pktBufAlloc(PACKETLEN_MAX_SMALL - 1);
+	char *b = pktBufAlloc(PACKETLEN_MAX_SMALL);
+	char *c = pktBufAlloc(PACKETLEN_MAX_LARGE - 1);
+	bool ok = (a != NULL) && (pktBufSize(a) == PACKETLEN_MAX_SMALL) && (b != NULL) && (pktBufSize(b) == PACKETLEN_MAX_MEDIUM) &&
+			  (c != NULL) && (pktBufSize(c) == PACKETLEN_MAX_LARGE) && (pktBufAlloc(PACKETLEN_MAX_LARGE) == NULL) &&
+			  pktBufOwns(a) && !pktBufOwns(a + 1) && !pktBufOwns("N0CALL>APRS:x");
+	pktBufRef(a);
+	pktBufRelease(a);
+	pktPoolStats st[PKTBUF_CLASSES];
+	pktPoolGetStats(st);
+	ok = ok && (st[0].used == 1);
+	pktBufRelease(a);
+	pktBufRelease(b);
+	pktBufRelease(c);
+	pktPoolGetStats(st);
+	ok = ok && (st[0].used == 0) && (st[1].used == 0) && (st[2].used == 0) && (st[2].fails == 0);
+	printf("pool classes and references: %s\n", ok ? "OK" : "FAIL");
+	failures += !ok;
+
+	//lengths as measured by aprsc, cumulative percent at 80..150 bytes, 0.5% longer up to 300
+	const int lenAt[] = {80, 90, 100, 110, 120, 130, 140, 150, 300};
+	const double share[] = {25, 36, 73, 89, 94, 97, 98.7, 99.4, 100};
+	srand(3);
+	std::vector<char *> list(stations, (char *)NULL);
+	std::vector<char *> page; //packets a web page still shows
+	char line[PACKETLEN_MAX];
+	memset(line, 'x', sizeof(line));
+	int lost = 0;
+	auto t0 = std::chrono::steady_clock::now();
+	for (int i = 0; i < updates; i++)
+	{
+		double p = (rand() % 10000) / 100.0;
+		int k = 0;
+		while (share[k] <= p)
+			k++;
+		int len = (k == 0) ? 40 + rand() % 40 : lenAt[k - 1] + rand() % (lenAt[k] - lenAt[k - 1]);
+		char *rx = pktBufDup(line, len); //the RX path
+		if (rx == NULL)
+		{
+			lost++;
+			continue;
+		}
+		int s = rand() % stations;
+		if ((rand() % 50) == 0) //a page is being built from the old packet
+			page.push_back(pktBufRef(list[s]));
+		pktBufRelease(list[s]);
+		list[s] = pktBufRef(rx);
+		pktBufRelease(rx);
+		if (page.size() > 30)
+		{
+			for (char *q : page)
+				pktBufRelease(q);
+			page.clear();
+		}
+	}
+	double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+	for (char *q : page)
+		pktBufRelease(q);
+	pktPoolGetStats(st);
+	ok = (lost == 0) && (st[0].used + st[1].used + st[2].used == stations);
+	printf("pool %d updates of %d stations: %u/%u/%u used, peak %u/%u/%u of %u/%u/%u, %u spilled, %d lost: %s\n", updates, stations,
+		   st[0].used, st[1].used, st[2].used, st[0].peak, st[1].peak, st[2].peak, st[0].count, st[1].count, st[2].count,
+		   st[0].spills + st[1].spills + st[2].spills, lost, ok ? "OK" : "FAIL");
+	printf("pool update time: %.0f ns per packet\n", elapsed * 1e9 / updates);
+	failures += !ok;
+
+	//run the classes empty: small requests spill into medium, then large, then fail
+	std::vector<char *> held;
+	char *q;
+	while ((q = pktBufAlloc(10)) != NULL)
+		held.push_back(q);
+	pktPoolStats full[PKTBUF_CLASSES];
+	pktPoolGetStats(full);
+	ok = (full[0].used == full[0].count) && (full[1].used == full[1].count) && (full[2].used == full[2].count) &&
+		 (full[1].spills > st[1].spills) && (full[2].spills > st[2].spills) && (full[0].fails == st[0].fails + 1);
+	for (char *r : held)
+		pktBufRelease(r);
+	for (char *r : list)
+		pktBufRelease(r);
+	pktPoolGetStats(st);
+	ok = ok && (st[0].used == 0) && (st[1].used == 0) && (st[2].used == 0);
+	printf("pool exhausted: spills into larger classes, then fails, all buffers back after: %s\n", ok ? "OK" : "FAIL");
+	failures += !ok;
+	return failures;
+}
+
+static void usage(const char *name)
+{
+	fprintf(stderr,
+			"usage: %s [options] file.wav...\n"
+			"  -m <n>   modem: 0=300, 1=1200 (default), 2=1200 V.23, 3=9600\n"
+			"  -x <n>   FX.25 mode: 0=off, 1=RX (default), 2=RX+TX\n"
+			"  -d <n>   number of parallel 1200 Bd demodulators (0 = default)\n"
+			"  -b <n>   CRC recovery budget, bit flip attempts per bad frame (0 = off)\n"
+			"  -s <ms>  read received frames only every <ms> of audio (slow consumer)\n"
+			"  -f       flat (unfiltered) audio input\n"
+			"  -g <n>   input attenuation as right shift of 16-bit samples (default 4)\n"
+			"  -r <hz>  feed samples at this ADC rate through the RX decimator (19200, 28800, 38400)\n"
+			"  -p <n>   decode the input on RX port 1 as well, with modem n (same values as -m)\n"
+			"  -t       test the RX decimator against a floating point reference and exit\n"
+			"  -c       test and benchmark the AX.25 CRC and exit\n"
+			"  -e       test and benchmark the FX.25 Reed-Solomon decoder against the original LwFEC and exit\n"
+			"  -k <n>   FX.25 correlation tag bit errors allowed (default %d)\n"
+			"  -a       test FX.25 correlation tag matching with bit errors and exit\n"
+			"  -q       test an AGWPE session against a client stub, through the modem, and exit\n"
+			"  -u       test and benchmark the duplicate packet check at 100 packets/s and exit\n"
+			"  -i       test and benchmark the APRS-IS line reader and TNC2 parser and exit\n"
+			"  -j       test and benchmark the APRS-IS filter engine and exit\n"
+			"  -y       test and benchmark the station index of the last heard list and exit\n"
+			"  -z       test and benchmark the packet buffer pool and exit\n"
+			"  -w <wav> render 10 test packets with the TX path into a WAV file and exit\n"
+			"  -l       loop 10 test packets rendered by the TX path back into the receiver\n"
+			"  -n <n>   replay each file n times (benchmark)\n"
+			"  -v       print decoded frames\n",
+			name, FX25_TAG_DISTANCE_DEFAULT);
+}
+
+int main(int argc, char **argv)
+{
+	int modem = 1;
+	int fx25Mode = 1;
+	int gainShift = 4;
+	int repeat = 1;
+	int demods = 0;
+	uint32_t adcRate = 0;
+	int fixBits = AX25_FIX_BITS_DEFAULT;
+	int drainMs = 0;
+	int port1Modem = -1;
+	int tagDistance = FX25_TAG_DISTANCE_DEFAULT;
+	bool tagTest = false;
+	const char *txWav = NULL;
+	bool loopback = false;
+	bool flat = false;
+	bool verbose = false;
+
+	int opt;
+	while ((opt = getopt(argc, argv, "m:x:g:n:d:r:b:s:w:k:p:lftceaquijyzvh")) != -1)
+	{
+		switch (opt)
+		{
+		case 'm':
+			modem = atoi(optarg);
+			break;
+		case 'x':
+			fx25Mode = atoi(optarg);
+			break;
+		case 'g':
+			gainShift = atoi(optarg);
+			break;
+		case 'n':
+			repeat = atoi(optarg);
+			break;
+		case 'd':
+			demods = atoi(optarg);
+			break;
+		case 'r':
+			adcRate = atoi(optarg);
+			break;
+		case 'b':
+			fixBits = atoi(optarg);
+			break;
+		case 's':
+			drainMs = atoi(optarg);
+			break;
+		case 'w':
+			txWav = optarg;
+			break;
+		case 'k':
+			tagDistance = atoi(optarg);
+			break;
+		case 'p':
+			port1Modem = atoi(optarg);
+			break;
+		case 'a':
+			tagTest = true;
+			break;
+		case 'l':
+			loopback = true;
+			break;
+		case 'f':
+			flat = true;
+			break;
+		case 't':
+			return decimatorSelfTest() ? 1 : 0;
+		case 'c':
+			return crcSelfTest() ? 1 : 0;
+		case 'e':
+			return rsSelfTest() ? 1 : 0;
+		case 'q':
+			return agwSelfTest() ? 1 : 0;
+		case 'u':
+			return dupeSelfTest() ? 1 : 0;
+		case 'i':
+			return aprsIsSelfTest() ? 1 : 0;
+		case 'j':
+			return filterSelfTest() ? 1 : 0;
+		case 'y':
+			return stationSelfTest() ? 1 : 0;
+		case 'z':
+			return poolSelfTest() ? 1 : 0;
+		case 'v':
+			verbose = true;
+			break;
+		default:
+			usage(argv[0]);
+			return 2;
+		}
+	}
+	if (((optind >= argc) && (txWav == NULL) && !loopback && !tagTest) || (modem < 0) || (modem > 3) || (port1Modem > 3) || (repeat < 1))
+	{
+		usage(argv[0]);
+		return 2;
+	}
+
+	//same mapping as afskSetModem()
+	static const enum ModemType modemTypes[] = {MODEM_300, MODEM_1200, MODEM_1200_V23, MODEM_9600};
+	ModemConfig.modem = modemTypes[modem];
+	ModemConfig.flatAudioIn = flat;
+	ModemConfig.usePWM = 1;
+	ModemConfig.demodCount = demods;
+	ModemConfig.ports = (port1Modem >= 0) ? 2 : 1;
+	ModemConfig.port1Modem = modemTypes[(port1Modem >= 0) ? port1Modem : modem];
+	ModemConfig.port1FlatAudioIn = flat;
+	if (tagTest)
+		return tagSelfTest(tagDistance) ? 1 : 0;
+	Fx25TagDistance(tagDistance);
+	if (txWav != NULL)
+	{
+		ModemInit();
+		Ax25Init(fx25Mode);
+#ifdef ENABLE_FX25
+		if (fx25Mode > 0)
+			Fx25Init();
+#endif
+		return renderTx(txWav, 10);
+	}
+
+	//rendered TX audio goes through the same resampling and receive path as a recording
+	std::vector<const char *> inputs(argv + optind, argv + argc);
+	struct WavData loopWav;
+	if (loopback)
+	{
+		ModemInit();
+		Ax25Init(fx25Mode);
+#ifdef ENABLE_FX25
+		if (fx25Mode > 0)
+			Fx25Init();
+#endif
+		loopWav.sampleRate = CONFIG_AFSK_DAC_SAMPLERATE;
+		if (!renderTxPackets(10, &loopWav.samples))
+			return 1;
+		inputs.push_back("loopback");
+	}
+	uint32_t rate = (ModemConfig.modem == MODEM_9600) ? 38400 : 9600;
+	uint8_t ratio = 1;
+	if (adcRate)
+	{
+		ratio = adcRate / rate;
+		if ((adcRate % rate) || (ratio > DECIMATOR_MAX_RATIO))
+		{
+			fprintf(stderr, "unsupported ADC rate %u for this modem\n", adcRate);
+			return 2;
+		}
+	}
+	uint32_t rate1 = (ModemConfig.port1Modem == MODEM_9600) ? 38400 : 9600; //port 1 is fed at its modem rate
+	static struct Decimator decimator;
+	std::vector<int16_t> decimated;
+
+	uint64_t totalSamples = 0;
+	double totalSeconds = 0;
+	struct Ax25RxStats total;
+	memset(&total, 0, sizeof(total));
+
+	for (const char *name : inputs)
+	{
+		struct WavData wav;
+		std::vector<int16_t> samples, samples1;
+		if (loopback && (name == inputs.back()))
+			wav = loopWav;
+		else if (!loadWav(name, &wav))
+			return 1;
+		prepareSamples(&wav, rate * ratio, gainShift, &samples);
+		if (port1Modem >= 0)
+			prepareSamples(&wav, rate1, gainShift, &samples1);
+
+		for (int r = 0; r < repeat; r++)
+		{
+			ModemInit();
+			Ax25Init(fx25Mode);
+			Ax25FixBits(fixBits);
+#ifdef ENABLE_FX25
+			if (fx25Mode > 0)
+				Fx25Init();
+#endif
+			Ax25ClearRxStats();
+			DecimatorInit(&decimator, ratio);
+			hostMillis = 0;
+
+			bool print = verbose && (r == 0);
+			if (print)
+				printf("%s:\n", name);
+
+			double seconds = 0;
+			unsigned long lastDrain = 0;
+			for (size_t i = 0; i < samples.size();)
+			{
+				//decode in 10 ms slices and drain the frame buffer in between, like taskAPRS does
+				size_t end = i + rate * ratio / 100;
+				if (end > samples.size())
+					end = samples.size();
+
+				auto t0 = std::chrono::steady_clock::now();
+				if (ratio > 1)
+				{
+					decimated.resize((end - i) / ratio);
+					size_t n = DecimatorProcess(&decimator, &samples[i], decimated.size() * ratio, decimated.data());
+					ModemDecodeBlock(0, decimated.data(), n, 0);
+				}
+				else
+					ModemDecodeBlock(0, &samples[i], end - i, 0);
+				if (port1Modem >= 0)
+				{
+					//the same slice of time on port 1
+					size_t from = (uint64_t)i * rate1 / (rate * ratio);
+					size_t to = (end == samples.size()) ? samples1.size() : (uint64_t)end * rate1 / (rate * ratio);
+					if (to > samples1.size())
+						to = samples1.size();
+					if (to > from)
+						ModemDecodeBlock(1, &samples1[from], to - from, 0);
+				}
+				i = end;
+				seconds += std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+				hostMillis = (unsigned long)((uint64_t)i * 1000 / (rate * ratio));
+
+				if ((drainMs > 0) && ((hostMillis - lastDrain) < (unsigned long)drainMs) && (i < samples.size()))
+					continue;
+				lastDrain = hostMillis;
+				struct Ax25RxFrame *frame;
+				while ((frame = Ax25BorrowRxFrame()) != NULL)
+				{
+					if (print && (ModemGetPortCount() > 1))
+						printf("port %u: ", frame->port);
+					if (print)
+						printFrame(frame->data, frame->size, frame->corrected);
+					Ax25ReleaseRxFrame(frame);
+				}
+			}
+
+			struct Ax25RxStats stats;
+			Ax25GetRxStats(&stats);
+			if (r == 0)
+			{
+				printf("%-32s frames %4u  crc-fail %5u  bit-fix %u  overrun %u (pool peak %u/%u)  fx25 %u (fixed %u, failed %u, tag-fix %u)\n",
+					   name, stats.frames, stats.crcErrors, stats.bitFixes, stats.overruns, stats.poolPeak, stats.poolSize,
+					   stats.fx25Frames, stats.fx25Corrected, stats.fx25Failures, stats.fx25TagFixed);
+				if (ModemGetPortCount() > 1)
+					printf("%-32s port 0 frames %4u  port 1 frames %4u\n", name, stats.portFrames[0], stats.portFrames[1]);
+				total.frames += stats.frames;
+				total.portFrames[0] += stats.portFrames[0];
+				total.portFrames[1] += stats.portFrames[1];
+				total.crcErrors += stats.crcErrors;
+				total.overruns += stats.overruns;
+				total.fx25Frames += stats.fx25Frames;
+				total.fx25Corrected += stats.fx25Corrected;
+				total.fx25Failures += stats.fx25Failures;
+				total.fx25TagFixed += stats.fx25TagFixed;
+				total.duplicates += stats.duplicates;
+				total.bitFixes += stats.bitFixes;
+				for (uint8_t k = 0; k < MODEM_MAX_DEMODULATOR_COUNT; k++)
+				{
+					total.slotFirst[k] += stats.slotFirst[k];
+					total.slotDecoded[k] += stats.slotDecoded[k];
+				}
+			}
+			totalSamples += samples.size();
+			totalSeconds += seconds;
+		}
+	}
+
+	printf("total: frames %u  crc-fail %u  bit-fix %u  overrun %u  fx25 %u (fixed %u, failed %u, tag-fix %u)\n",
+		   total.frames, total.crcErrors, total.bitFixes, total.overruns,
+		   total.fx25Frames, total.fx25Corrected, total.fx25Failures, total.fx25TagFixed);
+	if (ModemGetPortCount() > 1)
+		printf("ports: port 0 frames %u  port 1 frames %u\n", total.portFrames[0], total.portFrames[1]);
+	if (ModemGetDemodulatorCount() > 1)
+	{
+		printf("decoders (first/decoded):");
+		for (uint8_t k = 0; k < ModemGetDemodulatorCount(); k++)
+			printf("  #%d %u/%u", k, total.slotFirst[k], total.slotDecoded[k]);
+		printf("\n");
+	}
+	if (totalSeconds > 0)
+		printf("decode: %llu samples in %.3f s, %.0f samples/s (%.1fx realtime @ %u Hz, %u demodulators)\n",
+			   (unsigned long long)totalSamples, totalSeconds, (double)totalSamples / totalSeconds,
+			   (double)totalSamples / totalSeconds / (double)(rate * ratio), rate * ratio, ModemGetDemodulatorCount());
+	return 0;
+}
@@ -0,0 +1,33 @@
+/*
+This file is part of LwFEC.
+
+LwFEC is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 3 of the License, or
+(at your option) any later version.
+
+LwFEC is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with LwFEC.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef RS_REFERENCE_H_
+#define RS_REFERENCE_H_
+
+#include "rs.h"
+
+/*
+The original LwFEC Reed-Solomon coder, kept on the host as the reference for the optimized lib/lwfec/rs.cpp
+*/
+namespace RsReference
+{
+bool RsDecode(struct LwFecRS *rs, uint8_t *data, uint8_t size, uint8_t *fixed);
+void RsEncode(struct LwFecRS *rs, uint8_t *data, uint8_t size);
+void RsInit(struct LwFecRS *rs, uint8_t T, uint8_t fcr);
+} // namespace RsReference
+
+#endif
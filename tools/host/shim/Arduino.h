@@ -0,0 +1,57 @@
+/*
+ Minimal Arduino/ESP-IDF surface needed to build the modem, AX.25 and FX.25
+ sources on a PC. Only what those files actually touch is provided here.
+*/
+#ifndef HOST_SHIM_ARDUINO_H
+#define HOST_SHIM_ARDUINO_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+#define IRAM_ATTR
+#define DRAM_ATTR
+#define PROGMEM
+
+#ifndef _BV
+#define _BV(bit) (1UL << (bit))
+#endif
+
+#define HIGH 1
+#define LOW 0
+
+typedef void *TaskHandle_t;
+typedef void *SemaphoreHandle_t;
+
+/* The replay tool is single threaded, critical sections have nothing to exclude */
+typedef int portMUX_TYPE;
+#define portMUX_INITIALIZER_UNLOCKED 0
+#define portENTER_CRITICAL(mux) ((void)(mux))
+#define portEXIT_CRITICAL(mux) ((void)(mux))
+
+#define pgm_read_byte(addr) (*(const uint8_t *)(addr))
+#define pgm_read_word(addr) (*(const uint16_t *)(addr))
+
+#ifdef HOST_VERBOSE
+#define log_e(fmt, ...) fprintf(stderr, "[E] " fmt "\n", ##__VA_ARGS__)
+#define log_w(fmt, ...) fprintf(stderr, "[W] " fmt "\n", ##__VA_ARGS__)
+#define log_i(fmt, ...) fprintf(stderr, "[I] " fmt "\n", ##__VA_ARGS__)
+#define log_d(fmt, ...) fprintf(stderr, "[D] " fmt "\n", ##__VA_ARGS__)
+#else
+#define log_e(fmt, ...) do {} while (0)
+#define log_w(fmt, ...) do {} while (0)
+#define log_i(fmt, ...) do {} while (0)
+#define log_d(fmt, ...) do {} while (0)
+#endif
+
+/* Time is driven by the replay tool, not by a wall clock */
+unsigned long millis(void);
+void delay(unsigned long ms);
+long random(long min, long max);
+void digitalWrite(uint8_t pin, uint8_t val);
+
+#endif
@@ -0,0 +1,4 @@
+#ifndef HOST_SHIM_COMMON_H
+#define HOST_SHIM_COMMON_H
+
+#endif
@@ -0,0 +1,4 @@
+#ifndef HOST_SHIM_DSPS_FIR_H
+#define HOST_SHIM_DSPS_FIR_H
+
+#endif
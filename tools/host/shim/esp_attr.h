@@ -0,0 +1,11 @@
+#ifndef HOST_SHIM_ESP_ATTR_H
+#define HOST_SHIM_ESP_ATTR_H
+
+#ifndef IRAM_ATTR
+#define IRAM_ATTR
+#endif
+#ifndef DRAM_ATTR
+#define DRAM_ATTR
+#endif
+
+#endif
@@ -0,0 +1,4 @@
+#ifndef HOST_SHIM_ESP_DSP_H
+#define HOST_SHIM_ESP_DSP_H
+
+#endif
@@ -0,0 +1,6 @@
+#ifndef HOST_SHIM_PGMSPACE_H
+#define HOST_SHIM_PGMSPACE_H
+
+#include "Arduino.h"
+
+#endif